@@ -0,0 +1,1168 @@
+#include <benchmark/benchmark.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/bp_tree.h"
+#include "include/c/cache.h"
+#include "include/c/hash_map.h"
+#include "include/c/key_utils.h"
+#include "include/c/list.h"
+#include "include/c/queue.h"
+#include "include/c/rb_tree.h"
+#include "include/c/rb_tree_mmap.h"
+#include "include/c/rb_tree_stream.h"
+#include "include/c/skip_list.h"
+}
+
+/* containers benchmarks : besides time per op and ops/sec (items_per_second) every benchmark
+ * reports allocations per op and p50/p99 latency of sampled single ops
+ *
+ *   BENCH_MAX_KEYS=100000000 ./bench_containers --benchmark_filter=Rbt
+ *
+ * the tree key counts are 1K..BENCH_MAX_KEYS (1M by default : 100M keys need ~40 GB)
+ *
+ * the pool queue takes its items from the node BENCH_POOL_NODE (the calling thread node by
+ * default), numactl places the threads on another one for the remote memory case :
+ *
+ *   numactl --cpunodebind=0 env BENCH_POOL_NODE=1 ./bench_containers --benchmark_filter=Pool
+ *   numactl --cpunodebind=0 --membind=1 ./bench_containers --benchmark_filter=ConcurrentQueue
+ */
+
+/************************************************************************
+ *                          ALLOCATIONS COUNTER                          *
+ ************************************************************************/
+
+static std::atomic<size_t> allocationsCount (0);
+
+// sanitizers have own allocator hooks : allocations are not counted under them
+#if !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+
+extern "C"
+{
+  void* __libc_malloc (size_t size);
+  void* __libc_calloc (size_t count, size_t size);
+  void* __libc_realloc (void* pMemory, size_t size);
+  void* __libc_memalign (size_t alignment, size_t size);
+
+  // the library calls resolve to these ones : the definition in the executable wins
+  void* malloc (size_t size)
+  {
+    allocationsCount.fetch_add (1, std::memory_order_relaxed);
+    return __libc_malloc (size);
+  }
+
+  void* calloc (size_t count, size_t size)
+  {
+    allocationsCount.fetch_add (1, std::memory_order_relaxed);
+    return __libc_calloc (count, size);
+  }
+
+  void* realloc (void* pMemory, size_t size)
+  {
+    allocationsCount.fetch_add (1, std::memory_order_relaxed);
+    return __libc_realloc (pMemory, size);
+  }
+
+  void* aligned_alloc (size_t alignment, size_t size)
+  {
+    allocationsCount.fetch_add (1, std::memory_order_relaxed);
+    return __libc_memalign (alignment, size);
+  }
+}
+
+#endif
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+// every SAMPLE_PERIOD-th op is timed alone : timing every op would double the cost of fast ones
+class OpStats
+{
+public:
+  static const size_t SAMPLE_PERIOD = 16;
+
+  explicit OpStats (benchmark::State& state)
+      : state (state), allocationsStart (allocationsCount.load ())
+  {
+  }
+
+  template <typename Op> void run (Op op)
+  {
+    if ((opsCount++ % SAMPLE_PERIOD) != 0)
+    {
+      op ();
+      return;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    op ();
+    auto elapsed = std::chrono::steady_clock::now () - start;
+
+    samples.push_back (std::chrono::duration<double, std::nano> (elapsed).count ());
+  }
+
+  // ops of all the benchmark threads are counted, allocations are global
+  void report (size_t opsPerThread, bool isAllocationsReporter = true)
+  {
+    state.SetItemsProcessed (opsPerThread);
+
+    if (isAllocationsReporter)
+    {
+      size_t allocations = allocationsCount.load () - allocationsStart;
+      state.counters["allocs/op"]
+          = (double)allocations / (double)(opsPerThread * (size_t)state.threads ());
+    }
+
+    if (!samples.empty ())
+    {
+      std::sort (samples.begin (), samples.end ());
+      state.counters["p50_ns"]
+          = benchmark::Counter (samples[samples.size () / 2], benchmark::Counter::kAvgThreads);
+      state.counters["p99_ns"] = benchmark::Counter (samples[samples.size () * 99 / 100],
+                                                     benchmark::Counter::kAvgThreads);
+    }
+  }
+
+private:
+  benchmark::State& state;
+  size_t allocationsStart;
+  size_t opsCount = 0;
+  std::vector<double> samples;
+};
+
+struct Payload
+{
+  std::vector<char> bytes;
+  explicit Payload (size_t size) : bytes (size, 'p') {}
+};
+
+static std::vector<std::string> makeKeys (size_t count, bool isRandom)
+{
+  // zero-padded numbers : sequential keys are ascending in strcmp () order as well
+
+  std::vector<std::string> keys;
+  keys.reserve (count);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    char key[32] = { 0 };
+    snprintf (key, sizeof (key), "key:%012zu", i);
+    keys.push_back (key);
+  }
+
+  if (isRandom)
+  {
+    std::shuffle (keys.begin (), keys.end (), std::mt19937 (42));
+  }
+
+  return keys;
+}
+
+static void keyCounts (benchmark::internal::Benchmark* pBenchmark)
+{
+  const char* maxKeys = getenv ("BENCH_MAX_KEYS");
+  size_t maxCount = (maxKeys != NULL) ? strtoull (maxKeys, NULL, 10) : 1000000;
+
+  for (int64_t count = 1000; count <= (int64_t)maxCount; count *= 10)
+  {
+    pBenchmark->Args ({ count, 0 });    // sequential
+    pBenchmark->Args ({ count, 1 });    // random
+  }
+}
+
+/************************************************************************
+ *                             KEY KERNELS    	                        *
+ ************************************************************************/
+
+static void BM_KeyKernels (benchmark::State& state)
+{
+  // key_length + key_string_compare of equal 64..255 bytes keys by the given KEY_KERNEL
+
+  const size_t KEYS_COUNT = 4096;
+
+  if (!key_kernel_select ((KEY_KERNEL)state.range (0)))
+  {
+    state.SkipWithError ("the kernel isn't supported by CPU");
+    return;
+  }
+
+  std::mt19937 generator (42);
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < KEYS_COUNT; ++i)
+  {
+    keys.push_back (std::string (64 + generator () % 192, 'a' + i % 26));
+  }
+  std::vector<std::string> copies = keys;
+
+  size_t index = 0;
+  size_t bytes = 0;
+
+  for (auto _ : state)
+  {
+    const char* key = keys[index].c_str ();
+
+    benchmark::DoNotOptimize (key_length (key, 256));
+    benchmark::DoNotOptimize (key_string_compare (key, copies[index].c_str ()));
+
+    bytes += keys[index].size ();
+    index = (index + 1 == KEYS_COUNT) ? 0 : index + 1;
+  }
+
+  state.SetItemsProcessed (state.iterations ());
+  state.SetBytesProcessed (bytes);
+  key_kernel_select (KEY_KERNEL_AUTO);
+}
+BENCHMARK (BM_KeyKernels)
+    ->Arg (KEY_KERNEL_SCALAR)
+    ->Arg (KEY_KERNEL_SSE2)
+    ->Arg (KEY_KERNEL_AVX2);
+
+/************************************************************************
+ *                                LIST    	                            *
+ ************************************************************************/
+
+struct ListNode
+{
+  int value;
+  List listItem;
+};
+
+static void BM_ListFifo (benchmark::State& state)
+{
+  /* the intrusive list (0) vs std::list (1) as a FIFO of the given depth : every push is
+   * followed by a pop, the intrusive one allocates nothing
+   */
+
+  size_t depth = state.range (0);
+  bool isStdList = state.range (1) != 0;
+
+  std::vector<ListNode> nodes (depth + 1);
+  List head;
+  list_init (&head);
+  std::list<ListNode*> stdList;
+
+  for (size_t i = 0; i < depth; ++i)
+  {
+    nodes[i].value = (int)i;
+    list_add_tail (&head, &nodes[i].listItem);
+    stdList.push_back (&nodes[i]);
+  }
+
+  OpStats stats (state);
+  ListNode* pFree = &nodes[depth];    // the node which isn't queued
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      if (isStdList)
+      {
+        stdList.push_back (pFree);
+        pFree = stdList.front ();
+        stdList.pop_front ();
+      }
+      else
+      {
+        list_add_tail (&head, &pFree->listItem);
+        List* pItem = list_first (&head);
+        list_del (pItem);
+        pFree = GET_NODE (pItem, ListNode, listItem);
+      }
+    });
+  }
+
+  benchmark::DoNotOptimize (pFree->value);
+  stats.report (state.iterations ());
+}
+BENCHMARK (BM_ListFifo)->ArgsProduct ({ { 16, 4096, 1000000 }, { 0, 1 } });
+
+/************************************************************************
+ *                             QUEUE    	                            *
+ ************************************************************************/
+
+static void BM_QueuePushPop (benchmark::State& state)
+{
+  // steady depth : every push is followed by a pop
+
+  const size_t QUEUE_DEPTH = 1000;
+
+  Payload payload (state.range (0));
+  Queue queue = { 0 };
+  queue_init (&queue);
+
+  for (size_t i = 0; i < QUEUE_DEPTH; ++i)
+  {
+    queue_push (&queue, payload.bytes.data (), payload.bytes.size ());
+  }
+
+  OpStats stats (state);
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      queue_push (&queue, payload.bytes.data (), payload.bytes.size ());
+      queue_pop (&queue, payload.bytes.data (), payload.bytes.size ());
+    });
+  }
+
+  stats.report (state.iterations ());
+  queue_destroy (&queue);
+}
+BENCHMARK (BM_QueuePushPop)->Arg (16)->Arg (256)->Arg (4096);
+
+static QueueSafe concurrentQueue;
+
+static void BM_ConcurrentQueue (benchmark::State& state)
+{
+  /* every thread is a producer and a consumer : it pushes an item and pops one,
+   * pops never miss since every one is preceded by own push
+   */
+
+  if (state.thread_index () == 0)
+  {
+    concurrent_queue_init (&concurrentQueue);
+  }
+
+  Payload payload (state.range (0));
+  OpStats stats (state);
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      concurrent_queue_push (&concurrentQueue, payload.bytes.data (), payload.bytes.size ());
+      concurrent_queue_pop (&concurrentQueue, payload.bytes.data (), payload.bytes.size (), 0);
+    });
+  }
+
+  stats.report (state.iterations (), state.thread_index () == 0);
+
+  if (state.thread_index () == 0)
+  {
+    concurrent_queue_destroy (&concurrentQueue);
+  }
+}
+BENCHMARK (BM_ConcurrentQueue)
+    ->ArgsProduct ({ { 16, 256, 4096 } })
+    ->ThreadRange (1, 16)
+    ->UseRealTime ();
+
+static NumaPool* pQueuePool = NULL;
+
+static void BM_ConcurrentQueuePool (benchmark::State& state)
+{
+  // BM_ConcurrentQueue with items and payloads from the pool of one node
+
+  if (state.thread_index () == 0)
+  {
+    const char* poolNode = getenv ("BENCH_POOL_NODE");
+
+    pQueuePool = numa_pool_create ((poolNode != NULL) ? atoi (poolNode) : -1);
+    if (pQueuePool == NULL)
+    {
+      state.SkipWithError ("no such NUMA node");
+    }
+    concurrent_queue_init_allocator (&concurrentQueue,
+                                     (pQueuePool != NULL) ? &pQueuePool->allocator : NULL);
+  }
+
+  Payload payload (state.range (0));
+  OpStats stats (state);
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      concurrent_queue_push (&concurrentQueue, payload.bytes.data (), payload.bytes.size ());
+      concurrent_queue_pop (&concurrentQueue, payload.bytes.data (), payload.bytes.size (), 0);
+    });
+  }
+
+  stats.report (state.iterations (), state.thread_index () == 0);
+
+  if (state.thread_index () == 0)
+  {
+    concurrent_queue_destroy (&concurrentQueue);
+    numa_pool_release (pQueuePool);
+  }
+}
+BENCHMARK (BM_ConcurrentQueuePool)
+    ->ArgsProduct ({ { 16, 256, 4096 } })
+    ->ThreadRange (1, 16)
+    ->UseRealTime ();
+
+static QueueNuma numaQueue;
+
+static void BM_NumaQueue (benchmark::State& state)
+{
+  /* BM_ConcurrentQueue over the per-node shards : a thread works on the shard of its node,
+   * the range is the shards count (0 : one per node) to see the cross-shard fallback
+   */
+
+  if (state.thread_index () == 0)
+  {
+    numa_queue_init (&numaQueue, (int)state.range (1));
+  }
+
+  Payload payload (state.range (0));
+  OpStats stats (state);
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      numa_queue_push (&numaQueue, payload.bytes.data (), payload.bytes.size ());
+      numa_queue_pop (&numaQueue, payload.bytes.data (), payload.bytes.size (), 0);
+    });
+  }
+
+  stats.report (state.iterations (), state.thread_index () == 0);
+
+  if (state.thread_index () == 0)
+  {
+    numa_queue_destroy (&numaQueue);
+  }
+}
+BENCHMARK (BM_NumaQueue)
+    ->ArgsProduct ({ { 16, 256, 4096 }, { 0, 4 } })
+    ->ThreadRange (1, 16)
+    ->UseRealTime ();
+
+/************************************************************************
+ *                          RED-BLACK TREE    	                        *
+ ************************************************************************/
+
+static void BM_RbtInsert (benchmark::State& state)
+{
+  // one iteration builds the whole tree : ops are inserts
+
+  size_t keysCount = state.range (0);
+  auto keys = makeKeys (keysCount, state.range (1) != 0);
+  Payload payload (16);
+
+  OpStats stats (state);
+
+  for (auto _ : state)
+  {
+    RBTNode* pRoot = NULL;
+
+    for (const auto& key : keys)
+    {
+      stats.run ([&] {
+        rbt_insert (&pRoot, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+      });
+    }
+
+    state.PauseTiming ();
+    rbt_destroy (&pRoot);
+    state.ResumeTiming ();
+  }
+
+  stats.report (state.iterations () * keysCount);
+  state.counters["time/op"] = benchmark::Counter (
+      (double)state.iterations () * keysCount,
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+BENCHMARK (BM_RbtInsert)->Apply (keyCounts)->Unit (benchmark::kMillisecond);
+
+static void BM_RbtGet (benchmark::State& state)
+{
+  // lookups of present keys in the insertion pattern
+
+  size_t keysCount = state.range (0);
+  auto keys = makeKeys (keysCount, state.range (1) != 0);
+  Payload payload (16);
+
+  RBTNode* pRoot = NULL;
+  for (const auto& key : keys)
+  {
+    rbt_insert (&pRoot, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+  }
+
+  OpStats stats (state);
+  size_t index = 0;
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      rbt_get (pRoot, payload.bytes.data (), payload.bytes.size (), keys[index].c_str ());
+    });
+
+    index = (index + 1 == keysCount) ? 0 : index + 1;
+  }
+
+  stats.report (state.iterations ());
+  rbt_destroy (&pRoot);
+}
+BENCHMARK (BM_RbtGet)->Apply (keyCounts);
+
+static void BM_RbtScan (benchmark::State& state)
+{
+  // one iteration is the full in-order scan : ops are visited nodes
+
+  size_t keysCount = state.range (0);
+  auto keys = makeKeys (keysCount, state.range (1) != 0);
+  Payload payload (16);
+
+  RBTNode* pRoot = NULL;
+  for (const auto& key : keys)
+  {
+    rbt_insert (&pRoot, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+  }
+
+  auto countNodes = [] (const RBTNode* pNode, void* pContext) {
+    benchmark::DoNotOptimize (pNode->key[0]);
+    ++*static_cast<size_t*> (pContext);
+    return true;
+  };
+  size_t scanned = 0;
+
+  for (auto _ : state)
+  {
+    rbt_scan_range (pRoot, NULL, NULL, countNodes, &scanned);
+  }
+
+  benchmark::DoNotOptimize (scanned);
+  state.SetItemsProcessed (state.iterations () * keysCount);
+  rbt_destroy (&pRoot);
+}
+BENCHMARK (BM_RbtScan)->Apply (keyCounts);
+
+static void BM_RbtInsertHint (benchmark::State& state)
+{
+  /* timestamps-like ascending keys : plain inserts (0) vs hinted ones (1),
+   * the node returned by rbt_insert_hint is the hint of the next key
+   */
+
+  size_t keysCount = state.range (0);
+  bool isHinted = state.range (1) != 0;
+  auto keys = makeKeys (keysCount, false);
+  Payload payload (16);
+
+  OpStats stats (state);
+
+  for (auto _ : state)
+  {
+    RBTNode* pRoot = NULL;
+    RBTNode* pHint = NULL;
+
+    for (const auto& key : keys)
+    {
+      stats.run ([&] {
+        if (isHinted)
+        {
+          pHint = rbt_insert_hint (&pRoot, pHint, payload.bytes.data (), payload.bytes.size (),
+                                   key.c_str ());
+        }
+        else
+        {
+          rbt_insert (&pRoot, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+        }
+      });
+    }
+
+    state.PauseTiming ();
+    rbt_destroy (&pRoot);
+    state.ResumeTiming ();
+  }
+
+  stats.report (state.iterations () * keysCount);
+}
+BENCHMARK (BM_RbtInsertHint)
+    ->ArgsProduct ({ { 500000 }, { 0, 1 } })
+    ->Unit (benchmark::kMillisecond);
+
+static void BM_RbtKeyPrefix (benchmark::State& state)
+{
+  /* lookups by rbt_get (0), which compares the cached key prefix first, vs a plain strcmp ()
+   * descent (1) over the same tree : url keys (0) share the prefix, hex keys (1) don't
+   */
+
+  const size_t KEYS_COUNT = 100000;
+
+  bool isHex = state.range (0) != 0;
+  bool isStrcmp = state.range (1) != 0;
+  std::mt19937 generator (42);
+  Payload payload (16);
+
+  RBTNode* pRoot = NULL;
+  std::vector<std::string> keys;
+
+  for (size_t i = 0; i < KEYS_COUNT; ++i)
+  {
+    char key[128] = { 0 };
+
+    if (isHex)
+    {
+      snprintf (key, sizeof (key), "%08x%08x", generator (), generator ());
+    }
+    else
+    {
+      snprintf (key, sizeof (key), "https://cdn%u.example.com/static/v2/assets/%u/image.png",
+                generator () % 16, generator ());
+    }
+
+    if (rbt_insert (&pRoot, payload.bytes.data (), payload.bytes.size (), key))
+    {
+      keys.push_back (key);
+    }
+  }
+
+  std::shuffle (keys.begin (), keys.end (), generator);
+
+  auto strcmpLookup = [] (RBTNode* pNode, const char* key) {
+    while (!is_NIL_same (pNode))
+    {
+      int result = strcmp (pNode->key, key);
+      if (result == 0)
+      {
+        break;
+      }
+      pNode = (result > 0) ? pNode->left : pNode->right;
+    }
+    return pNode;
+  };
+
+  OpStats stats (state);
+  size_t index = 0;
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      if (isStrcmp)
+      {
+        benchmark::DoNotOptimize (strcmpLookup (pRoot, keys[index].c_str ()));
+      }
+      else
+      {
+        rbt_get (pRoot, payload.bytes.data (), payload.bytes.size (), keys[index].c_str ());
+      }
+    });
+
+    index = (index + 1 == keys.size ()) ? 0 : index + 1;
+  }
+
+  stats.report (state.iterations ());
+  rbt_destroy (&pRoot);
+}
+BENCHMARK (BM_RbtKeyPrefix)->ArgsProduct ({ { 0, 1 }, { 0, 1 } });
+
+static void BM_RbtDestroy (benchmark::State& state)
+{
+  /* teardown of a bulk built tree : regular (0) or contiguous (1) nodes,
+   * rbt_destroy_parallel with the given threads count
+   */
+
+  const size_t KEYS_COUNT = 1000000;
+
+  bool isContiguous = state.range (0) != 0;
+  unsigned int threadsCount = (unsigned int)state.range (1);
+
+  auto keysStorage = makeKeys (KEYS_COUNT, false);
+  std::vector<const char*> keys;
+  for (const auto& key : keysStorage)
+  {
+    keys.push_back (key.c_str ());
+  }
+
+  Payload payload (16);
+  std::vector<char> items (KEYS_COUNT * payload.bytes.size ());
+
+  for (auto _ : state)
+  {
+    state.PauseTiming ();
+    RBTNode* pRoot = NULL;
+    rbt_build_from_sorted (&pRoot, keys.data (), items.data (), payload.bytes.size (),
+                           keys.size (), isContiguous);
+    state.ResumeTiming ();
+
+    rbt_destroy_parallel (&pRoot, threadsCount);
+  }
+
+  state.SetItemsProcessed (state.iterations () * KEYS_COUNT);
+}
+BENCHMARK (BM_RbtDestroy)
+    ->ArgsProduct ({ { 0, 1 }, { 1, 8 } })
+    ->Unit (benchmark::kMillisecond)
+    ->UseRealTime ();
+
+static void BM_RbtMmapReopen (benchmark::State& state)
+{
+  /* restart cost of the file backed tree : rebuilding it by inserts (0) vs reopening the
+   * file (1), the first lookup of the reopened tree faults its pages in
+   */
+
+  size_t keysCount = state.range (0);
+  bool isReopen = state.range (1) != 0;
+  auto keys = makeKeys (keysCount, true);
+  Payload payload (16);
+
+  char name[] = "/tmp/bench_rbt_mmap_XXXXXX";
+  int fd = mkstemp (name);
+  if (fd < 0)
+  {
+    state.SkipWithError ("no temporary file");
+    return;
+  }
+  close (fd);
+
+  RBTMmap tree;
+  rbt_mmap_open (&tree, name, 0);
+  for (const auto& key : keys)
+  {
+    rbt_mmap_insert (&tree, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+  }
+  rbt_mmap_close (&tree);
+
+  for (auto _ : state)
+  {
+    if (isReopen)
+    {
+      rbt_mmap_open (&tree, name, 0);
+      rbt_mmap_get (&tree, payload.bytes.data (), payload.bytes.size (), keys[0].c_str ());
+    }
+    else
+    {
+      state.PauseTiming ();
+      truncate (name, 0);
+      state.ResumeTiming ();
+
+      rbt_mmap_open (&tree, name, 0);
+      for (const auto& key : keys)
+      {
+        rbt_mmap_insert (&tree, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+      }
+    }
+
+    state.PauseTiming ();
+    rbt_mmap_close (&tree);
+    state.ResumeTiming ();
+  }
+
+  unlink (name);
+}
+BENCHMARK (BM_RbtMmapReopen)
+    ->ArgsProduct ({ { 200000 }, { 0, 1 } })
+    ->Unit (benchmark::kMillisecond);
+
+// in-memory stream : dump appends to 'bytes', load reads it from 'position'
+struct MemoryStream
+{
+  std::string bytes;
+  size_t position = 0;
+
+  static bool write (const void* pChunk, size_t size, void* pContext)
+  {
+    static_cast<MemoryStream*> (pContext)->bytes.append (static_cast<const char*> (pChunk), size);
+    return true;
+  }
+
+  static size_t read (void* pChunk, size_t size, void* pContext)
+  {
+    auto* pStream = static_cast<MemoryStream*> (pContext);
+    size_t part = std::min (size, pStream->bytes.size () - pStream->position);
+    memcpy (pChunk, pStream->bytes.data () + pStream->position, part);
+    pStream->position += part;
+    return part;
+  }
+};
+
+static void BM_RbtDumpLoad (benchmark::State& state)
+{
+  // shipping a snapshot : dump (0) and load (1) vs reinserting the keys one by one (2)
+
+  size_t keysCount = state.range (0);
+  int mode = (int)state.range (1);
+  auto keys = makeKeys (keysCount, true);
+  Payload payload (16);
+
+  RBTNode* pRoot = NULL;
+  for (const auto& key : keys)
+  {
+    rbt_insert (&pRoot, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+  }
+
+  std::vector<char> buffer (RBT_STREAM_CHUNK_SIZE);
+  MemoryStream snapshot;
+  rbt_dump (pRoot, payload.bytes.size (), buffer.data (), buffer.size (), MemoryStream::write,
+            &snapshot);
+
+  for (auto _ : state)
+  {
+    RBTNode* pCopy = NULL;
+
+    if (mode == 0)
+    {
+      MemoryStream stream;
+      rbt_dump (pRoot, payload.bytes.size (), buffer.data (), buffer.size (),
+                MemoryStream::write, &stream);
+    }
+    else if (mode == 1)
+    {
+      snapshot.position = 0;
+      rbt_load (&pCopy, payload.bytes.size (), buffer.data (), buffer.size (), MemoryStream::read,
+                &snapshot);
+    }
+    else
+    {
+      for (const auto& key : keys)
+      {
+        rbt_insert (&pCopy, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+      }
+    }
+
+    state.PauseTiming ();
+    rbt_destroy (&pCopy);
+    state.ResumeTiming ();
+  }
+
+  state.SetItemsProcessed (state.iterations () * keysCount);
+  state.counters["snapshot_KiB"] = (double)snapshot.bytes.size () / 1024;
+  rbt_destroy (&pRoot);
+}
+BENCHMARK (BM_RbtDumpLoad)
+    ->ArgsProduct ({ { 200000 }, { 0, 1, 2 } })
+    ->Unit (benchmark::kMillisecond);
+
+/************************************************************************
+ *                              B+ TREE    	                            *
+ ************************************************************************/
+
+// the BM_Rbt* counterparts : the same keys, payloads and ops
+
+static void BM_BptInsert (benchmark::State& state)
+{
+  size_t keysCount = state.range (0);
+  auto keys = makeKeys (keysCount, state.range (1) != 0);
+  Payload payload (16);
+
+  OpStats stats (state);
+
+  for (auto _ : state)
+  {
+    BPTree tree;
+    bpt_init (&tree);
+
+    for (const auto& key : keys)
+    {
+      stats.run ([&] {
+        bpt_insert (&tree, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+      });
+    }
+
+    state.PauseTiming ();
+    bpt_destroy (&tree);
+    state.ResumeTiming ();
+  }
+
+  stats.report (state.iterations () * keysCount);
+}
+BENCHMARK (BM_BptInsert)->Apply (keyCounts)->Unit (benchmark::kMillisecond);
+
+static void BM_BptGet (benchmark::State& state)
+{
+  size_t keysCount = state.range (0);
+  auto keys = makeKeys (keysCount, state.range (1) != 0);
+  Payload payload (16);
+
+  BPTree tree;
+  bpt_init (&tree);
+  for (const auto& key : keys)
+  {
+    bpt_insert (&tree, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+  }
+
+  OpStats stats (state);
+  size_t index = 0;
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      bpt_get (&tree, payload.bytes.data (), payload.bytes.size (), keys[index].c_str ());
+    });
+
+    index = (index + 1 == keysCount) ? 0 : index + 1;
+  }
+
+  stats.report (state.iterations ());
+  bpt_destroy (&tree);
+}
+BENCHMARK (BM_BptGet)->Apply (keyCounts);
+
+static void BM_BptScan (benchmark::State& state)
+{
+  // one iteration is the full scan along the leaves : ops are visited keys
+  // (the key is touched : inlined scans can't fold the count into the leaves sizes)
+
+  size_t keysCount = state.range (0);
+  auto keys = makeKeys (keysCount, state.range (1) != 0);
+  Payload payload (16);
+
+  BPTree tree;
+  bpt_init (&tree);
+  for (const auto& key : keys)
+  {
+    bpt_insert (&tree, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+  }
+
+  auto countKeys = [] (const char* key, void*, void* pContext) {
+    benchmark::DoNotOptimize (key[0]);
+    ++*static_cast<size_t*> (pContext);
+    return true;
+  };
+  size_t scanned = 0;
+
+  for (auto _ : state)
+  {
+    bpt_scan_range (&tree, NULL, NULL, countKeys, &scanned);
+  }
+
+  benchmark::DoNotOptimize (scanned);
+  state.SetItemsProcessed (state.iterations () * keysCount);
+  bpt_destroy (&tree);
+}
+BENCHMARK (BM_BptScan)->Apply (keyCounts);
+
+/************************************************************************
+ *                             HASH MAP    	                            *
+ ************************************************************************/
+
+static void BM_HashMapInsert (benchmark::State& state)
+{
+  // BM_RbtInsert counterpart : the map grows from the default capacity
+
+  size_t keysCount = state.range (0);
+  auto keys = makeKeys (keysCount, state.range (1) != 0);
+  Payload payload (16);
+
+  OpStats stats (state);
+
+  for (auto _ : state)
+  {
+    HashMap map;
+    hm_init (&map, 0);
+
+    for (const auto& key : keys)
+    {
+      stats.run ([&] {
+        hm_insert (&map, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+      });
+    }
+
+    state.PauseTiming ();
+    hm_destroy (&map);
+    state.ResumeTiming ();
+  }
+
+  stats.report (state.iterations () * keysCount);
+}
+BENCHMARK (BM_HashMapInsert)->Apply (keyCounts)->Unit (benchmark::kMillisecond);
+
+static void BM_HashMapGet (benchmark::State& state)
+{
+  // BM_RbtGet counterpart
+
+  size_t keysCount = state.range (0);
+  auto keys = makeKeys (keysCount, state.range (1) != 0);
+  Payload payload (16);
+
+  HashMap map;
+  hm_init (&map, 0);
+  for (const auto& key : keys)
+  {
+    hm_insert (&map, payload.bytes.data (), payload.bytes.size (), key.c_str ());
+  }
+
+  OpStats stats (state);
+  size_t index = 0;
+
+  for (auto _ : state)
+  {
+    stats.run ([&] {
+      hm_get (&map, payload.bytes.data (), payload.bytes.size (), keys[index].c_str ());
+    });
+
+    index = (index + 1 == keysCount) ? 0 : index + 1;
+  }
+
+  stats.report (state.iterations ());
+  hm_destroy (&map);
+}
+BENCHMARK (BM_HashMapGet)->Apply (keyCounts);
+
+static HashMapSafe concurrentMap;
+static std::vector<std::string> concurrentMapKeys;
+
+static void BM_ConcurrentHashMap (benchmark::State& state)
+{
+  /* striped map scaling with one lock (1) or 64 stripes (64) : every thread inserts and
+   * reads own part of the keys, inserts of the next laps find the key present
+   */
+
+  const size_t KEYS_COUNT = 200000;
+
+  if (state.thread_index () == 0)
+  {
+    concurrentMapKeys = makeKeys (KEYS_COUNT, true);
+    concurrent_hm_init (&concurrentMap, KEYS_COUNT, state.range (0));
+  }
+
+  Payload payload (16);
+  OpStats stats (state);
+  size_t index = state.thread_index ();
+
+  for (auto _ : state)
+  {
+    const char* key = concurrentMapKeys[index].c_str ();
+
+    stats.run ([&] {
+      concurrent_hm_insert (&concurrentMap, payload.bytes.data (), payload.bytes.size (), key);
+      concurrent_hm_get (&concurrentMap, payload.bytes.data (), payload.bytes.size (), key);
+    });
+
+    index += state.threads ();
+    index = (index >= KEYS_COUNT) ? state.thread_index () : index;
+  }
+
+  stats.report (state.iterations (), state.thread_index () == 0);
+
+  if (state.thread_index () == 0)
+  {
+    concurrent_hm_destroy (&concurrentMap);
+  }
+}
+BENCHMARK (BM_ConcurrentHashMap)
+    ->ArgsProduct ({ { 1, 64 } })
+    ->ThreadRange (1, 16)
+    ->UseRealTime ();
+
+/************************************************************************
+ *                             SKIP LIST    	                        *
+ ************************************************************************/
+
+static SkipList concurrentList;
+static RBTNode* pLockedRoot = NULL;
+static pthread_rwlock_t rootLock = PTHREAD_RWLOCK_INITIALIZER;
+static std::vector<std::string> concurrentListKeys;
+
+static void BM_ConcurrentSkipList (benchmark::State& state)
+{
+  /* ordered maps scaling : the skip list (0) vs the red-black tree under rwlock (1),
+   * every thread inserts and reads own part of the keys
+   */
+
+  const size_t KEYS_COUNT = 200000;
+
+  bool isLockedTree = state.range (0) != 0;
+
+  if (state.thread_index () == 0)
+  {
+    concurrentListKeys = makeKeys (KEYS_COUNT, true);
+    sl_init (&concurrentList);
+  }
+
+  Payload payload (16);
+  OpStats stats (state);
+  size_t index = state.thread_index ();
+
+  for (auto _ : state)
+  {
+    const char* key = concurrentListKeys[index].c_str ();
+
+    stats.run ([&] {
+      if (isLockedTree)
+      {
+        pthread_rwlock_wrlock (&rootLock);
+        rbt_insert (&pLockedRoot, payload.bytes.data (), payload.bytes.size (), key);
+        pthread_rwlock_unlock (&rootLock);
+
+        pthread_rwlock_rdlock (&rootLock);
+        rbt_get (pLockedRoot, payload.bytes.data (), payload.bytes.size (), key);
+        pthread_rwlock_unlock (&rootLock);
+      }
+      else
+      {
+        sl_insert (&concurrentList, payload.bytes.data (), payload.bytes.size (), key);
+        sl_get (&concurrentList, payload.bytes.data (), payload.bytes.size (), key);
+      }
+    });
+
+    index += state.threads ();
+    index = (index >= KEYS_COUNT) ? state.thread_index () : index;
+  }
+
+  stats.report (state.iterations (), state.thread_index () == 0);
+
+  if (state.thread_index () == 0)
+  {
+    sl_destroy (&concurrentList);
+    rbt_destroy (&pLockedRoot);
+  }
+}
+BENCHMARK (BM_ConcurrentSkipList)
+    ->ArgsProduct ({ { 0, 1 } })
+    ->ThreadRange (1, 64)
+    ->UseRealTime ();
+
+/************************************************************************
+ *                               CACHE    	                            *
+ ************************************************************************/
+
+static void BM_CacheEviction (benchmark::State& state)
+{
+  /* a full cache of the given CACHE_POLICY : a get, a put on the miss, which evicts,
+   * half of the uniform keys fit the cache
+   */
+
+  const size_t MAX_COUNT = 10000;
+
+  Cache cache;
+  cache_init (&cache, (CACHE_POLICY)state.range (0), MAX_COUNT, 0, NULL, NULL);
+
+  std::mt19937 generator (42);
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < 1 << 20; ++i)
+  {
+    char key[32] = { 0 };
+    snprintf (key, sizeof (key), "user:%08x", (unsigned int)(generator () % (MAX_COUNT * 2)));
+    keys.push_back (key);
+  }
+
+  Payload payload (16);
+  OpStats stats (state);
+  size_t index = 0;
+  size_t hits = 0;
+
+  for (auto _ : state)
+  {
+    const char* key = keys[index].c_str ();
+
+    stats.run ([&] {
+      if (cache_get (&cache, payload.bytes.data (), payload.bytes.size (), key))
+      {
+        ++hits;
+      }
+      else
+      {
+        cache_put (&cache, payload.bytes.data (), payload.bytes.size (), key);
+      }
+    });
+
+    index = (index + 1 == keys.size ()) ? 0 : index + 1;
+  }
+
+  stats.report (state.iterations ());
+  state.counters["hit_ratio"] = (double)hits / (double)state.iterations ();
+  cache_destroy (&cache);
+}
+BENCHMARK (BM_CacheEviction)->Arg (CACHE_LRU)->Arg (CACHE_LFU);
+
+BENCHMARK_MAIN ();
@@ -0,0 +1,49 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /* pluggable memory of containers : an arena, a NUMA-local or a counting allocator is given
+   * at container init, libc is the default
+   *
+   * > free gets the size of the allocation back : sized deallocation for arenas
+   * > a Heap is the memory one container holds through its allocator : live bytes and
+   *   allocations, updated atomically since some containers release in parallel
+   * > NULL Heap is libc without counting
+   */
+
+  typedef struct AllocatorS
+  {
+    void* (*alloc) (size_t size, void* pContext);    // max_align_t aligned, NULL on failure
+    void (*free) (void* pMemory, size_t size, void* pContext);
+    void* pContext;
+  } Allocator;
+
+  typedef struct HeapS
+  {
+    Allocator allocator;
+    size_t bytes;          // live, atomic
+    size_t allocations;    // live, atomic
+  } Heap;
+
+  EXPORT const Allocator* allocator_libc (void);
+
+  // NULL allocator : libc
+  EXPORT bool heap_init (Heap* pHeap, const Allocator* pAllocator);
+  EXPORT void* heap_alloc (Heap* pHeap, size_t size);
+  EXPORT void heap_free (Heap* pHeap, void* pMemory, size_t size);    // size of heap_alloc ()
+
+  EXPORT size_t heap_bytes (const Heap* pHeap);
+  EXPORT size_t heap_allocations (const Heap* pHeap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // ALLOCATOR_H
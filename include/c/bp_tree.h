@@ -0,0 +1,45 @@
+#ifndef __BPTREE__
+#define __BPTREE__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "allocator.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  #define BPT_KEY_SIZE (256)
+
+  typedef struct BPTNodeS BPTNode;
+
+  // ordered map with the red-black tree semantics : string keys, copied payloads
+  typedef struct BPTreeS
+  {
+    BPTNode* root;
+    size_t count;
+    Heap heap;    // nodes, separators, keys and payloads
+  } BPTree;
+
+  // return false to stop scanning
+  typedef bool (*BPTScanCallback) (const char* key, void* pData, void* pContext);
+
+  EXPORT bool bpt_init (BPTree* pTree);
+  EXPORT bool bpt_init_allocator (BPTree* pTree, const Allocator* pAllocator);    // NULL : libc
+  EXPORT void bpt_destroy (BPTree* pTree);
+  EXPORT bool bpt_insert (BPTree* pTree, void* pItem, size_t itemSize, const char* key);
+  // itemSize is the buffer size : false if the stored payload doesn't fit it
+  EXPORT bool bpt_get (BPTree* pTree, void* pItem, size_t itemSize, const char* key);
+  EXPORT bool bpt_delete (BPTree* pTree, const char* key);
+
+  // [keyFrom, keyTo) in ascending order, NULL bound = unbounded
+  EXPORT bool bpt_scan_range (BPTree* pTree, const char* keyFrom, const char* keyTo,
+                              BPTScanCallback callback, void* pContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __BPTREE__
@@ -0,0 +1,100 @@
+#ifndef __CACHE__
+#define __CACHE__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "allocator.h"
+#include "list.h"
+#include "rb_tree_intrusive.h"
+#include "thread_utils.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  #define CACHE_KEY_SIZE (256)
+
+  typedef enum CACHE_POLICY_E
+  {
+    CACHE_LRU,    // the least recently used entry is evicted first
+    CACHE_LFU,    // the least frequently used one, the least recently used among equals
+  } CACHE_POLICY;
+
+  // called for entries evicted by the budget, not for deleted or destroyed ones
+  typedef void (*CacheEvictCallback) (const char* key, const void* pData, size_t dataSize,
+                                      void* pContext);
+
+  /* bounded cache : entry is one allocation with key, payload, index and recency links
+   *
+   * > the key index is the intrusive red-black tree
+   * > LRU : 'entries' is the recency list, the most recent entry first
+   * > LFU : 'entries' is the list of frequency buckets, the least frequency first,
+   *         every bucket keeps own recency list
+   *
+   * get and put touch the entry in O(1) besides the index search
+   */
+  typedef struct CacheS
+  {
+    RBTIntrusive index;
+    List entries;
+
+    CACHE_POLICY policy;
+    size_t count;
+    size_t bytes;       // keys and payloads, the budget
+    size_t maxCount;    // 0 : no limit
+    size_t maxBytes;    // 0 : no limit
+
+    CacheEvictCallback evict;
+    void* pContext;
+
+    Heap heap;    // entries and LFU buckets : the memory held, headers included
+  } Cache;
+
+  // thread-safety cache : independent caches with own locks and budget parts, selected by key hash
+  typedef struct CacheShardS CacheShard;
+
+  typedef struct CacheSafeS
+  {
+    CacheShard* shards;
+    size_t shardsCount;    // power of two
+  } CacheSafe;
+
+  EXPORT bool cache_init (Cache* pCache, CACHE_POLICY policy, size_t maxCount, size_t maxBytes,
+                          CacheEvictCallback evict, void* pContext);
+  // NULL allocator : libc
+  EXPORT bool cache_init_allocator (Cache* pCache, CACHE_POLICY policy, size_t maxCount,
+                                    size_t maxBytes, CacheEvictCallback evict, void* pContext,
+                                    const Allocator* pAllocator);
+  EXPORT void cache_destroy (Cache* pCache);
+
+  // inserts or replaces the payload, may evict other entries : false if entry exceeds the budget
+  EXPORT bool cache_put (Cache* pCache, const void* pItem, size_t itemSize, const char* key);
+  EXPORT bool cache_get (Cache* pCache, void* pItem, size_t itemSize, const char* key);
+  EXPORT bool cache_delete (Cache* pCache, const char* key);
+  EXPORT size_t cache_count (const Cache* pCache);
+  EXPORT size_t cache_bytes (const Cache* pCache);
+
+  // the budget is split between shards, evict callback is called under the shard lock
+  EXPORT bool concurrent_cache_init (CacheSafe* pCache, CACHE_POLICY policy, size_t maxCount,
+                                     size_t maxBytes, size_t shardsCount,
+                                     CacheEvictCallback evict, void* pContext);
+  // every shard cache has own heap of the allocator
+  EXPORT bool concurrent_cache_init_allocator (CacheSafe* pCache, CACHE_POLICY policy,
+                                               size_t maxCount, size_t maxBytes, size_t shardsCount,
+                                               CacheEvictCallback evict, void* pContext,
+                                               const Allocator* pAllocator);
+  EXPORT void concurrent_cache_destroy (CacheSafe* pCache);
+  EXPORT bool concurrent_cache_put (CacheSafe* pCache, const void* pItem, size_t itemSize,
+                                    const char* key);
+  EXPORT bool concurrent_cache_get (CacheSafe* pCache, void* pItem, size_t itemSize,
+                                    const char* key);
+  EXPORT bool concurrent_cache_delete (CacheSafe* pCache, const char* key);
+  EXPORT size_t concurrent_cache_count (CacheSafe* pCache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __CACHE__
@@ -0,0 +1,63 @@
+#ifndef __HASH_MAP__
+#define __HASH_MAP__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "thread_utils.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  #define HM_KEY_SIZE (256)
+
+  typedef struct HashMapSlotS HashMapSlot;
+
+  // open addressing (swiss table) : one control byte per slot, probed by groups
+  typedef struct HashMapS
+  {
+    int8_t* ctrl;
+    HashMapSlot* slots;
+    size_t capacity;      // power of two, 0 until the first insertion
+    size_t count;
+    size_t growthLeft;    // insertions to empty slots left before rehashing
+    Heap heap;            // control bytes, slots, keys and payloads
+  } HashMap;
+
+  // thread-safety hash map : independent maps with own locks, selected by key hash
+  typedef struct HashMapStripeS HashMapStripe;
+
+  typedef struct HashMapSafeS
+  {
+    HashMapStripe* stripes;
+    size_t stripesCount;    // power of two
+  } HashMapSafe;
+
+  EXPORT bool hm_init (HashMap* pMap, size_t capacity);
+  EXPORT bool hm_init_allocator (HashMap* pMap, size_t capacity,
+                                 const Allocator* pAllocator);    // NULL : libc
+  EXPORT void hm_destroy (HashMap* pMap);
+  EXPORT bool hm_insert (HashMap* pMap, void* pItem, size_t itemSize, const char* key);
+  // itemSize is the buffer size : false if the stored payload doesn't fit it
+  EXPORT bool hm_get (HashMap* pMap, void* pItem, size_t itemSize, const char* key);
+  EXPORT bool hm_delete (HashMap* pMap, const char* key);
+
+  EXPORT bool concurrent_hm_init (HashMapSafe* pMap, size_t capacity, size_t stripesCount);
+  // every stripe map has own heap of the allocator
+  EXPORT bool concurrent_hm_init_allocator (HashMapSafe* pMap, size_t capacity,
+                                            size_t stripesCount, const Allocator* pAllocator);
+  EXPORT void concurrent_hm_destroy (HashMapSafe* pMap);
+  EXPORT bool concurrent_hm_insert (HashMapSafe* pMap, void* pItem, size_t itemSize,
+                                    const char* key);
+  EXPORT bool concurrent_hm_get (HashMapSafe* pMap, void* pItem, size_t itemSize, const char* key);
+  EXPORT bool concurrent_hm_delete (HashMapSafe* pMap, const char* key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __HASH_MAP__
@@ -0,0 +1,40 @@
+#ifndef KEY_UTILS_H
+#define KEY_UTILS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define KEY_PREFIX_SIZE (sizeof (uint64_t))
+
+// implementation of the key kernels : every one gives the same results as KEY_KERNEL_SCALAR
+typedef enum KEY_KERNEL_E
+{
+  KEY_KERNEL_AUTO,    // the best one supported by CPU, selected at startup
+  KEY_KERNEL_SCALAR,
+  KEY_KERNEL_SSE2,
+  KEY_KERNEL_AVX2,
+} KEY_KERNEL;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // not thread-safe : to be called before containers are used
+  EXPORT bool key_kernel_select (KEY_KERNEL kernel);
+  EXPORT KEY_KERNEL key_kernel_active (void);
+
+  EXPORT size_t key_length (const char* key, size_t maxSize);                       // strnlen ()
+  EXPORT size_t key_mismatch (const void* key1, const void* key2, size_t size);     // first index
+  EXPORT int key_compare (const void* key1, const void* key2, size_t size);         // memcmp ()
+  EXPORT int key_string_compare (const char* key1, const char* key2);               // strcmp ()
+
+  // first key bytes in big-endian order : integer order of prefixes is strcmp () order
+  EXPORT uint64_t key_prefix (const char* key, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // KEY_UTILS_H
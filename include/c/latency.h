@@ -0,0 +1,94 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* latency histograms of container operations
+ *
+ * > built in with CONTAINERS_LATENCY defined, otherwise LATENCY_START/LATENCY_STOP are empty
+ * > every thread records into own histograms : the hot path is a timestamp pair and a bucket
+ *   increment, no locks and no shared cache lines
+ * > buckets are log-linear (HDR-style) : 16 sub-buckets per power of two, ~6% precision
+ * > latency_merge sums the histograms of all threads, those exited included
+ */
+
+#define LATENCY_SUB_BITS (4)
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS (40)    // ~18 minutes in ns, longer ones fall into the last bucket
+#define LATENCY_BUCKETS ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+typedef enum LATENCY_OP_E
+{
+  LATENCY_QUEUE_PUSH,    // concurrent_queue_push
+  LATENCY_QUEUE_POP,     // concurrent_queue_pop, waiting included
+  LATENCY_RBT_INSERT,
+  LATENCY_RBT_GET,
+
+  LATENCY_OPS_COUNT
+} LATENCY_OP;
+
+// ticks : TSC on x86-64, CLOCK_MONOTONIC_RAW ns otherwise
+typedef struct LatencyHistogramS
+{
+  uint64_t counts[LATENCY_BUCKETS];
+  uint64_t count;
+  uint64_t maxTicks;
+  double ticksPerNs;
+} LatencyHistogram;
+
+#ifdef CONTAINERS_LATENCY
+  #define LATENCY_START(start) uint64_t start = latency_ticks ()
+  #define LATENCY_STOP(op, start) latency_record (op, latency_ticks () - (start))
+#else
+  #define LATENCY_START(start)
+  #define LATENCY_STOP(op, start)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  static inline uint64_t latency_ticks (void)
+  {
+#if defined(__x86_64__)
+    return __builtin_ia32_rdtsc ();
+#else
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC_RAW, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+  }
+
+  // the calling thread histogram of op, no locks
+  EXPORT void latency_record (LATENCY_OP op, uint64_t ticks);
+
+  // a histogram of own : no atomics, the caller serializes the access
+  EXPORT void latency_histogram_record (LatencyHistogram* pHistogram, uint64_t ticks);
+
+  // sum of all the thread histograms : concurrent records may be partly seen
+  EXPORT bool latency_merge (LATENCY_OP op, LatencyHistogram* pHistogram);
+
+  // ns : the upper bound of the bucket holding the quantile (0.5, 0.99, 0.999), 0 if empty
+  EXPORT uint64_t latency_percentile (const LatencyHistogram* pHistogram, double quantile);
+
+  // count, p50, p99, p999, max of every op with records
+  EXPORT bool latency_dump (FILE* pFile);
+
+  // concurrent records may survive it
+  EXPORT void latency_reset (void);
+
+  EXPORT const char* latency_op_name (LATENCY_OP op);
+
+  // TSC rate : the first call may sleep up to 10 ms to measure it
+  EXPORT double latency_ticks_per_ns (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // LATENCY_H
@@ -0,0 +1,59 @@
+#ifndef __LF_LIST__
+#define __LF_LIST__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "thread_utils.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  #define LFL_KEY_SIZE (256)
+
+  /* lock-free sorted singly linked list (Harris, with Michael's search) : key/data semantics
+   * of rb_tree.h, so it may serve as a bucket chain of a concurrent hash map
+   *
+   * > deletion marks the low bit of the victim 'next' link first, that's the linearization
+   *   point, then the victim is unlinked by CAS on its predecessor link
+   * > searches of writers finish unlinking of marked nodes met on the way
+   * > lfl_get and traversal neither write nor retry
+   * > every call is an epoch critical section : unlinked nodes are released once
+   *   no reader may still be on them
+   */
+
+  typedef struct LFListNodeS LFListNode;
+
+  typedef struct LFListS
+  {
+    LFListNode* head;       // the first node link, never marked
+    SmrDomain smr;          // epochs : unlinked nodes waiting for release
+    size_t count;
+    Heap heap;    // nodes, released by the reclaiming thread : the allocator must be thread safe
+  } LFList;
+
+  // return false to stop traversal
+  typedef bool (*LFListCallback) (const char* key, const void* pData, size_t dataSize,
+                                  void* pContext);
+
+  EXPORT bool lfl_init (LFList* pList);
+  EXPORT bool lfl_init_allocator (LFList* pList, const Allocator* pAllocator);    // NULL : libc
+  EXPORT void lfl_destroy (LFList* pList);    // no concurrent access is allowed here
+  EXPORT bool lfl_insert (LFList* pList, const void* pItem, size_t itemSize, const char* key);
+  // itemSize is the buffer size : false if the stored payload doesn't fit it
+  EXPORT bool lfl_get (LFList* pList, void* pItem, size_t itemSize, const char* key);
+  EXPORT bool lfl_delete (LFList* pList, const char* key);
+  EXPORT size_t lfl_count (LFList* pList);
+
+  // ascending key order, weakly consistent : keys present for the whole traversal are visited once
+  EXPORT bool lfl_for_each (LFList* pList, LFListCallback callback, void* pContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __LF_LIST__
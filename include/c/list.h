@@ -0,0 +1,90 @@
+#ifndef __LIST__
+#define __LIST__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /* intrusive circular doubly linked list (linux <list.h> approach):
+   *
+   * > List member lives inside the user struct, the list never allocates
+   * > the list head is a List itself, empty list head points to itself
+   * > GET_NODE () gets the user struct back from its List member
+   *
+   *   typedef struct NodeS
+   *   {
+   *     void* data;
+   *     List listItem;
+   *   } Node;
+   *
+   *   LIST_FOR_EACH_ENTRY (pNode, &head, Node, listItem) { ... }
+   */
+
+  typedef struct ListS
+  {
+    struct ListS* prev;
+    struct ListS* next;
+  } List;
+
+  // address of the struct by the address of its List member
+  #define GET_NODE(pListItem, StructType, ListItemName) \
+    ((StructType*)((char*)(pListItem)-offsetof (StructType, ListItemName)))
+
+  #define LIST_HEAD_INIT(name) { &(name), &(name) }
+
+  // the item must not be removed inside, use the _SAFE version for that
+  #define LIST_FOR_EACH(pItem, pHead) \
+    for ((pItem) = (pHead)->next; (pItem) != (pHead); (pItem) = (pItem)->next)
+
+  #define LIST_FOR_EACH_REVERSE(pItem, pHead) \
+    for ((pItem) = (pHead)->prev; (pItem) != (pHead); (pItem) = (pItem)->prev)
+
+  // the current item may be removed or moved to another list
+  #define LIST_FOR_EACH_SAFE(pItem, pTemp, pHead)                      \
+    for ((pItem) = (pHead)->next, (pTemp) = (pItem)->next; (pItem) != (pHead); \
+         (pItem) = (pTemp), (pTemp) = (pItem)->next)
+
+  #define LIST_FOR_EACH_ENTRY(pEntry, pHead, StructType, ListItemName)                       \
+    for ((pEntry) = GET_NODE ((pHead)->next, StructType, ListItemName);                      \
+         &(pEntry)->ListItemName != (pHead);                                                 \
+         (pEntry) = GET_NODE ((pEntry)->ListItemName.next, StructType, ListItemName))
+
+  #define LIST_FOR_EACH_ENTRY_SAFE(pEntry, pTemp, pHead, StructType, ListItemName)           \
+    for ((pEntry) = GET_NODE ((pHead)->next, StructType, ListItemName),                      \
+        (pTemp) = GET_NODE ((pEntry)->ListItemName.next, StructType, ListItemName);          \
+         &(pEntry)->ListItemName != (pHead);                                                 \
+         (pEntry) = (pTemp), (pTemp) = GET_NODE ((pTemp)->ListItemName.next, StructType,     \
+                                                 ListItemName))
+
+  // all the operations are O(1) except list_count ()
+  EXPORT void list_init (List* pHead);
+  EXPORT bool list_is_empty (const List* pHead);
+  EXPORT bool list_is_singular (const List* pHead);
+  EXPORT size_t list_count (const List* pHead);
+
+  EXPORT void list_add (List* pHead, List* pItem);         // to the beginning : stack
+  EXPORT void list_add_tail (List* pHead, List* pItem);    // to the end : queue
+  EXPORT void list_del (List* pItem);    // the item is left as an empty list, so it's reusable
+  EXPORT void list_replace (List* pOld, List* pNew);
+
+  // delete from its list and add to another (or the same) one
+  EXPORT void list_move (List* pHead, List* pItem);
+  EXPORT void list_move_tail (List* pHead, List* pItem);
+
+  // all the items of pList are moved to pHead, pList is left empty
+  EXPORT void list_splice (List* pHead, List* pList);
+  EXPORT void list_splice_tail (List* pHead, List* pList);
+
+  // NULL for empty list
+  EXPORT List* list_first (const List* pHead);
+  EXPORT List* list_last (const List* pHead);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __LIST__
@@ -0,0 +1,60 @@
+#ifndef NUMA_POOL_H
+#define NUMA_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "allocator.h"
+#include "thread_utils.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  #define NUMA_POOL_CLASSES (9)               // 16 B .. 4 KB chunks, power of two sizes
+  #define NUMA_POOL_BLOCK_SIZE (1 << 20)      // chunks are carved from blocks of the node
+
+  /* memory pool of one NUMA node : an Allocator for containers whose memory should be
+   * local to their consumer, e.g. a QueueSafe filled by producers of another node
+   *
+   * > with libnuma (CONTAINERS_HAVE_LIBNUMA) blocks are bound to the node by
+   *   numa_alloc_onnode (); when the node is out of memory they are placed by first touch.
+   *   numa_pool_create builds the pool of another node on a thread run on that node, so the
+   *   first block and the pool lock are faulted in there; later blocks are faulted in by the
+   *   thread which grows the pool
+   * > without libnuma a single node is reported : placement is first touch by the creating
+   *   and growing threads, not per node
+   * > freed chunks go to per-size free lists and are reused, blocks are released with the pool
+   * > larger allocations are taken from the node directly
+   * > the pool itself lives in its first block : its lock line is local to the node as well
+   */
+
+  typedef struct NumaBlockS NumaBlock;
+
+  typedef struct NumaPoolS
+  {
+    int node;
+
+    MUTEX_TYPE mutex;
+    void* freeLists[NUMA_POOL_CLASSES];
+    NumaBlock* blocks;
+    size_t blockUsed;    // bytes carved from the newest block
+
+    Allocator allocator;    // over this pool : the one to give to container init
+  } NumaPool;
+
+  // false without libnuma or NUMA support of the kernel : a single node is reported then
+  EXPORT bool numa_is_available (void);
+  EXPORT int numa_nodes_count (void);
+  EXPORT int numa_current_node (void);    // the node of the calling thread CPU
+
+  // node -1 : the calling thread node, NULL on failure
+  EXPORT NumaPool* numa_pool_create (int node);
+  EXPORT void numa_pool_release (NumaPool* pPool);    // every chunk must be freed already
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // NUMA_POOL_H
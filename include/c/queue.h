@@ -1,6 +1,10 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
+#include "allocator.h"
+#include "latency.h"
+#include "list.h"
+#include "numa_pool.h"
 #include "thread_utils.h"
 
 typedef struct QueueItemS
@@ -8,12 +12,46 @@ typedef struct QueueItemS
   void* data;
   size_t dataSize;
   struct QueueItemS* next;
+  uint64_t enqueueTicks;    // latency_ticks () of the push, 0 if the queue wasn't traced
 } QueueItem;
 
+// CoDel (RFC 8289) : sojourn over target for a whole interval is a standing queue,
+// then the head items are marked or dropped, more often while it stays
+typedef enum QUEUE_CODEL_E
+{
+  QUEUE_CODEL_OFF,
+  QUEUE_CODEL_MARK,    // counted in markedCount, delivered anyway
+  QUEUE_CODEL_DROP,    // counted in droppedCount, released without delivery
+} QUEUE_CODEL;
+
+// sojourn tracing : queue_push stamps items, queue_pop records enqueue-to-dequeue time
+typedef struct QueueTraceS
+{
+  LatencyHistogram sojourn;    // ticks, dropped items included
+
+  QUEUE_CODEL codel;
+  uint64_t targetTicks;
+  uint64_t intervalTicks;
+
+  uint64_t overTargetCount;    // items with sojourn over target
+  uint64_t markedCount;
+  uint64_t droppedCount;
+
+  // CoDel state
+  bool isDropping;
+  uint64_t firstAboveTicks;    // end of the interval over target, 0 if under it
+  uint64_t dropNextTicks;
+  uint32_t dropCount;
+} QueueTrace;
+
 typedef struct QueueS
 {
   QueueItem* head;    // pop from head
   QueueItem* tail;    // push to tail
+
+  QueueTrace* pTrace;    // NULL if not traced
+
+  Heap heap;    // items, their payloads and the trace
 } Queue;
 
 // tread-safety queue
@@ -25,28 +63,54 @@ typedef struct QueueSafeS
   Queue queue;
 } QueueSafe;
 
-#define LIST_ITEM_KEY_SIZE (256)
+// sharded by NUMA node : producers push to the shard of their node, consumers pop the local
+// shard first and take from the other ones when it's empty
+typedef struct QueueNumaS
+{
+  QueueSafe** shards;    // shard i, its items and payloads are on node i % numa_nodes_count ()
+  NumaPool** pools;      // of the shards
+  int shardsCount;
+} QueueNuma;
 
-typedef struct ListItemS
+// intrusive queue : QueueLink is embedded into the user struct, GET_NODE () gets the struct back
+typedef struct QueueLinkS
 {
-  char key[LIST_ITEM_KEY_SIZE];
-  void* data;
-  size_t dataSize;
+  struct QueueLinkS* next;
+} QueueLink;
 
-  struct ListItemS* next;
-  struct ListItemS* prev;
-} ListItem;
+typedef struct QueueIntrusiveS
+{
+  QueueLink* head;    // pop from head
+  QueueLink* tail;    // push to tail
+} QueueIntrusive;
+
+typedef struct QueueIntrusiveSafeS
+{
+  MUTEX_TYPE mutex;
+  CONDITION_TYPE cond;
+
+  QueueIntrusive queue;
+} QueueIntrusiveSafe;
 
 /************************************************************************
  *                                QUEUES                                *
  ************************************************************************/
 bool queue_init (Queue* pQueue);
+bool queue_init_allocator (Queue* pQueue, const Allocator* pAllocator);    // NULL : libc
 void queue_destroy (Queue* pQueue);
 bool queue_push (Queue* pQueue, const void* pItem, const size_t itemSize);
 bool queue_pop (Queue* pQueue, void* pItem, const size_t itemSize);
 bool queue_peek (Queue* pQueue, void* pItem, const size_t itemSize);
 
+// items pushed before are not traced
+bool queue_trace_enable (Queue* pQueue);
+// enables tracing, QUEUE_CODEL_OFF leaves the sojourn histogram only
+bool queue_codel_set (Queue* pQueue, QUEUE_CODEL codel, uint64_t targetNs, uint64_t intervalNs);
+// snapshot : sojourn.ticksPerNs is set for latency_percentile ()
+bool queue_trace_get (Queue* pQueue, QueueTrace* pTrace);
+
 bool concurrent_queue_init (QueueSafe* pQueue);
+bool concurrent_queue_init_allocator (QueueSafe* pQueue, const Allocator* pAllocator);
 void concurrent_queue_destroy (QueueSafe* pQueue);
 bool concurrent_queue_push (QueueSafe* pQueue, const void* pItem, const size_t itemSize);
 bool concurrent_queue_pop (QueueSafe* pQueue, void* pItem, const size_t itemSize,
@@ -54,4 +118,40 @@ bool concurrent_queue_pop (QueueSafe* pQueue, void* pItem, const size_t itemSize
 bool concurrent_queue_peek (QueueSafe* pQueue, void* pItem, const size_t itemSize,
                             const unsigned int asyncWaitMs);
 
+// under the queue lock : a pop missing due to CoDel drops returns false
+bool concurrent_queue_trace_enable (QueueSafe* pQueue);
+bool concurrent_queue_codel_set (QueueSafe* pQueue, QUEUE_CODEL codel, uint64_t targetNs,
+                                 uint64_t intervalNs);
+bool concurrent_queue_trace_get (QueueSafe* pQueue, QueueTrace* pTrace);
+
+/************************************************************************
+ *                              NUMA QUEUES                             *
+ ************************************************************************/
+// shardsCount 0 : one shard per node, more shards than nodes go round the nodes;
+// without libnuma a single node is reported and the shards aren't placed per node
+bool numa_queue_init (QueueNuma* pQueue, int shardsCount);
+void numa_queue_destroy (QueueNuma* pQueue);
+// to the shard of the calling thread node
+bool numa_queue_push (QueueNuma* pQueue, const void* pItem, const size_t itemSize);
+bool numa_queue_push_to (QueueNuma* pQueue, int shard, const void* pItem, const size_t itemSize);
+// the wait is on the local shard only : an item pushed to another one meanwhile is taken
+// after the timeout
+bool numa_queue_pop (QueueNuma* pQueue, void* pItem, const size_t itemSize,
+                     const unsigned int asyncWaitMs);
+
+/************************************************************************
+ *                          INTRUSIVE QUEUES                            *
+ ************************************************************************/
+// no allocation and no copy : the linked object must live until it's popped
+bool intrusive_queue_init (QueueIntrusive* pQueue);
+bool intrusive_queue_push (QueueIntrusive* pQueue, QueueLink* pLink);
+QueueLink* intrusive_queue_pop (QueueIntrusive* pQueue);     // NULL if empty
+QueueLink* intrusive_queue_peek (QueueIntrusive* pQueue);    // NULL if empty
+
+bool concurrent_intrusive_queue_init (QueueIntrusiveSafe* pQueue);
+void concurrent_intrusive_queue_destroy (QueueIntrusiveSafe* pQueue);
+bool concurrent_intrusive_queue_push (QueueIntrusiveSafe* pQueue, QueueLink* pLink);
+QueueLink* concurrent_intrusive_queue_pop (QueueIntrusiveSafe* pQueue,
+                                           const unsigned int asyncWaitMs);
+
 #endif    // QUEUE_H
\ No newline at end of file
@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -10,6 +13,7 @@ extern "C"
 #endif
 
   #define RBT_KEY_SIZE (256)
+  #define RBT_INLINE_DATA_SIZE (16)    // payloads up to this size are kept in the node itself
 
   typedef enum COLOR_E
   {
@@ -20,22 +24,107 @@ extern "C"
   typedef struct RBTNodeS
   {
     char key[RBT_KEY_SIZE];
-    void* data;
+    void* data;    // inlineData, pool slot or own allocation
+    size_t dataSize;
+    size_t dataCapacity;    // payload can be updated in place up to this size
+
+    uint64_t keyPrefix;    // first key bytes in big-endian order, compared before the key itself
+    size_t keyLength;
+    size_t size;    // nodes count of the subtree rooted at this node, 0 for NIL
 
     COLOR color;
+    unsigned int poolSlot;    // 0 = allocated alone, otherwise 1-based index in contiguous block
+    char inlineData[RBT_INLINE_DATA_SIZE];    // pointer-aligned
+    bool isDataOwned;    // data is a separate allocation released together with the node
+    Heap* pHeap;         // the node and its data memory, NULL : libc
 
     struct RBTNodeS* left;
     struct RBTNodeS* right;
     struct RBTNodeS* parent;
   } RBTNode;
 
+  /* a tree with own allocator and memory counters : the rbt_* functions work on root,
+   * the rbt_tree_* creating functions take nodes from the heap
+   *
+   * > every node is released to the heap it came from : rbt_delete, rbt_destroy work as usual
+   * > a contiguous bulk block is one heap allocation, returned with its last node
+   * > nodes created by the plain rbt_* functions are libc ones, they aren't counted
+   * > last is the rightmost node : rbt_tree_insert compares an ascending key with it only,
+   *   the other rbt_tree_* functions keep it valid, the plain rbt_* ones on root don't
+   */
+  typedef struct RBTreeS
+  {
+    RBTNode* root;
+    RBTNode* last;
+    Heap heap;
+  } RBTree;
+
+  // return false to stop scanning
+  typedef bool (*RBTScanCallback) (const RBTNode* pNode, void* pContext);
+  // combine the new item into the existing payload in place
+  typedef void (*RBTMergeCallback) (void* pData, size_t dataSize, const void* pItem,
+                                    size_t itemSize, void* pContext);
+
   EXPORT bool is_NIL_same (RBTNode* pNIL);
   EXPORT bool rbt_destroy (RBTNode** pRoot);
+  EXPORT bool rbt_destroy_parallel (RBTNode** pRoot, unsigned int threadsCount);    // huge trees
   EXPORT bool rbt_insert (RBTNode** pRoot, void* pItem, size_t itemSize, const char* key);
+  // itemSize is the buffer size : false if the stored payload doesn't fit it
   EXPORT bool rbt_get (RBTNode* pRoot, void* pItem, size_t itemSize, const char* key);
-  
+  // insert, or merge into the existing payload by one search : NULL merge replaces the payload,
+  // the node storage is reused when the new payload fits it
+  EXPORT bool rbt_upsert (RBTNode** pRoot, void* pItem, size_t itemSize, const char* key,
+                          RBTMergeCallback merge, void* pContext);
+  // pHint is a tree node adjacent to the key place : the place is found by two key compares
+  // and a neighbour step instead of the O(log n) compares of the descent; a hint which isn't
+  // adjacent costs the full search. The neighbour step and the subtree sizes update still
+  // walk links up to O(log n) : the maximum node hint climbs the whole right spine
+  EXPORT RBTNode* rbt_insert_hint (RBTNode** pRoot, RBTNode* pHint, void* pItem, size_t itemSize,
+                                   const char* key);
+  EXPORT bool rbt_delete (RBTNode** pRoot, const char* key);
+
+  EXPORT bool rbt_tree_init (RBTree* pTree, const Allocator* pAllocator);    // NULL : libc
+  EXPORT bool rbt_tree_insert (RBTree* pTree, void* pItem, size_t itemSize, const char* key);
+  EXPORT bool rbt_tree_upsert (RBTree* pTree, void* pItem, size_t itemSize, const char* key,
+                               RBTMergeCallback merge, void* pContext);
+  EXPORT RBTNode* rbt_tree_insert_hint (RBTree* pTree, RBTNode* pHint, void* pItem,
+                                        size_t itemSize, const char* key);
+  EXPORT bool rbt_tree_delete (RBTree* pTree, const char* key);
+  EXPORT bool rbt_tree_destroy (RBTree* pTree);
+
+  // bulk loading: keys must be strictly ascending, items is an array of 'count' items
+  EXPORT bool rbt_build_from_sorted (RBTNode** pRoot, const char* const* keys, const void* items,
+                                     size_t itemSize, size_t count, bool isContiguous);
+  EXPORT bool rbt_merge_sorted (RBTNode** pRoot, const char* const* keys, const void* items,
+                                size_t itemSize, size_t count, unsigned int threadsCount);
+  EXPORT bool rbt_tree_build_from_sorted (RBTree* pTree, const char* const* keys,
+                                          const void* items, size_t itemSize, size_t count,
+                                          bool isContiguous);
+  EXPORT bool rbt_tree_merge_sorted (RBTree* pTree, const char* const* keys, const void* items,
+                                     size_t itemSize, size_t count, unsigned int threadsCount);
+
+  // in-order iteration: NULL is returned when there is no such node
+  EXPORT RBTNode* rbt_first (RBTNode* pRoot);
+  EXPORT RBTNode* rbt_last (RBTNode* pRoot);
+  EXPORT RBTNode* rbt_next (RBTNode* pNode);
+  EXPORT RBTNode* rbt_prev (RBTNode* pNode);
+  EXPORT RBTNode* rbt_lower_bound (RBTNode* pRoot, const char* key);    // first key >= key
+  EXPORT RBTNode* rbt_upper_bound (RBTNode* pRoot, const char* key);    // first key >  key
+
+  // [keyFrom, keyTo) in ascending order, NULL bound = unbounded
+  EXPORT bool rbt_scan_range (RBTNode* pRoot, const char* keyFrom, const char* keyTo,
+                              RBTScanCallback callback, void* pContext);
+  EXPORT bool rbt_scan_prefix (RBTNode* pRoot, const char* prefix, RBTScanCallback callback,
+                               void* pContext);
+
+  // zero-copy view of the payload : valid until the node is updated or deleted
+  EXPORT bool rbt_get_ref (RBTNode* pRoot, const char* key, const void** ppData, size_t* pSize);
+
+  // order statistics in O(log n) : index is 0-based, rank is the count of keys < key
+  EXPORT RBTNode* rbt_select (RBTNode* pRoot, size_t index);
+  EXPORT bool rbt_rank (RBTNode* pRoot, const char* key, size_t* pRank);
+
   // EXPORT bool rbt_init(RBTNode* pRoot);                          // no need without thread-safety approach
-  // EXPORT bool rbt_delete (RBTNode** pRoot, const char* key);     // not debugged yet
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,71 @@
+#ifndef __RBTREE_INTRUSIVE__
+#define __RBTREE_INTRUSIVE__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "list.h"    // GET_NODE ()
+#include "rb_tree.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /* intrusive red-black tree : RBTLink lives inside the user struct together with the key,
+   * the tree never allocates and never copies, GET_NODE () gets the user struct back
+   *
+   *   typedef struct SessionS
+   *   {
+   *     uint64_t id;
+   *     RBTLink byId;
+   *     QueueLink expired;    // the same object may be queued at the same time
+   *   } Session;
+   *
+   *   int compare_session (const RBTLink* pLink, const void* key)
+   *   {
+   *     uint64_t id = GET_NODE (pLink, Session, byId)->id;
+   *     return (id > *(const uint64_t*)key) - (id < *(const uint64_t*)key);
+   *   }
+   */
+
+  typedef struct RBTLinkS
+  {
+    COLOR color;
+
+    struct RBTLinkS* left;
+    struct RBTLinkS* right;
+    struct RBTLinkS* parent;
+  } RBTLink;
+
+  // key of the linked object vs searched key : < 0, 0, > 0
+  typedef int (*RBTLinkCompare) (const RBTLink* pLink, const void* key);
+
+  typedef struct RBTIntrusiveS
+  {
+    RBTLink* root;
+    RBTLinkCompare compare;
+  } RBTIntrusive;
+
+  EXPORT bool rbt_intrusive_init (RBTIntrusive* pTree, RBTLinkCompare compare);
+  EXPORT void rbt_intrusive_clear (RBTIntrusive* pTree);    // objects are unlinked, not freed
+
+  // key is the key of the linked object : false if such key is already in the tree
+  EXPORT bool rbt_intrusive_insert (RBTIntrusive* pTree, RBTLink* pLink, const void* key);
+  EXPORT RBTLink* rbt_intrusive_find (const RBTIntrusive* pTree, const void* key);
+  EXPORT void rbt_intrusive_remove (RBTIntrusive* pTree, RBTLink* pLink);    // no search
+  EXPORT bool rbt_intrusive_is_linked (const RBTLink* pLink);    // zeroed link is not linked
+
+  // NULL for empty tree or the end of iteration
+  EXPORT RBTLink* rbt_intrusive_first (const RBTIntrusive* pTree);
+  EXPORT RBTLink* rbt_intrusive_last (const RBTIntrusive* pTree);
+  EXPORT RBTLink* rbt_intrusive_next (RBTLink* pLink);
+  EXPORT RBTLink* rbt_intrusive_prev (RBTLink* pLink);
+  EXPORT RBTLink* rbt_intrusive_lower_bound (const RBTIntrusive* pTree, const void* key);
+  EXPORT RBTLink* rbt_intrusive_upper_bound (const RBTIntrusive* pTree, const void* key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __RBTREE_INTRUSIVE__
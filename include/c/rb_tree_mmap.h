@@ -0,0 +1,59 @@
+#ifndef __RBTREE_MMAP__
+#define __RBTREE_MMAP__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rb_tree.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /* persistent red-black tree : nodes live in a memory-mapped file and refer to each other
+   * by offsets from the file start, so the file is valid at any mapping address
+   *
+   * > offset 0 is the shared NIL sentinel, it is placed at the start of the file header
+   * > reopening is just mmap, pages are read on demand
+   * > changes are durable after rbt_mmap_checkpoint () or rbt_mmap_close ()
+   * > a file changed after the last checkpoint and not closed (crash) is refused by open
+   * > node pointers are valid until the next insertion : the file may be remapped to grow
+   * > there is no allocator to plug in : nodes are carved from the file, so the memory
+   *   the tree holds is 'mappedSize' of the page cache
+   */
+
+  typedef uint64_t RBTOffset;
+  typedef struct RBTMmapNodeS RBTMmapNode;
+
+  typedef struct RBTMmapS
+  {
+    int fd;
+    char* base;
+    size_t mappedSize;
+  } RBTMmap;
+
+  EXPORT bool rbt_mmap_open (RBTMmap* pTree, const char* path, size_t initialSize);
+  EXPORT bool rbt_mmap_close (RBTMmap* pTree);
+  EXPORT bool rbt_mmap_checkpoint (RBTMmap* pTree);
+
+  EXPORT bool rbt_mmap_insert (RBTMmap* pTree, const void* pItem, size_t itemSize,
+                               const char* key);
+  // itemSize is the buffer size : false if the stored payload doesn't fit it
+  EXPORT bool rbt_mmap_get (const RBTMmap* pTree, void* pItem, size_t itemSize, const char* key);
+  EXPORT size_t rbt_mmap_count (const RBTMmap* pTree);
+
+  // in-order iteration: NULL is returned when there is no such node
+  EXPORT RBTMmapNode* rbt_mmap_first (const RBTMmap* pTree);
+  EXPORT RBTMmapNode* rbt_mmap_next (const RBTMmap* pTree, const RBTMmapNode* pNode);
+  EXPORT RBTMmapNode* rbt_mmap_lower_bound (const RBTMmap* pTree, const char* key);
+  EXPORT const char* rbt_mmap_key (const RBTMmapNode* pNode);
+  EXPORT void* rbt_mmap_data (const RBTMmapNode* pNode);
+  EXPORT size_t rbt_mmap_data_size (const RBTMmapNode* pNode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __RBTREE_MMAP__
@@ -0,0 +1,48 @@
+#ifndef __RBTREE_STREAM__
+#define __RBTREE_STREAM__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rb_tree.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /* binary snapshot of the tree contents:
+   *
+   *   header  : magic, version, count, itemSize
+   *   records : in-order [ keyLength u32 | key | payloadLength u32 | payload ]
+   *   trailer : CRC-32C of all the bytes above
+   *
+   * > the snapshot goes through the caller buffer in 'bufferSize' chunks,
+   *   so neither side needs the whole snapshot in memory
+   * > loading verifies the checksum before building the tree by the linear bulk build,
+   *   the tree is left empty on any error
+   * > all payloads are 'itemSize' bytes : the bulk build takes one payload size
+   * > integers are in the host byte order, magic mismatch rejects the foreign one
+   */
+
+  #define RBT_STREAM_CHUNK_SIZE ((size_t)1 << 16)    // buffer size of the fd variants
+
+  // write the whole chunk, false to stop dumping
+  typedef bool (*RBTStreamWrite) (const void* pChunk, size_t size, void* pContext);
+  // read up to 'size' bytes, 0 = end of stream or error
+  typedef size_t (*RBTStreamRead) (void* pChunk, size_t size, void* pContext);
+
+  EXPORT bool rbt_dump (RBTNode* pRoot, size_t itemSize, void* pBuffer, size_t bufferSize,
+                        RBTStreamWrite writeChunk, void* pContext);
+  EXPORT bool rbt_load (RBTNode** pRoot, size_t itemSize, void* pBuffer, size_t bufferSize,
+                        RBTStreamRead readChunk, void* pContext);
+
+  EXPORT bool rbt_dump_fd (RBTNode* pRoot, size_t itemSize, int fd);
+  EXPORT bool rbt_load_fd (RBTNode** pRoot, size_t itemSize, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __RBTREE_STREAM__
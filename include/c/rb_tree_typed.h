@@ -0,0 +1,101 @@
+#ifndef __RBTREE_TYPED__
+#define __RBTREE_TYPED__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rb_tree.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // the same red-black tree for non-string keys : integer and fixed-length binary
+
+  typedef struct RBTU64NodeS
+  {
+    uint64_t key;
+    void* data;
+    size_t dataSize;
+    Heap* pHeap;    // the node and its data memory, NULL : libc
+
+    COLOR color;
+
+    struct RBTU64NodeS* left;
+    struct RBTU64NodeS* right;
+    struct RBTU64NodeS* parent;
+  } RBTU64Node;
+
+  typedef struct RBTBinNodeS
+  {
+    void* data;
+    size_t dataSize;
+    Heap* pHeap;    // the node and its data memory, NULL : libc
+
+    COLOR color;
+    unsigned int keySize;    // the same for all nodes of a tree
+
+    struct RBTBinNodeS* left;
+    struct RBTBinNodeS* right;
+    struct RBTBinNodeS* parent;
+
+    unsigned char key[];    // compared with memcmp()
+  } RBTBinNode;
+
+  // trees with own allocator and memory counters, the same as RBTree
+  typedef struct RBTU64TreeS
+  {
+    RBTU64Node* root;
+    Heap heap;
+  } RBTU64Tree;
+
+  typedef struct RBTBinTreeS
+  {
+    RBTBinNode* root;
+    Heap heap;
+  } RBTBinTree;
+
+  EXPORT bool is_u64_NIL_same (RBTU64Node* pNIL);
+  EXPORT bool rbt_u64_destroy (RBTU64Node** pRoot);
+  EXPORT bool rbt_u64_insert (RBTU64Node** pRoot, void* pItem, size_t itemSize, uint64_t key);
+  // itemSize is the buffer size : false if the stored payload doesn't fit it
+  EXPORT bool rbt_u64_get (RBTU64Node* pRoot, void* pItem, size_t itemSize, uint64_t key);
+  EXPORT bool rbt_u64_delete (RBTU64Node** pRoot, uint64_t key);
+
+  EXPORT bool rbt_u64_tree_init (RBTU64Tree* pTree, const Allocator* pAllocator);    // NULL : libc
+  EXPORT bool rbt_u64_tree_insert (RBTU64Tree* pTree, void* pItem, size_t itemSize, uint64_t key);
+
+  EXPORT RBTU64Node* rbt_u64_first (RBTU64Node* pRoot);
+  EXPORT RBTU64Node* rbt_u64_last (RBTU64Node* pRoot);
+  EXPORT RBTU64Node* rbt_u64_next (RBTU64Node* pNode);
+  EXPORT RBTU64Node* rbt_u64_prev (RBTU64Node* pNode);
+  EXPORT RBTU64Node* rbt_u64_lower_bound (RBTU64Node* pRoot, uint64_t key);
+  EXPORT RBTU64Node* rbt_u64_upper_bound (RBTU64Node* pRoot, uint64_t key);
+
+  EXPORT bool is_bin_NIL_same (RBTBinNode* pNIL);
+  EXPORT bool rbt_bin_destroy (RBTBinNode** pRoot);
+  EXPORT bool rbt_bin_insert (RBTBinNode** pRoot, void* pItem, size_t itemSize, const void* key,
+                              size_t keySize);
+  // itemSize is the buffer size : false if the stored payload doesn't fit it
+  EXPORT bool rbt_bin_get (RBTBinNode* pRoot, void* pItem, size_t itemSize, const void* key,
+                           size_t keySize);
+  EXPORT bool rbt_bin_delete (RBTBinNode** pRoot, const void* key, size_t keySize);
+
+  EXPORT bool rbt_bin_tree_init (RBTBinTree* pTree, const Allocator* pAllocator);    // NULL : libc
+  EXPORT bool rbt_bin_tree_insert (RBTBinTree* pTree, void* pItem, size_t itemSize,
+                                   const void* key, size_t keySize);
+
+  EXPORT RBTBinNode* rbt_bin_first (RBTBinNode* pRoot);
+  EXPORT RBTBinNode* rbt_bin_last (RBTBinNode* pRoot);
+  EXPORT RBTBinNode* rbt_bin_next (RBTBinNode* pNode);
+  EXPORT RBTBinNode* rbt_bin_prev (RBTBinNode* pNode);
+  EXPORT RBTBinNode* rbt_bin_lower_bound (RBTBinNode* pRoot, const void* key, size_t keySize);
+  EXPORT RBTBinNode* rbt_bin_upper_bound (RBTBinNode* pRoot, const void* key, size_t keySize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __RBTREE_TYPED__
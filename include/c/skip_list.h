@@ -0,0 +1,59 @@
+#ifndef __SKIP_LIST__
+#define __SKIP_LIST__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "thread_utils.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  #define SL_KEY_SIZE (256)
+  #define SL_MAX_LEVEL (32)
+
+  /* concurrent ordered map (lazy skip list) : the same key/data semantics as rb_tree.h
+   *
+   * > sl_get and scans take no locks, writers lock only the predecessors of the changed node
+   * > scans are weakly consistent : keys present for the whole scan are visited once in order
+   * > deleted nodes are unlinked at once and released by epochs,
+   *   once no lock-free reader may still be on them
+   */
+
+  typedef struct SkipListNodeS SkipListNode;
+
+  typedef struct SkipListS
+  {
+    SkipListNode* head;
+    SmrDomain smr;    // unlinked nodes waiting for release
+    int level;    // highest level in use
+    size_t count;
+    Heap heap;    // nodes, released by the reclaiming thread : the allocator must be thread safe
+  } SkipList;
+
+  // return false to stop scanning
+  typedef bool (*SkipListScanCallback) (const char* key, const void* pData, size_t dataSize,
+                                        void* pContext);
+
+  EXPORT bool sl_init (SkipList* pList);
+  EXPORT bool sl_init_allocator (SkipList* pList, const Allocator* pAllocator);    // NULL : libc
+  EXPORT void sl_destroy (SkipList* pList);
+  EXPORT bool sl_insert (SkipList* pList, void* pItem, size_t itemSize, const char* key);
+  // itemSize is the buffer size : false if the stored payload doesn't fit it
+  EXPORT bool sl_get (SkipList* pList, void* pItem, size_t itemSize, const char* key);
+  EXPORT bool sl_delete (SkipList* pList, const char* key);
+  EXPORT size_t sl_count (SkipList* pList);
+
+  // [keyFrom, keyTo) in ascending order, NULL bound = unbounded
+  EXPORT bool sl_scan_range (SkipList* pList, const char* keyFrom, const char* keyTo,
+                             SkipListScanCallback callback, void* pContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // __SKIP_LIST__
@@ -3,6 +3,8 @@
 
 #include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define NS_PER_MS 	(1000000ULL)
 #define NS_PER_SEC  (1000000000ULL)
@@ -24,16 +26,12 @@
 #define SIGNAL_CONDITION(cond) pthread_cond_signal(&(cond))
 #define BROADCAST_CONDITION(cond) pthread_cond_broadcast(&(cond))
 
-/* TENPORARILY UNUSED 
-
 // thread
 #define THREAD_ROUTINE(func_name, pArg) void* func_name(void* pArg)
 #define THREAD_ROUTINE_RET_CODE() NULL
 #define CREATE_THREAD(thread, pFunc, pArg) pthread_create(&thread, NULL, pFunc, (void*)(pArg))
 #define JOIN_THREAD(thread)	pthread_join(thread, NULL)
 
-*/
-
 // clang-format off
 #define GENERATE_TIMESPEC(deltaMs)                        							\
 		struct timespec ts = { 0 }; 																				\
@@ -43,6 +41,43 @@
 		ts.tv_nsec = TARGET_NS % NS_PER_SEC;
 // clang-format on
 
+// safe memory reclamation
+#define SMR_MAX_RECORDS	(128)	// critical sections of one domain at the same time
+#define SMR_HAZARDS			(4)		// hazard pointers per critical section
+#define SMR_SCAN_THRESHOLD	(64)	// retired nodes of a record before reclamation is tried
+
+/* safe memory reclamation : a node unlinked from a lock-free container is retired,
+ * and released by the domain 'reclaim' callback when no thread can be reading it
+ *
+ * > every container operation runs inside smr_enter / smr_exit, the record is owned
+ *   by the caller until smr_exit, so nested critical sections are allowed
+ * > SMR_EPOCH  : entering publishes the global epoch, a node retired at epoch E is released
+ *                when the epoch reaches E + 2, i.e. every reader of E has left.
+ *                Reads are free, but a stalled reader holds all the memory retired after it
+ * > SMR_HAZARD : a reader publishes every node it's going to dereference by smr_protect,
+ *                a retired node is released when no hazard pointer refers to it.
+ *                Reads pay a fence per node, retired memory is bounded
+ */
+typedef enum SMR_MODE_E
+{
+	SMR_EPOCH,
+	SMR_HAZARD,
+} SMR_MODE;
+
+typedef void (*SmrReclaim)(void* pNode, void* pContext);
+
+typedef struct SmrRecordS SmrRecord;
+
+typedef struct SmrDomainS
+{
+	SMR_MODE mode;
+	uint64_t epoch;			// global epoch, atomic
+	SmrRecord* records;		// SMR_MAX_RECORDS
+
+	SmrReclaim reclaim;
+	void* pContext;
+} SmrDomain;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -59,6 +94,16 @@ extern "C" {
 	bool condition_broadcast(CONDITION_TYPE* cond);
 	bool condition_wait(CONDITION_TYPE* cond, MUTEX_TYPE* mutex, unsigned int timeoutMs);
 
+	bool smr_init(SmrDomain* pDomain, SMR_MODE mode, SmrReclaim reclaim, void* pContext);
+	void smr_destroy(SmrDomain* pDomain);	// releases all retired nodes, no concurrent access
+	SmrRecord* smr_enter(SmrDomain* pDomain);
+	void smr_exit(SmrDomain* pDomain, SmrRecord* pRecord);
+	// loads *pLink and keeps it from release until smr_exit, the low bit (mark) is ignored
+	void* smr_protect(SmrDomain* pDomain, SmrRecord* pRecord, int slot, void* const* pLink);
+	// the node must be unlinked already : new readers can't reach it
+	void smr_retire(SmrDomain* pDomain, SmrRecord* pRecord, void* pNode);
+	void smr_reclaim(SmrDomain* pDomain, SmrRecord* pRecord);	// try to release retired nodes now
+
 #ifdef __cplusplus
 }
 #endif
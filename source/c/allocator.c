@@ -0,0 +1,112 @@
+#include <stdlib.h>
+
+#include "../../include/c/allocator.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+static void* libc_alloc (size_t size, void* pContext);
+static void libc_free (void* pMemory, size_t size, void* pContext);
+
+static const Allocator LIBC_ALLOCATOR = { libc_alloc, libc_free, NULL };
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+const Allocator* allocator_libc (void)
+{
+  return &LIBC_ALLOCATOR;
+}
+
+bool heap_init (Heap* pHeap, const Allocator* pAllocator)
+{
+  bool result = false;
+
+  do
+  {
+    if (pHeap == NULL)
+    {
+      break;
+    }
+
+    if (pAllocator == NULL)
+    {
+      pAllocator = &LIBC_ALLOCATOR;
+    }
+
+    if (pAllocator->alloc == NULL || pAllocator->free == NULL)
+    {
+      break;
+    }
+
+    pHeap->allocator = *pAllocator;
+    pHeap->bytes = 0;
+    pHeap->allocations = 0;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void* heap_alloc (Heap* pHeap, size_t size)
+{
+  void* pMemory = NULL;
+
+  if (pHeap == NULL)
+  {
+    pMemory = malloc (size);
+  }
+  else if ((pMemory = pHeap->allocator.alloc (size, pHeap->allocator.pContext)) != NULL)
+  {
+    __atomic_add_fetch (&pHeap->bytes, size, __ATOMIC_RELAXED);
+    __atomic_add_fetch (&pHeap->allocations, 1, __ATOMIC_RELAXED);
+  }
+
+  return pMemory;
+}
+
+void heap_free (Heap* pHeap, void* pMemory, size_t size)
+{
+  if (pHeap == NULL)
+  {
+    free (pMemory);
+  }
+  else if (pMemory != NULL)
+  {
+    pHeap->allocator.free (pMemory, size, pHeap->allocator.pContext);
+
+    __atomic_sub_fetch (&pHeap->bytes, size, __ATOMIC_RELAXED);
+    __atomic_sub_fetch (&pHeap->allocations, 1, __ATOMIC_RELAXED);
+  }
+}
+
+size_t heap_bytes (const Heap* pHeap)
+{
+  return (pHeap != NULL) ? __atomic_load_n (&pHeap->bytes, __ATOMIC_RELAXED) : 0;
+}
+
+size_t heap_allocations (const Heap* pHeap)
+{
+  return (pHeap != NULL) ? __atomic_load_n (&pHeap->allocations, __ATOMIC_RELAXED) : 0;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+void* libc_alloc (size_t size, void* pContext)
+{
+  return malloc (size);
+}
+
+void libc_free (void* pMemory, size_t size, void* pContext)
+{
+  free (pMemory);
+}
@@ -0,0 +1,908 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/c/bp_tree.h"
+#include "../../include/c/key_utils.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define BPT_MAX_KEYS (16)    // prefixes of a node take two cache lines
+#define BPT_MIN_KEYS ((BPT_MAX_KEYS - 1) / 2)    // any node except the root
+#define BPT_MAX_HEIGHT (32)
+
+#define BPT_ALIGNMENT (_Alignof (max_align_t))
+#define BPT_ALIGN_UP(size) (((size) + BPT_ALIGNMENT - 1) & ~(BPT_ALIGNMENT - 1))
+
+// leaf entry : key and payload in one allocation
+typedef struct BPTItemS
+{
+  void* data;
+  size_t dataSize;
+  char key[];
+} BPTItem;
+
+struct BPTNodeS
+{
+  uint64_t prefixes[BPT_MAX_KEYS];    // searched first, keys are touched on prefix ties only
+  char* keys[BPT_MAX_KEYS];           // leaf : keys of items, internal : separators buffers
+
+  union
+  {
+    struct BPTNodeS* children[BPT_MAX_KEYS + 1];
+    BPTItem* items[BPT_MAX_KEYS];
+  };
+
+  struct BPTNodeS* next;    // leaves only : linked in keys order
+  unsigned int count;
+  bool isLeaf;
+};
+
+// searched key : length and prefix are computed once per call
+typedef struct KeyInfoS
+{
+  const char* key;
+  size_t length;
+  uint64_t prefix;
+} KeyInfo;
+
+// key and node which are pushed up to the parent after split
+typedef struct SplitS
+{
+  uint64_t prefix;
+  char* key;
+  BPTNode* pRight;
+} Split;
+
+// path from the root to the leaf
+typedef struct PathS
+{
+  BPTNode* nodes[BPT_MAX_HEIGHT];
+  unsigned int indices[BPT_MAX_HEIGHT];    // child index taken in every node
+  unsigned int depth;
+} Path;
+
+static bool bpt_key_info (const char* key, KeyInfo* pKey);
+static int bpt_key_compare (uint64_t prefix, const char* key, const KeyInfo* pKey);
+static unsigned int bpt_search (const BPTNode* pNode, const KeyInfo* pKey, bool* pIsFound);
+static BPTNode* bpt_find_leaf (BPTNode* pRoot, const KeyInfo* pKey, Path* pPath);
+static BPTNode* bpt_create_node (Heap* pHeap, bool isLeaf);
+static BPTItem* bpt_create_item (Heap* pHeap, const void* pItem, size_t itemSize,
+                                 const KeyInfo* pKey);
+static void bpt_release_item (Heap* pHeap, BPTItem* pItem);
+static void bpt_insert_leaf (BPTNode* pLeaf, unsigned int index, uint64_t prefix, BPTItem* pItem);
+static void bpt_insert_internal (BPTNode* pNode, unsigned int index, const Split* pSplit);
+static void bpt_split_leaf (BPTNode* pLeaf, unsigned int index, uint64_t prefix, BPTItem* pItem,
+                            BPTNode* pRight, char* separator, Split* pSplit);
+static void bpt_split_internal (BPTNode* pNode, unsigned int index, Split* pSplit,
+                                BPTNode* pRight);
+static void bpt_remove_leaf (Heap* pHeap, BPTNode* pLeaf, unsigned int index);
+static void bpt_rebalance (Heap* pHeap, BPTNode* pParent, unsigned int index);
+static void bpt_borrow_left (BPTNode* pParent, unsigned int index);
+static void bpt_borrow_right (BPTNode* pParent, unsigned int index);
+static void bpt_merge (Heap* pHeap, BPTNode* pParent, unsigned int index);
+static void bpt_free_memory (Heap* pHeap, BPTNode* pNode);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool bpt_init (BPTree* pTree)
+{
+  return bpt_init_allocator (pTree, NULL);
+}
+
+bool bpt_init_allocator (BPTree* pTree, const Allocator* pAllocator)
+{
+  if (pTree != NULL && heap_init (&pTree->heap, pAllocator))
+  {
+    pTree->root = NULL;
+    pTree->count = 0;
+
+    return true;
+  }
+
+  return false;
+}
+
+void bpt_destroy (BPTree* pTree)
+{
+  if (pTree != NULL && pTree->root != NULL)
+  {
+    bpt_free_memory (&pTree->heap, pTree->root);
+
+    pTree->root = NULL;
+    pTree->count = 0;
+  }
+}
+
+bool bpt_insert (BPTree* pTree, void* pItem, size_t itemSize, const char* key)
+{
+  /* everything split might need is allocated before the tree is modified:
+   * one node per full node on the path bottom-up, one more for the new root
+   * and the separator buffer when the leaf is full
+   */
+
+  bool result = false;
+  KeyInfo keyInfo;
+  Path path;
+  BPTNode* spares[BPT_MAX_HEIGHT + 1] = { NULL };
+  unsigned int sparesCount = 0;
+  char* separator = NULL;
+  BPTItem* pNew = NULL;
+
+  do
+  {
+    if (pTree == NULL || pItem == NULL || !bpt_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    if (pTree->root == NULL)
+    {
+      pTree->root = bpt_create_node (&pTree->heap, true);
+      if (pTree->root == NULL)
+      {
+        break;
+      }
+    }
+
+    bool isFound = false;
+    BPTNode* pLeaf = bpt_find_leaf (pTree->root, &keyInfo, &path);
+    unsigned int index = bpt_search (pLeaf, &keyInfo, &isFound);
+
+    if (isFound)    // node with such key already exists
+    {
+      break;
+    }
+
+    // splits go up while nodes are full
+    unsigned int splitsCount = 0;
+    BPTNode* pNode = pLeaf;
+    unsigned int depth = path.depth;
+
+    while (pNode != NULL && pNode->count == BPT_MAX_KEYS)
+    {
+      ++splitsCount;
+      pNode = (depth > 0) ? path.nodes[--depth] : NULL;
+    }
+
+    unsigned int needed = splitsCount + ((pNode == NULL) ? 1 : 0);
+    bool isAllocated = true;
+
+    for (sparesCount = 0; isAllocated && sparesCount < needed; ++sparesCount)
+    {
+      spares[sparesCount]
+          = bpt_create_node (&pTree->heap, sparesCount == 0 && pLeaf->count == BPT_MAX_KEYS);
+      isAllocated = (spares[sparesCount] != NULL);
+    }
+
+    if (isAllocated && splitsCount > 0)
+    {
+      separator = (char*)heap_alloc (&pTree->heap, BPT_KEY_SIZE);
+      isAllocated = (separator != NULL);
+    }
+
+    if (isAllocated)
+    {
+      pNew = bpt_create_item (&pTree->heap, pItem, itemSize, &keyInfo);
+      isAllocated = (pNew != NULL);
+    }
+
+    if (!isAllocated)
+    {
+      break;
+    }
+
+    // leaf
+    Split split;
+    unsigned int spareIndex = 0;
+
+    if (splitsCount == 0)
+    {
+      bpt_insert_leaf (pLeaf, index, keyInfo.prefix, pNew);
+    }
+    else
+    {
+      bpt_split_leaf (pLeaf, index, keyInfo.prefix, pNew, spares[spareIndex++], separator,
+                      &split);
+      separator = NULL;
+
+      // internal nodes
+      depth = path.depth;
+      while (spareIndex < splitsCount)
+      {
+        --depth;
+        bpt_split_internal (path.nodes[depth], path.indices[depth], &split,
+                            spares[spareIndex++]);
+      }
+
+      if (depth > 0)    // the first not full node takes pushed up key
+      {
+        --depth;
+        bpt_insert_internal (path.nodes[depth], path.indices[depth], &split);
+      }
+      else    // the root was split
+      {
+        BPTNode* pRoot = spares[spareIndex++];
+
+        pRoot->prefixes[0] = split.prefix;
+        pRoot->keys[0] = split.key;
+        pRoot->children[0] = pTree->root;
+        pRoot->children[1] = split.pRight;
+        pRoot->count = 1;
+
+        pTree->root = pRoot;
+      }
+    }
+
+    sparesCount = 0;    // all are in use
+    pNew = NULL;
+    ++pTree->count;
+
+    result = true;
+
+  } while (0);
+
+  // cleanup when insertion is failed
+  while (sparesCount-- > 0)
+  {
+    heap_free (&pTree->heap, spares[sparesCount], sizeof (BPTNode));
+  }
+
+  if (separator != NULL)
+  {
+    heap_free (&pTree->heap, separator, BPT_KEY_SIZE);
+  }
+
+  if (pNew != NULL)
+  {
+    bpt_release_item (&pTree->heap, pNew);
+  }
+
+  if (!result && pTree != NULL && pTree->root != NULL && pTree->root->count == 0)
+  {
+    heap_free (&pTree->heap, pTree->root, sizeof (BPTNode));
+    pTree->root = NULL;
+  }
+
+  return result;
+}
+
+bool bpt_get (BPTree* pTree, void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (pTree == NULL || pItem == NULL || pTree->root == NULL || !bpt_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    bool isFound = false;
+    BPTNode* pLeaf = bpt_find_leaf (pTree->root, &keyInfo, NULL);
+    unsigned int index = bpt_search (pLeaf, &keyInfo, &isFound);
+
+    if (!isFound || pLeaf->items[index]->dataSize > itemSize)    // or doesn't fit
+    {
+      break;
+    }
+
+    memcpy (pItem, pLeaf->items[index]->data, pLeaf->items[index]->dataSize);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool bpt_delete (BPTree* pTree, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+  Path path;
+
+  do
+  {
+    if (pTree == NULL || pTree->root == NULL || !bpt_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    bool isFound = false;
+    BPTNode* pLeaf = bpt_find_leaf (pTree->root, &keyInfo, &path);
+    unsigned int index = bpt_search (pLeaf, &keyInfo, &isFound);
+
+    if (!isFound)
+    {
+      break;
+    }
+
+    bpt_remove_leaf (&pTree->heap, pLeaf, index);
+
+    // underflow goes up while parents lose keys because of merging
+    BPTNode* pNode = pLeaf;
+    unsigned int depth = path.depth;
+
+    while (depth > 0 && pNode->count < BPT_MIN_KEYS)
+    {
+      --depth;
+      bpt_rebalance (&pTree->heap, path.nodes[depth], path.indices[depth]);
+      pNode = path.nodes[depth];
+    }
+
+    // the root is allowed to have any keys count but not zero
+    BPTNode* pRoot = pTree->root;
+    if (pRoot->count == 0)
+    {
+      pTree->root = pRoot->isLeaf ? NULL : pRoot->children[0];
+      heap_free (&pTree->heap, pRoot, sizeof (BPTNode));
+    }
+
+    --pTree->count;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool bpt_scan_range (BPTree* pTree, const char* keyFrom, const char* keyTo,
+                     BPTScanCallback callback, void* pContext)
+{
+  bool result = false;
+  KeyInfo fromInfo = { NULL, 0, 0 };    // set only for bounded range
+  KeyInfo toInfo = { NULL, 0, 0 };
+
+  do
+  {
+    if (pTree == NULL || callback == NULL)
+    {
+      break;
+    }
+
+    if ((keyFrom != NULL && !bpt_key_info (keyFrom, &fromInfo))
+        || (keyTo != NULL && !bpt_key_info (keyTo, &toInfo)))
+    {
+      break;
+    }
+
+    result = true;
+
+    if (pTree->root == NULL)
+    {
+      break;
+    }
+
+    // the leftmost leaf or the leaf with lower bound
+    BPTNode* pLeaf = pTree->root;
+    unsigned int index = 0;
+
+    if (keyFrom == NULL)
+    {
+      while (!pLeaf->isLeaf)
+      {
+        pLeaf = pLeaf->children[0];
+      }
+    }
+    else
+    {
+      bool isFound = false;
+
+      pLeaf = bpt_find_leaf (pTree->root, &fromInfo, NULL);
+      index = bpt_search (pLeaf, &fromInfo, &isFound);
+    }
+
+    // leaves chain
+    bool isStopped = false;
+
+    while (pLeaf != NULL && !isStopped)
+    {
+      for (; index < pLeaf->count; ++index)
+      {
+        if (keyTo != NULL
+            && bpt_key_compare (pLeaf->prefixes[index], pLeaf->keys[index], &toInfo) >= 0)
+        {
+          isStopped = true;
+          break;
+        }
+
+        if (!callback (pLeaf->keys[index], pLeaf->items[index]->data, pContext))
+        {
+          isStopped = true;
+          break;
+        }
+      }
+
+      pLeaf = pLeaf->next;
+      index = 0;
+    }
+
+  } while (0);
+
+  return result;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+bool bpt_key_info (const char* key, KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    if (key == NULL)
+    {
+      break;
+    }
+
+    size_t keyLen = key_length (key, BPT_KEY_SIZE);
+
+    if (keyLen > BPT_KEY_SIZE - 1)    // for '\0'
+    {
+      break;
+    }
+
+    pKey->key = key;
+    pKey->length = keyLen;
+    pKey->prefix = key_prefix (key, keyLen);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+int bpt_key_compare (uint64_t prefix, const char* key, const KeyInfo* pKey)
+{
+  // strcmp (key, pKey->key) equivalent : the last prefix byte is '\0' for short keys
+
+  int result = 0;
+
+  if (prefix != pKey->prefix)
+  {
+    result = (prefix < pKey->prefix) ? -1 : 1;
+  }
+  else if ((prefix & 0xFF) != 0)
+  {
+    result = key_string_compare (key + KEY_PREFIX_SIZE, pKey->key + KEY_PREFIX_SIZE);
+  }
+
+  return result;
+}
+
+unsigned int bpt_search (const BPTNode* pNode, const KeyInfo* pKey, bool* pIsFound)
+{
+  // index of the first key >= searched key
+
+  unsigned int low = 0;
+  unsigned int high = pNode->count;
+
+  *pIsFound = false;
+
+  while (low < high)
+  {
+    unsigned int middle = (low + high) / 2;
+    int result = bpt_key_compare (pNode->prefixes[middle], pNode->keys[middle], pKey);
+
+    if (result < 0)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      *pIsFound = *pIsFound || (result == 0);
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+BPTNode* bpt_find_leaf (BPTNode* pRoot, const KeyInfo* pKey, Path* pPath)
+{
+  // separator is the first key of its right subtree : equal keys go right
+
+  BPTNode* pNode = pRoot;
+  unsigned int depth = 0;
+
+  while (!pNode->isLeaf)
+  {
+    bool isFound = false;
+    unsigned int index = bpt_search (pNode, pKey, &isFound);
+
+    if (isFound)
+    {
+      ++index;
+    }
+
+    if (pPath != NULL)
+    {
+      pPath->nodes[depth] = pNode;
+      pPath->indices[depth] = index;
+    }
+
+    ++depth;
+    pNode = pNode->children[index];
+  }
+
+  if (pPath != NULL)
+  {
+    pPath->depth = depth;
+  }
+
+  return pNode;
+}
+
+BPTNode* bpt_create_node (Heap* pHeap, bool isLeaf)
+{
+  BPTNode* pNode = (BPTNode*)heap_alloc (pHeap, sizeof (BPTNode));
+
+  if (pNode != NULL)
+  {
+    pNode->next = NULL;
+    pNode->count = 0;
+    pNode->isLeaf = isLeaf;
+  }
+
+  return pNode;
+}
+
+BPTItem* bpt_create_item (Heap* pHeap, const void* pItem, size_t itemSize, const KeyInfo* pKey)
+{
+  size_t dataOffset = BPT_ALIGN_UP (sizeof (BPTItem) + pKey->length + 1);
+  BPTItem* pNew = (BPTItem*)heap_alloc (pHeap, dataOffset + itemSize);
+
+  if (pNew != NULL)
+  {
+    memcpy (pNew->key, pKey->key, pKey->length + 1);
+    pNew->data = (char*)pNew + dataOffset;
+    pNew->dataSize = itemSize;
+    memcpy (pNew->data, pItem, itemSize);
+  }
+
+  return pNew;
+}
+
+void bpt_release_item (Heap* pHeap, BPTItem* pItem)
+{
+  // the payload follows the key : the block size is known from both
+  size_t dataOffset = (size_t)((char*)pItem->data - (char*)pItem);
+
+  heap_free (pHeap, pItem, dataOffset + pItem->dataSize);
+}
+
+void bpt_insert_leaf (BPTNode* pLeaf, unsigned int index, uint64_t prefix, BPTItem* pItem)
+{
+  for (unsigned int i = pLeaf->count; i > index; --i)
+  {
+    pLeaf->prefixes[i] = pLeaf->prefixes[i - 1];
+    pLeaf->keys[i] = pLeaf->keys[i - 1];
+    pLeaf->items[i] = pLeaf->items[i - 1];
+  }
+
+  pLeaf->prefixes[index] = prefix;
+  pLeaf->keys[index] = pItem->key;
+  pLeaf->items[index] = pItem;
+  ++pLeaf->count;
+}
+
+void bpt_insert_internal (BPTNode* pNode, unsigned int index, const Split* pSplit)
+{
+  // separator goes to 'index', its right subtree goes right after the child at 'index'
+
+  for (unsigned int i = pNode->count; i > index; --i)
+  {
+    pNode->prefixes[i] = pNode->prefixes[i - 1];
+    pNode->keys[i] = pNode->keys[i - 1];
+    pNode->children[i + 1] = pNode->children[i];
+  }
+
+  pNode->prefixes[index] = pSplit->prefix;
+  pNode->keys[index] = pSplit->key;
+  pNode->children[index + 1] = pSplit->pRight;
+  ++pNode->count;
+}
+
+void bpt_split_leaf (BPTNode* pLeaf, unsigned int index, uint64_t prefix, BPTItem* pItem,
+                     BPTNode* pRight, char* separator, Split* pSplit)
+{
+  // BPT_MAX_KEYS + 1 items are distributed between two leaves
+
+  uint64_t prefixes[BPT_MAX_KEYS + 1];
+  BPTItem* items[BPT_MAX_KEYS + 1];
+
+  for (unsigned int i = 0, j = 0; i < BPT_MAX_KEYS + 1; ++i)
+  {
+    if (i == index)
+    {
+      prefixes[i] = prefix;
+      items[i] = pItem;
+    }
+    else
+    {
+      prefixes[i] = pLeaf->prefixes[j];
+      items[i] = pLeaf->items[j];
+      ++j;
+    }
+  }
+
+  unsigned int leftCount = (BPT_MAX_KEYS + 1) / 2;
+
+  for (unsigned int i = 0; i < BPT_MAX_KEYS + 1; ++i)
+  {
+    BPTNode* pNode = (i < leftCount) ? pLeaf : pRight;
+    unsigned int position = (i < leftCount) ? i : i - leftCount;
+
+    pNode->prefixes[position] = prefixes[i];
+    pNode->keys[position] = items[i]->key;
+    pNode->items[position] = items[i];
+  }
+
+  pLeaf->count = leftCount;
+  pRight->count = BPT_MAX_KEYS + 1 - leftCount;
+
+  pRight->next = pLeaf->next;
+  pLeaf->next = pRight;
+
+  strcpy (separator, pRight->keys[0]);
+  pSplit->prefix = pRight->prefixes[0];
+  pSplit->key = separator;
+  pSplit->pRight = pRight;
+}
+
+void bpt_split_internal (BPTNode* pNode, unsigned int index, Split* pSplit, BPTNode* pRight)
+{
+  /* BPT_MAX_KEYS + 1 keys and BPT_MAX_KEYS + 2 children are distributed between two nodes,
+   * the middle key is pushed up to the parent
+   *
+   * 'pSplit' : in - key and child to insert, out - key and node to push up
+   */
+
+  uint64_t prefixes[BPT_MAX_KEYS + 1];
+  char* keys[BPT_MAX_KEYS + 1];
+  BPTNode* children[BPT_MAX_KEYS + 2];
+
+  children[0] = pNode->children[0];
+
+  for (unsigned int i = 0, j = 0; i < BPT_MAX_KEYS + 1; ++i)
+  {
+    if (i == index)
+    {
+      prefixes[i] = pSplit->prefix;
+      keys[i] = pSplit->key;
+      children[i + 1] = pSplit->pRight;
+    }
+    else
+    {
+      prefixes[i] = pNode->prefixes[j];
+      keys[i] = pNode->keys[j];
+      children[i + 1] = pNode->children[j + 1];
+      ++j;
+    }
+  }
+
+  unsigned int middle = (BPT_MAX_KEYS + 1) / 2;
+
+  pNode->count = middle;
+  for (unsigned int i = 0; i < middle; ++i)
+  {
+    pNode->prefixes[i] = prefixes[i];
+    pNode->keys[i] = keys[i];
+    pNode->children[i] = children[i];
+  }
+  pNode->children[middle] = children[middle];
+
+  pRight->count = BPT_MAX_KEYS - middle;
+  for (unsigned int i = 0; i < pRight->count; ++i)
+  {
+    pRight->prefixes[i] = prefixes[middle + 1 + i];
+    pRight->keys[i] = keys[middle + 1 + i];
+    pRight->children[i] = children[middle + 1 + i];
+  }
+  pRight->children[pRight->count] = children[BPT_MAX_KEYS + 1];
+
+  pSplit->prefix = prefixes[middle];
+  pSplit->key = keys[middle];
+  pSplit->pRight = pRight;
+}
+
+void bpt_remove_leaf (Heap* pHeap, BPTNode* pLeaf, unsigned int index)
+{
+  bpt_release_item (pHeap, pLeaf->items[index]);
+
+  for (unsigned int i = index + 1; i < pLeaf->count; ++i)
+  {
+    pLeaf->prefixes[i - 1] = pLeaf->prefixes[i];
+    pLeaf->keys[i - 1] = pLeaf->keys[i];
+    pLeaf->items[i - 1] = pLeaf->items[i];
+  }
+
+  --pLeaf->count;
+}
+
+void bpt_rebalance (Heap* pHeap, BPTNode* pParent, unsigned int index)
+{
+  // child at 'index' has less than BPT_MIN_KEYS keys
+
+  BPTNode* pLeft = (index > 0) ? pParent->children[index - 1] : NULL;
+  BPTNode* pRight = (index < pParent->count) ? pParent->children[index + 1] : NULL;
+
+  if (pLeft != NULL && pLeft->count > BPT_MIN_KEYS)
+  {
+    bpt_borrow_left (pParent, index);
+  }
+  else if (pRight != NULL && pRight->count > BPT_MIN_KEYS)
+  {
+    bpt_borrow_right (pParent, index);
+  }
+  else if (pLeft != NULL)
+  {
+    bpt_merge (pHeap, pParent, index - 1);
+  }
+  else
+  {
+    bpt_merge (pHeap, pParent, index);
+  }
+}
+
+void bpt_borrow_left (BPTNode* pParent, unsigned int index)
+{
+  BPTNode* pLeft = pParent->children[index - 1];
+  BPTNode* pNode = pParent->children[index];
+  unsigned int last = pLeft->count - 1;
+
+  if (pNode->isLeaf)
+  {
+    bpt_insert_leaf (pNode, 0, pLeft->prefixes[last], pLeft->items[last]);
+
+    // separator becomes the new first key of the node
+    strcpy (pParent->keys[index - 1], pNode->keys[0]);
+    pParent->prefixes[index - 1] = pNode->prefixes[0];
+  }
+  else
+  {
+    // separator goes down, the last key of the left sibling goes up
+    for (unsigned int i = pNode->count; i > 0; --i)
+    {
+      pNode->prefixes[i] = pNode->prefixes[i - 1];
+      pNode->keys[i] = pNode->keys[i - 1];
+      pNode->children[i + 1] = pNode->children[i];
+    }
+    pNode->children[1] = pNode->children[0];
+
+    pNode->prefixes[0] = pParent->prefixes[index - 1];
+    pNode->keys[0] = pParent->keys[index - 1];
+    pNode->children[0] = pLeft->children[last + 1];
+    ++pNode->count;
+
+    pParent->prefixes[index - 1] = pLeft->prefixes[last];
+    pParent->keys[index - 1] = pLeft->keys[last];
+  }
+
+  --pLeft->count;
+}
+
+void bpt_borrow_right (BPTNode* pParent, unsigned int index)
+{
+  BPTNode* pRight = pParent->children[index + 1];
+  BPTNode* pNode = pParent->children[index];
+
+  if (pNode->isLeaf)
+  {
+    bpt_insert_leaf (pNode, pNode->count, pRight->prefixes[0], pRight->items[0]);
+
+    for (unsigned int i = 1; i < pRight->count; ++i)
+    {
+      pRight->prefixes[i - 1] = pRight->prefixes[i];
+      pRight->keys[i - 1] = pRight->keys[i];
+      pRight->items[i - 1] = pRight->items[i];
+    }
+    --pRight->count;
+
+    // separator becomes the new first key of the right sibling
+    strcpy (pParent->keys[index], pRight->keys[0]);
+    pParent->prefixes[index] = pRight->prefixes[0];
+  }
+  else
+  {
+    // separator goes down, the first key of the right sibling goes up
+    pNode->prefixes[pNode->count] = pParent->prefixes[index];
+    pNode->keys[pNode->count] = pParent->keys[index];
+    pNode->children[pNode->count + 1] = pRight->children[0];
+    ++pNode->count;
+
+    pParent->prefixes[index] = pRight->prefixes[0];
+    pParent->keys[index] = pRight->keys[0];
+
+    for (unsigned int i = 1; i < pRight->count; ++i)
+    {
+      pRight->prefixes[i - 1] = pRight->prefixes[i];
+      pRight->keys[i - 1] = pRight->keys[i];
+      pRight->children[i - 1] = pRight->children[i];
+    }
+    pRight->children[pRight->count - 1] = pRight->children[pRight->count];
+    --pRight->count;
+  }
+}
+
+void bpt_merge (Heap* pHeap, BPTNode* pParent, unsigned int index)
+{
+  // children at 'index' and 'index + 1' become one node
+
+  BPTNode* pLeft = pParent->children[index];
+  BPTNode* pRight = pParent->children[index + 1];
+
+  if (pLeft->isLeaf)
+  {
+    for (unsigned int i = 0; i < pRight->count; ++i)
+    {
+      bpt_insert_leaf (pLeft, pLeft->count, pRight->prefixes[i], pRight->items[i]);
+    }
+
+    pLeft->next = pRight->next;
+    heap_free (pHeap, pParent->keys[index], BPT_KEY_SIZE);    // separator is not needed anymore
+  }
+  else
+  {
+    // separator goes down between two halves
+    pLeft->prefixes[pLeft->count] = pParent->prefixes[index];
+    pLeft->keys[pLeft->count] = pParent->keys[index];
+    ++pLeft->count;
+
+    for (unsigned int i = 0; i < pRight->count; ++i)
+    {
+      pLeft->prefixes[pLeft->count + i] = pRight->prefixes[i];
+      pLeft->keys[pLeft->count + i] = pRight->keys[i];
+      pLeft->children[pLeft->count + i] = pRight->children[i];
+    }
+    pLeft->children[pLeft->count + pRight->count] = pRight->children[pRight->count];
+    pLeft->count += pRight->count;
+  }
+
+  heap_free (pHeap, pRight, sizeof (BPTNode));
+
+  // remove separator and the right child from the parent
+  for (unsigned int i = index + 1; i < pParent->count; ++i)
+  {
+    pParent->prefixes[i - 1] = pParent->prefixes[i];
+    pParent->keys[i - 1] = pParent->keys[i];
+    pParent->children[i] = pParent->children[i + 1];
+  }
+
+  --pParent->count;
+}
+
+void bpt_free_memory (Heap* pHeap, BPTNode* pNode)
+{
+  for (unsigned int i = 0; i < pNode->count; ++i)
+  {
+    if (pNode->isLeaf)
+    {
+      bpt_release_item (pHeap, pNode->items[i]);
+    }
+    else
+    {
+      heap_free (pHeap, pNode->keys[i], BPT_KEY_SIZE);
+      bpt_free_memory (pHeap, pNode->children[i]);
+    }
+  }
+
+  if (!pNode->isLeaf)
+  {
+    bpt_free_memory (pHeap, pNode->children[pNode->count]);
+  }
+
+  heap_free (pHeap, pNode, sizeof (BPTNode));
+}
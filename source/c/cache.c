@@ -0,0 +1,675 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/c/cache.h"
+#include "../../include/c/key_utils.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define CACHE_CACHE_LINE (64)
+
+#define CACHE_ALIGNMENT (_Alignof (max_align_t))
+#define CACHE_ALIGN_UP(size) (((size) + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1))
+
+// LFU : entries with the same use count
+typedef struct CacheBucketS
+{
+  List bucketLink;    // in Cache.entries
+  List entries;       // the most recent entry first
+  size_t frequency;
+} CacheBucket;
+
+// key and aligned payload follow the header in the same allocation
+typedef struct CacheEntryS
+{
+  RBTLink indexLink;
+  List recencyLink;
+  CacheBucket* pBucket;    // LFU only
+
+  size_t dataSize;
+  size_t keyLength;
+  char key[];
+} CacheEntry;
+
+struct CacheShardS
+{
+  MUTEX_TYPE mutex;
+  Cache cache;
+} __attribute__ ((aligned (CACHE_CACHE_LINE)));
+
+static int cache_compare (const RBTLink* pLink, const void* key);
+static bool cache_key_length (const char* key, size_t* pLength);
+static void* cache_entry_data (CacheEntry* pEntry);
+static void cache_release_entry (Cache* pCache, CacheEntry* pEntry);
+static CacheEntry* cache_find (Cache* pCache, const char* key);
+static bool cache_link_entry (Cache* pCache, CacheEntry* pEntry);
+static void cache_unlink_entry (Cache* pCache, CacheEntry* pEntry);
+static void cache_touch (Cache* pCache, CacheEntry* pEntry);
+static CacheEntry* cache_victim (Cache* pCache, const CacheEntry* pKeep);
+static void cache_fit_budget (Cache* pCache, const CacheEntry* pKeep);
+static CacheShard* cache_shard (CacheSafe* pCache, const char* key);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool cache_init (Cache* pCache, CACHE_POLICY policy, size_t maxCount, size_t maxBytes,
+                 CacheEvictCallback evict, void* pContext)
+{
+  return cache_init_allocator (pCache, policy, maxCount, maxBytes, evict, pContext, NULL);
+}
+
+bool cache_init_allocator (Cache* pCache, CACHE_POLICY policy, size_t maxCount, size_t maxBytes,
+                           CacheEvictCallback evict, void* pContext, const Allocator* pAllocator)
+{
+  bool result = false;
+
+  do
+  {
+    if (pCache == NULL || (policy != CACHE_LRU && policy != CACHE_LFU))
+    {
+      break;
+    }
+
+    if (!heap_init (&pCache->heap, pAllocator))
+    {
+      break;
+    }
+
+    (void)rbt_intrusive_init (&pCache->index, cache_compare);
+    list_init (&pCache->entries);
+
+    pCache->policy = policy;
+    pCache->count = 0;
+    pCache->bytes = 0;
+    pCache->maxCount = maxCount;
+    pCache->maxBytes = maxBytes;
+    pCache->evict = evict;
+    pCache->pContext = pContext;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void cache_destroy (Cache* pCache)
+{
+  /* the index is cleared first : it resets the links inside the entries, no rebalancing
+   * a zeroed cache which was never inited has no lists yet : nothing to release
+   */
+
+  if (pCache != NULL && pCache->entries.next != NULL)
+  {
+    CacheEntry* pEntry = NULL;
+    CacheEntry* pTempEntry = NULL;
+
+    rbt_intrusive_clear (&pCache->index);
+
+    if (pCache->policy == CACHE_LRU)
+    {
+      LIST_FOR_EACH_ENTRY_SAFE (pEntry, pTempEntry, &pCache->entries, CacheEntry, recencyLink)
+      {
+        cache_release_entry (pCache, pEntry);
+      }
+    }
+    else
+    {
+      CacheBucket* pBucket = NULL;
+      CacheBucket* pTempBucket = NULL;
+
+      LIST_FOR_EACH_ENTRY_SAFE (pBucket, pTempBucket, &pCache->entries, CacheBucket, bucketLink)
+      {
+        LIST_FOR_EACH_ENTRY_SAFE (pEntry, pTempEntry, &pBucket->entries, CacheEntry, recencyLink)
+        {
+          cache_release_entry (pCache, pEntry);
+        }
+
+        heap_free (&pCache->heap, pBucket, sizeof (CacheBucket));
+      }
+    }
+
+    list_init (&pCache->entries);
+    pCache->count = 0;
+    pCache->bytes = 0;
+  }
+}
+
+bool cache_put (Cache* pCache, const void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+
+  do
+  {
+    size_t keyLength = 0;
+
+    if (pCache == NULL || pItem == NULL || !cache_key_length (key, &keyLength))
+    {
+      break;
+    }
+
+    if (pCache->maxBytes != 0 && keyLength + itemSize > pCache->maxBytes)
+    {
+      break;
+    }
+
+    CacheEntry* pOld = cache_find (pCache, key);
+
+    // the same size : payload is overwritten in place
+    if (pOld != NULL && pOld->dataSize == itemSize)
+    {
+      memcpy (cache_entry_data (pOld), pItem, itemSize);
+      cache_touch (pCache, pOld);
+
+      result = true;
+      break;
+    }
+
+    size_t dataOffset = CACHE_ALIGN_UP (offsetof (CacheEntry, key) + keyLength + 1);
+
+    CacheEntry* pEntry = (CacheEntry*)heap_alloc (&pCache->heap, dataOffset + itemSize);
+    if (pEntry == NULL)
+    {
+      break;
+    }
+
+    memset (&pEntry->indexLink, 0, sizeof (pEntry->indexLink));
+    pEntry->pBucket = NULL;
+    pEntry->dataSize = itemSize;
+    pEntry->keyLength = keyLength;
+    memcpy (pEntry->key, key, keyLength + 1);
+    memcpy (cache_entry_data (pEntry), pItem, itemSize);
+
+    if (pOld != NULL)    // new entry takes the place of the old one in the recency order
+    {
+      rbt_intrusive_remove (&pCache->index, &pOld->indexLink);
+      (void)rbt_intrusive_insert (&pCache->index, &pEntry->indexLink, pEntry->key);
+
+      list_replace (&pOld->recencyLink, &pEntry->recencyLink);
+      pEntry->pBucket = pOld->pBucket;
+
+      pCache->bytes = pCache->bytes - pOld->dataSize + itemSize;
+      cache_release_entry (pCache, pOld);
+
+      cache_touch (pCache, pEntry);
+    }
+    else if (!cache_link_entry (pCache, pEntry))
+    {
+      cache_release_entry (pCache, pEntry);
+      break;
+    }
+
+    cache_fit_budget (pCache, pEntry);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool cache_get (Cache* pCache, void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+
+  do
+  {
+    size_t keyLength = 0;
+
+    if (pCache == NULL || pItem == NULL || !cache_key_length (key, &keyLength))
+    {
+      break;
+    }
+
+    CacheEntry* pEntry = cache_find (pCache, key);
+
+    if (pEntry == NULL || pEntry->dataSize > itemSize)
+    {
+      break;
+    }
+
+    memcpy (pItem, cache_entry_data (pEntry), pEntry->dataSize);
+    cache_touch (pCache, pEntry);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool cache_delete (Cache* pCache, const char* key)
+{
+  bool result = false;
+
+  do
+  {
+    size_t keyLength = 0;
+
+    if (pCache == NULL || !cache_key_length (key, &keyLength))
+    {
+      break;
+    }
+
+    CacheEntry* pEntry = cache_find (pCache, key);
+    if (pEntry == NULL)
+    {
+      break;
+    }
+
+    cache_unlink_entry (pCache, pEntry);
+    cache_release_entry (pCache, pEntry);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+size_t cache_count (const Cache* pCache)
+{
+  return pCache->count;
+}
+
+size_t cache_bytes (const Cache* pCache)
+{
+  return pCache->bytes;
+}
+
+bool concurrent_cache_init (CacheSafe* pCache, CACHE_POLICY policy, size_t maxCount,
+                            size_t maxBytes, size_t shardsCount, CacheEvictCallback evict,
+                            void* pContext)
+{
+  return concurrent_cache_init_allocator (pCache, policy, maxCount, maxBytes, shardsCount, evict,
+                                          pContext, NULL);
+}
+
+bool concurrent_cache_init_allocator (CacheSafe* pCache, CACHE_POLICY policy, size_t maxCount,
+                                      size_t maxBytes, size_t shardsCount,
+                                      CacheEvictCallback evict, void* pContext,
+                                      const Allocator* pAllocator)
+{
+  bool result = false;
+
+  do
+  {
+    if (pCache == NULL || shardsCount == 0 || (shardsCount & (shardsCount - 1)) != 0)
+    {
+      break;
+    }
+
+    pCache->shards = (CacheShard*)aligned_alloc (CACHE_CACHE_LINE,
+                                                 shardsCount * sizeof (CacheShard));
+    if (pCache->shards == NULL)
+    {
+      break;
+    }
+
+    // rounded up : a shard budget must not become 0, that means no limit
+    size_t shardCount = (maxCount + shardsCount - 1) / shardsCount;
+    size_t shardBytes = (maxBytes + shardsCount - 1) / shardsCount;
+    size_t inited = 0;
+
+    for (; inited < shardsCount; ++inited)
+    {
+      CacheShard* pShard = &pCache->shards[inited];
+
+      if (!cache_init_allocator (&pShard->cache, policy, shardCount, shardBytes, evict, pContext,
+                                 pAllocator))
+      {
+        break;
+      }
+
+      if (!mutex_init (&pShard->mutex))
+      {
+        break;
+      }
+    }
+
+    if (inited != shardsCount)
+    {
+      while (inited-- > 0)
+      {
+        (void)mutex_destroy (&pCache->shards[inited].mutex);
+      }
+
+      free (pCache->shards);
+      pCache->shards = NULL;
+      break;
+    }
+
+    pCache->shardsCount = shardsCount;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void concurrent_cache_destroy (CacheSafe* pCache)
+{
+  if (pCache != NULL && pCache->shards != NULL)
+  {
+    for (size_t i = 0; i < pCache->shardsCount; ++i)
+    {
+      CacheShard* pShard = &pCache->shards[i];
+
+      if (mutex_lock (&pShard->mutex))
+      {
+        cache_destroy (&pShard->cache);
+
+        (void)mutex_unlock (&pShard->mutex);
+        (void)mutex_destroy (&pShard->mutex);
+      }
+    }
+
+    free (pCache->shards);
+    pCache->shards = NULL;
+    pCache->shardsCount = 0;
+  }
+}
+
+bool concurrent_cache_put (CacheSafe* pCache, const void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+
+  if (pCache != NULL && key != NULL)
+  {
+    CacheShard* pShard = cache_shard (pCache, key);
+
+    if (mutex_lock (&pShard->mutex))
+    {
+      result = cache_put (&pShard->cache, pItem, itemSize, key);
+
+      (void)mutex_unlock (&pShard->mutex);
+    }
+  }
+
+  return result;
+}
+
+bool concurrent_cache_get (CacheSafe* pCache, void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+
+  if (pCache != NULL && key != NULL)
+  {
+    CacheShard* pShard = cache_shard (pCache, key);
+
+    if (mutex_lock (&pShard->mutex))
+    {
+      result = cache_get (&pShard->cache, pItem, itemSize, key);
+
+      (void)mutex_unlock (&pShard->mutex);
+    }
+  }
+
+  return result;
+}
+
+bool concurrent_cache_delete (CacheSafe* pCache, const char* key)
+{
+  bool result = false;
+
+  if (pCache != NULL && key != NULL)
+  {
+    CacheShard* pShard = cache_shard (pCache, key);
+
+    if (mutex_lock (&pShard->mutex))
+    {
+      result = cache_delete (&pShard->cache, key);
+
+      (void)mutex_unlock (&pShard->mutex);
+    }
+  }
+
+  return result;
+}
+
+size_t concurrent_cache_count (CacheSafe* pCache)
+{
+  size_t count = 0;
+
+  for (size_t i = 0; i < pCache->shardsCount; ++i)
+  {
+    CacheShard* pShard = &pCache->shards[i];
+
+    if (mutex_lock (&pShard->mutex))
+    {
+      count += pShard->cache.count;
+
+      (void)mutex_unlock (&pShard->mutex);
+    }
+  }
+
+  return count;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+int cache_compare (const RBTLink* pLink, const void* key)
+{
+  return key_string_compare (GET_NODE (pLink, CacheEntry, indexLink)->key, (const char*)key);
+}
+
+bool cache_key_length (const char* key, size_t* pLength)
+{
+  bool result = false;
+
+  if (key != NULL)
+  {
+    *pLength = key_length (key, CACHE_KEY_SIZE);
+    result = *pLength < CACHE_KEY_SIZE;    // for '\0'
+  }
+
+  return result;
+}
+
+void* cache_entry_data (CacheEntry* pEntry)
+{
+  return (char*)pEntry + CACHE_ALIGN_UP (offsetof (CacheEntry, key) + pEntry->keyLength + 1);
+}
+
+void cache_release_entry (Cache* pCache, CacheEntry* pEntry)
+{
+  size_t entrySize = (size_t)((char*)cache_entry_data (pEntry) - (char*)pEntry) + pEntry->dataSize;
+
+  heap_free (&pCache->heap, pEntry, entrySize);
+}
+
+CacheEntry* cache_find (Cache* pCache, const char* key)
+{
+  RBTLink* pLink = rbt_intrusive_find (&pCache->index, key);
+
+  return (pLink == NULL) ? NULL : GET_NODE (pLink, CacheEntry, indexLink);
+}
+
+bool cache_link_entry (Cache* pCache, CacheEntry* pEntry)
+{
+  // new entry : the most recent one, LFU puts it to the bucket of single use
+
+  bool result = false;
+
+  do
+  {
+    List* pRecency = &pCache->entries;
+
+    if (pCache->policy == CACHE_LFU)
+    {
+      List* pFirst = list_first (&pCache->entries);
+      CacheBucket* pBucket = (pFirst == NULL) ? NULL : GET_NODE (pFirst, CacheBucket, bucketLink);
+
+      if (pBucket == NULL || pBucket->frequency != 1)
+      {
+        pBucket = (CacheBucket*)heap_alloc (&pCache->heap, sizeof (CacheBucket));
+        if (pBucket == NULL)
+        {
+          break;
+        }
+
+        list_init (&pBucket->entries);
+        pBucket->frequency = 1;
+        list_add (&pCache->entries, &pBucket->bucketLink);
+      }
+
+      pEntry->pBucket = pBucket;
+      pRecency = &pBucket->entries;
+    }
+
+    (void)rbt_intrusive_insert (&pCache->index, &pEntry->indexLink, pEntry->key);
+    list_add (pRecency, &pEntry->recencyLink);
+
+    ++pCache->count;
+    pCache->bytes += pEntry->keyLength + pEntry->dataSize;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void cache_unlink_entry (Cache* pCache, CacheEntry* pEntry)
+{
+  rbt_intrusive_remove (&pCache->index, &pEntry->indexLink);
+  list_del (&pEntry->recencyLink);
+
+  if (pEntry->pBucket != NULL && list_is_empty (&pEntry->pBucket->entries))
+  {
+    list_del (&pEntry->pBucket->bucketLink);
+    heap_free (&pCache->heap, pEntry->pBucket, sizeof (CacheBucket));
+  }
+
+  --pCache->count;
+  pCache->bytes -= pEntry->keyLength + pEntry->dataSize;
+}
+
+void cache_touch (Cache* pCache, CacheEntry* pEntry)
+{
+  /* LRU : the entry becomes the most recent one
+   * LFU : the entry goes to the bucket of the next frequency, which is created after
+   *       the current one if it doesn't exist; the current bucket is freed when it's left empty
+   */
+
+  if (pCache->policy == CACHE_LRU)
+  {
+    list_move (&pCache->entries, &pEntry->recencyLink);
+    return;
+  }
+
+  CacheBucket* pBucket = pEntry->pBucket;
+  CacheBucket* pNext = NULL;
+
+  if (pBucket->bucketLink.next != &pCache->entries)
+  {
+    pNext = GET_NODE (pBucket->bucketLink.next, CacheBucket, bucketLink);
+  }
+
+  if (pNext == NULL || pNext->frequency != pBucket->frequency + 1)
+  {
+    pNext = (CacheBucket*)heap_alloc (&pCache->heap, sizeof (CacheBucket));
+    if (pNext == NULL)    // the entry stays with its frequency, only recency is updated
+    {
+      list_move (&pBucket->entries, &pEntry->recencyLink);
+      return;
+    }
+
+    list_init (&pNext->entries);
+    pNext->frequency = pBucket->frequency + 1;
+    list_add (&pBucket->bucketLink, &pNext->bucketLink);
+  }
+
+  list_move (&pNext->entries, &pEntry->recencyLink);
+  pEntry->pBucket = pNext;
+
+  if (list_is_empty (&pBucket->entries))
+  {
+    list_del (&pBucket->bucketLink);
+    heap_free (&pCache->heap, pBucket, sizeof (CacheBucket));
+  }
+}
+
+CacheEntry* cache_victim (Cache* pCache, const CacheEntry* pKeep)
+{
+  // the least recent entry of the lowest bucket except pKeep : NULL if there is no other one
+
+  if (pCache->policy == CACHE_LRU)
+  {
+    List* pLink = pCache->entries.prev;
+
+    if (pLink != &pCache->entries && GET_NODE (pLink, CacheEntry, recencyLink) == pKeep)
+    {
+      pLink = pLink->prev;
+    }
+
+    return (pLink == &pCache->entries) ? NULL : GET_NODE (pLink, CacheEntry, recencyLink);
+  }
+
+  List* pBucketLink = NULL;
+
+  LIST_FOR_EACH (pBucketLink, &pCache->entries)
+  {
+    CacheBucket* pBucket = GET_NODE (pBucketLink, CacheBucket, bucketLink);
+    List* pLink = pBucket->entries.prev;
+
+    if (GET_NODE (pLink, CacheEntry, recencyLink) == pKeep)
+    {
+      pLink = pLink->prev;
+    }
+
+    if (pLink != &pBucket->entries)
+    {
+      return GET_NODE (pLink, CacheEntry, recencyLink);
+    }
+  }
+
+  return NULL;
+}
+
+void cache_fit_budget (Cache* pCache, const CacheEntry* pKeep)
+{
+  while ((pCache->maxCount != 0 && pCache->count > pCache->maxCount)
+         || (pCache->maxBytes != 0 && pCache->bytes > pCache->maxBytes))
+  {
+    CacheEntry* pVictim = cache_victim (pCache, pKeep);
+    if (pVictim == NULL)
+    {
+      break;
+    }
+
+    if (pCache->evict != NULL)
+    {
+      pCache->evict (pVictim->key, cache_entry_data (pVictim), pVictim->dataSize,
+                     pCache->pContext);
+    }
+
+    cache_unlink_entry (pCache, pVictim);
+    cache_release_entry (pCache, pVictim);
+  }
+}
+
+CacheShard* cache_shard (CacheSafe* pCache, const char* key)
+{
+  // FNV-1a over the key, the high bits mixed down : shards don't follow the key order
+
+  uint64_t hash = 0xCBF29CE484222325ULL;
+
+  for (; *key != '\0'; ++key)
+  {
+    hash = (hash ^ (unsigned char)*key) * 0x100000001B3ULL;
+  }
+
+  hash ^= hash >> 32;
+
+  return &pCache->shards[hash & (pCache->shardsCount - 1)];
+}
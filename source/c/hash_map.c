@@ -0,0 +1,701 @@
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../../include/c/hash_map.h"
+#include "../../include/c/key_utils.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define HM_GROUP_SIZE (16)    // control bytes compared at once
+#define HM_MIN_CAPACITY (HM_GROUP_SIZE)
+#define HM_INLINE_KEY_SIZE (24)    // shorter keys don't need own allocation
+#define HM_CACHE_LINE (64)
+
+#define HM_ALIGNMENT (_Alignof (max_align_t))
+#define HM_ALIGN_UP(size) (((size) + HM_ALIGNMENT - 1) & ~(HM_ALIGNMENT - 1))
+
+// control byte : EMPTY and DELETED are negative, FULL keeps 7 bits of hash
+#define HM_CTRL_EMPTY ((int8_t)-128)
+#define HM_CTRL_DELETED ((int8_t)-2)
+#define HM_H1(hash) ((hash) >> 7)
+#define HM_H2(hash) ((int8_t)((hash)&0x7F))
+
+// the table is rehashed when it becomes 7/8 full
+#define HM_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+#define HM_NOT_FOUND ((size_t)-1)
+
+struct HashMapSlotS
+{
+  uint64_t hash;    // kept for rehashing
+  void* data;       // payload, for long keys it follows the key in the same allocation
+  size_t dataSize;
+  size_t keyLength;
+
+  union
+  {
+    char inlineKey[HM_INLINE_KEY_SIZE];
+    char* key;
+  };
+};
+
+struct HashMapStripeS
+{
+  MUTEX_TYPE mutex;
+  HashMap map;
+} __attribute__ ((aligned (HM_CACHE_LINE)));
+
+// searched key : length and hash are computed once per call
+typedef struct KeyInfoS
+{
+  const char* key;
+  size_t length;
+  uint64_t hash;
+} KeyInfo;
+
+static bool hm_key_info (const char* key, KeyInfo* pKey);
+static uint64_t hm_hash (const char* key, size_t length);
+static uint32_t hm_match (const int8_t* pGroup, int8_t value);
+static uint32_t hm_match_available (const int8_t* pGroup);
+static const char* hm_slot_key (const HashMapSlot* pSlot);
+static size_t hm_find (const HashMap* pMap, const KeyInfo* pKey);
+static size_t hm_find_available (const HashMap* pMap, uint64_t hash);
+static bool hm_resize (HashMap* pMap, size_t capacity);
+static bool hm_insert_key (HashMap* pMap, void* pItem, size_t itemSize, const KeyInfo* pKey);
+static bool hm_get_key (HashMap* pMap, void* pItem, size_t itemSize, const KeyInfo* pKey);
+static bool hm_delete_key (HashMap* pMap, const KeyInfo* pKey);
+static void hm_free_slot (HashMap* pMap, HashMapSlot* pSlot);
+static HashMapStripe* hm_stripe (HashMapSafe* pMap, const KeyInfo* pKey);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool hm_init (HashMap* pMap, size_t capacity)
+{
+  return hm_init_allocator (pMap, capacity, NULL);
+}
+
+bool hm_init_allocator (HashMap* pMap, size_t capacity, const Allocator* pAllocator)
+{
+  bool result = false;
+
+  do
+  {
+    if (pMap == NULL || !heap_init (&pMap->heap, pAllocator))
+    {
+      break;
+    }
+
+    pMap->ctrl = NULL;
+    pMap->slots = NULL;
+    pMap->capacity = 0;
+    pMap->count = 0;
+    pMap->growthLeft = 0;
+
+    // capacity is a hint : enough slots to keep 'capacity' items without rehashing
+    if (capacity != 0)
+    {
+      size_t slotsCount = HM_MIN_CAPACITY;
+
+      while (HM_MAX_LOAD (slotsCount) < capacity)
+      {
+        slotsCount *= 2;
+      }
+
+      if (!hm_resize (pMap, slotsCount))
+      {
+        break;
+      }
+    }
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void hm_destroy (HashMap* pMap)
+{
+  if (pMap != NULL)
+  {
+    for (size_t i = 0; i < pMap->capacity; ++i)
+    {
+      if (pMap->ctrl[i] >= 0)
+      {
+        hm_free_slot (pMap, &pMap->slots[i]);
+      }
+    }
+
+    heap_free (&pMap->heap, pMap->ctrl, pMap->capacity);
+    heap_free (&pMap->heap, pMap->slots, pMap->capacity * sizeof (HashMapSlot));
+
+    pMap->ctrl = NULL;
+    pMap->slots = NULL;
+    pMap->capacity = 0;
+    pMap->count = 0;
+    pMap->growthLeft = 0;
+  }
+}
+
+bool hm_insert (HashMap* pMap, void* pItem, size_t itemSize, const char* key)
+{
+  KeyInfo keyInfo;
+
+  return pMap != NULL && hm_key_info (key, &keyInfo)
+         && hm_insert_key (pMap, pItem, itemSize, &keyInfo);
+}
+
+bool hm_get (HashMap* pMap, void* pItem, size_t itemSize, const char* key)
+{
+  KeyInfo keyInfo;
+
+  return pMap != NULL && hm_key_info (key, &keyInfo)
+         && hm_get_key (pMap, pItem, itemSize, &keyInfo);
+}
+
+bool hm_delete (HashMap* pMap, const char* key)
+{
+  KeyInfo keyInfo;
+
+  return pMap != NULL && hm_key_info (key, &keyInfo) && hm_delete_key (pMap, &keyInfo);
+}
+
+bool concurrent_hm_init (HashMapSafe* pMap, size_t capacity, size_t stripesCount)
+{
+  return concurrent_hm_init_allocator (pMap, capacity, stripesCount, NULL);
+}
+
+bool concurrent_hm_init_allocator (HashMapSafe* pMap, size_t capacity, size_t stripesCount,
+                                   const Allocator* pAllocator)
+{
+  bool result = false;
+
+  do
+  {
+    if (pMap == NULL || stripesCount == 0 || (stripesCount & (stripesCount - 1)) != 0)
+    {
+      break;
+    }
+
+    pMap->stripes = (HashMapStripe*)aligned_alloc (HM_CACHE_LINE,
+                                                   stripesCount * sizeof (HashMapStripe));
+    if (pMap->stripes == NULL)
+    {
+      break;
+    }
+
+    size_t inited = 0;
+
+    for (; inited < stripesCount; ++inited)
+    {
+      HashMapStripe* pStripe = &pMap->stripes[inited];
+
+      if (!hm_init_allocator (&pStripe->map, capacity / stripesCount, pAllocator))
+      {
+        break;
+      }
+
+      if (!mutex_init (&pStripe->mutex))
+      {
+        hm_destroy (&pStripe->map);
+        break;
+      }
+    }
+
+    if (inited != stripesCount)
+    {
+      while (inited-- > 0)
+      {
+        (void)mutex_destroy (&pMap->stripes[inited].mutex);
+        hm_destroy (&pMap->stripes[inited].map);
+      }
+
+      free (pMap->stripes);
+      pMap->stripes = NULL;
+      break;
+    }
+
+    pMap->stripesCount = stripesCount;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void concurrent_hm_destroy (HashMapSafe* pMap)
+{
+  if (pMap != NULL && pMap->stripes != NULL)
+  {
+    for (size_t i = 0; i < pMap->stripesCount; ++i)
+    {
+      HashMapStripe* pStripe = &pMap->stripes[i];
+
+      if (mutex_lock (&pStripe->mutex))
+      {
+        hm_destroy (&pStripe->map);
+
+        (void)mutex_unlock (&pStripe->mutex);
+        (void)mutex_destroy (&pStripe->mutex);
+      }
+    }
+
+    free (pMap->stripes);
+    pMap->stripes = NULL;
+    pMap->stripesCount = 0;
+  }
+}
+
+bool concurrent_hm_insert (HashMapSafe* pMap, void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+
+  if (pMap != NULL && hm_key_info (key, &keyInfo))
+  {
+    HashMapStripe* pStripe = hm_stripe (pMap, &keyInfo);
+
+    if (mutex_lock (&pStripe->mutex))
+    {
+      result = hm_insert_key (&pStripe->map, pItem, itemSize, &keyInfo);
+
+      (void)mutex_unlock (&pStripe->mutex);
+    }
+  }
+
+  return result;
+}
+
+bool concurrent_hm_get (HashMapSafe* pMap, void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+
+  if (pMap != NULL && hm_key_info (key, &keyInfo))
+  {
+    HashMapStripe* pStripe = hm_stripe (pMap, &keyInfo);
+
+    if (mutex_lock (&pStripe->mutex))
+    {
+      result = hm_get_key (&pStripe->map, pItem, itemSize, &keyInfo);
+
+      (void)mutex_unlock (&pStripe->mutex);
+    }
+  }
+
+  return result;
+}
+
+bool concurrent_hm_delete (HashMapSafe* pMap, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+
+  if (pMap != NULL && hm_key_info (key, &keyInfo))
+  {
+    HashMapStripe* pStripe = hm_stripe (pMap, &keyInfo);
+
+    if (mutex_lock (&pStripe->mutex))
+    {
+      result = hm_delete_key (&pStripe->map, &keyInfo);
+
+      (void)mutex_unlock (&pStripe->mutex);
+    }
+  }
+
+  return result;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+bool hm_key_info (const char* key, KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    if (key == NULL)
+    {
+      break;
+    }
+
+    size_t keyLen = key_length (key, HM_KEY_SIZE);
+
+    if (keyLen > HM_KEY_SIZE - 1)    // for '\0'
+    {
+      break;
+    }
+
+    pKey->key = key;
+    pKey->length = keyLen;
+    pKey->hash = hm_hash (key, keyLen);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+uint64_t hm_hash (const char* key, size_t length)
+{
+  // 8 bytes per step multiply-xorshift, the final mix spreads bits to both H1 and H2
+
+  const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+  uint64_t hash = length * multiplier;
+
+  while (length >= sizeof (uint64_t))
+  {
+    uint64_t word;
+    memcpy (&word, key, sizeof (word));
+
+    hash = (hash ^ word) * multiplier;
+    hash ^= hash >> 32;
+
+    key += sizeof (uint64_t);
+    length -= sizeof (uint64_t);
+  }
+
+  if (length > 0)
+  {
+    uint64_t word = 0;
+    memcpy (&word, key, length);
+
+    hash = (hash ^ word) * multiplier;
+  }
+
+  hash ^= hash >> 29;
+  hash *= 0xBF58476D1CE4E5B9ULL;
+  hash ^= hash >> 32;
+
+  return hash;
+}
+
+uint32_t hm_match (const int8_t* pGroup, int8_t value)
+{
+  // bit i is set when control byte i equals to value
+
+#if defined(__SSE2__)
+  __m128i group = _mm_load_si128 ((const __m128i*)pGroup);
+  return (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (group, _mm_set1_epi8 (value)));
+#else
+  uint32_t mask = 0;
+
+  for (int i = 0; i < HM_GROUP_SIZE; ++i)
+  {
+    mask |= (uint32_t)(pGroup[i] == value) << i;
+  }
+
+  return mask;
+#endif
+}
+
+uint32_t hm_match_available (const int8_t* pGroup)
+{
+  // EMPTY or DELETED : sign bit is set
+
+#if defined(__SSE2__)
+  return (uint32_t)_mm_movemask_epi8 (_mm_load_si128 ((const __m128i*)pGroup));
+#else
+  uint32_t mask = 0;
+
+  for (int i = 0; i < HM_GROUP_SIZE; ++i)
+  {
+    mask |= (uint32_t)(pGroup[i] < 0) << i;
+  }
+
+  return mask;
+#endif
+}
+
+const char* hm_slot_key (const HashMapSlot* pSlot)
+{
+  return (pSlot->keyLength < HM_INLINE_KEY_SIZE) ? pSlot->inlineKey : pSlot->key;
+}
+
+size_t hm_find (const HashMap* pMap, const KeyInfo* pKey)
+{
+  /* groups are visited in triangular order : 0, 1, 3, 6 ... groups from the start,
+   * which covers all groups when their count is power of two
+   *
+   * the group with an EMPTY slot ends the search : the key would have been placed there
+   */
+
+  size_t index = HM_NOT_FOUND;
+
+  if (pMap->capacity != 0)
+  {
+    size_t groupsMask = pMap->capacity / HM_GROUP_SIZE - 1;
+    size_t group = HM_H1 (pKey->hash) & groupsMask;
+    int8_t h2 = HM_H2 (pKey->hash);
+
+    for (size_t step = 1; step <= groupsMask + 1; ++step)
+    {
+      const int8_t* pGroup = pMap->ctrl + group * HM_GROUP_SIZE;
+
+      for (uint32_t mask = hm_match (pGroup, h2); mask != 0; mask &= mask - 1)
+      {
+        size_t candidate = group * HM_GROUP_SIZE + __builtin_ctz (mask);
+        const HashMapSlot* pSlot = &pMap->slots[candidate];
+
+        if (pSlot->hash == pKey->hash && pSlot->keyLength == pKey->length
+            && key_compare (hm_slot_key (pSlot), pKey->key, pKey->length) == 0)
+        {
+          index = candidate;
+          break;
+        }
+      }
+
+      if (index != HM_NOT_FOUND || hm_match (pGroup, HM_CTRL_EMPTY) != 0)
+      {
+        break;
+      }
+
+      group = (group + step) & groupsMask;
+    }
+  }
+
+  return index;
+}
+
+size_t hm_find_available (const HashMap* pMap, uint64_t hash)
+{
+  // the first EMPTY or DELETED slot in the probe sequence, the table is never full
+
+  size_t groupsMask = pMap->capacity / HM_GROUP_SIZE - 1;
+  size_t group = HM_H1 (hash) & groupsMask;
+  size_t index = HM_NOT_FOUND;
+
+  for (size_t step = 1; index == HM_NOT_FOUND; ++step)
+  {
+    uint32_t mask = hm_match_available (pMap->ctrl + group * HM_GROUP_SIZE);
+
+    if (mask != 0)
+    {
+      index = group * HM_GROUP_SIZE + __builtin_ctz (mask);
+    }
+
+    group = (group + step) & groupsMask;
+  }
+
+  return index;
+}
+
+bool hm_resize (HashMap* pMap, size_t capacity)
+{
+  // rehashing drops all DELETED slots as well
+
+  bool result = false;
+  int8_t* pCtrl = NULL;
+  HashMapSlot* pSlots = NULL;
+
+  do
+  {
+    // max_align_t of the allocator is enough for the group loads of SSE2
+    pCtrl = (int8_t*)heap_alloc (&pMap->heap, capacity);
+    pSlots = (HashMapSlot*)heap_alloc (&pMap->heap, capacity * sizeof (HashMapSlot));
+    if (pCtrl == NULL || pSlots == NULL)
+    {
+      break;
+    }
+
+    memset (pCtrl, HM_CTRL_EMPTY, capacity);
+
+    HashMap resized = { pCtrl, pSlots, capacity, pMap->count,
+                        HM_MAX_LOAD (capacity) - pMap->count, pMap->heap };
+
+    for (size_t i = 0; i < pMap->capacity; ++i)
+    {
+      if (pMap->ctrl[i] >= 0)
+      {
+        size_t index = hm_find_available (&resized, pMap->slots[i].hash);
+
+        pCtrl[index] = pMap->ctrl[i];
+        pSlots[index] = pMap->slots[i];
+      }
+    }
+
+    heap_free (&pMap->heap, pMap->ctrl, pMap->capacity);
+    heap_free (&pMap->heap, pMap->slots, pMap->capacity * sizeof (HashMapSlot));
+    resized.heap = pMap->heap;    // counters are up to date after the frees
+    *pMap = resized;
+
+    pCtrl = NULL;
+    pSlots = NULL;
+
+    result = true;
+
+  } while (0);
+
+  heap_free (&pMap->heap, pCtrl, capacity);
+  heap_free (&pMap->heap, pSlots, capacity * sizeof (HashMapSlot));
+
+  return result;
+}
+
+bool hm_insert_key (HashMap* pMap, void* pItem, size_t itemSize, const KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    if (hm_find (pMap, pKey) != HM_NOT_FOUND)    // item with such key already exists
+    {
+      break;
+    }
+
+    // no empty slots left : grow if the map is really full, otherwise just drop DELETED slots
+    if (pMap->growthLeft == 0)
+    {
+      size_t capacity = (pMap->capacity == 0) ? HM_MIN_CAPACITY : pMap->capacity;
+
+      if (pMap->count >= HM_MAX_LOAD (capacity) / 2)
+      {
+        capacity *= 2;
+      }
+
+      if (!hm_resize (pMap, capacity))
+      {
+        break;
+      }
+    }
+
+    // payload follows long key in the same allocation
+    bool isInline = pKey->length < HM_INLINE_KEY_SIZE;
+    size_t dataOffset = isInline ? 0 : HM_ALIGN_UP (pKey->length + 1);
+
+    char* pBlock = (char*)heap_alloc (&pMap->heap, dataOffset + itemSize);
+    if (pBlock == NULL)
+    {
+      break;
+    }
+
+    size_t index = hm_find_available (pMap, pKey->hash);
+    HashMapSlot* pSlot = &pMap->slots[index];
+
+    if (pMap->ctrl[index] == HM_CTRL_EMPTY)
+    {
+      --pMap->growthLeft;
+    }
+
+    pMap->ctrl[index] = HM_H2 (pKey->hash);
+    pSlot->hash = pKey->hash;
+    pSlot->keyLength = pKey->length;
+    pSlot->data = pBlock + dataOffset;
+    pSlot->dataSize = itemSize;
+
+    if (isInline)
+    {
+      memcpy (pSlot->inlineKey, pKey->key, pKey->length + 1);
+    }
+    else
+    {
+      memcpy (pBlock, pKey->key, pKey->length + 1);
+      pSlot->key = pBlock;
+    }
+
+    memcpy (pSlot->data, pItem, itemSize);
+    ++pMap->count;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool hm_get_key (HashMap* pMap, void* pItem, size_t itemSize, const KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    size_t index = hm_find (pMap, pKey);
+    if (index == HM_NOT_FOUND || pMap->slots[index].dataSize > itemSize)    // or doesn't fit
+    {
+      break;
+    }
+
+    memcpy (pItem, pMap->slots[index].data, pMap->slots[index].dataSize);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool hm_delete_key (HashMap* pMap, const KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    size_t index = hm_find (pMap, pKey);
+    if (index == HM_NOT_FOUND)
+    {
+      break;
+    }
+
+    hm_free_slot (pMap, &pMap->slots[index]);
+
+    // group which still has EMPTY slot has never been full : nobody probed past it
+    const int8_t* pGroup = pMap->ctrl + index / HM_GROUP_SIZE * HM_GROUP_SIZE;
+
+    if (hm_match (pGroup, HM_CTRL_EMPTY) != 0)
+    {
+      pMap->ctrl[index] = HM_CTRL_EMPTY;
+      ++pMap->growthLeft;
+    }
+    else
+    {
+      pMap->ctrl[index] = HM_CTRL_DELETED;
+    }
+
+    --pMap->count;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void hm_free_slot (HashMap* pMap, HashMapSlot* pSlot)
+{
+  // the block of a long key starts with the key, the payload follows it
+  bool isInline = pSlot->keyLength < HM_INLINE_KEY_SIZE;
+  size_t dataOffset = isInline ? 0 : HM_ALIGN_UP (pSlot->keyLength + 1);
+
+  heap_free (&pMap->heap, isInline ? pSlot->data : (void*)pSlot->key, dataOffset + pSlot->dataSize);
+}
+
+HashMapStripe* hm_stripe (HashMapSafe* pMap, const KeyInfo* pKey)
+{
+  // the highest hash bits : H1 low bits choose group inside the stripe map
+  return &pMap->stripes[(pKey->hash >> 56) & (pMap->stripesCount - 1)];
+}
@@ -0,0 +1,436 @@
+#include <string.h>
+
+#include "../../include/c/key_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define KEY_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define KEY_PAGE_SIZE (4096)
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define KEY_NO_SANITIZE __attribute__ ((no_sanitize_address, no_sanitize_thread))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define KEY_NO_SANITIZE __attribute__ ((no_sanitize ("address", "thread")))
+#endif
+#endif
+
+#ifndef KEY_NO_SANITIZE
+#define KEY_NO_SANITIZE
+#endif
+
+typedef struct KeyKernelsS
+{
+  KEY_KERNEL kernel;
+  size_t (*length) (const char* key, size_t maxSize);
+  size_t (*mismatch) (const void* key1, const void* key2, size_t size);
+  int (*string_compare) (const char* key1, const char* key2);
+} KeyKernels;
+
+static size_t key_length_scalar (const char* key, size_t maxSize);
+static size_t key_mismatch_scalar (const void* key1, const void* key2, size_t size);
+static int key_string_compare_scalar (const char* key1, const char* key2);
+
+static const KeyKernels SCALAR_KERNELS = { KEY_KERNEL_SCALAR, key_length_scalar,
+                                           key_mismatch_scalar, key_string_compare_scalar };
+
+#ifdef KEY_SIMD_X86
+static size_t key_length_sse2 (const char* key, size_t maxSize);
+static size_t key_mismatch_sse2 (const void* key1, const void* key2, size_t size);
+static int key_string_compare_sse2 (const char* key1, const char* key2);
+static size_t key_length_avx2 (const char* key, size_t maxSize);
+static size_t key_mismatch_avx2 (const void* key1, const void* key2, size_t size);
+static int key_string_compare_avx2 (const char* key1, const char* key2);
+
+static const KeyKernels SSE2_KERNELS = { KEY_KERNEL_SSE2, key_length_sse2, key_mismatch_sse2,
+                                         key_string_compare_sse2 };
+static const KeyKernels AVX2_KERNELS = { KEY_KERNEL_AVX2, key_length_avx2, key_mismatch_avx2,
+                                         key_string_compare_avx2 };
+#endif
+
+// scalar until the startup selection : usable from other constructors as well
+static const KeyKernels* pKernels = &SCALAR_KERNELS;
+
+static void key_kernels_init (void) __attribute__ ((constructor));
+static int key_byte_compare (unsigned char byte1, unsigned char byte2);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool key_kernel_select (KEY_KERNEL kernel)
+{
+  bool result = true;
+
+  switch (kernel)
+  {
+    case KEY_KERNEL_AUTO:
+      key_kernels_init ();
+      break;
+
+    case KEY_KERNEL_SCALAR:
+      pKernels = &SCALAR_KERNELS;
+      break;
+
+#ifdef KEY_SIMD_X86
+    case KEY_KERNEL_SSE2:
+      __builtin_cpu_init ();
+      result = __builtin_cpu_supports ("sse2");
+      if (result)
+      {
+        pKernels = &SSE2_KERNELS;
+      }
+      break;
+
+    case KEY_KERNEL_AVX2:
+      __builtin_cpu_init ();
+      result = __builtin_cpu_supports ("avx2");
+      if (result)
+      {
+        pKernels = &AVX2_KERNELS;
+      }
+      break;
+#endif
+
+    default:
+      result = false;
+      break;
+  }
+
+  return result;
+}
+
+KEY_KERNEL key_kernel_active (void)
+{
+  return pKernels->kernel;
+}
+
+size_t key_length (const char* key, size_t maxSize)
+{
+  return pKernels->length (key, maxSize);
+}
+
+size_t key_mismatch (const void* key1, const void* key2, size_t size)
+{
+  return pKernels->mismatch (key1, key2, size);
+}
+
+int key_compare (const void* key1, const void* key2, size_t size)
+{
+  size_t index = pKernels->mismatch (key1, key2, size);
+
+  return (index == size) ? 0
+                         : key_byte_compare (((const unsigned char*)key1)[index],
+                                             ((const unsigned char*)key2)[index]);
+}
+
+int key_string_compare (const char* key1, const char* key2)
+{
+  return pKernels->string_compare (key1, key2);
+}
+
+uint64_t key_prefix (const char* key, size_t length)
+{
+  // missing bytes are zeros just like '\0' is
+
+  uint64_t prefix = 0;
+
+  memcpy (&prefix, key, (length < KEY_PREFIX_SIZE) ? length : KEY_PREFIX_SIZE);
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  prefix = __builtin_bswap64 (prefix);
+#endif
+
+  return prefix;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+void key_kernels_init (void)
+{
+  pKernels = &SCALAR_KERNELS;
+
+#ifdef KEY_SIMD_X86
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("avx2"))
+  {
+    pKernels = &AVX2_KERNELS;
+  }
+  else if (__builtin_cpu_supports ("sse2"))
+  {
+    pKernels = &SSE2_KERNELS;
+  }
+#endif
+}
+
+int key_byte_compare (unsigned char byte1, unsigned char byte2)
+{
+  return (byte1 > byte2) - (byte1 < byte2);
+}
+
+size_t key_length_scalar (const char* key, size_t maxSize)
+{
+  size_t length = 0;
+
+  while (length < maxSize && key[length] != '\0')
+  {
+    ++length;
+  }
+
+  return length;
+}
+
+size_t key_mismatch_scalar (const void* key1, const void* key2, size_t size)
+{
+  const unsigned char* pKey1 = (const unsigned char*)key1;
+  const unsigned char* pKey2 = (const unsigned char*)key2;
+  size_t index = 0;
+
+  while (index < size && pKey1[index] == pKey2[index])
+  {
+    ++index;
+  }
+
+  return index;
+}
+
+int key_string_compare_scalar (const char* key1, const char* key2)
+{
+  const unsigned char* pKey1 = (const unsigned char*)key1;
+  const unsigned char* pKey2 = (const unsigned char*)key2;
+
+  while (*pKey1 != '\0' && *pKey1 == *pKey2)
+  {
+    ++pKey1;
+    ++pKey2;
+  }
+
+  return key_byte_compare (*pKey1, *pKey2);
+}
+
+#ifdef KEY_SIMD_X86
+
+/* string kernels read whole vectors past the terminator :
+ * > key_length loads aligned vectors, they never cross a page
+ * > key_string_compare loads unaligned ones, so vectors crossing a page are compared bytewise
+ *
+ * such reads are invisible to the program but not to address sanitizer
+ */
+
+#define KEY_IS_IN_PAGE(pointer, width) \
+  (((uintptr_t)(pointer) & (KEY_PAGE_SIZE - 1)) <= KEY_PAGE_SIZE - (width))
+
+__attribute__ ((target ("sse2"))) KEY_NO_SANITIZE size_t key_length_sse2 (const char* key,
+                                                                          size_t maxSize)
+{
+  size_t length = 0;
+
+  if (maxSize != 0)
+  {
+    // bytes before the key are shifted out of the first mask
+    size_t offset = (uintptr_t)key & 15;
+    const __m128i* pBlock = (const __m128i*)(key - offset);
+    const __m128i zero = _mm_setzero_si128 ();
+
+    uint32_t mask = (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_load_si128 (pBlock), zero));
+    mask >>= offset;
+
+    // 'length' is the key offset of the current block start
+    if (mask == 0)
+    {
+      for (length = 16 - offset; length < maxSize; length += 16)
+      {
+        mask = (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_load_si128 (++pBlock), zero));
+        if (mask != 0)
+        {
+          break;
+        }
+      }
+    }
+
+    if (mask != 0)
+    {
+      length += __builtin_ctz (mask);
+    }
+
+    length = (length < maxSize) ? length : maxSize;
+  }
+
+  return length;
+}
+
+__attribute__ ((target ("sse2"))) size_t key_mismatch_sse2 (const void* key1, const void* key2,
+                                                            size_t size)
+{
+  const char* pKey1 = (const char*)key1;
+  const char* pKey2 = (const char*)key2;
+  size_t index = 0;
+
+  for (; index + 16 <= size; index += 16)
+  {
+    __m128i block1 = _mm_loadu_si128 ((const __m128i*)(pKey1 + index));
+    __m128i block2 = _mm_loadu_si128 ((const __m128i*)(pKey2 + index));
+    uint32_t mask = (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (block1, block2)) ^ 0xFFFF;
+
+    if (mask != 0)
+    {
+      return index + __builtin_ctz (mask);
+    }
+  }
+
+  return index + key_mismatch_scalar (pKey1 + index, pKey2 + index, size - index);
+}
+
+__attribute__ ((target ("sse2"))) KEY_NO_SANITIZE int key_string_compare_sse2 (const char* key1,
+                                                                               const char* key2)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+
+  for (size_t index = 0;; index += 16)
+  {
+    const char* pKey1 = key1 + index;
+    const char* pKey2 = key2 + index;
+
+    if (!KEY_IS_IN_PAGE (pKey1, 16) || !KEY_IS_IN_PAGE (pKey2, 16))
+    {
+      for (int i = 0; i < 16; ++i)
+      {
+        if (pKey1[i] != pKey2[i] || pKey1[i] == '\0')
+        {
+          return key_byte_compare ((unsigned char)pKey1[i], (unsigned char)pKey2[i]);
+        }
+      }
+
+      continue;
+    }
+
+    __m128i block1 = _mm_loadu_si128 ((const __m128i*)pKey1);
+    __m128i block2 = _mm_loadu_si128 ((const __m128i*)pKey2);
+
+    // the first byte which differs or ends the key
+    uint32_t mask = ((uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (block1, block2)) ^ 0xFFFF)
+                    | (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (block1, zero));
+
+    if (mask != 0)
+    {
+      int i = __builtin_ctz (mask);
+      return key_byte_compare ((unsigned char)pKey1[i], (unsigned char)pKey2[i]);
+    }
+  }
+}
+
+__attribute__ ((target ("avx2"))) KEY_NO_SANITIZE size_t key_length_avx2 (const char* key,
+                                                                          size_t maxSize)
+{
+  size_t length = 0;
+
+  if (maxSize != 0)
+  {
+    // bytes before the key are shifted out of the first mask
+    size_t offset = (uintptr_t)key & 31;
+    const __m256i* pBlock = (const __m256i*)(key - offset);
+    const __m256i zero = _mm256_setzero_si256 ();
+
+    uint32_t mask =
+      (uint32_t)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_load_si256 (pBlock), zero));
+    mask >>= offset;
+
+    // 'length' is the key offset of the current block start
+    if (mask == 0)
+    {
+      for (length = 32 - offset; length < maxSize; length += 32)
+      {
+        mask = (uint32_t)_mm256_movemask_epi8 (
+          _mm256_cmpeq_epi8 (_mm256_load_si256 (++pBlock), zero));
+        if (mask != 0)
+        {
+          break;
+        }
+      }
+    }
+
+    if (mask != 0)
+    {
+      length += __builtin_ctz (mask);
+    }
+
+    length = (length < maxSize) ? length : maxSize;
+  }
+
+  return length;
+}
+
+__attribute__ ((target ("avx2"))) size_t key_mismatch_avx2 (const void* key1, const void* key2,
+                                                            size_t size)
+{
+  const char* pKey1 = (const char*)key1;
+  const char* pKey2 = (const char*)key2;
+  size_t index = 0;
+
+  for (; index + 32 <= size; index += 32)
+  {
+    __m256i block1 = _mm256_loadu_si256 ((const __m256i*)(pKey1 + index));
+    __m256i block2 = _mm256_loadu_si256 ((const __m256i*)(pKey2 + index));
+    uint32_t mask = ~(uint32_t)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (block1, block2));
+
+    if (mask != 0)
+    {
+      return index + __builtin_ctz (mask);
+    }
+  }
+
+  // the tail is shorter than 32 bytes
+  return index + key_mismatch_sse2 (pKey1 + index, pKey2 + index, size - index);
+}
+
+__attribute__ ((target ("avx2"))) KEY_NO_SANITIZE int key_string_compare_avx2 (const char* key1,
+                                                                               const char* key2)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+
+  for (size_t index = 0;; index += 32)
+  {
+    const char* pKey1 = key1 + index;
+    const char* pKey2 = key2 + index;
+
+    if (!KEY_IS_IN_PAGE (pKey1, 32) || !KEY_IS_IN_PAGE (pKey2, 32))
+    {
+      for (int i = 0; i < 32; ++i)
+      {
+        if (pKey1[i] != pKey2[i] || pKey1[i] == '\0')
+        {
+          return key_byte_compare ((unsigned char)pKey1[i], (unsigned char)pKey2[i]);
+        }
+      }
+
+      continue;
+    }
+
+    __m256i block1 = _mm256_loadu_si256 ((const __m256i*)pKey1);
+    __m256i block2 = _mm256_loadu_si256 ((const __m256i*)pKey2);
+
+    // the first byte which differs or ends the key
+    uint32_t mask = ~(uint32_t)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (block1, block2))
+                    | (uint32_t)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (block1, zero));
+
+    if (mask != 0)
+    {
+      int i = __builtin_ctz (mask);
+      return key_byte_compare ((unsigned char)pKey1[i], (unsigned char)pKey2[i]);
+    }
+  }
+}
+
+#endif    // KEY_SIMD_X86
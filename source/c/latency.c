@@ -0,0 +1,360 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/c/latency.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define LATENCY_CACHE_LINE (64)
+#define LATENCY_CALIBRATION_NS (10000000ULL)    // TSC rate is measured over 10 ms at least
+
+// histograms of one thread : written by the owner only, read by mergers
+typedef struct LatencyRecordS
+{
+  struct LatencyRecordS* pNext;    // registry link, records are never unlinked
+  bool isBusy;                     // owned by a live thread
+
+  uint64_t counts[LATENCY_OPS_COUNT][LATENCY_BUCKETS];
+  uint64_t maxTicks[LATENCY_OPS_COUNT];
+} LatencyRecord;
+
+static LatencyRecord* records = NULL;    // atomic head of the registry
+static __thread LatencyRecord* pThreadRecord = NULL;
+
+static pthread_once_t initOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t threadKey;    // releases the record of an exiting thread
+static uint64_t startTicks = 0;    // TSC calibration point
+static uint64_t startNs = 0;
+
+static const char* opNames[LATENCY_OPS_COUNT] = {
+  "queue_push",
+  "queue_pop",
+  "rbt_insert",
+  "rbt_get",
+};
+
+static void latency_init (void);
+static uint64_t latency_clock_ns (void);
+static LatencyRecord* latency_attach (void);
+static void latency_detach (void* pRecord);
+static size_t latency_bucket (uint64_t ticks);
+static uint64_t latency_bucket_max (size_t bucket);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+void latency_record (LATENCY_OP op, uint64_t ticks)
+{
+  LatencyRecord* pRecord = pThreadRecord;
+
+  if ((unsigned int)op < LATENCY_OPS_COUNT
+      && (pRecord != NULL || (pRecord = latency_attach ()) != NULL))
+  {
+    // the owner is the only writer : no read-modify-write atomics
+    uint64_t* pCount = &pRecord->counts[op][latency_bucket (ticks)];
+    __atomic_store_n (pCount, __atomic_load_n (pCount, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+
+    if (ticks > __atomic_load_n (&pRecord->maxTicks[op], __ATOMIC_RELAXED))
+    {
+      __atomic_store_n (&pRecord->maxTicks[op], ticks, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+void latency_histogram_record (LatencyHistogram* pHistogram, uint64_t ticks)
+{
+  ++pHistogram->counts[latency_bucket (ticks)];
+  ++pHistogram->count;
+
+  if (ticks > pHistogram->maxTicks)
+  {
+    pHistogram->maxTicks = ticks;
+  }
+}
+
+bool latency_merge (LATENCY_OP op, LatencyHistogram* pHistogram)
+{
+  bool result = false;
+
+  do
+  {
+    if ((unsigned int)op >= LATENCY_OPS_COUNT || pHistogram == NULL)
+    {
+      break;
+    }
+
+    memset (pHistogram, 0, sizeof (*pHistogram));
+    pHistogram->ticksPerNs = latency_ticks_per_ns ();
+
+    LatencyRecord* pRecord = __atomic_load_n (&records, __ATOMIC_ACQUIRE);
+
+    for (; pRecord != NULL; pRecord = pRecord->pNext)
+    {
+      for (size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+      {
+        uint64_t count = __atomic_load_n (&pRecord->counts[op][bucket], __ATOMIC_RELAXED);
+
+        pHistogram->counts[bucket] += count;
+        pHistogram->count += count;
+      }
+
+      uint64_t maxTicks = __atomic_load_n (&pRecord->maxTicks[op], __ATOMIC_RELAXED);
+
+      if (maxTicks > pHistogram->maxTicks)
+      {
+        pHistogram->maxTicks = maxTicks;
+      }
+    }
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+uint64_t latency_percentile (const LatencyHistogram* pHistogram, double quantile)
+{
+  uint64_t result = 0;
+
+  if (pHistogram != NULL && pHistogram->count != 0)
+  {
+    // rank of the quantile sample, 1-based
+    uint64_t rank = (uint64_t)(quantile * (double)pHistogram->count + 0.5);
+    rank = (rank == 0) ? 1 : (rank > pHistogram->count) ? pHistogram->count : rank;
+
+    uint64_t seen = 0;
+    size_t bucket = 0;
+
+    while (bucket < LATENCY_BUCKETS - 1 && (seen += pHistogram->counts[bucket]) < rank)
+    {
+      ++bucket;
+    }
+
+    // the bucket bound overestimates the top samples : the maximum is exact
+    uint64_t ticks = latency_bucket_max (bucket);
+    ticks = (ticks < pHistogram->maxTicks && rank < pHistogram->count) ? ticks
+                                                                       : pHistogram->maxTicks;
+
+    result = (uint64_t)((double)ticks / pHistogram->ticksPerNs + 0.5);
+  }
+
+  return result;
+}
+
+bool latency_dump (FILE* pFile)
+{
+  bool result = false;
+  LatencyHistogram* pHistogram = NULL;
+
+  do
+  {
+    // ~5 KB : not for the caller stack
+    pHistogram = (LatencyHistogram*)malloc (sizeof (LatencyHistogram));
+
+    if (pFile == NULL || pHistogram == NULL)
+    {
+      break;
+    }
+
+    fprintf (pFile, "%-12s %12s %12s %12s %12s %12s\n", "op", "count", "p50_ns", "p99_ns",
+             "p999_ns", "max_ns");
+
+    for (int op = 0; op < LATENCY_OPS_COUNT; ++op)
+    {
+      if (!latency_merge ((LATENCY_OP)op, pHistogram) || pHistogram->count == 0)
+      {
+        continue;
+      }
+
+      fprintf (pFile, "%-12s %12llu %12llu %12llu %12llu %12llu\n", opNames[op],
+               (unsigned long long)pHistogram->count,
+               (unsigned long long)latency_percentile (pHistogram, 0.5),
+               (unsigned long long)latency_percentile (pHistogram, 0.99),
+               (unsigned long long)latency_percentile (pHistogram, 0.999),
+               (unsigned long long)latency_percentile (pHistogram, 1.0));
+    }
+
+    result = (fflush (pFile) == 0);
+
+  } while (0);
+
+  free (pHistogram);
+
+  return result;
+}
+
+void latency_reset (void)
+{
+  LatencyRecord* pRecord = __atomic_load_n (&records, __ATOMIC_ACQUIRE);
+
+  for (; pRecord != NULL; pRecord = pRecord->pNext)
+  {
+    for (int op = 0; op < LATENCY_OPS_COUNT; ++op)
+    {
+      for (size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+      {
+        __atomic_store_n (&pRecord->counts[op][bucket], 0, __ATOMIC_RELAXED);
+      }
+
+      __atomic_store_n (&pRecord->maxTicks[op], 0, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+const char* latency_op_name (LATENCY_OP op)
+{
+  return ((unsigned int)op < LATENCY_OPS_COUNT) ? opNames[op] : NULL;
+}
+
+double latency_ticks_per_ns (void)
+{
+  double result = 1.0;
+
+#if defined(__x86_64__)
+  // TSC ticks at a constant rate : measured against the clock since the first use
+  (void)pthread_once (&initOnce, latency_init);
+
+  uint64_t elapsedNs = latency_clock_ns () - startNs;
+
+  while (elapsedNs < LATENCY_CALIBRATION_NS)
+  {
+    struct timespec pause = { 0, (long)(LATENCY_CALIBRATION_NS - elapsedNs) };
+    nanosleep (&pause, NULL);
+
+    elapsedNs = latency_clock_ns () - startNs;
+  }
+
+  result = (double)(latency_ticks () - startTicks) / (double)elapsedNs;
+#endif
+
+  return result;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+void latency_init (void)
+{
+  (void)pthread_key_create (&threadKey, latency_detach);
+
+  startTicks = latency_ticks ();
+  startNs = latency_clock_ns ();
+}
+
+uint64_t latency_clock_ns (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC_RAW, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+LatencyRecord* latency_attach (void)
+{
+  // the slow path of the first record of a thread : an idle record is reused or a new one
+  // is published, its histograms keep counts of the previous owner
+
+  LatencyRecord* pRecord = NULL;
+
+  do
+  {
+    (void)pthread_once (&initOnce, latency_init);
+
+    for (pRecord = __atomic_load_n (&records, __ATOMIC_ACQUIRE); pRecord != NULL;
+         pRecord = pRecord->pNext)
+    {
+      bool isBusy = false;
+
+      if (!__atomic_load_n (&pRecord->isBusy, __ATOMIC_RELAXED)
+          && __atomic_compare_exchange_n (&pRecord->isBusy, &isBusy, true, false,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+    }
+
+    if (pRecord == NULL)
+    {
+      pRecord = (LatencyRecord*)aligned_alloc (
+          LATENCY_CACHE_LINE,
+          (sizeof (LatencyRecord) + LATENCY_CACHE_LINE - 1) & ~(size_t)(LATENCY_CACHE_LINE - 1));
+
+      if (pRecord == NULL)
+      {
+        break;
+      }
+
+      memset (pRecord, 0, sizeof (LatencyRecord));
+      pRecord->isBusy = true;
+      pRecord->pNext = __atomic_load_n (&records, __ATOMIC_RELAXED);
+
+      while (!__atomic_compare_exchange_n (&records, &pRecord->pNext, pRecord, false,
+                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+      {
+      }
+    }
+
+    (void)pthread_setspecific (threadKey, pRecord);
+    pThreadRecord = pRecord;
+
+  } while (0);
+
+  return pRecord;
+}
+
+void latency_detach (void* pRecord)
+{
+  __atomic_store_n (&((LatencyRecord*)pRecord)->isBusy, false, __ATOMIC_RELEASE);
+}
+
+size_t latency_bucket (uint64_t ticks)
+{
+  // [0, 16) : one bucket per value, then 16 buckets per power of two
+
+  size_t result = (size_t)ticks;
+
+  if (ticks >= LATENCY_SUB_BUCKETS)
+  {
+    unsigned int exponent = 63 - (unsigned int)__builtin_clzll (ticks);
+
+    if (exponent >= LATENCY_MAX_BITS)
+    {
+      result = LATENCY_BUCKETS - 1;
+    }
+    else
+    {
+      unsigned int shift = exponent - LATENCY_SUB_BITS;
+
+      result = (size_t)(shift + 1) * LATENCY_SUB_BUCKETS
+               + (size_t)((ticks >> shift) & (LATENCY_SUB_BUCKETS - 1));
+    }
+  }
+
+  return result;
+}
+
+uint64_t latency_bucket_max (size_t bucket)
+{
+  // the largest value of the bucket, see latency_bucket ()
+
+  uint64_t result = bucket;
+
+  if (bucket >= LATENCY_SUB_BUCKETS)
+  {
+    unsigned int shift = (unsigned int)(bucket / LATENCY_SUB_BUCKETS) - 1;
+    uint64_t sub = bucket % LATENCY_SUB_BUCKETS;
+
+    result = ((LATENCY_SUB_BUCKETS + sub + 1) << shift) - 1;
+  }
+
+  return result;
+}
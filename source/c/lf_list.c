@@ -0,0 +1,431 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/c/key_utils.h"
+#include "../../include/c/lf_list.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define LFL_ALIGNMENT (_Alignof (max_align_t))
+#define LFL_ALIGN_UP(size) (((size) + LFL_ALIGNMENT - 1) & ~(LFL_ALIGNMENT - 1))
+
+#define LFL_LOAD(pValue) __atomic_load_n (pValue, __ATOMIC_ACQUIRE)
+#define LFL_CAS(pValue, pExpected, desired)                                      \
+  __atomic_compare_exchange_n (pValue, pExpected, desired, false, __ATOMIC_ACQ_REL, \
+                               __ATOMIC_ACQUIRE)
+
+// the low bit of 'next' : the node owning the link is logically deleted
+#define LFL_MARK(pNode) ((LFListNode*)((uintptr_t)(pNode) | 1))
+#define LFL_UNMARK(pNode) ((LFListNode*)((uintptr_t)(pNode) & ~(uintptr_t)1))
+#define LFL_IS_MARKED(pNode) (((uintptr_t)(pNode)&1) != 0)
+
+#define LFL_DATA_OFFSET LFL_ALIGN_UP (sizeof (LFListNode))
+
+// node : [ LFListNode | payload | key '\0' ]
+struct LFListNodeS
+{
+  LFListNode* next;    // atomic, marked
+
+  uint64_t keyPrefix;    // first key bytes in big-endian order, compared before the key itself
+  size_t keyLength;
+  const char* key;
+
+  void* data;
+  size_t dataSize;
+};
+
+// searched key : length and prefix are computed once per call
+typedef struct KeyInfoS
+{
+  const char* key;
+  size_t length;
+  uint64_t prefix;
+} KeyInfo;
+
+static bool lfl_key_info (const char* key, KeyInfo* pKey);
+static int lfl_key_compare (const LFListNode* pNode, const KeyInfo* pKey);
+static LFListNode* lfl_create_node (Heap* pHeap, const KeyInfo* pKey, const void* pItem,
+                                    size_t itemSize);
+static bool lfl_find (LFList* pList, SmrRecord* pRecord, const KeyInfo* pKey,
+                      LFListNode*** pPrev, LFListNode** pCurr);
+static void lfl_release_node (void* pNode, void* pContext);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool lfl_init (LFList* pList)
+{
+  return lfl_init_allocator (pList, NULL);
+}
+
+bool lfl_init_allocator (LFList* pList, const Allocator* pAllocator)
+{
+  bool result = false;
+
+  if (pList != NULL && heap_init (&pList->heap, pAllocator)
+      && smr_init (&pList->smr, SMR_EPOCH, lfl_release_node, &pList->heap))
+  {
+    pList->head = NULL;
+    pList->count = 0;
+
+    result = true;
+  }
+
+  return result;
+}
+
+void lfl_destroy (LFList* pList)
+{
+  LFListNode* pNode = pList->head;
+
+  while (pNode != NULL)
+  {
+    LFListNode* pNext = LFL_UNMARK (pNode->next);
+    lfl_release_node (pNode, &pList->heap);
+    pNode = pNext;
+  }
+
+  smr_destroy (&pList->smr);
+
+  pList->head = NULL;
+  pList->count = 0;
+}
+
+bool lfl_insert (LFList* pList, const void* pItem, size_t itemSize, const char* key)
+{
+  // the new node is published by CAS on the predecessor link : it fails if the predecessor
+  // was marked or got another successor meanwhile, then the position is searched again
+
+  bool result = false;
+  KeyInfo keyInfo;
+  LFListNode* pNode = NULL;
+
+  do
+  {
+    if (!lfl_key_info (key, &keyInfo) || pItem == NULL)
+    {
+      break;
+    }
+
+    LFListNode** pPrev = NULL;
+    LFListNode* pCurr = NULL;
+    SmrRecord* pRecord = smr_enter (&pList->smr);
+
+    while (!lfl_find (pList, pRecord, &keyInfo, &pPrev, &pCurr))
+    {
+      if (pNode == NULL)
+      {
+        pNode = lfl_create_node (&pList->heap, &keyInfo, pItem, itemSize);
+        if (pNode == NULL)
+        {
+          break;
+        }
+      }
+
+      pNode->next = pCurr;
+
+      if (LFL_CAS (pPrev, &pCurr, pNode))
+      {
+        __atomic_add_fetch (&pList->count, 1, __ATOMIC_RELAXED);
+
+        result = true;
+        break;
+      }
+    }
+
+    smr_exit (&pList->smr, pRecord);
+
+    if (!result && pNode != NULL)    // the key exists, the node was never published
+    {
+      lfl_release_node (pNode, &pList->heap);
+    }
+
+  } while (0);
+
+  return result;
+}
+
+bool lfl_get (LFList* pList, void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (!lfl_key_info (key, &keyInfo) || pItem == NULL)
+    {
+      break;
+    }
+
+    // marked links are just passed through : readers don't help writers
+    SmrRecord* pRecord = smr_enter (&pList->smr);
+    LFListNode* pNode = LFL_LOAD (&pList->head);
+    int compare = 1;
+
+    while (pNode != NULL && (compare = lfl_key_compare (pNode, &keyInfo)) < 0)
+    {
+      pNode = LFL_UNMARK (LFL_LOAD (&pNode->next));
+    }
+
+    if (pNode != NULL && compare == 0 && !LFL_IS_MARKED (LFL_LOAD (&pNode->next))
+        && pNode->dataSize <= itemSize)
+    {
+      // payload is immutable after insertion
+      memcpy (pItem, pNode->data, pNode->dataSize);
+
+      result = true;
+    }
+
+    smr_exit (&pList->smr, pRecord);
+
+  } while (0);
+
+  return result;
+}
+
+bool lfl_delete (LFList* pList, const char* key)
+{
+  // the one who marks the victim deletes it; the one whose CAS unlinks it retires it
+
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (!lfl_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    LFListNode** pPrev = NULL;
+    LFListNode* pCurr = NULL;
+    SmrRecord* pRecord = smr_enter (&pList->smr);
+
+    while (lfl_find (pList, pRecord, &keyInfo, &pPrev, &pCurr))
+    {
+      LFListNode* pNext = LFL_LOAD (&pCurr->next);
+
+      if (LFL_IS_MARKED (pNext))    // deleted by another thread : search again
+      {
+        continue;
+      }
+
+      if (!LFL_CAS (&pCurr->next, &pNext, LFL_MARK (pNext)))
+      {
+        continue;
+      }
+
+      __atomic_sub_fetch (&pList->count, 1, __ATOMIC_RELAXED);
+
+      if (LFL_CAS (pPrev, &pCurr, pNext))
+      {
+        smr_retire (&pList->smr, pRecord, pCurr);
+      }
+      else    // the predecessor changed : the search unlinks the victim
+      {
+        (void)lfl_find (pList, pRecord, &keyInfo, &pPrev, &pCurr);
+      }
+
+      result = true;
+      break;
+    }
+
+    smr_exit (&pList->smr, pRecord);
+
+  } while (0);
+
+  return result;
+}
+
+size_t lfl_count (LFList* pList)
+{
+  return __atomic_load_n (&pList->count, __ATOMIC_RELAXED);
+}
+
+bool lfl_for_each (LFList* pList, LFListCallback callback, void* pContext)
+{
+  bool result = false;
+
+  if (callback != NULL)
+  {
+    SmrRecord* pRecord = smr_enter (&pList->smr);
+    LFListNode* pNode = LFL_LOAD (&pList->head);
+
+    while (pNode != NULL)
+    {
+      LFListNode* pNext = LFL_LOAD (&pNode->next);
+
+      if (!LFL_IS_MARKED (pNext)
+          && !callback (pNode->key, pNode->data, pNode->dataSize, pContext))
+      {
+        break;
+      }
+
+      pNode = LFL_UNMARK (pNext);
+    }
+
+    smr_exit (&pList->smr, pRecord);
+
+    result = true;
+  }
+
+  return result;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+bool lfl_key_info (const char* key, KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    if (key == NULL)
+    {
+      break;
+    }
+
+    size_t keyLen = key_length (key, LFL_KEY_SIZE);
+
+    if (keyLen > LFL_KEY_SIZE - 1)    // for '\0'
+    {
+      break;
+    }
+
+    pKey->key = key;
+    pKey->length = keyLen;
+    pKey->prefix = key_prefix (key, keyLen);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+int lfl_key_compare (const LFListNode* pNode, const KeyInfo* pKey)
+{
+  // strcmp (pNode->key, pKey->key) equivalent, see rbt_key_compare ()
+
+  int result = 0;
+
+  if (pNode->keyPrefix != pKey->prefix)
+  {
+    result = (pNode->keyPrefix < pKey->prefix) ? -1 : 1;
+  }
+  else if (pNode->keyLength > KEY_PREFIX_SIZE || pKey->length > KEY_PREFIX_SIZE)
+  {
+    size_t length = (pNode->keyLength < pKey->length) ? pNode->keyLength : pKey->length;
+
+    result = key_compare (pNode->key + KEY_PREFIX_SIZE, pKey->key + KEY_PREFIX_SIZE,
+                          length + 1 - KEY_PREFIX_SIZE);
+  }
+
+  return result;
+}
+
+LFListNode* lfl_create_node (Heap* pHeap, const KeyInfo* pKey, const void* pItem, size_t itemSize)
+{
+  LFListNode* pNode = NULL;
+
+  do
+  {
+    size_t dataOffset = LFL_DATA_OFFSET;
+
+    pNode = (LFListNode*)heap_alloc (pHeap, dataOffset + itemSize + pKey->length + 1);
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    char* pData = (char*)pNode + dataOffset;
+    char* pKeyCopy = pData + itemSize;
+
+    memcpy (pData, pItem, itemSize);
+    memcpy (pKeyCopy, pKey->key, pKey->length + 1);
+
+    pNode->next = NULL;
+    pNode->keyPrefix = pKey->prefix;
+    pNode->keyLength = pKey->length;
+    pNode->key = pKeyCopy;
+    pNode->data = pData;
+    pNode->dataSize = itemSize;
+
+  } while (0);
+
+  return pNode;
+}
+
+bool lfl_find (LFList* pList, SmrRecord* pRecord, const KeyInfo* pKey, LFListNode*** pPrev,
+               LFListNode** pCurr)
+{
+  /* *pCurr : the first node with node.key >= key or NULL, *pPrev : the unmarked link to it
+   *
+   * marked nodes on the way are unlinked, the search starts over if the predecessor
+   * link changes under us
+   */
+
+  bool isFound = false;
+  bool isRetry = false;
+
+  do
+  {
+    LFListNode** pLink = &pList->head;
+    LFListNode* pNode = LFL_LOAD (pLink);
+
+    isFound = false;
+    isRetry = false;
+
+    while (pNode != NULL)
+    {
+      LFListNode* pNext = LFL_LOAD (&pNode->next);
+
+      if (LFL_IS_MARKED (pNext))
+      {
+        if (!LFL_CAS (pLink, &pNode, LFL_UNMARK (pNext)))
+        {
+          isRetry = true;
+          break;
+        }
+
+        smr_retire (&pList->smr, pRecord, pNode);
+        pNode = LFL_UNMARK (pNext);
+        continue;
+      }
+
+      int compare = lfl_key_compare (pNode, pKey);
+
+      if (compare >= 0)
+      {
+        isFound = (compare == 0);
+        break;
+      }
+
+      pLink = &pNode->next;
+      pNode = pNext;
+    }
+
+    *pPrev = pLink;
+    *pCurr = pNode;
+
+  } while (isRetry);
+
+  return isFound;
+}
+
+void lfl_release_node (void* pNode, void* pContext)
+{
+  // pContext : the list heap, the node size is known from its payload and key
+  LFListNode* pListNode = (LFListNode*)pNode;
+
+  heap_free ((Heap*)pContext, pNode,
+             LFL_DATA_OFFSET + pListNode->dataSize + pListNode->keyLength + 1);
+}
@@ -0,0 +1,142 @@
+#include "../../include/c/list.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+static void list_link (List* pItem, List* pPrev, List* pNext);
+static void list_unlink (List* pPrev, List* pNext);
+static void list_splice_between (List* pList, List* pPrev, List* pNext);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+void list_init (List* pHead)
+{
+  pHead->prev = pHead;
+  pHead->next = pHead;
+}
+
+bool list_is_empty (const List* pHead)
+{
+  return pHead->next == pHead;
+}
+
+bool list_is_singular (const List* pHead)
+{
+  return pHead->next != pHead && pHead->next == pHead->prev;
+}
+
+size_t list_count (const List* pHead)
+{
+  size_t count = 0;
+
+  for (const List* pItem = pHead->next; pItem != pHead; pItem = pItem->next)
+  {
+    ++count;
+  }
+
+  return count;
+}
+
+void list_add (List* pHead, List* pItem)
+{
+  list_link (pItem, pHead, pHead->next);
+}
+
+void list_add_tail (List* pHead, List* pItem)
+{
+  list_link (pItem, pHead->prev, pHead);
+}
+
+void list_del (List* pItem)
+{
+  list_unlink (pItem->prev, pItem->next);
+  list_init (pItem);
+}
+
+void list_replace (List* pOld, List* pNew)
+{
+  pNew->next = pOld->next;
+  pNew->next->prev = pNew;
+  pNew->prev = pOld->prev;
+  pNew->prev->next = pNew;
+
+  list_init (pOld);
+}
+
+void list_move (List* pHead, List* pItem)
+{
+  list_unlink (pItem->prev, pItem->next);
+  list_add (pHead, pItem);
+}
+
+void list_move_tail (List* pHead, List* pItem)
+{
+  list_unlink (pItem->prev, pItem->next);
+  list_add_tail (pHead, pItem);
+}
+
+void list_splice (List* pHead, List* pList)
+{
+  if (!list_is_empty (pList))
+  {
+    list_splice_between (pList, pHead, pHead->next);
+    list_init (pList);
+  }
+}
+
+void list_splice_tail (List* pHead, List* pList)
+{
+  if (!list_is_empty (pList))
+  {
+    list_splice_between (pList, pHead->prev, pHead);
+    list_init (pList);
+  }
+}
+
+List* list_first (const List* pHead)
+{
+  return list_is_empty (pHead) ? NULL : pHead->next;
+}
+
+List* list_last (const List* pHead)
+{
+  return list_is_empty (pHead) ? NULL : pHead->prev;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+void list_link (List* pItem, List* pPrev, List* pNext)
+{
+  pNext->prev = pItem;
+  pItem->next = pNext;
+  pItem->prev = pPrev;
+  pPrev->next = pItem;
+}
+
+void list_unlink (List* pPrev, List* pNext)
+{
+  pNext->prev = pPrev;
+  pPrev->next = pNext;
+}
+
+void list_splice_between (List* pList, List* pPrev, List* pNext)
+{
+  // items of non-empty pList are placed between pPrev and pNext
+
+  List* pFirst = pList->next;
+  List* pLast = pList->prev;
+
+  pFirst->prev = pPrev;
+  pPrev->next = pFirst;
+
+  pLast->next = pNext;
+  pNext->prev = pLast;
+}
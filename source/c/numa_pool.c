@@ -0,0 +1,362 @@
+#define _GNU_SOURCE    // sched_getcpu ()
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CONTAINERS_HAVE_LIBNUMA
+  #include <numa.h>
+#endif
+
+#include "../../include/c/numa_pool.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define NUMA_POOL_MIN_CHUNK (16)
+#define NUMA_POOL_MAX_CHUNK (NUMA_POOL_MIN_CHUNK << (NUMA_POOL_CLASSES - 1))
+#define NUMA_POOL_PAGE_SIZE (4096)
+#define NUMA_POOL_CACHE_LINE (64)
+#define NUMA_POOL_ALIGN_UP(size, alignment) (((size) + (alignment) - 1) & ~((size_t)(alignment) - 1))
+
+#define NUMA_BLOCK_HEADER_SIZE NUMA_POOL_ALIGN_UP (sizeof (NumaBlock), NUMA_POOL_CACHE_LINE)
+#define NUMA_LARGE_HEADER_SIZE NUMA_POOL_ALIGN_UP (sizeof (bool), _Alignof (max_align_t))
+
+// block : [ NumaBlock | chunks ... ], the first block has the pool after its header
+struct NumaBlockS
+{
+  NumaBlock* next;
+  bool isBound;    // numa_alloc_onnode () memory, otherwise aligned_alloc ()
+};
+
+// pool built on a thread running on the node
+typedef struct PoolTaskS
+{
+  int node;
+  NumaPool* pPool;    // output
+} PoolTask;
+
+static NumaPool* numa_pool_build (int node);
+static void* numa_pool_alloc (size_t size, void* pContext);
+static void numa_pool_free (void* pMemory, size_t size, void* pContext);
+static void* numa_node_alloc (int node, size_t size, bool* pIsBound);
+static void numa_node_free (void* pMemory, size_t size, bool isBound);
+static NumaBlock* numa_pool_add_block (NumaPool* pPool, int node);
+static int numa_pool_class (size_t size);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool numa_is_available (void)
+{
+#ifdef CONTAINERS_HAVE_LIBNUMA
+  return numa_available () >= 0;
+#else
+  return false;
+#endif
+}
+
+int numa_nodes_count (void)
+{
+  int result = 1;
+
+#ifdef CONTAINERS_HAVE_LIBNUMA
+  if (numa_is_available ())
+  {
+    result = numa_max_node () + 1;
+  }
+#endif
+
+  return result;
+}
+
+int numa_current_node (void)
+{
+  int result = 0;
+
+#ifdef CONTAINERS_HAVE_LIBNUMA
+  // numa_node_of_cpu () scans the node masks : looked up when the thread changes the CPU only
+  static __thread int lastCpu = -1;
+  static __thread int lastNode = 0;
+
+  int cpu = sched_getcpu ();
+
+  if (cpu >= 0 && cpu != lastCpu && numa_is_available ())
+  {
+    lastNode = numa_node_of_cpu (cpu);
+    lastNode = (lastNode < 0) ? 0 : lastNode;
+    lastCpu = cpu;
+  }
+
+  result = lastNode;
+#endif
+
+  return result;
+}
+
+static THREAD_ROUTINE (numa_pool_routine, pArg)
+{
+  PoolTask* pTask = (PoolTask*)pArg;
+
+#ifdef CONTAINERS_HAVE_LIBNUMA
+  (void)numa_run_on_node (pTask->node);
+#endif
+
+  pTask->pPool = numa_pool_build (pTask->node);
+  return THREAD_ROUTINE_RET_CODE ();
+}
+
+NumaPool* numa_pool_create (int node)
+{
+  NumaPool* pPool = NULL;
+
+  do
+  {
+    int currentNode = numa_current_node ();
+
+    if (node < 0)
+    {
+      node = currentNode;
+    }
+
+    if (node >= numa_nodes_count ())
+    {
+      break;
+    }
+
+    // another node : first touch of the fallback faults the pages in there as well
+    if (node != currentNode)
+    {
+      THREAD_TYPE thread;
+      PoolTask task = { node, NULL };
+
+      if (CREATE_THREAD (thread, numa_pool_routine, &task) == 0)
+      {
+        (void)JOIN_THREAD (thread);
+
+        pPool = task.pPool;
+        break;
+      }
+    }
+
+    pPool = numa_pool_build (node);
+
+  } while (0);
+
+  return pPool;
+}
+
+void numa_pool_release (NumaPool* pPool)
+{
+  if (pPool != NULL)
+  {
+    (void)mutex_destroy (&pPool->mutex);
+
+    // the first block holding the pool is the last one in the list
+    NumaBlock* pBlock = pPool->blocks;
+
+    while (pBlock != NULL)
+    {
+      NumaBlock* pNext = pBlock->next;
+      numa_node_free (pBlock, NUMA_POOL_BLOCK_SIZE, pBlock->isBound);
+      pBlock = pNext;
+    }
+  }
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+NumaPool* numa_pool_build (int node)
+{
+  NumaPool* pPool = NULL;
+
+  do
+  {
+    // the pool is placed in its first block, carving starts after it
+    NumaBlock* pBlock = numa_pool_add_block (NULL, node);
+    if (pBlock == NULL)
+    {
+      break;
+    }
+
+    pPool = (NumaPool*)((char*)pBlock + NUMA_BLOCK_HEADER_SIZE);
+    memset (pPool, 0, sizeof (NumaPool));
+
+    if (!mutex_init (&pPool->mutex))
+    {
+      numa_node_free (pBlock, NUMA_POOL_BLOCK_SIZE, pBlock->isBound);
+      pPool = NULL;
+      break;
+    }
+
+    pPool->node = node;
+    pPool->blocks = pBlock;
+    pPool->blockUsed
+        = NUMA_BLOCK_HEADER_SIZE + NUMA_POOL_ALIGN_UP (sizeof (NumaPool), NUMA_POOL_CACHE_LINE);
+
+    pPool->allocator.alloc = numa_pool_alloc;
+    pPool->allocator.free = numa_pool_free;
+    pPool->allocator.pContext = pPool;
+
+  } while (0);
+
+  return pPool;
+}
+
+void* numa_pool_alloc (size_t size, void* pContext)
+{
+  NumaPool* pPool = (NumaPool*)pContext;
+  void* pMemory = NULL;
+  int sizeClass = numa_pool_class (size);
+
+  if (sizeClass < 0)
+  {
+    // large one : own pages of the node, the header tells how to release them
+    bool isBound = false;
+    char* pLarge = (char*)numa_node_alloc (pPool->node, NUMA_LARGE_HEADER_SIZE + size, &isBound);
+
+    if (pLarge != NULL)
+    {
+      *(bool*)pLarge = isBound;
+      pMemory = pLarge + NUMA_LARGE_HEADER_SIZE;
+    }
+  }
+  else if (mutex_lock (&pPool->mutex))
+  {
+    size_t chunkSize = (size_t)NUMA_POOL_MIN_CHUNK << sizeClass;
+
+    if (pPool->freeLists[sizeClass] != NULL)
+    {
+      pMemory = pPool->freeLists[sizeClass];
+      pPool->freeLists[sizeClass] = *(void**)pMemory;
+    }
+    else
+    {
+      if (pPool->blockUsed + chunkSize > NUMA_POOL_BLOCK_SIZE
+          && numa_pool_add_block (pPool, pPool->node) != NULL)
+      {
+        pPool->blockUsed = NUMA_BLOCK_HEADER_SIZE;
+      }
+
+      if (pPool->blockUsed + chunkSize <= NUMA_POOL_BLOCK_SIZE)
+      {
+        pMemory = (char*)pPool->blocks + pPool->blockUsed;
+        pPool->blockUsed += chunkSize;
+      }
+    }
+
+    (void)mutex_unlock (&pPool->mutex);
+  }
+
+  return pMemory;
+}
+
+void numa_pool_free (void* pMemory, size_t size, void* pContext)
+{
+  NumaPool* pPool = (NumaPool*)pContext;
+  int sizeClass = numa_pool_class (size);
+
+  if (pMemory == NULL)
+  {
+    return;
+  }
+
+  if (sizeClass < 0)
+  {
+    char* pLarge = (char*)pMemory - NUMA_LARGE_HEADER_SIZE;
+    numa_node_free (pLarge, NUMA_LARGE_HEADER_SIZE + size, *(bool*)pLarge);
+  }
+  else if (mutex_lock (&pPool->mutex))
+  {
+    *(void**)pMemory = pPool->freeLists[sizeClass];
+    pPool->freeLists[sizeClass] = pMemory;
+
+    (void)mutex_unlock (&pPool->mutex);
+  }
+}
+
+void* numa_node_alloc (int node, size_t size, bool* pIsBound)
+{
+  void* pMemory = NULL;
+  *pIsBound = false;
+
+#ifdef CONTAINERS_HAVE_LIBNUMA
+  if (numa_is_available () && (pMemory = numa_alloc_onnode (size, node)) != NULL)
+  {
+    *pIsBound = true;
+  }
+#endif
+
+  // first touch : the pages are faulted in on the calling thread node
+  if (pMemory == NULL)
+  {
+    pMemory = aligned_alloc (NUMA_POOL_PAGE_SIZE, NUMA_POOL_ALIGN_UP (size, NUMA_POOL_PAGE_SIZE));
+
+    if (pMemory != NULL)
+    {
+      memset (pMemory, 0, size);
+    }
+  }
+
+  return pMemory;
+}
+
+void numa_node_free (void* pMemory, size_t size, bool isBound)
+{
+#ifdef CONTAINERS_HAVE_LIBNUMA
+  if (isBound)
+  {
+    numa_free (pMemory, size);
+    return;
+  }
+#endif
+
+  free (pMemory);
+}
+
+NumaBlock* numa_pool_add_block (NumaPool* pPool, int node)
+{
+  // NULL pool : the first block, linked by the caller
+
+  bool isBound = false;
+  NumaBlock* pBlock = (NumaBlock*)numa_node_alloc (node, NUMA_POOL_BLOCK_SIZE, &isBound);
+
+  if (pBlock != NULL)
+  {
+    pBlock->next = (pPool != NULL) ? pPool->blocks : NULL;
+    pBlock->isBound = isBound;
+
+    if (pPool != NULL)
+    {
+      pPool->blocks = pBlock;
+    }
+  }
+
+  return pBlock;
+}
+
+int numa_pool_class (size_t size)
+{
+  // -1 : larger than the largest chunk
+
+  int result = -1;
+
+  if (size <= NUMA_POOL_MIN_CHUNK)
+  {
+    result = 0;
+  }
+  else if (size <= NUMA_POOL_MAX_CHUNK)
+  {
+    result = (64 - __builtin_clzll ((unsigned long long)(size - 1))) - 4;
+  }
+
+  return result;
+}
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../../include/c/latency.h"
 #include "../../include/c/queue.h"
 
 /************************************************************************
@@ -8,7 +9,7 @@
  ************************************************************************/
 #define QUEUE_IS_EMPTY(queue) ((queue)->head == NULL)
 
-static QueueItem* create_node (const void* pItem, const size_t itemSize)
+static QueueItem* create_node (Heap* pHeap, const void* pItem, const size_t itemSize)
 {
   QueueItem* pNode = NULL;
 
@@ -20,17 +21,17 @@ static QueueItem* create_node (const void* pItem, const size_t itemSize)
     }
 
     // allocate memory for node
-    pNode = (QueueItem*)malloc (sizeof (QueueItem));
+    pNode = (QueueItem*)heap_alloc (pHeap, sizeof (QueueItem));
     if (pNode == NULL)
     {
       break;
     }
 
     // allocate memory for data
-    void* pData = malloc (itemSize);
+    void* pData = heap_alloc (pHeap, itemSize);
     if (pData == NULL)
     {
-      free (pNode);
+      heap_free (pHeap, pNode, sizeof (QueueItem));
       pNode = NULL;
       break;
     }
@@ -40,18 +41,156 @@ static QueueItem* create_node (const void* pItem, const size_t itemSize)
     pNode->data = pData;
     pNode->dataSize = itemSize;
     pNode->next = NULL;
+    pNode->enqueueTicks = 0;
 
   } while (0);
 
   return pNode;
 }
 
+static void release_node (Heap* pHeap, QueueItem* pNode)
+{
+  heap_free (pHeap, pNode->data, pNode->dataSize);
+  heap_free (pHeap, pNode, sizeof (QueueItem));
+}
+
+static QueueItem* unlink_head (Queue* pQueue)
+{
+  QueueItem* pNode = pQueue->head;
+  pQueue->head = pQueue->head->next;
+
+  if (QUEUE_IS_EMPTY (pQueue))
+  {
+    pQueue->tail = NULL;
+  }
+
+  return pNode;
+}
+
+static uint64_t isqrt (uint64_t value)
+{
+  uint64_t result = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > value)
+  {
+    bit >>= 2;
+  }
+
+  for (; bit != 0; bit >>= 2)
+  {
+    if (value >= result + bit)
+    {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    }
+    else
+    {
+      result >>= 1;
+    }
+  }
+
+  return result;
+}
+
+static uint64_t codel_control_law (const QueueTrace* pTrace, uint64_t ticks)
+{
+  // the next signal in interval / sqrt (count) : 10-bit fixed point
+  return ticks + pTrace->intervalTicks * 1024 / isqrt ((uint64_t)pTrace->dropCount << 20);
+}
+
+static bool codel_signal (QueueTrace* pTrace, uint64_t sojourn, uint64_t now, bool isLast)
+{
+  // RFC 8289 dequeue : true if the item is to be marked or dropped
+
+  bool result = false;
+  bool isStanding = false;
+
+  if (sojourn > pTrace->targetTicks)
+  {
+    ++pTrace->overTargetCount;
+  }
+
+  if (sojourn < pTrace->targetTicks || isLast)    // the queue drains
+  {
+    pTrace->firstAboveTicks = 0;
+  }
+  else if (pTrace->firstAboveTicks == 0)
+  {
+    pTrace->firstAboveTicks = now + pTrace->intervalTicks;
+  }
+  else if (now >= pTrace->firstAboveTicks)
+  {
+    isStanding = true;
+  }
+
+  if (pTrace->isDropping)
+  {
+    if (!isStanding)
+    {
+      pTrace->isDropping = false;
+    }
+    else if (now >= pTrace->dropNextTicks)
+    {
+      ++pTrace->dropCount;
+      pTrace->dropNextTicks = codel_control_law (pTrace, pTrace->dropNextTicks);
+
+      result = true;
+    }
+  }
+  else if (isStanding)
+  {
+    // a recent dropping state goes on at about its last rate
+    bool isRecent = now < pTrace->dropNextTicks + 16 * pTrace->intervalTicks;
+    pTrace->dropCount = (isRecent && pTrace->dropCount > 2) ? pTrace->dropCount - 2 : 1;
+
+    pTrace->isDropping = true;
+    pTrace->dropNextTicks = codel_control_law (pTrace, now);
+
+    result = true;
+  }
+
+  return result;
+}
+
+static bool trace_sojourn (Queue* pQueue)
+{
+  // records the sojourn of the head item : true if CoDel drops it
+
+  bool isDropped = false;
+  QueueTrace* pTrace = pQueue->pTrace;
+  QueueItem* pHead = pQueue->head;
+
+  if (pHead->enqueueTicks != 0)
+  {
+    uint64_t now = latency_ticks ();
+    uint64_t sojourn = (now > pHead->enqueueTicks) ? now - pHead->enqueueTicks : 0;
+
+    latency_histogram_record (&pTrace->sojourn, sojourn);
+
+    if (pTrace->codel != QUEUE_CODEL_OFF
+        && codel_signal (pTrace, sojourn, now, pHead->next == NULL))
+    {
+      isDropped = (pTrace->codel == QUEUE_CODEL_DROP);
+      ++*(isDropped ? &pTrace->droppedCount : &pTrace->markedCount);
+    }
+  }
+
+  return isDropped;
+}
+
 bool queue_init (Queue* pQueue)
 {
-  if (pQueue != NULL)
+  return queue_init_allocator (pQueue, NULL);
+}
+
+bool queue_init_allocator (Queue* pQueue, const Allocator* pAllocator)
+{
+  if (pQueue != NULL && heap_init (&pQueue->heap, pAllocator))
   {
     pQueue->head = NULL;
     pQueue->tail = NULL;
+    pQueue->pTrace = NULL;
 
     return true;
   }
@@ -68,11 +207,13 @@ void queue_destroy (Queue* pQueue)
       QueueItem* pNode = pQueue->head;
       pQueue->head = pQueue->head->next;
 
-      free (pNode->data);
-      free (pNode);
+      release_node (&pQueue->heap, pNode);
     }
 
     pQueue->tail = NULL;
+
+    heap_free (&pQueue->heap, pQueue->pTrace, sizeof (QueueTrace));
+    pQueue->pTrace = NULL;
   }
 }
 
@@ -87,12 +228,17 @@ bool queue_push (Queue* pQueue, const void* pItem, const size_t itemSize)
       break;
     }
 
-    QueueItem* pNode = create_node (pItem, itemSize);
+    QueueItem* pNode = create_node (&pQueue->heap, pItem, itemSize);
     if (pNode == NULL)
     {
       break;
     }
 
+    if (pQueue->pTrace != NULL)
+    {
+      pNode->enqueueTicks = latency_ticks ();
+    }
+
     if (QUEUE_IS_EMPTY (pQueue))
     {
       pQueue->tail = pNode;
@@ -117,7 +263,19 @@ bool queue_pop (Queue* pQueue, void* pItem, const size_t itemSize)
 
   do
   {
-    if (pItem == NULL || QUEUE_IS_EMPTY (pQueue))
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    // traced queue : the head dropped by CoDel is released, the next one is popped instead
+    while (pQueue->pTrace != NULL && !QUEUE_IS_EMPTY (pQueue)
+           && itemSize == pQueue->head->dataSize && trace_sojourn (pQueue))
+    {
+      release_node (&pQueue->heap, unlink_head (pQueue));
+    }
+
+    if (QUEUE_IS_EMPTY (pQueue))
     {
       break;
     }
@@ -130,17 +288,10 @@ bool queue_pop (Queue* pQueue, void* pItem, const size_t itemSize)
 
     memcpy (pItem, pQueue->head->data, itemSize);
 
-    QueueItem* pTemp = pQueue->head;
-    pQueue->head = pQueue->head->next;
-
-    if (QUEUE_IS_EMPTY (pQueue))
-    {
-      pQueue->tail = NULL;
-    }
+    QueueItem* pTemp = unlink_head (pQueue);
 
     // free memory of copied and popped Node
-    free (pTemp->data);
-    free (pTemp);
+    release_node (&pQueue->heap, pTemp);
 
     result = true;
 
@@ -175,15 +326,86 @@ bool queue_peek (Queue* pQueue, void* pItem, const size_t itemSize)
   return result;
 }
 
+bool queue_trace_enable (Queue* pQueue)
+{
+  if (pQueue->pTrace == NULL
+      && (pQueue->pTrace = (QueueTrace*)heap_alloc (&pQueue->heap, sizeof (QueueTrace))) != NULL)
+  {
+    memset (pQueue->pTrace, 0, sizeof (QueueTrace));
+  }
+
+  return pQueue->pTrace != NULL;
+}
+
+bool queue_codel_set (Queue* pQueue, QUEUE_CODEL codel, uint64_t targetNs, uint64_t intervalNs)
+{
+  bool result = false;
+
+  do
+  {
+    if (codel > QUEUE_CODEL_DROP)
+    {
+      break;
+    }
+
+    if (codel != QUEUE_CODEL_OFF && (targetNs == 0 || intervalNs == 0))
+    {
+      break;
+    }
+
+    if (!queue_trace_enable (pQueue))
+    {
+      break;
+    }
+
+    QueueTrace* pTrace = pQueue->pTrace;
+    double ticksPerNs = latency_ticks_per_ns ();
+
+    pTrace->codel = codel;
+    pTrace->targetTicks = (uint64_t)((double)targetNs * ticksPerNs);
+    pTrace->intervalTicks = (uint64_t)((double)intervalNs * ticksPerNs);
+
+    pTrace->isDropping = false;
+    pTrace->firstAboveTicks = 0;
+    pTrace->dropNextTicks = 0;
+    pTrace->dropCount = 0;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool queue_trace_get (Queue* pQueue, QueueTrace* pTrace)
+{
+  bool result = false;
+
+  if (pQueue->pTrace != NULL && pTrace != NULL)
+  {
+    *pTrace = *pQueue->pTrace;
+    pTrace->sojourn.ticksPerNs = latency_ticks_per_ns ();
+
+    result = true;
+  }
+
+  return result;
+}
+
 /************************************************************************
  *                             QUEUE_SAFE                               *
  ************************************************************************/
 
 bool concurrent_queue_init (QueueSafe* pQueue)
+{
+  return concurrent_queue_init_allocator (pQueue, NULL);
+}
+
+bool concurrent_queue_init_allocator (QueueSafe* pQueue, const Allocator* pAllocator)
 {
   bool result = false;
 
-  bool internalQueueInited = queue_init (&pQueue->queue);
+  bool internalQueueInited = queue_init_allocator (&pQueue->queue, pAllocator);
 
   if (internalQueueInited)
   {
@@ -219,6 +441,7 @@ void concurrent_queue_destroy (QueueSafe* pQueue)
 bool concurrent_queue_push (QueueSafe* pQueue, const void* pItem, const size_t itemSize)
 {
   bool result = false;
+  LATENCY_START (start);
 
   if (mutex_lock (&pQueue->mutex))
   {
@@ -232,6 +455,8 @@ bool concurrent_queue_push (QueueSafe* pQueue, const void* pItem, const size_t i
     (void)mutex_unlock (&pQueue->mutex);
   }
 
+  LATENCY_STOP (LATENCY_QUEUE_PUSH, start);
+
   return result;
 }
 
@@ -239,6 +464,7 @@ bool concurrent_queue_pop (QueueSafe* pQueue, void* pItem, const size_t itemSize
                            const unsigned int asyncWaitMs)
 {
   bool result = false;
+  LATENCY_START (start);
 
   if (mutex_lock (&pQueue->mutex))
   {
@@ -269,6 +495,56 @@ bool concurrent_queue_pop (QueueSafe* pQueue, void* pItem, const size_t itemSize
     (void)mutex_unlock (&pQueue->mutex);
   }
 
+  LATENCY_STOP (LATENCY_QUEUE_POP, start);
+
+  return result;
+}
+
+bool concurrent_queue_trace_enable (QueueSafe* pQueue)
+{
+  bool result = false;
+
+  if (mutex_lock (&pQueue->mutex))
+  {
+    result = queue_trace_enable (&pQueue->queue);
+
+    (void)mutex_unlock (&pQueue->mutex);
+  }
+
+  return result;
+}
+
+bool concurrent_queue_codel_set (QueueSafe* pQueue, QUEUE_CODEL codel, uint64_t targetNs,
+                                 uint64_t intervalNs)
+{
+  bool result = false;
+
+  // the first call measures TSC rate : not under the lock
+  (void)latency_ticks_per_ns ();
+
+  if (mutex_lock (&pQueue->mutex))
+  {
+    result = queue_codel_set (&pQueue->queue, codel, targetNs, intervalNs);
+
+    (void)mutex_unlock (&pQueue->mutex);
+  }
+
+  return result;
+}
+
+bool concurrent_queue_trace_get (QueueSafe* pQueue, QueueTrace* pTrace)
+{
+  bool result = false;
+
+  (void)latency_ticks_per_ns ();
+
+  if (mutex_lock (&pQueue->mutex))
+  {
+    result = queue_trace_get (&pQueue->queue, pTrace);
+
+    (void)mutex_unlock (&pQueue->mutex);
+  }
+
   return result;
 }
 
@@ -300,4 +576,315 @@ bool concurrent_queue_peek (QueueSafe* pQueue, void* pItem, const size_t itemSiz
   }
 
   return result;
+}
+
+/************************************************************************
+ *                              NUMA QUEUE                              *
+ ************************************************************************/
+
+// no wait : an empty shard is a miss
+static bool shard_try_pop (QueueSafe* pShard, void* pItem, const size_t itemSize)
+{
+  bool result = false;
+
+  if (mutex_lock (&pShard->mutex))
+  {
+    if (!QUEUE_IS_EMPTY (&pShard->queue))
+    {
+      result = queue_pop (&pShard->queue, pItem, itemSize);
+    }
+
+    (void)mutex_unlock (&pShard->mutex);
+  }
+
+  return result;
+}
+
+// from the local shard round the other ones, the first hit wins
+static bool shards_try_pop (QueueNuma* pQueue, int local, void* pItem, const size_t itemSize)
+{
+  bool result = false;
+
+  for (int i = 0; !result && i < pQueue->shardsCount; ++i)
+  {
+    result = shard_try_pop (pQueue->shards[(local + i) % pQueue->shardsCount], pItem, itemSize);
+  }
+
+  return result;
+}
+
+bool numa_queue_init (QueueNuma* pQueue, int shardsCount)
+{
+  bool result = false;
+  int nodesCount = numa_nodes_count ();
+
+  do
+  {
+    if (pQueue == NULL)
+    {
+      break;
+    }
+
+    pQueue->shards = NULL;
+    pQueue->pools = NULL;
+    pQueue->shardsCount = 0;
+
+    if (shardsCount < 0)
+    {
+      break;
+    }
+
+    shardsCount = (shardsCount == 0) ? nodesCount : shardsCount;
+
+    pQueue->shards = (QueueSafe**)calloc ((size_t)shardsCount, sizeof (QueueSafe*));
+    pQueue->pools = (NumaPool**)calloc ((size_t)shardsCount, sizeof (NumaPool*));
+
+    if (pQueue->shards == NULL || pQueue->pools == NULL)
+    {
+      break;
+    }
+
+    // the shard struct comes from its pool as well : the lock line is local to the consumers
+    while (pQueue->shardsCount < shardsCount)
+    {
+      NumaPool* pPool = numa_pool_create (pQueue->shardsCount % nodesCount);
+      if (pPool == NULL)
+      {
+        break;
+      }
+
+      Allocator* pAllocator = &pPool->allocator;
+      QueueSafe* pShard = (QueueSafe*)pAllocator->alloc (sizeof (QueueSafe), pAllocator->pContext);
+
+      if (pShard == NULL || !concurrent_queue_init_allocator (pShard, pAllocator))
+      {
+        pAllocator->free (pShard, sizeof (QueueSafe), pAllocator->pContext);
+        numa_pool_release (pPool);
+        break;
+      }
+
+      pQueue->pools[pQueue->shardsCount] = pPool;
+      pQueue->shards[pQueue->shardsCount] = pShard;
+      ++pQueue->shardsCount;
+    }
+
+    result = (pQueue->shardsCount == shardsCount);
+
+  } while (0);
+
+  if (!result && pQueue != NULL)
+  {
+    numa_queue_destroy (pQueue);
+  }
+
+  return result;
+}
+
+void numa_queue_destroy (QueueNuma* pQueue)
+{
+  for (int i = 0; i < pQueue->shardsCount; ++i)
+  {
+    Allocator* pAllocator = &pQueue->pools[i]->allocator;
+
+    concurrent_queue_destroy (pQueue->shards[i]);
+    pAllocator->free (pQueue->shards[i], sizeof (QueueSafe), pAllocator->pContext);
+    numa_pool_release (pQueue->pools[i]);
+  }
+
+  free (pQueue->shards);
+  free (pQueue->pools);
+
+  pQueue->shards = NULL;
+  pQueue->pools = NULL;
+  pQueue->shardsCount = 0;
+}
+
+bool numa_queue_push (QueueNuma* pQueue, const void* pItem, const size_t itemSize)
+{
+  return numa_queue_push_to (pQueue, numa_current_node () % pQueue->shardsCount, pItem, itemSize);
+}
+
+bool numa_queue_push_to (QueueNuma* pQueue, int shard, const void* pItem, const size_t itemSize)
+{
+  bool result = false;
+
+  if (shard >= 0 && shard < pQueue->shardsCount)
+  {
+    result = concurrent_queue_push (pQueue->shards[shard], pItem, itemSize);
+  }
+
+  return result;
+}
+
+bool numa_queue_pop (QueueNuma* pQueue, void* pItem, const size_t itemSize,
+                     const unsigned int asyncWaitMs)
+{
+  int local = numa_current_node () % pQueue->shardsCount;
+
+  // remote shards are swept without waiting, the wait is for the local producers
+  bool result = shards_try_pop (pQueue, local, pItem, itemSize);
+
+  if (!result && asyncWaitMs > 0)
+  {
+    result = concurrent_queue_pop (pQueue->shards[local], pItem, itemSize, asyncWaitMs)
+             || shards_try_pop (pQueue, local, pItem, itemSize);
+  }
+
+  return result;
+}
+
+/************************************************************************
+ *                           INTRUSIVE QUEUE                            *
+ ************************************************************************/
+
+bool intrusive_queue_init (QueueIntrusive* pQueue)
+{
+  if (pQueue != NULL)
+  {
+    pQueue->head = NULL;
+    pQueue->tail = NULL;
+
+    return true;
+  }
+
+  return false;
+}
+
+bool intrusive_queue_push (QueueIntrusive* pQueue, QueueLink* pLink)
+{
+  bool result = false;
+
+  do
+  {
+    if (pLink == NULL)
+    {
+      break;
+    }
+
+    pLink->next = NULL;
+
+    if (QUEUE_IS_EMPTY (pQueue))
+    {
+      pQueue->tail = pLink;
+      pQueue->head = pLink;
+    }
+    else
+    {
+      pQueue->tail->next = pLink;
+      pQueue->tail = pLink;
+    }
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+QueueLink* intrusive_queue_pop (QueueIntrusive* pQueue)
+{
+  QueueLink* pLink = pQueue->head;
+
+  if (pLink != NULL)
+  {
+    pQueue->head = pLink->next;
+
+    if (QUEUE_IS_EMPTY (pQueue))
+    {
+      pQueue->tail = NULL;
+    }
+
+    pLink->next = NULL;
+  }
+
+  return pLink;
+}
+
+QueueLink* intrusive_queue_peek (QueueIntrusive* pQueue)
+{
+  return pQueue->head;
+}
+
+/************************************************************************
+ *                        INTRUSIVE QUEUE_SAFE                          *
+ ************************************************************************/
+
+bool concurrent_intrusive_queue_init (QueueIntrusiveSafe* pQueue)
+{
+  bool result = false;
+
+  if (intrusive_queue_init (&pQueue->queue))
+  {
+    if (mutex_init (&pQueue->mutex))
+    {
+      if (condition_init (&pQueue->cond))
+      {
+        result = true;
+      }
+      else
+      {
+        (void)mutex_destroy (&pQueue->mutex);
+      }
+    }
+  }
+
+  return result;
+}
+
+void concurrent_intrusive_queue_destroy (QueueIntrusiveSafe* pQueue)
+{
+  // linked objects belong to the user, they are just left unlinked
+
+  if (mutex_lock (&pQueue->mutex))
+  {
+    while (intrusive_queue_pop (&pQueue->queue) != NULL)
+    {
+    }
+
+    (void)mutex_unlock (&pQueue->mutex);
+
+    (void)mutex_destroy (&pQueue->mutex);
+    (void)condition_destroy (&pQueue->cond);
+  }
+}
+
+bool concurrent_intrusive_queue_push (QueueIntrusiveSafe* pQueue, QueueLink* pLink)
+{
+  bool result = false;
+
+  if (mutex_lock (&pQueue->mutex))
+  {
+    result = intrusive_queue_push (&pQueue->queue, pLink);
+
+    if (result)
+    {
+      (void)condition_broadcast (&pQueue->cond);
+    }
+
+    (void)mutex_unlock (&pQueue->mutex);
+  }
+
+  return result;
+}
+
+QueueLink* concurrent_intrusive_queue_pop (QueueIntrusiveSafe* pQueue,
+                                           const unsigned int asyncWaitMs)
+{
+  QueueLink* pLink = NULL;
+
+  if (mutex_lock (&pQueue->mutex))
+  {
+    QueueIntrusive* pPrivateQueue = &pQueue->queue;
+
+    // another waiter may have taken the item after the wake up : checked again
+    if (!QUEUE_IS_EMPTY (pPrivateQueue)
+        || condition_wait (&pQueue->cond, &pQueue->mutex, asyncWaitMs))
+    {
+      pLink = intrusive_queue_pop (pPrivateQueue);
+    }
+
+    (void)mutex_unlock (&pQueue->mutex);
+  }
+
+  return pLink;
 }
\ No newline at end of file
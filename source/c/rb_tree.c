@@ -1,37 +1,105 @@
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
+#include "../../include/c/key_utils.h"
+#include "../../include/c/latency.h"
 #include "../../include/c/rb_tree.h"
+#include "../../include/c/thread_utils.h"
 
 
 /************************************************************************
  *                              UTILS     	                            *
  ************************************************************************/
 
-typedef enum SUBTREE_E
+// header of a contiguous block: [ RBTPool | nodes | payloads ]
+typedef struct RBTPoolS
 {
-  NONE,
-  LEFT,
-  RIGHT,
-} SUBTREE;
+  size_t liveCount;    // nodes of the block which are not released yet, atomic : parallel destroy
+  size_t blockSize;    // the whole block, returned to the heap of its nodes
+} RBTPool;
 
-typedef struct FoundInfoS
-{
-  RBTNode* pParent;
-  RBTNode* pNode;
-  SUBTREE subtree;
-} FoundInfo;
+#define RBT_ALIGNMENT (_Alignof (max_align_t))
+#define RBT_ALIGN_UP(size) (((size) + RBT_ALIGNMENT - 1) & ~(RBT_ALIGNMENT - 1))
+#define RBT_POOL_HEADER_SIZE RBT_ALIGN_UP (sizeof (RBTPool))
+#define RBT_MAX_BULK_THREADS (64)
 
-static RBTNode NIL = { "", NULL, BLACK, NULL, NULL, NULL };
+typedef struct CreateTaskS
+{
+  const char* const* keys;
+  const char* items;
+  size_t itemSize;
+  size_t count;
+  Heap* pHeap;
+  RBTNode** pNodes;    // output : one node per key
+  bool isFailed;
+} CreateTask;
+
+typedef struct LinkTaskS
+{
+  RBTNode** pNodes;
+  size_t count;
+  int depth;
+  int redDepth;
+  RBTNode* pSubtree;    // output : root of linked subtree
+} LinkTask;
+
+typedef struct DestroyTaskS
+{
+  RBTNode* pSubtree;
+} DestroyTask;
 
-static void rbt_actualize_root (RBTNode** pRoot);
-static bool is_key_valid (const char* key);
-static FoundInfo rbt_find_node (RBTNode* pRoot, const char* key);
-static RBTNode* rbt_create_node (const void* pItem, size_t itemSize, const char* key);
-static void rbt_free_memory (RBTNode* pNode);
-static void rbt_rot_left (RBTNode* pNode);
-static void rbt_rot_right (RBTNode* pNode);
-static bool is_balance_broken (RBTNode* pNode);
-static void rbt_insert_balance (RBTNode* pNode);
+// searched key : length and prefix are computed once per call
+typedef struct KeyInfoS
+{
+  const char* key;
+  size_t length;
+  uint64_t prefix;
+} KeyInfo;
+
+static RBTNode NIL = { "", NULL, 0, 0, 0, 0, 0, BLACK, 0, "", false, NULL, NULL, NULL, NULL };
+
+static bool rbt_key_info (const char* key, KeyInfo* pKey);
+static int rbt_key_compare (const RBTNode* pNode, const KeyInfo* pKey);
+static void rbt_set_key (RBTNode* pNode, const KeyInfo* pKey);
+static RBTNode* rbt_create_node (Heap* pHeap, const void* pItem, size_t itemSize,
+                                 const KeyInfo* pKey);
+static bool rbt_set_data (RBTNode* pNode, const void* pItem, size_t itemSize);
+static RBTNode* rbt_bound_by_key (RBTNode* pRoot, const char* key, bool isUpper);
+static void rbt_release_node (RBTNode* pNode);
+static bool is_batch_sorted (const char* const* keys, size_t count);
+static bool rbt_create_pool (RBTNode** pNodes, Heap* pHeap, const char* const* keys,
+                             const void* items, size_t itemSize, size_t count);
+static void rbt_create_nodes (CreateTask* pTask);
+static int rbt_red_depth (size_t count);
+static RBTNode* rbt_link_balanced (RBTNode** pNodes, size_t count, int depth, int redDepth);
+static RBTNode* rbt_link_balanced_parallel (RBTNode** pNodes, size_t count,
+                                            unsigned int threadsCount);
+static size_t rbt_cut_subtrees (RBTNode* pNode, int depth, int splitDepth, DestroyTask* pTasks);
+static void rbt_run_tasks (void* (*routine) (void*), void* pTasks, size_t taskSize,
+                           size_t tasksCount);
+
+#define RBT_CORE_NODE RBTNode
+#define RBT_CORE_NIL (&NIL)
+#define RBT_CORE_KEY const KeyInfo*
+#define RBT_CORE_COMPARE(pNode, pKey) rbt_key_compare (pNode, pKey)
+#define RBT_CORE_RELEASE(pNode) rbt_release_node (pNode)
+#define RBT_CORE_FOUND FoundInfo
+#define RBT_CORE_FN(name) rbt_##name
+#define RBT_CORE_SIZE
+#include "rb_tree_core.h"
+
+static FoundInfo rbt_find_near (RBTNode* pRoot, RBTNode* pHint, const KeyInfo* pKey);
+static bool rbt_insert_node (RBTNode** pRoot, RBTNode** pLast, Heap* pHeap, void* pItem,
+                             size_t itemSize, const char* key);
+static bool rbt_upsert_node (RBTNode** pRoot, Heap* pHeap, void* pItem, size_t itemSize,
+                             const char* key, RBTMergeCallback merge, void* pContext);
+static RBTNode* rbt_insert_hint_node (RBTNode** pRoot, Heap* pHeap, RBTNode* pHint, void* pItem,
+                                      size_t itemSize, const char* key);
+static bool rbt_build_nodes (RBTNode** pRoot, Heap* pHeap, const char* const* keys,
+                             const void* items, size_t itemSize, size_t count, bool isContiguous);
+static bool rbt_merge_nodes (RBTNode** pRoot, Heap* pHeap, const char* const* keys,
+                             const void* items, size_t itemSize, size_t count,
+                             unsigned int threadsCount);
 
 
 /************************************************************************
@@ -66,67 +134,49 @@ bool rbt_destroy (RBTNode** pRoot)
 
   } while (0);
 
-  return false;
+  return result;
 }
 
-bool rbt_insert (RBTNode** pRoot, void* pItem, size_t itemSize, const char* key)
+static THREAD_ROUTINE (rbt_destroy_routine, pArg)
 {
-  /* insertion place:
-   *   always to the NIL
-   *   exception: red-black tree is empty
-   */
+  rbt_free_memory (((DestroyTask*)pArg)->pSubtree);
+  return THREAD_ROUTINE_RET_CODE ();
+}
 
+bool rbt_destroy_parallel (RBTNode** pRoot, unsigned int threadsCount)
+{
   bool result = false;
 
   do
   {
-    if (!is_key_valid (key))
+    if (*pRoot == NULL || threadsCount == 0)
     {
       break;
     }
 
-    if (pItem == NULL)
+    if (threadsCount > RBT_MAX_BULK_THREADS)
     {
-      break;
+      threadsCount = RBT_MAX_BULK_THREADS;
     }
 
-    // search place to insert to
-    FoundInfo info = rbt_find_node (*pRoot, key);
+    int splitDepth = 0;
 
-    if (info.pNode != NULL && info.pNode != &NIL)    // node with such key already exists
+    while (((unsigned int)2 << splitDepth) <= threadsCount)
     {
-      break;    // different logic might be implemented
+      ++splitDepth;
     }
 
-    RBTNode* pNode = rbt_create_node (pItem, itemSize, key);
-
-    if (pNode == NULL)    // error while creating node to insert
+    // subtrees at 'splitDepth' are released by tasks, levels above them - by the caller
+    if (splitDepth > 0)
     {
-      break;
-    }
+      DestroyTask tasks[RBT_MAX_BULK_THREADS];
+      size_t tasksCount = rbt_cut_subtrees (*pRoot, 0, splitDepth, tasks);
 
-    if (*pRoot == NULL)    // insertion to root
-    {
-      pNode->color = BLACK;
-      *pRoot = pNode;
+      rbt_run_tasks (rbt_destroy_routine, tasks, sizeof (DestroyTask), tasksCount);
     }
-    else
-    {
-      // insertion
-      pNode->parent = info.pParent;
-      if (info.subtree == LEFT)
-      {
-        info.pParent->left = pNode;
-      }
-      else
-      {
-        info.pParent->right = pNode;
-      }
 
-      // balansing
-      rbt_insert_balance (pNode);
-      rbt_actualize_root (pRoot);
-    }
+    rbt_free_memory (*pRoot);
+    *pRoot = NULL;
 
     result = true;
 
@@ -135,13 +185,20 @@ bool rbt_insert (RBTNode** pRoot, void* pItem, size_t itemSize, const char* key)
   return result;
 }
 
+bool rbt_insert (RBTNode** pRoot, void* pItem, size_t itemSize, const char* key)
+{
+  return rbt_insert_node (pRoot, NULL, NULL, pItem, itemSize, key);
+}
+
 bool rbt_get (RBTNode* pRoot, void* pItem, size_t itemSize, const char* key)
 {
   int result = false;
+  KeyInfo keyInfo;
+  LATENCY_START (start);
 
   do
   {
-    if (!is_key_valid (key))
+    if (!rbt_key_info (key, &keyInfo))
     {
       break;
     }
@@ -151,7 +208,7 @@ bool rbt_get (RBTNode* pRoot, void* pItem, size_t itemSize, const char* key)
       break;
     }
 
-    FoundInfo info = rbt_find_node (pRoot, key);
+    FoundInfo info = rbt_find_node (pRoot, &keyInfo);
 
     if (info.pNode == NULL)    // tree is empty
     {
@@ -163,385 +220,341 @@ bool rbt_get (RBTNode* pRoot, void* pItem, size_t itemSize, const char* key)
       break;
     }
 
-    memcpy (pItem, info.pNode->data, itemSize);
+    if (info.pNode->dataSize > itemSize)    // doesn't fit the caller buffer
+    {
+      break;
+    }
+
+    memcpy (pItem, info.pNode->data, info.pNode->dataSize);
 
     result = true;
 
   } while (0);
 
+  LATENCY_STOP (LATENCY_RBT_GET, start);
+
   return result;
 }
 
-
-/************************************************************************
- *                             STATIC    	                            *
- ************************************************************************/
-
-void rbt_actualize_root (RBTNode** pRoot)
+bool rbt_get_ref (RBTNode* pRoot, const char* key, const void** ppData, size_t* pSize)
 {
-  while ((*pRoot)->parent != NULL)
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
   {
-    *pRoot = (*pRoot)->parent;
-  }
+    if (!rbt_key_info (key, &keyInfo))
+    {
+      break;
+    }
 
-  (*pRoot)->color = BLACK;
-}
+    FoundInfo info = rbt_find_node (pRoot, &keyInfo);
 
-bool is_key_valid (const char* key)
-{
-  bool result = true;
+    if (info.pNode == NULL || info.pNode == &NIL)    // tree is empty or node was not found
+    {
+      break;
+    }
 
-  size_t keyLen = strnlen (key, RBT_KEY_SIZE);
+    *ppData = info.pNode->data;
+    *pSize = info.pNode->dataSize;
 
-  if (keyLen > RBT_KEY_SIZE - 1)    // for '\0'
-  {
-    result = false;
-  }
+    result = true;
+
+  } while (0);
 
   return result;
 }
 
-FoundInfo rbt_find_node (RBTNode* pRoot, const char* key)
+bool rbt_upsert (RBTNode** pRoot, void* pItem, size_t itemSize, const char* key,
+                 RBTMergeCallback merge, void* pContext)
 {
-  /*           variant                 description
-   *
-   * >>  { NULL, NULL, NONE }    >>   tree is empty
-   * >>  { NULL, ROOT, NONE }    >>   found : node is root
-   * >>  { ....  ....  .... }    >>   found : node is not root
-   * >>  { ...., &NIL, .... }    >>   not found
-   *
-   */
+  return rbt_upsert_node (pRoot, NULL, pItem, itemSize, key, merge, pContext);
+}
 
-  FoundInfo info = { NULL, NULL, NONE };
+RBTNode* rbt_insert_hint (RBTNode** pRoot, RBTNode* pHint, void* pItem, size_t itemSize,
+                          const char* key)
+{
+  return rbt_insert_hint_node (pRoot, NULL, pHint, pItem, itemSize, key);
+}
+
+bool rbt_delete (RBTNode** pRoot, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
 
   do
   {
-    if (pRoot == NULL)
+    if (!rbt_key_info (key, &keyInfo))
     {
       break;
     }
 
-    info.pNode = pRoot;
+    FoundInfo info = rbt_find_node (*pRoot, &keyInfo);
 
-    while (info.pNode != &NIL)
+    if (info.pNode == NULL || info.pNode == &NIL)    // tree is empty or node was not found
     {
-      int result = strcmp (info.pNode->key, key);
-
-      if (result > 0)    // go left
-      {
-        info.pParent = info.pNode;
-        info.pNode = info.pNode->left;
-        info.subtree = LEFT;
-      }
-      else if (result < 0)    // go right
-      {
-        info.pParent = info.pNode;
-        info.pNode = info.pNode->right;
-        info.subtree = RIGHT;
-      }
-      else    // found , info is in actual state
-      {
-        break;
-      }
+      break;
     }
 
+    rbt_detach_node (pRoot, info.pNode);
+    rbt_release_node (info.pNode);
+
+    result = true;
+
   } while (0);
 
-  return info;
+  return result;
 }
 
-RBTNode* rbt_create_node (const void* pItem, size_t itemSize, const char* key)
+bool rbt_tree_init (RBTree* pTree, const Allocator* pAllocator)
 {
-  RBTNode* pNode = NULL;
+  bool result = false;
 
-  do
+  if (pTree != NULL && heap_init (&pTree->heap, pAllocator))
   {
-    if (pItem == NULL)
-    {
-      break;
-    }
+    pTree->root = NULL;
+    pTree->last = NULL;
 
-    // no need to check if key is valid
-    // it was already checked in caller = rbt_insert()
+    result = true;
+  }
 
-    // allocate memory for node
-    pNode = (RBTNode*)malloc (sizeof (RBTNode));
-    if (pNode == NULL)
-    {
-      break;
-    }
+  return result;
+}
 
-    // allocate memory for data
-    void* pData = malloc (itemSize);
-    if (pData == NULL)
-    {
-      free (pNode);
-      pNode = NULL;
-      break;
-    }
+bool rbt_tree_insert (RBTree* pTree, void* pItem, size_t itemSize, const char* key)
+{
+  return rbt_insert_node (&pTree->root, &pTree->last, &pTree->heap, pItem, itemSize, key);
+}
 
-    // key and data
-    strcpy (pNode->key, key);
-    memcpy (pData, pItem, itemSize);
-    pNode->data = pData;
+bool rbt_tree_upsert (RBTree* pTree, void* pItem, size_t itemSize, const char* key,
+                      RBTMergeCallback merge, void* pContext)
+{
+  bool result
+      = rbt_upsert_node (&pTree->root, &pTree->heap, pItem, itemSize, key, merge, pContext);
 
-    // default settings
-    pNode->color = RED;
-    pNode->left = &NIL;
-    pNode->right = &NIL;
-    pNode->parent = NULL;
+  pTree->last = rbt_last (pTree->root);
 
-  } while (0);
+  return result;
+}
+
+RBTNode* rbt_tree_insert_hint (RBTree* pTree, RBTNode* pHint, void* pItem, size_t itemSize,
+                               const char* key)
+{
+  RBTNode* pNode = rbt_insert_hint_node (&pTree->root, &pTree->heap, pHint, pItem, itemSize, key);
+
+  pTree->last = rbt_last (pTree->root);
 
   return pNode;
 }
 
-void rbt_free_memory (RBTNode* pNode)
+bool rbt_tree_delete (RBTree* pTree, const char* key)
 {
-  // depth-first = left sub-tree
-  if (pNode->left != &NIL)
-  {
-    rbt_free_memory (pNode->left);
-  }
+  // the rightmost node steps back before it's released
+  RBTNode* pLast = pTree->last;
 
-  // depth-first = right sub-tree
-  if (pNode->right != &NIL)
+  if (pLast != NULL && strcmp (pLast->key, key) == 0)
   {
-    rbt_free_memory (pNode->right);
+    pTree->last = rbt_prev_node (pLast);
   }
 
-  // wheh both left and right children are NIL
-  free (pNode->data);
-  free (pNode);
+  return rbt_delete (&pTree->root, key);
 }
 
-void rbt_rot_left (RBTNode* pNode)
+bool rbt_tree_destroy (RBTree* pTree)
 {
-  /* state before left rotation
-   *
-   *      Parent (don't know if Node == Parent.left or Parent.right)
-   *        |
-   *       Node
-   *      /   \
-   *    A      Temp
-   *          /   \
-   *         B     C
-   */
+  pTree->last = NULL;
 
-  RBTNode* pTemp = pNode->right;
-  RBTNode* pParent = pNode->parent;
+  return rbt_destroy (&pTree->root);
+}
 
-  // Node and B
-  pNode->parent = pTemp;
-  pNode->right = pTemp->left;
-  if (pNode->right != &NIL)
-  {
-    pNode->right->parent = pNode;
-  }
+bool rbt_tree_build_from_sorted (RBTree* pTree, const char* const* keys, const void* items,
+                                 size_t itemSize, size_t count, bool isContiguous)
+{
+  bool result
+      = rbt_build_nodes (&pTree->root, &pTree->heap, keys, items, itemSize, count, isContiguous);
 
-  // Temp
-  pTemp->parent = pParent;
-  pTemp->left = pNode;
+  pTree->last = rbt_last (pTree->root);
 
-  // Parent
-  if (pParent != NULL)
-  {
-    if (pParent->left == pNode)
-    {
-      pParent->left = pTemp;
-    }
-    else
-    {
-      pParent->right = pTemp;
-    }
-  }
+  return result;
 }
 
-void rbt_rot_right (RBTNode* pNode)
+bool rbt_tree_merge_sorted (RBTree* pTree, const char* const* keys, const void* items,
+                            size_t itemSize, size_t count, unsigned int threadsCount)
 {
-  /* state before right rotation
-   *
-   *           Parent (don't know if Node == Parent.left or Parent.right)
-   *             |
-   *            Node
-   *           /   \
-   *       Temp     A
-   *      /    \
-   *     C      B
-   */
+  bool result
+      = rbt_merge_nodes (&pTree->root, &pTree->heap, keys, items, itemSize, count, threadsCount);
 
-  RBTNode* pTemp = pNode->left;
-  RBTNode* pParent = pNode->parent;
+  pTree->last = rbt_last (pTree->root);
 
-  // Node and B
-  pNode->parent = pTemp;
-  pNode->left = pTemp->right;
-  if (pNode->right != &NIL)
-  {
-    pNode->left->parent = pNode;
-  }
+  return result;
+}
+
+RBTNode* rbt_select (RBTNode* pRoot, size_t index)
+{
+  // left subtree size is the node index inside its own subtree
 
-  // Temp
-  pTemp->parent = pParent;
-  pTemp->right = pNode;
+  RBTNode* pNode = pRoot;
 
-  // Parent
-  if (pParent != NULL)
+  while (pNode != NULL && pNode != &NIL && index != pNode->left->size)
   {
-    if (pParent->left == pNode)
+    if (index < pNode->left->size)
     {
-      pParent->left = pTemp;
+      pNode = pNode->left;
     }
     else
     {
-      pParent->right = pTemp;
+      index -= pNode->left->size + 1;
+      pNode = pNode->right;
     }
   }
+
+  return (pNode == &NIL) ? NULL : pNode;
 }
 
-bool is_balance_broken (RBTNode* pNode)
+bool rbt_rank (RBTNode* pRoot, const char* key, size_t* pRank)
 {
+  // every time we go right the node and its left subtree are less than key
+
   bool result = false;
+  KeyInfo keyInfo;
 
   do
   {
-    if (pNode == NULL)
-    {
-      break;
-    }
-
-    if (pNode->color == BLACK)
+    if (pRank == NULL || !rbt_key_info (key, &keyInfo))
     {
       break;
     }
 
-    if (pNode->parent == NULL)
-    {
-      break;
-    }
+    *pRank = 0;
 
-    if (pNode->parent->color == BLACK)
+    for (RBTNode* pNode = pRoot; pNode != NULL && pNode != &NIL;)
     {
-      break;
+      if (rbt_key_compare (pNode, &keyInfo) < 0)
+      {
+        *pRank += pNode->left->size + 1;
+        pNode = pNode->right;
+      }
+      else
+      {
+        pNode = pNode->left;
+      }
     }
 
     result = true;
+
   } while (0);
 
   return result;
 }
 
-void rbt_insert_balance (RBTNode* pNode)
+
+RBTNode* rbt_first (RBTNode* pRoot)
 {
-  /* possible state after insertion (X == pNode)
-   *
-   *  v1       A           v2        A
-   *         /   \                 /   \
-   *        B     C               B     C
-   *         \                   /
-   *          X                 X
-   *
-   *
-   *  v3       A           v4        A
-   *         /   \                 /   \
-   *        B     C               B     C
-   *             /                       \
-   *            X                         X
-   */
+  return (pRoot == NULL) ? NULL : rbt_min_node (pRoot);
+}
+
+RBTNode* rbt_last (RBTNode* pRoot)
+{
+  return (pRoot == NULL) ? NULL : rbt_max_node (pRoot);
+}
+
+RBTNode* rbt_next (RBTNode* pNode)
+{
+  return rbt_next_node (pNode);
+}
+
+RBTNode* rbt_prev (RBTNode* pNode)
+{
+  return rbt_prev_node (pNode);
+}
+
+RBTNode* rbt_lower_bound (RBTNode* pRoot, const char* key)
+{
+  return rbt_bound_by_key (pRoot, key, false);
+}
+
+RBTNode* rbt_upper_bound (RBTNode* pRoot, const char* key)
+{
+  return rbt_bound_by_key (pRoot, key, true);
+}
+
+bool rbt_scan_range (RBTNode* pRoot, const char* keyFrom, const char* keyTo,
+                     RBTScanCallback callback, void* pContext)
+{
+  bool result = false;
+  KeyInfo keyInfo = { NULL, 0, 0 };    // set only for bounded range
 
-  while (is_balance_broken(pNode))
+  do
   {
-    // v1, v2: X on the LEFT of A
-    if (pNode->parent == pNode->parent->parent->left)
+    if (callback == NULL)
     {
-      // C is RED
-      if (pNode->parent->parent->right->color == RED)
-      {
-        pNode->parent->color = BLACK;                   // B
-        pNode->parent->parent->color = RED;             // A
-        pNode->parent->parent->right->color = BLACK;    // C
+      break;
+    }
 
-        pNode = pNode->parent->parent;    // A is next we deal with
-      }
-      // C is BLACK = impossible to be immidiately after insertion,
-      // exception: C is NIL
-      else
-      {
-        // v1: X on the RIGHT of B
-        if (pNode == pNode->parent->right)
-        {
-          rbt_rot_left (pNode->parent);
-          pNode = pNode->left;    // to make following code universal
-        }
+    if ((keyFrom != NULL && !rbt_key_info (keyFrom, &keyInfo))
+        || (keyTo != NULL && !rbt_key_info (keyTo, &keyInfo)))
+    {
+      break;
+    }
 
-        pNode->parent->color = BLACK;
-        pNode->parent->parent->color = RED;
-        rbt_rot_right (pNode->parent->parent);
+    RBTNode* pNode = (keyFrom == NULL) ? rbt_first (pRoot) : rbt_lower_bound (pRoot, keyFrom);
 
-        pNode = pNode->parent;
-      }
-    }
-    // v3, v4: X on the RIGHT of A
-    else
+    while (pNode != NULL)
     {
-      // B is RED
-      if (pNode->parent->parent->left->color == RED)
+      if (keyTo != NULL && rbt_key_compare (pNode, &keyInfo) >= 0)
       {
-        pNode->parent->color = BLACK;                  // C
-        pNode->parent->parent->color = RED;            // A
-        pNode->parent->parent->left->color = BLACK;    // B
-
-        pNode = pNode->parent->parent;    // A is next we deal with
+        break;
       }
-      // B is BLACK = impossible to be immidiately after insertion
-      // exception: B is NIL
-      else
-      {
-        // v3: X on the LEFT of C
-        if (pNode == pNode->parent->left)
-        {
-          rbt_rot_right (pNode->parent);
-          pNode = pNode->right;    // to make following code universal
-        }
-
-        // [ backup : 16.02.2022 ]
-        // pNode->color = BLACK;
-        // pNode->parent->color = RED;
-        // rbt_rot_left(pNode->parent->parent);
 
-        pNode->parent->color = BLACK;
-        pNode->parent->parent->color = RED;
-        rbt_rot_left (pNode->parent->parent);
+      // the next payload is being fetched while callback works on the current one
+      RBTNode* pNext = rbt_next (pNode);
+      if (pNext != NULL)
+      {
+        __builtin_prefetch (pNext->data);
+      }
 
-        pNode = pNode->parent;
+      if (!callback (pNode, pContext))
+      {
+        break;
       }
+
+      pNode = pNext;
     }
-  }
-}
 
+    result = true;
 
-/************************************************************************
- *                           UNAVAILABLE   	                            *
- ************************************************************************/
+  } while (0);
 
-// no need without thread-safety approach
-bool rbt_init (RBTNode* pRoot)  
+  return result;
+}
+
+bool rbt_scan_prefix (RBTNode* pRoot, const char* prefix, RBTScanCallback callback,
+                      void* pContext)
 {
   bool result = false;
+  KeyInfo keyInfo;
 
   do
   {
-    if (pRoot == NULL)
+    if (callback == NULL || !rbt_key_info (prefix, &keyInfo))
     {
       break;
     }
 
-    memset (pRoot->key, '\0', RBT_KEY_SIZE);
-    pRoot->data = NULL;
-    pRoot->color = BLACK;
-    pRoot->left = &NIL;
-    pRoot->right = &NIL;
-    pRoot->parent = NULL;
+    size_t prefixLen = keyInfo.length;
+
+    // all keys with the prefix are adjacent and start from the prefix lower bound
+    RBTNode* pNode = rbt_lower_bound (pRoot, prefix);
+
+    while (pNode != NULL && key_mismatch (pNode->key, prefix, prefixLen) == prefixLen)
+    {
+      if (!callback (pNode, pContext))
+      {
+        break;
+      }
+
+      pNode = rbt_next (pNode);
+    }
 
     result = true;
 
@@ -550,291 +563,1003 @@ bool rbt_init (RBTNode* pRoot)
   return result;
 }
 
-// not debugged yet
-static void rbt_delete_black_node (FoundInfo info)    // right case
-{
-  /* delete black node without children
-   * balancing by using mirror subtree red nodes
-   * information = habr.com/ru/company/otus/blog/521034/
-   *
-   *           Node (info.pParent)
-   *         /      \
-   *    [subtree]    x (deleted black node)
-   *
-   * starting from this moment:
-   *    > all off actoins will be described relative to the 'pNode = info.pParent'
-   *    > 'subtree' will describe mirror subtree side
-   *
-   * scheme for both 'subtree' value variants
-   *
-   *             Node             Node
-   *           /      \         /      \
-   *          A        x       x        A
-   *       /     \                   /     \
-   *      B       C                 C       B
-   *             /  \             /  \
-   *            D    E           E    D
-   *
-   *
-   * attention! cases order matters, they are placed
-   *     > in decreasing order of red nodes number
-   *     > in increasing order of balancing complexity
-   */
 
-  RBTNode* pNode = info.pParent;
-  SUBTREE subtree = (info.subtree == LEFT) ? RIGHT : LEFT;
+bool rbt_build_from_sorted (RBTNode** pRoot, const char* const* keys, const void* items,
+                            size_t itemSize, size_t count, bool isContiguous)
+{
+  return rbt_build_nodes (pRoot, NULL, keys, items, itemSize, count, isContiguous);
+}
 
-  // prepare all nodes pointers depending on the 'subtree' value
-  RBTNode* A = (subtree == LEFT) ? pNode->left : pNode->right;
-  RBTNode* B = (subtree == LEFT) ? A->left : A->right;
-  RBTNode* C = (subtree == LEFT) ? A->right : A->left;
-  RBTNode* D = NULL;
-  RBTNode* E = NULL;
+static THREAD_ROUTINE (rbt_create_nodes_routine, pArg)
+{
+  rbt_create_nodes ((CreateTask*)pArg);
+  return THREAD_ROUTINE_RET_CODE ();
+}
+
+bool rbt_merge_sorted (RBTNode** pRoot, const char* const* keys, const void* items,
+                       size_t itemSize, size_t count, unsigned int threadsCount)
+{
+  return rbt_merge_nodes (pRoot, NULL, keys, items, itemSize, count, threadsCount);
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+bool rbt_key_info (const char* key, KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    if (key == NULL)
+    {
+      break;
+    }
+
+    size_t keyLen = key_length (key, RBT_KEY_SIZE);
+
+    if (keyLen > RBT_KEY_SIZE - 1)    // for '\0'
+    {
+      break;
+    }
+
+    pKey->key = key;
+    pKey->length = keyLen;
+    pKey->prefix = key_prefix (key, keyLen);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+int rbt_key_compare (const RBTNode* pNode, const KeyInfo* pKey)
+{
+  /* strcmp (pNode->key, pKey->key) equivalent
+   *
+   * > prefixes differ : their integer order is the keys order
+   * > prefixes equal and both keys fit into prefix : keys are equal
+   * > otherwise the rest of keys is compared up to the shortest '\0' inclusively
+   */
+
+  int result = 0;
+
+  if (pNode->keyPrefix != pKey->prefix)
+  {
+    result = (pNode->keyPrefix < pKey->prefix) ? -1 : 1;
+  }
+  else if (pNode->keyLength > KEY_PREFIX_SIZE || pKey->length > KEY_PREFIX_SIZE)
+  {
+    size_t length = (pNode->keyLength < pKey->length) ? pNode->keyLength : pKey->length;
+
+    result = key_compare (pNode->key + KEY_PREFIX_SIZE, pKey->key + KEY_PREFIX_SIZE,
+                          length + 1 - KEY_PREFIX_SIZE);
+  }
+
+  return result;
+}
+
+void rbt_set_key (RBTNode* pNode, const KeyInfo* pKey)
+{
+  memcpy (pNode->key, pKey->key, pKey->length + 1);
+  pNode->keyPrefix = pKey->prefix;
+  pNode->keyLength = pKey->length;
+}
+
+RBTNode* rbt_create_node (Heap* pHeap, const void* pItem, size_t itemSize, const KeyInfo* pKey)
+{
+  RBTNode* pNode = NULL;
+
+  do
+  {
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    // no need to check if key is valid
+    // it was already checked in caller = rbt_insert()
+
+    // allocate memory for node
+    pNode = (RBTNode*)heap_alloc (pHeap, sizeof (RBTNode));
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    // key and data : small payload is kept inline, otherwise memory is allocated for it
+    pNode->data = pNode->inlineData;
+    pNode->dataCapacity = RBT_INLINE_DATA_SIZE;
+    pNode->isDataOwned = false;
+    pNode->pHeap = pHeap;
+
+    if (!rbt_set_data (pNode, pItem, itemSize))
+    {
+      heap_free (pHeap, pNode, sizeof (RBTNode));
+      pNode = NULL;
+      break;
+    }
+
+    rbt_set_key (pNode, pKey);
+
+    // default settings
+    pNode->size = 1;
+    pNode->color = RED;
+    pNode->poolSlot = 0;
+    pNode->left = &NIL;
+    pNode->right = &NIL;
+    pNode->parent = NULL;
+
+  } while (0);
+
+  return pNode;
+}
+
+bool rbt_set_data (RBTNode* pNode, const void* pItem, size_t itemSize)
+{
+  // the current storage is reused when the payload fits it, so updates don't reallocate
+
+  bool result = false;
+
+  do
+  {
+    if (itemSize > pNode->dataCapacity)
+    {
+      void* pData = heap_alloc (pNode->pHeap, itemSize);
+      if (pData == NULL)
+      {
+        break;
+      }
+
+      if (pNode->isDataOwned)
+      {
+        heap_free (pNode->pHeap, pNode->data, pNode->dataCapacity);
+      }
+
+      pNode->data = pData;
+      pNode->dataCapacity = itemSize;
+      pNode->isDataOwned = true;
+    }
+
+    memcpy (pNode->data, pItem, itemSize);
+    pNode->dataSize = itemSize;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void rbt_release_node (RBTNode* pNode)
+{
+  if (pNode->isDataOwned)
+  {
+    heap_free (pNode->pHeap, pNode->data, pNode->dataCapacity);
+  }
+
+  if (pNode->poolSlot == 0)
+  {
+    heap_free (pNode->pHeap, pNode, sizeof (RBTNode));
+  }
+  else
+  {
+    // nodes and payloads of contiguous block are freed all together with the last node
+    RBTPool* pPool
+        = (RBTPool*)((char*)(pNode - (pNode->poolSlot - 1)) - RBT_POOL_HEADER_SIZE);
+
+    if (__atomic_sub_fetch (&pPool->liveCount, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+      heap_free (pNode->pHeap, pPool, pPool->blockSize);
+    }
+  }
+}
+
+
+RBTNode* rbt_bound_by_key (RBTNode* pRoot, const char* key, bool isUpper)
+{
+  RBTNode* pBound = NULL;
+  KeyInfo keyInfo;
+
+  if (rbt_key_info (key, &keyInfo))
+  {
+    pBound = rbt_bound (pRoot, &keyInfo, isUpper);
+  }
+
+  return pBound;
+}
+
+
+FoundInfo rbt_find_near (RBTNode* pRoot, RBTNode* pHint, const KeyInfo* pKey)
+{
+  /* the key place is checked next to the hint first:
+   *   > hint < key < next (hint) : right child of hint if it's NIL, otherwise left child of next
+   *   > prev (hint) < key < hint : mirrored
+   * the neighbours search only follows links, so the key is compared twice at most
+   * the whole tree is searched when the key doesn't belong there
+   */
+
+  FoundInfo info = { NULL, NULL, NONE };
+  bool isFound = false;
+
+  if (pHint != NULL && pHint != &NIL)
+  {
+    int order = rbt_key_compare (pHint, pKey);
+
+    if (order < 0)
+    {
+      RBTNode* pNext = rbt_next_node (pHint);
+
+      if (pNext == NULL || rbt_key_compare (pNext, pKey) > 0)
+      {
+        info.pParent = (pHint->right == &NIL) ? pHint : pNext;
+        info.subtree = (pHint->right == &NIL) ? RIGHT : LEFT;
+        info.pNode = &NIL;
+        isFound = true;
+      }
+    }
+    else if (order > 0)
+    {
+      RBTNode* pPrev = rbt_prev_node (pHint);
+
+      if (pPrev == NULL || rbt_key_compare (pPrev, pKey) < 0)
+      {
+        info.pParent = (pHint->left == &NIL) ? pHint : pPrev;
+        info.subtree = (pHint->left == &NIL) ? LEFT : RIGHT;
+        info.pNode = &NIL;
+        isFound = true;
+      }
+    }
+    else
+    {
+      info.pParent = pHint->parent;
+      info.pNode = pHint;
+      isFound = true;
+    }
+  }
+
+  if (!isFound)
+  {
+    info = rbt_find_node (pRoot, pKey);
+  }
+
+  return info;
+}
+
+bool rbt_insert_node (RBTNode** pRoot, RBTNode** pLast, Heap* pHeap, void* pItem,
+                      size_t itemSize, const char* key)
+{
+  /* insertion place:
+   *   always to the NIL
+   *   exception: red-black tree is empty
+   * pLast is the rightmost node cache, NULL for the plain functions : a key above it is
+   * appended as its right child without the descent
+   */
+
+  bool result = false;
+  KeyInfo keyInfo;
+  LATENCY_START (start);
+
+  do
+  {
+    if (!rbt_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    // search place to insert to
+    bool isAppend = (pLast != NULL && *pLast != NULL && rbt_key_compare (*pLast, &keyInfo) < 0);
+    FoundInfo info = { NULL, NULL, NONE };
+
+    if (isAppend)
+    {
+      info.pParent = *pLast;
+      info.pNode = &NIL;
+      info.subtree = RIGHT;
+    }
+    else
+    {
+      info = rbt_find_node (*pRoot, &keyInfo);
+    }
+
+    if (info.pNode != NULL && info.pNode != &NIL)    // node with such key already exists
+    {
+      break;    // different logic might be implemented
+    }
+
+    RBTNode* pNode = rbt_create_node (pHeap, pItem, itemSize, &keyInfo);
+
+    if (pNode == NULL)    // error while creating node to insert
+    {
+      break;
+    }
+
+    rbt_attach_node (pRoot, info, pNode);
+
+    if (isAppend)
+    {
+      *pLast = pNode;
+    }
+    else if (pLast != NULL && *pLast == NULL)
+    {
+      *pLast = rbt_max_node (*pRoot);
+    }
+
+    result = true;
+
+  } while (0);
+
+  LATENCY_STOP (LATENCY_RBT_INSERT, start);
+
+  return result;
+}
+
+bool rbt_upsert_node (RBTNode** pRoot, Heap* pHeap, void* pItem, size_t itemSize,
+                      const char* key, RBTMergeCallback merge, void* pContext)
+{
+  // one search for both cases : existing node gets the new payload, otherwise it's inserted
+
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (!rbt_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    FoundInfo info = rbt_find_node (*pRoot, &keyInfo);
+
+    if (info.pNode != NULL && info.pNode != &NIL)
+    {
+      if (merge != NULL)
+      {
+        merge (info.pNode->data, info.pNode->dataSize, pItem, itemSize, pContext);
+        result = true;
+      }
+      else
+      {
+        result = rbt_set_data (info.pNode, pItem, itemSize);
+      }
+      break;
+    }
+
+    RBTNode* pNode = rbt_create_node (pHeap, pItem, itemSize, &keyInfo);
+
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    rbt_attach_node (pRoot, info, pNode);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+RBTNode* rbt_insert_hint_node (RBTNode** pRoot, Heap* pHeap, RBTNode* pHint, void* pItem,
+                               size_t itemSize, const char* key)
+{
+  RBTNode* pNode = NULL;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (!rbt_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    FoundInfo info = rbt_find_near (*pRoot, pHint, &keyInfo);
+
+    if (info.pNode != NULL && info.pNode != &NIL)    // node with such key already exists
+    {
+      break;
+    }
+
+    pNode = rbt_create_node (pHeap, pItem, itemSize, &keyInfo);
+
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    rbt_attach_node (pRoot, info, pNode);
+
+  } while (0);
 
-  if (C != &NIL)    // D, E exist only if B is not a leaf
-  {
-    D = (subtree == LEFT) ? C->left : C->right;
-    E = (subtree == LEFT) ? C->right : C->left;
-  }
+  return pNode;
+}
+
+bool rbt_build_nodes (RBTNode** pRoot, Heap* pHeap, const char* const* keys, const void* items,
+                      size_t itemSize, size_t count, bool isContiguous)
+{
+  /* linear time building:
+   *   > middle key of a range becomes root of the subtree built from that range
+   *   > so all levels are full except probably the deepest one
+   *   > nodes of the deepest partially filled level are RED, all the others are BLACK
+   */
+
+  bool result = false;
+  RBTNode** pNodes = NULL;
 
   do
   {
-    // case 1 ('subtree' independent)
-    if (pNode->color == RED && A->color == BLACK && B->color == BLACK && C->color == BLACK)
+    if (*pRoot != NULL)    // rbt_merge_sorted() is for non-empty trees
     {
-      pNode->color = BLACK;
-      A->color = RED;
+      break;
+    }
 
+    if (keys == NULL || items == NULL || !is_batch_sorted (keys, count))
+    {
       break;
     }
 
-    // case 2
-    if (pNode->color == BLACK && A->color == RED && B->color == BLACK)
+    if (count == 0)
     {
-      pNode->color = RED;
-      A->color = BLACK;
-      B->color = RED;
+      result = true;
+      break;
+    }
 
-      (subtree == LEFT) ? rbt_rot_right (pNode) : rbt_rot_left (pNode);
+    if (isContiguous && count > UINT_MAX)    // doesn't fit RBTNode.poolSlot
+    {
+      break;
+    }
 
+    pNodes = (RBTNode**)malloc (count * sizeof (RBTNode*));
+    if (pNodes == NULL)
+    {
       break;
     }
 
-    // case 3
-    if (pNode->color == BLACK && A->color == RED && D->color == BLACK
-        && E->color == BLACK)    // DENGEROUS, CHECK IF LOGIC CORRECT
+    if (isContiguous)
+    {
+      if (!rbt_create_pool (pNodes, pHeap, keys, items, itemSize, count))
+      {
+        break;
+      }
+    }
+    else
     {
-      A->color = BLACK;
-      C->color = RED;
+      CreateTask task = { keys, (const char*)items, itemSize, count, pHeap, pNodes, false };
+
+      rbt_create_nodes (&task);
+      if (task.isFailed)
+      {
+        break;
+      }
+    }
+
+    *pRoot = rbt_link_balanced (pNodes, count, 0, rbt_red_depth (count));
+    (*pRoot)->parent = NULL;
+
+    result = true;
+
+  } while (0);
+
+  free (pNodes);
+
+  return result;
+}
+
+bool rbt_merge_nodes (RBTNode** pRoot, Heap* pHeap, const char* const* keys, const void* items,
+                      size_t itemSize, size_t count, unsigned int threadsCount)
+{
+  /* the tree is flattened into sorted array of nodes, merged with the batch
+   * and relinked into the balanced tree, so it costs O(n + m) instead of O(m * log(n + m))
+   *
+   * nodes creation and subtrees linking are split between 'threadsCount' threads,
+   * the tree isn't modified until all the batch nodes are successfully created
+   */
 
-      (subtree == LEFT) ? rbt_rot_right (pNode) : rbt_rot_left (pNode);
+  bool result = false;
+  RBTNode** pMerged = NULL;
+  RBTNode** pCreated = NULL;
 
+  do
+  {
+    if (keys == NULL || items == NULL || !is_batch_sorted (keys, count))
+    {
       break;
     }
 
-    // case 4
-    if (pNode->color == BLACK && A->color == RED
-        && D->color == RED)    // DENGEROUS, CHECK IF LOGIC CORRECT
+    if (count == 0)
     {
-      D->color = BLACK;
+      result = true;
+      break;
+    }
 
-      (subtree == LEFT) ? rbt_rot_left (A) : rbt_rot_right (A);
-      (subtree == LEFT) ? rbt_rot_right (pNode) : rbt_rot_left (pNode);
+    size_t treeSize = 0;
+    for (RBTNode* pNode = rbt_first (*pRoot); pNode != NULL; pNode = rbt_next (pNode))
+    {
+      ++treeSize;
+    }
 
+    pMerged = (RBTNode**)malloc ((treeSize + count) * sizeof (RBTNode*));
+    pCreated = (RBTNode**)malloc (count * sizeof (RBTNode*));
+    if (pMerged == NULL || pCreated == NULL)
+    {
       break;
     }
 
-    // case 5
-    if (pNode->color == BLACK && A->color == BLACK && C->color == RED)
+    // merge : NULL is placeholder for the next batch node
+    bool isDuplicated = false;
+    size_t mergedCount = 0;
+    size_t batchIndex = 0;
+    RBTNode* pNode = rbt_first (*pRoot);
+    KeyInfo keyInfo = { NULL, 0, 0 };
+
+    (void)rbt_key_info (keys[0], &keyInfo);
+
+    while (pNode != NULL || batchIndex < count)
     {
-      C->color = BLACK;
+      int order = 1;    // batch key goes first
+
+      if (batchIndex == count)
+      {
+        order = -1;
+      }
+      else if (pNode != NULL)
+      {
+        order = rbt_key_compare (pNode, &keyInfo);
+      }
+
+      if (order == 0)    // node with such key already exists
+      {
+        isDuplicated = true;
+        break;
+      }
+
+      if (order < 0)
+      {
+        pMerged[mergedCount++] = pNode;
+        pNode = rbt_next (pNode);
+      }
+      else
+      {
+        pMerged[mergedCount++] = NULL;
 
-      (subtree == LEFT) ? rbt_rot_left (A) : rbt_rot_right (A);
-      (subtree == LEFT) ? rbt_rot_right (pNode) : rbt_rot_left (pNode);
+        if (++batchIndex < count)
+        {
+          (void)rbt_key_info (keys[batchIndex], &keyInfo);
+        }
+      }
+    }
 
+    if (isDuplicated)
+    {
       break;
     }
 
-    // case 6 (correct current context to the detriment of entire tree balance)
-    if (pNode->color == BLACK && A->color == BLACK && B->color == BLACK && C->color == BLACK)
+    // create batch nodes
+    if (threadsCount == 0)
+    {
+      threadsCount = 1;
+    }
+
+    if (threadsCount > RBT_MAX_BULK_THREADS)
+    {
+      threadsCount = RBT_MAX_BULK_THREADS;
+    }
+
+    if (threadsCount > count)
+    {
+      threadsCount = (unsigned int)count;
+    }
+
+    CreateTask tasks[RBT_MAX_BULK_THREADS];
+    size_t chunk = count / threadsCount;
+
+    for (unsigned int i = 0; i < threadsCount; ++i)
+    {
+      size_t from = i * chunk;
+      size_t to = (i == threadsCount - 1) ? count : from + chunk;
+
+      tasks[i].keys = keys + from;
+      tasks[i].items = (const char*)items + from * itemSize;
+      tasks[i].itemSize = itemSize;
+      tasks[i].count = to - from;
+      tasks[i].pHeap = pHeap;
+      tasks[i].pNodes = pCreated + from;
+      tasks[i].isFailed = false;
+    }
+
+    rbt_run_tasks (rbt_create_nodes_routine, tasks, sizeof (CreateTask), threadsCount);
+
+    bool isFailed = false;
+    for (unsigned int i = 0; i < threadsCount; ++i)
     {
-      A->color = RED;
+      isFailed = isFailed || tasks[i].isFailed;
+    }
 
-      // recursive call (only if pNode is not root)
-      if (pNode->parent != NULL)
+    if (isFailed)    // failed task has already released its own nodes
+    {
+      for (unsigned int i = 0; i < threadsCount; ++i)
       {
-        info.pParent = pNode->parent;
-        info.subtree = (pNode->parent->left == pNode) ? LEFT : RIGHT;
-        rbt_delete_black_node (info);
+        for (size_t j = 0; !tasks[i].isFailed && j < tasks[i].count; ++j)
+        {
+          rbt_release_node (tasks[i].pNodes[j]);
+        }
       }
 
       break;
     }
 
+    // fill placeholders and relink
+    batchIndex = 0;
+    for (size_t i = 0; i < mergedCount; ++i)
+    {
+      if (pMerged[i] == NULL)
+      {
+        pMerged[i] = pCreated[batchIndex++];
+      }
+    }
+
+    *pRoot = rbt_link_balanced_parallel (pMerged, mergedCount, threadsCount);
+    (*pRoot)->parent = NULL;
+
+    result = true;
+
   } while (0);
+
+  free (pMerged);
+  free (pCreated);
+
+  return result;
 }
-static void rbt_delete_balance (FoundInfo info)
-{
-  /* description
-   *
-   * 1. already know that node for delete is
-   *    - or root with two children
-   *    - or any of not root node
-   *
-   * 2. if node has two children task would be reduced
-   *    to delete node with zero or one child and then
-   *    rbt_delete_balance() would be recursevily called
-   *
-   */
 
-  // preparing
-  RBTNode* pCurr = NULL;
-  RBTNode* pNode = info.pNode;
-  RBTNode* pParent = info.pParent;
-  SUBTREE subtree = info.subtree;
+bool is_batch_sorted (const char* const* keys, size_t count)
+{
+  bool result = true;
+  KeyInfo keyInfo;
 
-  // case 1: node has two children, node color doesn't matter
-  if (pNode->left != &NIL && pNode->right != &NIL)
+  for (size_t i = 0; i < count; ++i)
   {
-    // find nearest node from right
-    pCurr = pNode->right;
-
-    while (pCurr->left != &NIL)
+    if (!rbt_key_info (keys[i], &keyInfo))
     {
-      pCurr = pCurr->left;
+      result = false;
+      break;
     }
 
-    // make exchange: key
-    strncpy (pNode->key, pCurr->key, RBT_KEY_SIZE);
+    if (i > 0 && key_string_compare (keys[i - 1], keys[i]) >= 0)    // duplicated or unsorted
+    {
+      result = false;
+      break;
+    }
+  }
 
-    // make exchange: data
-    void* pData = pNode->data;
-    pNode->data = pCurr->data;
-    pCurr->data = pData;
+  return result;
+}
 
-    // call rbt_delete_balance() for pCurr node
-    info.pNode = pCurr;
-    info.pParent = pCurr->parent;
-    info.subtree = (pCurr->parent == pNode) ? RIGHT : LEFT;
-    rbt_delete_balance (info);
-  }
+bool rbt_create_pool (RBTNode** pNodes, Heap* pHeap, const char* const* keys,
+                      const void* items, size_t itemSize, size_t count)
+{
+  bool result = false;
 
-  // case 2: node hasn't children, node is red
-  else if (pNode->color == RED && pNode->left == &NIL && pNode->right == &NIL)
+  do
   {
-    if (subtree = LEFT)
+    // small payloads are inline, so the block has no slots for them
+    bool isInline = (itemSize <= RBT_INLINE_DATA_SIZE);
+    size_t nodesSize = RBT_ALIGN_UP (count * sizeof (RBTNode));
+    size_t slotSize = isInline ? 0 : RBT_ALIGN_UP (itemSize);
+
+    size_t blockSize = RBT_POOL_HEADER_SIZE + nodesSize + count * slotSize;
+    char* pBlock = (char*)heap_alloc (pHeap, blockSize);
+    if (pBlock == NULL)
     {
-      pParent->left = &NIL;
+      break;
     }
-    else
+
+    ((RBTPool*)pBlock)->liveCount = count;
+    ((RBTPool*)pBlock)->blockSize = blockSize;
+
+    // nodes are placed in keys order, so in-order traversal goes through memory sequentially
+    RBTNode* pNode = (RBTNode*)(pBlock + RBT_POOL_HEADER_SIZE);
+    char* pData = pBlock + RBT_POOL_HEADER_SIZE + nodesSize;
+
+    for (size_t i = 0; i < count; ++i, ++pNode, pData += slotSize)
     {
-      pParent->right = &NIL;
+      KeyInfo keyInfo = { NULL, 0, 0 };
+
+      (void)rbt_key_info (keys[i], &keyInfo);    // keys are already validated
+      rbt_set_key (pNode, &keyInfo);
+      pNode->data = isInline ? pNode->inlineData : pData;
+      pNode->dataSize = itemSize;
+      pNode->dataCapacity = isInline ? RBT_INLINE_DATA_SIZE : slotSize;
+      pNode->isDataOwned = false;
+      pNode->pHeap = pHeap;
+      memcpy (pNode->data, (const char*)items + i * itemSize, itemSize);
+
+      pNode->size = 1;
+      pNode->color = RED;
+      pNode->poolSlot = (unsigned int)(i + 1);
+      pNode->left = &NIL;
+      pNode->right = &NIL;
+      pNode->parent = NULL;
+
+      pNodes[i] = pNode;
     }
-  }
 
-  // case 3: node has one child, node is black (child might be only red)
-  else if (pNode->color == BLACK && (pNode->left != &NIL || pNode->right != &NIL))
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void rbt_create_nodes (CreateTask* pTask)
+{
+  for (size_t i = 0; i < pTask->count; ++i)
   {
-    pCurr = pNode;    // child would be deleted so we keep pNode name for free()
+    KeyInfo keyInfo = { NULL, 0, 0 };
+
+    (void)rbt_key_info (pTask->keys[i], &keyInfo);    // keys are already validated
+    pTask->pNodes[i] = rbt_create_node (pTask->pHeap, pTask->items + i * pTask->itemSize,
+                                        pTask->itemSize, &keyInfo);
+
+    if (pTask->pNodes[i] == NULL)
+    {
+      while (i-- > 0)
+      {
+        rbt_release_node (pTask->pNodes[i]);
+      }
 
-    pNode = (pNode->left != &NIL) ? pNode->left : pNode->right;
+      pTask->isFailed = true;
+      break;
+    }
+  }
+}
 
-    // make exchange: key
-    strncpy (pCurr->key, pNode->key, RBT_KEY_SIZE);
+int rbt_red_depth (size_t count)
+{
+  // levels above this depth are full, the level at this depth (if exists) is partially filled
 
-    // make exchange: data
-    void* pData = pCurr->data;
-    pCurr->data = pNode->data;
-    pNode->data = pData;
+  int depth = 0;
 
-    // remove pNode from tree
-    pCurr->left = &NIL;
-    pCurr->right = &NIL;
+  while (((size_t)1 << (depth + 1)) <= count + 1)
+  {
+    ++depth;
   }
 
-  // case 4: node hasn't children, node is black
-  if (pNode->color == BLACK)
+  return depth;
+}
+
+RBTNode* rbt_link_balanced (RBTNode** pNodes, size_t count, int depth, int redDepth)
+{
+  RBTNode* pNode = &NIL;
+
+  if (count != 0)
   {
-    if (subtree == LEFT)
+    size_t middle = count / 2;
+
+    pNode = pNodes[middle];
+    pNode->color = (depth == redDepth) ? RED : BLACK;
+    pNode->size = count;
+
+    pNode->left = rbt_link_balanced (pNodes, middle, depth + 1, redDepth);
+    if (pNode->left != &NIL)
     {
-      pParent->left = &NIL;
+      pNode->left->parent = pNode;
     }
-    else
+
+    pNode->right
+        = rbt_link_balanced (pNodes + middle + 1, count - middle - 1, depth + 1, redDepth);
+    if (pNode->right != &NIL)
     {
-      pParent->right = &NIL;
+      pNode->right->parent = pNode;
     }
+  }
+
+  return pNode;
+}
 
-    info.pNode = &NIL;
-    rbt_delete_black_node (info);    // recursive function
+static THREAD_ROUTINE (rbt_link_balanced_routine, pArg)
+{
+  LinkTask* pTask = (LinkTask*)pArg;
+  pTask->pSubtree = rbt_link_balanced (pTask->pNodes, pTask->count, pTask->depth, pTask->redDepth);
+  return THREAD_ROUTINE_RET_CODE ();
+}
+
+static size_t rbt_split_subtrees (LinkTask* pTasks, RBTNode** pNodes, size_t count, int depth,
+                                  int splitDepth, int redDepth)
+{
+  // subtrees at 'splitDepth' in-order, the same ranges rbt_link_balanced() produces
+
+  size_t tasksCount = 1;
+
+  if (depth == splitDepth)
+  {
+    *pTasks = (LinkTask) { pNodes, count, depth, redDepth, &NIL };
+  }
+  else
+  {
+    size_t middle = (count == 0) ? 0 : count / 2;
+    size_t rightCount = (count == 0) ? 0 : count - middle - 1;
+
+    tasksCount = rbt_split_subtrees (pTasks, pNodes, middle, depth + 1, splitDepth, redDepth);
+    tasksCount += rbt_split_subtrees (pTasks + tasksCount, pNodes + middle + 1, rightCount,
+                                      depth + 1, splitDepth, redDepth);
   }
 
-  free (pNode->data);
-  free (pNode);
+  return tasksCount;
 }
-bool rbt_delete (RBTNode** pRoot, const char* key)
+
+static RBTNode* rbt_link_top (LinkTask** ppTask, RBTNode** pNodes, size_t count, int depth,
+                              int splitDepth, int redDepth)
 {
-  bool result = false;
+  // levels above 'splitDepth' : subtrees below are already linked by tasks
 
-  do
+  RBTNode* pNode = &NIL;
+
+  if (depth == splitDepth)
   {
-    if (!is_key_valid (key))
-    {
-      break;
-    }
+    pNode = (*ppTask)->pSubtree;
+    ++*ppTask;
+  }
+  else if (count != 0)
+  {
+    size_t middle = count / 2;
 
-    FoundInfo info = rbt_find_node (*pRoot, key);
+    pNode = pNodes[middle];
+    pNode->color = (depth == redDepth) ? RED : BLACK;
+    pNode->size = count;
 
-    if (info.pNode == NULL)    // tree is empty
+    pNode->left = rbt_link_top (ppTask, pNodes, middle, depth + 1, splitDepth, redDepth);
+    if (pNode->left != &NIL)
     {
-      break;
+      pNode->left->parent = pNode;
     }
 
-    if (info.pNode == &NIL)    // node was not found
+    pNode->right = rbt_link_top (ppTask, pNodes + middle + 1, count - middle - 1, depth + 1,
+                                 splitDepth, redDepth);
+    if (pNode->right != &NIL)
     {
-      break;
+      pNode->right->parent = pNode;
     }
+  }
+  else
+  {
+    // empty range above 'splitDepth' : skip its placeholders
+    *ppTask += (size_t)1 << (splitDepth - depth);
+  }
+
+  return pNode;
+}
+
+RBTNode* rbt_link_balanced_parallel (RBTNode** pNodes, size_t count, unsigned int threadsCount)
+{
+  int redDepth = rbt_red_depth (count);
+  int splitDepth = 0;
 
-    // node is root and has zero or one child
-    // specific case because root hasn't parent
-    // if node is root and has two children parent doesn't matter
-    if (info.pNode == *pRoot)
+  while (((unsigned int)2 << splitDepth) <= threadsCount)
+  {
+    ++splitDepth;
+  }
+
+  LinkTask tasks[RBT_MAX_BULK_THREADS];
+  size_t tasksCount = rbt_split_subtrees (tasks, pNodes, count, 0, splitDepth, redDepth);
+
+  rbt_run_tasks (rbt_link_balanced_routine, tasks, sizeof (LinkTask), tasksCount);
+
+  LinkTask* pTask = tasks;
+  return rbt_link_top (&pTask, pNodes, count, 0, splitDepth, redDepth);
+}
+
+size_t rbt_cut_subtrees (RBTNode* pNode, int depth, int splitDepth, DestroyTask* pTasks)
+{
+  // subtrees at 'splitDepth' are detached from their parents, recursion is 'splitDepth' deep
+
+  size_t tasksCount = 0;
+
+  if (pNode != &NIL)
+  {
+    if (depth == splitDepth)
     {
-      if (info.pNode->left == &NIL && info.pNode->right == &NIL)    // zero children
-      {
-        *pRoot = NULL;
-      }
-      else if (info.pNode->left != &NIL && info.pNode->right != &NIL)
+      RBTNode* pParent = pNode->parent;
+
+      if (pParent->left == pNode)
       {
-        rbt_delete_balance (info);
+        pParent->left = &NIL;
       }
       else
       {
-        if (info.pNode->left != &NIL)
-        {
-          *pRoot = info.pNode->left;
-        }
-        else
-        {
-          *pRoot = info.pNode->right;
-        }
-
-        (*pRoot)->color = BLACK;
-        (*pRoot)->parent = NULL;
+        pParent->right = &NIL;
       }
 
-      free (info.pNode->data);
-      free (info.pNode);
+      pNode->parent = NULL;
+      pTasks->pSubtree = pNode;
+      tasksCount = 1;
+    }
+    else
+    {
+      tasksCount = rbt_cut_subtrees (pNode->left, depth + 1, splitDepth, pTasks);
+      tasksCount
+          += rbt_cut_subtrees (pNode->right, depth + 1, splitDepth, pTasks + tasksCount);
+    }
+  }
+
+  return tasksCount;
+}
+
+static void rbt_run_tasks (void* (*routine) (void*), void* pTasks, size_t taskSize,
+                           size_t tasksCount)
+{
+  // the first task is run by the caller thread as well as tasks failed to get own thread
+
+  THREAD_TYPE threads[RBT_MAX_BULK_THREADS];
+  bool isStarted[RBT_MAX_BULK_THREADS] = { false };
+
+  for (size_t i = 1; i < tasksCount; ++i)
+  {
+    isStarted[i] = (CREATE_THREAD (threads[i], routine, (char*)pTasks + i * taskSize) == 0);
+  }
+
+  for (size_t i = 0; i < tasksCount; ++i)
+  {
+    if (!isStarted[i])
+    {
+      routine ((char*)pTasks + i * taskSize);
+    }
+  }
+
+  for (size_t i = 1; i < tasksCount; ++i)
+  {
+    if (isStarted[i])
+    {
+      (void)JOIN_THREAD (threads[i]);
     }
-    else    // node is not root
+  }
+}
+
+
+/************************************************************************
+ *                           UNAVAILABLE   	                            *
+ ************************************************************************/
+
+// no need without thread-safety approach
+bool rbt_init (RBTNode* pRoot)  
+{
+  bool result = false;
+
+  do
+  {
+    if (pRoot == NULL)
     {
-      rbt_delete_balance (info);
+      break;
     }
 
-    rbt_actualize_root (pRoot);
+    memset (pRoot->key, '\0', RBT_KEY_SIZE);
+    pRoot->data = NULL;
+    pRoot->color = BLACK;
+    pRoot->left = &NIL;
+    pRoot->right = &NIL;
+    pRoot->parent = NULL;
 
     result = true;
 
   } while (0);
 
   return result;
-}
\ No newline at end of file
+}
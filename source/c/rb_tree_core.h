@@ -0,0 +1,689 @@
+/* red-black tree balancing code shared by all the tree variants
+ *
+ * the file is included by variant source once per node type, after defining:
+ *
+ *   RBT_CORE_NODE                node type : 'color', 'left', 'right', 'parent' members
+ *   RBT_CORE_NIL                 address of the variant sentinel node
+ *   RBT_CORE_KEY                 type of the searched key argument
+ *   RBT_CORE_COMPARE(pNode, key) node key vs searched key : < 0, 0, > 0
+ *   RBT_CORE_RELEASE(pNode)      free node memory
+ *   RBT_CORE_FOUND               name of generated search result type
+ *   RBT_CORE_FN(name)            name of generated static function
+ *
+ * optional:
+ *
+ *   RBT_CORE_SIZE                node has 'size' member : nodes count of its subtree, 0 for NIL
+ *
+ * all the parameters are undefined at the end of the file
+ */
+
+#ifndef RBT_CORE_COMMON
+#define RBT_CORE_COMMON
+
+typedef enum SUBTREE_E
+{
+  NONE,
+  LEFT,
+  RIGHT,
+} SUBTREE;
+
+#endif    // RBT_CORE_COMMON
+
+// subtree sizes : a rotated pair is recounted, a path to the root is shifted by insert/delete
+#ifdef RBT_CORE_SIZE
+#define RBT_CORE_RESIZE(pNode) ((pNode)->size = (pNode)->left->size + (pNode)->right->size + 1)
+#define RBT_CORE_ROT_RESIZE(pNode, pTemp) ((pTemp)->size = (pNode)->size, RBT_CORE_RESIZE (pNode))
+#define RBT_CORE_PATH_RESIZE(pNode, delta)                                     \
+  for (RBT_CORE_NODE* pPath = (pNode); pPath != NULL; pPath = pPath->parent) \
+  {                                                                            \
+    pPath->size += (delta);                                                    \
+  }
+#else
+#define RBT_CORE_ROT_RESIZE(pNode, pTemp)
+#define RBT_CORE_PATH_RESIZE(pNode, delta)
+#endif
+
+typedef struct
+{
+  RBT_CORE_NODE* pParent;
+  RBT_CORE_NODE* pNode;
+  SUBTREE subtree;
+} RBT_CORE_FOUND;
+
+static void RBT_CORE_FN (actualize_root) (RBT_CORE_NODE** pRoot)
+{
+  while ((*pRoot)->parent != NULL)
+  {
+    *pRoot = (*pRoot)->parent;
+  }
+
+  (*pRoot)->color = BLACK;
+}
+
+static RBT_CORE_FOUND RBT_CORE_FN (find_node) (RBT_CORE_NODE* pRoot, RBT_CORE_KEY key)
+{
+  /*           variant                 description
+   *
+   * >>  { NULL, NULL, NONE }    >>   tree is empty
+   * >>  { NULL, ROOT, NONE }    >>   found : node is root
+   * >>  { ....  ....  .... }    >>   found : node is not root
+   * >>  { ...., &NIL, .... }    >>   not found
+   *
+   */
+
+  RBT_CORE_FOUND info = { NULL, NULL, NONE };
+
+  do
+  {
+    if (pRoot == NULL)
+    {
+      break;
+    }
+
+    info.pNode = pRoot;
+
+    while (info.pNode != RBT_CORE_NIL)
+    {
+      int result = RBT_CORE_COMPARE (info.pNode, key);
+
+      if (result > 0)    // go left
+      {
+        info.pParent = info.pNode;
+        info.pNode = info.pNode->left;
+        info.subtree = LEFT;
+      }
+      else if (result < 0)    // go right
+      {
+        info.pParent = info.pNode;
+        info.pNode = info.pNode->right;
+        info.subtree = RIGHT;
+      }
+      else    // found , info is in actual state
+      {
+        break;
+      }
+    }
+
+  } while (0);
+
+  return info;
+}
+
+static RBT_CORE_NODE* RBT_CORE_FN (bound) (RBT_CORE_NODE* pRoot, RBT_CORE_KEY key, bool isUpper)
+{
+  /* lower bound : the leftmost node with node.key >= key
+   * upper bound : the leftmost node with node.key >  key
+   *
+   * every time we go left current node is the best candidate so far
+   */
+
+  RBT_CORE_NODE* pBound = NULL;
+  RBT_CORE_NODE* pNode = pRoot;
+
+  while (pNode != NULL && pNode != RBT_CORE_NIL)
+  {
+    int result = RBT_CORE_COMPARE (pNode, key);
+
+    if (result > 0 || (result == 0 && !isUpper))    // go left
+    {
+      pBound = pNode;
+      pNode = pNode->left;
+    }
+    else    // go right
+    {
+      pNode = pNode->right;
+    }
+  }
+
+  return pBound;
+}
+
+static void RBT_CORE_FN (free_memory) (RBT_CORE_NODE* pNode)
+{
+  /* pNode is a root of a tree or a cut off subtree : its parent is NULL
+   *
+   * post-order without recursion and extra memory : the link to a visited child is cut,
+   * so a node is released when we come back to it from the last child by parent pointer
+   *
+   * children are prefetched as soon as the node is reached
+   */
+
+  while (pNode != NULL)
+  {
+    RBT_CORE_NODE* pNext = NULL;
+
+    __builtin_prefetch (pNode->left, 1);
+    __builtin_prefetch (pNode->right, 1);
+
+    if (pNode->left != RBT_CORE_NIL)
+    {
+      pNext = pNode->left;
+      pNode->left = RBT_CORE_NIL;
+    }
+    else if (pNode->right != RBT_CORE_NIL)
+    {
+      pNext = pNode->right;
+      pNode->right = RBT_CORE_NIL;
+    }
+    else    // when both left and right children are NIL
+    {
+      pNext = pNode->parent;
+      RBT_CORE_RELEASE (pNode);
+    }
+
+    pNode = pNext;
+  }
+}
+
+static void RBT_CORE_FN (rot_left) (RBT_CORE_NODE* pNode)
+{
+  /* state before left rotation
+   *
+   *      Parent (don't know if Node == Parent.left or Parent.right)
+   *        |
+   *       Node
+   *      /   \
+   *    A      Temp
+   *          /   \
+   *         B     C
+   */
+
+  RBT_CORE_NODE* pTemp = pNode->right;
+  RBT_CORE_NODE* pParent = pNode->parent;
+
+  // Node and B
+  pNode->parent = pTemp;
+  pNode->right = pTemp->left;
+  if (pNode->right != RBT_CORE_NIL)
+  {
+    pNode->right->parent = pNode;
+  }
+
+  // Temp
+  pTemp->parent = pParent;
+  pTemp->left = pNode;
+  RBT_CORE_ROT_RESIZE (pNode, pTemp);
+
+  // Parent
+  if (pParent != NULL)
+  {
+    if (pParent->left == pNode)
+    {
+      pParent->left = pTemp;
+    }
+    else
+    {
+      pParent->right = pTemp;
+    }
+  }
+}
+
+static void RBT_CORE_FN (rot_right) (RBT_CORE_NODE* pNode)
+{
+  /* state before right rotation
+   *
+   *           Parent (don't know if Node == Parent.left or Parent.right)
+   *             |
+   *            Node
+   *           /   \
+   *       Temp     A
+   *      /    \
+   *     C      B
+   */
+
+  RBT_CORE_NODE* pTemp = pNode->left;
+  RBT_CORE_NODE* pParent = pNode->parent;
+
+  // Node and B
+  pNode->parent = pTemp;
+  pNode->left = pTemp->right;
+  if (pNode->left != RBT_CORE_NIL)
+  {
+    pNode->left->parent = pNode;
+  }
+
+  // Temp
+  pTemp->parent = pParent;
+  pTemp->right = pNode;
+  RBT_CORE_ROT_RESIZE (pNode, pTemp);
+
+  // Parent
+  if (pParent != NULL)
+  {
+    if (pParent->left == pNode)
+    {
+      pParent->left = pTemp;
+    }
+    else
+    {
+      pParent->right = pTemp;
+    }
+  }
+}
+
+static bool RBT_CORE_FN (is_balance_broken) (RBT_CORE_NODE* pNode)
+{
+  bool result = false;
+
+  do
+  {
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    if (pNode->color == BLACK)
+    {
+      break;
+    }
+
+    if (pNode->parent == NULL)
+    {
+      break;
+    }
+
+    if (pNode->parent->color == BLACK)
+    {
+      break;
+    }
+
+    result = true;
+  } while (0);
+
+  return result;
+}
+
+static void RBT_CORE_FN (insert_balance) (RBT_CORE_NODE* pNode)
+{
+  /* possible state after insertion (X == pNode)
+   *
+   *  v1       A           v2        A
+   *         /   \                 /   \
+   *        B     C               B     C
+   *         \                   /
+   *          X                 X
+   *
+   *
+   *  v3       A           v4        A
+   *         /   \                 /   \
+   *        B     C               B     C
+   *             /                       \
+   *            X                         X
+   */
+
+  while (RBT_CORE_FN (is_balance_broken) (pNode))
+  {
+    // v1, v2: X on the LEFT of A
+    if (pNode->parent == pNode->parent->parent->left)
+    {
+      // C is RED
+      if (pNode->parent->parent->right->color == RED)
+      {
+        pNode->parent->color = BLACK;                   // B
+        pNode->parent->parent->color = RED;             // A
+        pNode->parent->parent->right->color = BLACK;    // C
+
+        pNode = pNode->parent->parent;    // A is next we deal with
+      }
+      // C is BLACK = impossible to be immidiately after insertion,
+      // exception: C is NIL
+      else
+      {
+        // v1: X on the RIGHT of B
+        if (pNode == pNode->parent->right)
+        {
+          RBT_CORE_FN (rot_left) (pNode->parent);
+          pNode = pNode->left;    // to make following code universal
+        }
+
+        pNode->parent->color = BLACK;
+        pNode->parent->parent->color = RED;
+        RBT_CORE_FN (rot_right) (pNode->parent->parent);
+
+        pNode = pNode->parent;
+      }
+    }
+    // v3, v4: X on the RIGHT of A
+    else
+    {
+      // B is RED
+      if (pNode->parent->parent->left->color == RED)
+      {
+        pNode->parent->color = BLACK;                  // C
+        pNode->parent->parent->color = RED;            // A
+        pNode->parent->parent->left->color = BLACK;    // B
+
+        pNode = pNode->parent->parent;    // A is next we deal with
+      }
+      // B is BLACK = impossible to be immidiately after insertion
+      // exception: B is NIL
+      else
+      {
+        // v3: X on the LEFT of C
+        if (pNode == pNode->parent->left)
+        {
+          RBT_CORE_FN (rot_right) (pNode->parent);
+          pNode = pNode->right;    // to make following code universal
+        }
+
+        pNode->parent->color = BLACK;
+        pNode->parent->parent->color = RED;
+        RBT_CORE_FN (rot_left) (pNode->parent->parent);
+
+        pNode = pNode->parent;
+      }
+    }
+  }
+}
+
+static void RBT_CORE_FN (attach_node) (RBT_CORE_NODE** pRoot, RBT_CORE_FOUND info,
+                                       RBT_CORE_NODE* pNode)
+{
+  // 'info' is the result of unsuccessful search for the node key
+
+  if (*pRoot == NULL)    // insertion to root
+  {
+    pNode->color = BLACK;
+    *pRoot = pNode;
+  }
+  else
+  {
+    // insertion
+    pNode->parent = info.pParent;
+    if (info.subtree == LEFT)
+    {
+      info.pParent->left = pNode;
+    }
+    else
+    {
+      info.pParent->right = pNode;
+    }
+
+    RBT_CORE_PATH_RESIZE (info.pParent, 1);
+
+    // balansing
+    RBT_CORE_FN (insert_balance) (pNode);
+    RBT_CORE_FN (actualize_root) (pRoot);
+  }
+}
+
+static RBT_CORE_NODE* RBT_CORE_FN (min_node) (RBT_CORE_NODE* pNode)
+{
+  while (pNode->left != RBT_CORE_NIL)
+  {
+    pNode = pNode->left;
+  }
+
+  return pNode;
+}
+
+static RBT_CORE_NODE* RBT_CORE_FN (max_node) (RBT_CORE_NODE* pNode)
+{
+  while (pNode->right != RBT_CORE_NIL)
+  {
+    pNode = pNode->right;
+  }
+
+  return pNode;
+}
+
+static RBT_CORE_NODE* RBT_CORE_FN (next_node) (RBT_CORE_NODE* pNode)
+{
+  RBT_CORE_NODE* pNext = NULL;
+
+  do
+  {
+    if (pNode == NULL || pNode == RBT_CORE_NIL)
+    {
+      break;
+    }
+
+    // successor is the leftmost node of the right subtree
+    if (pNode->right != RBT_CORE_NIL)
+    {
+      pNext = RBT_CORE_FN (min_node) (pNode->right);
+      break;
+    }
+
+    // otherwise it is the first ancestor we come to from the left
+    pNext = pNode->parent;
+    while (pNext != NULL && pNode == pNext->right)
+    {
+      pNode = pNext;
+      pNext = pNext->parent;
+    }
+
+  } while (0);
+
+  return pNext;
+}
+
+static RBT_CORE_NODE* RBT_CORE_FN (prev_node) (RBT_CORE_NODE* pNode)
+{
+  RBT_CORE_NODE* pPrev = NULL;
+
+  do
+  {
+    if (pNode == NULL || pNode == RBT_CORE_NIL)
+    {
+      break;
+    }
+
+    // predecessor is the rightmost node of the left subtree
+    if (pNode->left != RBT_CORE_NIL)
+    {
+      pPrev = RBT_CORE_FN (max_node) (pNode->left);
+      break;
+    }
+
+    // otherwise it is the first ancestor we come to from the right
+    pPrev = pNode->parent;
+    while (pPrev != NULL && pNode == pPrev->left)
+    {
+      pNode = pPrev;
+      pPrev = pPrev->parent;
+    }
+
+  } while (0);
+
+  return pPrev;
+}
+
+static void RBT_CORE_FN (replace_node) (RBT_CORE_NODE** pRoot, RBT_CORE_NODE* pNode,
+                                        RBT_CORE_NODE* pNew)
+{
+  // pNew (may be NIL) takes pNode place under pNode parent
+
+  RBT_CORE_NODE* pParent = pNode->parent;
+
+  if (pParent == NULL)
+  {
+    *pRoot = (pNew == RBT_CORE_NIL) ? NULL : pNew;
+  }
+  else if (pParent->left == pNode)
+  {
+    pParent->left = pNew;
+  }
+  else
+  {
+    pParent->right = pNew;
+  }
+
+  if (pNew != RBT_CORE_NIL)
+  {
+    pNew->parent = pParent;
+  }
+}
+
+static void RBT_CORE_FN (delete_balance) (RBT_CORE_NODE* pNode, RBT_CORE_NODE* pParent)
+{
+  /* pNode (may be NIL) took the place of removed black node : its path is one black short
+   *
+   * shared NIL is never written, so pNode parent is passed separately
+   *
+   *  v1 (X on the LEFT of P)      P
+   *                             /   \
+   *                            X     S (sibling)
+   *                                 /  \
+   *                               SL    SR
+   *
+   *  v2 (X on the RIGHT of P) is mirrored
+   */
+
+  while (pParent != NULL && pNode->color == BLACK)
+  {
+    // v1: X on the LEFT of P
+    if (pNode == pParent->left)
+    {
+      RBT_CORE_NODE* pSibling = pParent->right;
+
+      // S is RED : make it BLACK by rotation, then one of the cases below
+      if (pSibling->color == RED)
+      {
+        pSibling->color = BLACK;
+        pParent->color = RED;
+        RBT_CORE_FN (rot_left) (pParent);
+        pSibling = pParent->right;
+      }
+
+      // SL and SR are BLACK : S subtree loses one black too, P is next we deal with
+      if (pSibling->left->color == BLACK && pSibling->right->color == BLACK)
+      {
+        pSibling->color = RED;
+        pNode = pParent;
+        pParent = pNode->parent;
+      }
+      else
+      {
+        // SL is RED : move it to SR place
+        if (pSibling->right->color == BLACK)
+        {
+          pSibling->left->color = BLACK;
+          pSibling->color = RED;
+          RBT_CORE_FN (rot_right) (pSibling);
+          pSibling = pParent->right;
+        }
+
+        // SR is RED : rotation adds the missing black to X path
+        pSibling->color = pParent->color;
+        pParent->color = BLACK;
+        pSibling->right->color = BLACK;
+        RBT_CORE_FN (rot_left) (pParent);
+        break;
+      }
+    }
+    // v2: X on the RIGHT of P
+    else
+    {
+      RBT_CORE_NODE* pSibling = pParent->left;
+
+      // S is RED : make it BLACK by rotation, then one of the cases below
+      if (pSibling->color == RED)
+      {
+        pSibling->color = BLACK;
+        pParent->color = RED;
+        RBT_CORE_FN (rot_right) (pParent);
+        pSibling = pParent->left;
+      }
+
+      // SL and SR are BLACK : S subtree loses one black too, P is next we deal with
+      if (pSibling->left->color == BLACK && pSibling->right->color == BLACK)
+      {
+        pSibling->color = RED;
+        pNode = pParent;
+        pParent = pNode->parent;
+      }
+      else
+      {
+        // SR is RED : move it to SL place
+        if (pSibling->left->color == BLACK)
+        {
+          pSibling->right->color = BLACK;
+          pSibling->color = RED;
+          RBT_CORE_FN (rot_left) (pSibling);
+          pSibling = pParent->left;
+        }
+
+        // SL is RED : rotation adds the missing black to X path
+        pSibling->color = pParent->color;
+        pParent->color = BLACK;
+        pSibling->left->color = BLACK;
+        RBT_CORE_FN (rot_right) (pParent);
+        break;
+      }
+    }
+  }
+
+  if (pNode != RBT_CORE_NIL)
+  {
+    pNode->color = BLACK;
+  }
+}
+
+static void RBT_CORE_FN (detach_node) (RBT_CORE_NODE** pRoot, RBT_CORE_NODE* pNode)
+{
+  /* node with two children is replaced by its successor : nodes are relinked,
+   * not their keys and data swapped, so pointers to other nodes stay valid
+   */
+
+  RBT_CORE_NODE* pChild = NULL;     // takes the place of removed node
+  RBT_CORE_NODE* pParent = NULL;    // parent of pChild after removal
+  COLOR removedColor;
+
+  if (pNode->left != RBT_CORE_NIL && pNode->right != RBT_CORE_NIL)
+  {
+    RBT_CORE_NODE* pNext = RBT_CORE_FN (min_node) (pNode->right);
+
+    removedColor = pNext->color;
+    pChild = pNext->right;
+
+    if (pNext->parent == pNode)
+    {
+      pParent = pNext;
+    }
+    else
+    {
+      pParent = pNext->parent;
+      RBT_CORE_FN (replace_node) (pRoot, pNext, pChild);
+
+      pNext->right = pNode->right;
+      pNext->right->parent = pNext;
+    }
+
+    RBT_CORE_FN (replace_node) (pRoot, pNode, pNext);
+    pNext->left = pNode->left;
+    pNext->left->parent = pNext;
+    pNext->color = pNode->color;
+#ifdef RBT_CORE_SIZE
+    pNext->size = pNode->size;
+#endif
+  }
+  else
+  {
+    removedColor = pNode->color;
+    pChild = (pNode->left != RBT_CORE_NIL) ? pNode->left : pNode->right;
+    pParent = pNode->parent;
+
+    RBT_CORE_FN (replace_node) (pRoot, pNode, pChild);
+  }
+
+  RBT_CORE_PATH_RESIZE (pParent, -1);
+
+  if (removedColor == BLACK && *pRoot != NULL)
+  {
+    RBT_CORE_FN (delete_balance) (pChild, pParent);
+    RBT_CORE_FN (actualize_root) (pRoot);
+  }
+}
+
+#undef RBT_CORE_NODE
+#undef RBT_CORE_NIL
+#undef RBT_CORE_KEY
+#undef RBT_CORE_COMPARE
+#undef RBT_CORE_RELEASE
+#undef RBT_CORE_FOUND
+#undef RBT_CORE_FN
+#undef RBT_CORE_SIZE
+#undef RBT_CORE_RESIZE
+#undef RBT_CORE_ROT_RESIZE
+#undef RBT_CORE_PATH_RESIZE
@@ -0,0 +1,153 @@
+#include "../../include/c/rb_tree_intrusive.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+// searched key : the comparator goes with it into the core
+typedef struct LinkKeyS
+{
+  RBTLinkCompare compare;
+  const void* key;
+} LinkKey;
+
+static RBTLink LINK_NIL = { BLACK, NULL, NULL, NULL };
+
+static void rbt_link_release_node (RBTLink* pLink);
+
+// the tree doesn't own objects : release only unlinks them
+#define RBT_CORE_NODE RBTLink
+#define RBT_CORE_NIL (&LINK_NIL)
+#define RBT_CORE_KEY const LinkKey*
+#define RBT_CORE_COMPARE(pNode, pKey) ((pKey)->compare ((pNode), (pKey)->key))
+#define RBT_CORE_RELEASE(pNode) rbt_link_release_node (pNode)
+#define RBT_CORE_FOUND LinkFoundInfo
+#define RBT_CORE_FN(name) rbt_link_##name
+#include "rb_tree_core.h"
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool rbt_intrusive_init (RBTIntrusive* pTree, RBTLinkCompare compare)
+{
+  bool result = false;
+
+  if (compare != NULL)
+  {
+    pTree->root = NULL;
+    pTree->compare = compare;
+
+    result = true;
+  }
+
+  return result;
+}
+
+void rbt_intrusive_clear (RBTIntrusive* pTree)
+{
+  rbt_link_free_memory (pTree->root);
+  pTree->root = NULL;
+}
+
+bool rbt_intrusive_insert (RBTIntrusive* pTree, RBTLink* pLink, const void* key)
+{
+  bool result = false;
+
+  do
+  {
+    if (pLink == NULL || rbt_intrusive_is_linked (pLink))
+    {
+      break;
+    }
+
+    LinkKey linkKey = { pTree->compare, key };
+    LinkFoundInfo info = rbt_link_find_node (pTree->root, &linkKey);
+
+    if (info.pNode != NULL && info.pNode != &LINK_NIL)    // node with such key already exists
+    {
+      break;
+    }
+
+    pLink->color = RED;
+    pLink->left = &LINK_NIL;
+    pLink->right = &LINK_NIL;
+    pLink->parent = NULL;
+
+    rbt_link_attach_node (&pTree->root, info, pLink);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+RBTLink* rbt_intrusive_find (const RBTIntrusive* pTree, const void* key)
+{
+  LinkKey linkKey = { pTree->compare, key };
+  LinkFoundInfo info = rbt_link_find_node (pTree->root, &linkKey);
+
+  return (info.pNode == &LINK_NIL) ? NULL : info.pNode;
+}
+
+void rbt_intrusive_remove (RBTIntrusive* pTree, RBTLink* pLink)
+{
+  if (rbt_intrusive_is_linked (pLink))
+  {
+    rbt_link_detach_node (&pTree->root, pLink);
+    rbt_link_release_node (pLink);
+  }
+}
+
+bool rbt_intrusive_is_linked (const RBTLink* pLink)
+{
+  // a linked node always has both children : real nodes or NIL
+  return pLink->left != NULL;
+}
+
+RBTLink* rbt_intrusive_first (const RBTIntrusive* pTree)
+{
+  return (pTree->root == NULL) ? NULL : rbt_link_min_node (pTree->root);
+}
+
+RBTLink* rbt_intrusive_last (const RBTIntrusive* pTree)
+{
+  return (pTree->root == NULL) ? NULL : rbt_link_max_node (pTree->root);
+}
+
+RBTLink* rbt_intrusive_next (RBTLink* pLink)
+{
+  return rbt_link_next_node (pLink);
+}
+
+RBTLink* rbt_intrusive_prev (RBTLink* pLink)
+{
+  return rbt_link_prev_node (pLink);
+}
+
+RBTLink* rbt_intrusive_lower_bound (const RBTIntrusive* pTree, const void* key)
+{
+  LinkKey linkKey = { pTree->compare, key };
+  return rbt_link_bound (pTree->root, &linkKey, false);
+}
+
+RBTLink* rbt_intrusive_upper_bound (const RBTIntrusive* pTree, const void* key)
+{
+  LinkKey linkKey = { pTree->compare, key };
+  return rbt_link_bound (pTree->root, &linkKey, true);
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+void rbt_link_release_node (RBTLink* pLink)
+{
+  pLink->left = NULL;
+  pLink->right = NULL;
+  pLink->parent = NULL;
+}
@@ -0,0 +1,767 @@
+#define _GNU_SOURCE    // mremap ()
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../include/c/key_utils.h"
+#include "../../include/c/rb_tree_mmap.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define RBT_MMAP_MAGIC (0x50414d4d54425200ULL)    // "\0RBTMMAP" little-endian
+#define RBT_MMAP_VERSION (2)    // 2 : payload size is stored in the node
+#define RBT_MMAP_NIL ((RBTOffset)0)
+#define RBT_MMAP_ALIGNMENT (sizeof (uint64_t))
+#define RBT_MMAP_ALIGN_UP(size) (((size) + RBT_MMAP_ALIGNMENT - 1) & ~(RBT_MMAP_ALIGNMENT - 1))
+#define RBT_MMAP_MIN_SIZE ((size_t)1 << 16)
+
+#define RBT_MMAP_HEADER(pTree) ((RBTMmapHeader*)(pTree)->base)
+#define RBT_MMAP_NODE(pTree, offset) ((RBTMmapNode*)((pTree)->base + (offset)))
+
+// node : [ RBTMmapNode | key '\0' | payload ], fixed-size types only
+struct RBTMmapNodeS
+{
+  RBTOffset left;
+  RBTOffset right;
+  RBTOffset parent;    // RBT_MMAP_NIL for the root
+
+  uint64_t keyPrefix;    // first key bytes in big-endian order, compared before the key itself
+  uint32_t keyLength;
+  uint32_t dataOffset;    // from the node start
+
+  uint32_t color;
+  uint32_t dataSize;
+};
+
+typedef struct RBTMmapHeaderS
+{
+  RBTMmapNode nil;    // offset 0 : NIL sentinel, always BLACK
+
+  uint64_t magic;
+  uint32_t version;
+  uint32_t isDirty;    // changed after the last checkpoint
+
+  uint64_t size;    // file size
+  uint64_t used;    // nodes are appended here
+  RBTOffset root;
+  uint64_t count;
+} RBTMmapHeader;
+
+// searched key : length and prefix are computed once per call
+typedef struct KeyInfoS
+{
+  const char* key;
+  size_t length;
+  uint64_t prefix;
+} KeyInfo;
+
+static bool rbt_mmap_key_info (const char* key, KeyInfo* pKey);
+static int rbt_mmap_key_compare (const RBTMmapNode* pNode, const KeyInfo* pKey);
+static bool rbt_mmap_is_header_valid (const RBTMmapHeader* pHeader, size_t fileSize);
+static bool rbt_mmap_mark_dirty (RBTMmap* pTree);
+static RBTOffset rbt_mmap_allocate (RBTMmap* pTree, size_t size);
+static void rbt_mmap_rot_left (RBTMmap* pTree, RBTOffset offset);
+static void rbt_mmap_rot_right (RBTMmap* pTree, RBTOffset offset);
+static void rbt_mmap_insert_balance (RBTMmap* pTree, RBTOffset offset);
+static RBTOffset rbt_mmap_min_node (const RBTMmap* pTree, RBTOffset offset);
+static RBTMmapNode* rbt_mmap_node_or_null (const RBTMmap* pTree, RBTOffset offset);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool rbt_mmap_open (RBTMmap* pTree, const char* path, size_t initialSize)
+{
+  bool result = false;
+  struct stat fileStat;
+
+  pTree->fd = -1;
+  pTree->base = NULL;
+  pTree->mappedSize = 0;
+
+  do
+  {
+    if (path == NULL)
+    {
+      break;
+    }
+
+    pTree->fd = open (path, O_RDWR | O_CREAT, 0644);
+    if (pTree->fd < 0 || fstat (pTree->fd, &fileStat) != 0)
+    {
+      break;
+    }
+
+    bool isNew = (fileStat.st_size == 0);
+    size_t size = (size_t)fileStat.st_size;
+
+    if (isNew)
+    {
+      size = (initialSize < RBT_MMAP_MIN_SIZE) ? RBT_MMAP_MIN_SIZE : initialSize;
+
+      if (ftruncate (pTree->fd, (off_t)size) != 0)
+      {
+        break;
+      }
+    }
+    else if (size < sizeof (RBTMmapHeader))
+    {
+      break;
+    }
+
+    void* pMapped = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, pTree->fd, 0);
+    if (pMapped == MAP_FAILED)
+    {
+      break;
+    }
+
+    pTree->base = (char*)pMapped;
+    pTree->mappedSize = size;
+
+    RBTMmapHeader* pHeader = RBT_MMAP_HEADER (pTree);
+
+    if (isNew)
+    {
+      memset (pHeader, 0, sizeof (RBTMmapHeader));
+      pHeader->nil.color = BLACK;
+      pHeader->magic = RBT_MMAP_MAGIC;
+      pHeader->version = RBT_MMAP_VERSION;
+      pHeader->size = size;
+      pHeader->used = RBT_MMAP_ALIGN_UP (sizeof (RBTMmapHeader));
+      pHeader->root = RBT_MMAP_NIL;
+
+      if (!rbt_mmap_checkpoint (pTree))
+      {
+        break;
+      }
+    }
+    else if (!rbt_mmap_is_header_valid (pHeader, size))
+    {
+      break;
+    }
+
+    result = true;
+
+  } while (0);
+
+  if (!result)
+  {
+    if (pTree->base != NULL)
+    {
+      munmap (pTree->base, pTree->mappedSize);
+    }
+
+    if (pTree->fd >= 0)
+    {
+      close (pTree->fd);
+    }
+
+    pTree->fd = -1;
+    pTree->base = NULL;
+    pTree->mappedSize = 0;
+  }
+
+  return result;
+}
+
+bool rbt_mmap_close (RBTMmap* pTree)
+{
+  bool result = false;
+
+  if (pTree->base != NULL)
+  {
+    result = rbt_mmap_checkpoint (pTree);
+
+    result = (munmap (pTree->base, pTree->mappedSize) == 0) && result;
+    result = (close (pTree->fd) == 0) && result;
+
+    pTree->fd = -1;
+    pTree->base = NULL;
+    pTree->mappedSize = 0;
+  }
+
+  return result;
+}
+
+bool rbt_mmap_checkpoint (RBTMmap* pTree)
+{
+  /* nodes first, then the header is marked clean and written on its own :
+   * a clean header on disk always describes completely written nodes
+   */
+
+  bool result = false;
+
+  do
+  {
+    if (pTree->base == NULL)
+    {
+      break;
+    }
+
+    RBTMmapHeader* pHeader = RBT_MMAP_HEADER (pTree);
+
+    if (msync (pTree->base, pHeader->used, MS_SYNC) != 0 || fsync (pTree->fd) != 0)
+    {
+      break;
+    }
+
+    pHeader->isDirty = 0;
+
+    if (msync (pTree->base, sizeof (RBTMmapHeader), MS_SYNC) != 0)
+    {
+      break;
+    }
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_mmap_insert (RBTMmap* pTree, const void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (pTree->base == NULL || pItem == NULL || itemSize > UINT32_MAX
+        || !rbt_mmap_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    // search for the parent of the new node
+    RBTOffset parent = RBT_MMAP_NIL;
+    RBTOffset offset = RBT_MMAP_HEADER (pTree)->root;
+    int compared = 0;
+
+    while (offset != RBT_MMAP_NIL)
+    {
+      RBTMmapNode* pNode = RBT_MMAP_NODE (pTree, offset);
+
+      compared = rbt_mmap_key_compare (pNode, &keyInfo);
+      if (compared == 0)    // node with such key already exists
+      {
+        break;
+      }
+
+      parent = offset;
+      offset = (compared > 0) ? pNode->left : pNode->right;
+    }
+
+    if (offset != RBT_MMAP_NIL || !rbt_mmap_mark_dirty (pTree))
+    {
+      break;
+    }
+
+    // offsets survive the file growth, pointers are taken after allocation
+    size_t dataOffset = RBT_MMAP_ALIGN_UP (sizeof (RBTMmapNode) + keyInfo.length + 1);
+    RBTOffset newOffset = rbt_mmap_allocate (pTree, dataOffset + itemSize);
+    if (newOffset == RBT_MMAP_NIL)
+    {
+      break;
+    }
+
+    RBTMmapNode* pNew = RBT_MMAP_NODE (pTree, newOffset);
+
+    pNew->left = RBT_MMAP_NIL;
+    pNew->right = RBT_MMAP_NIL;
+    pNew->parent = parent;
+    pNew->keyPrefix = keyInfo.prefix;
+    pNew->keyLength = (uint32_t)keyInfo.length;
+    pNew->dataOffset = (uint32_t)dataOffset;
+    pNew->color = RED;
+    pNew->dataSize = (uint32_t)itemSize;
+    memcpy ((char*)(pNew + 1), keyInfo.key, keyInfo.length + 1);
+    memcpy ((char*)pNew + dataOffset, pItem, itemSize);
+
+    RBTMmapHeader* pHeader = RBT_MMAP_HEADER (pTree);
+
+    if (parent == RBT_MMAP_NIL)    // insertion to root
+    {
+      pHeader->root = newOffset;
+    }
+    else if (compared > 0)
+    {
+      RBT_MMAP_NODE (pTree, parent)->left = newOffset;
+    }
+    else
+    {
+      RBT_MMAP_NODE (pTree, parent)->right = newOffset;
+    }
+
+    rbt_mmap_insert_balance (pTree, newOffset);
+    RBT_MMAP_NODE (pTree, pHeader->root)->color = BLACK;
+    ++pHeader->count;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_mmap_get (const RBTMmap* pTree, void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (pTree->base == NULL || pItem == NULL || !rbt_mmap_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    RBTOffset offset = RBT_MMAP_HEADER (pTree)->root;
+
+    while (offset != RBT_MMAP_NIL)
+    {
+      RBTMmapNode* pNode = RBT_MMAP_NODE (pTree, offset);
+      int compared = rbt_mmap_key_compare (pNode, &keyInfo);
+
+      if (compared == 0)
+      {
+        // doesn't fit the caller buffer : nothing is copied
+        if (pNode->dataSize <= itemSize)
+        {
+          memcpy (pItem, rbt_mmap_data (pNode), pNode->dataSize);
+          result = true;
+        }
+        break;
+      }
+
+      offset = (compared > 0) ? pNode->left : pNode->right;
+    }
+
+  } while (0);
+
+  return result;
+}
+
+size_t rbt_mmap_count (const RBTMmap* pTree)
+{
+  return (pTree->base == NULL) ? 0 : RBT_MMAP_HEADER (pTree)->count;
+}
+
+RBTMmapNode* rbt_mmap_first (const RBTMmap* pTree)
+{
+  RBTMmapNode* pFirst = NULL;
+
+  if (pTree->base != NULL && RBT_MMAP_HEADER (pTree)->root != RBT_MMAP_NIL)
+  {
+    pFirst = RBT_MMAP_NODE (pTree, rbt_mmap_min_node (pTree, RBT_MMAP_HEADER (pTree)->root));
+  }
+
+  return pFirst;
+}
+
+RBTMmapNode* rbt_mmap_next (const RBTMmap* pTree, const RBTMmapNode* pNode)
+{
+  RBTOffset next = RBT_MMAP_NIL;
+
+  do
+  {
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    // successor is the leftmost node of the right subtree
+    if (pNode->right != RBT_MMAP_NIL)
+    {
+      next = rbt_mmap_min_node (pTree, pNode->right);
+      break;
+    }
+
+    // otherwise it is the first ancestor we come to from the left
+    RBTOffset offset = (RBTOffset)((const char*)pNode - pTree->base);
+
+    next = pNode->parent;
+    while (next != RBT_MMAP_NIL && RBT_MMAP_NODE (pTree, next)->right == offset)
+    {
+      offset = next;
+      next = RBT_MMAP_NODE (pTree, next)->parent;
+    }
+
+  } while (0);
+
+  return rbt_mmap_node_or_null (pTree, next);
+}
+
+RBTMmapNode* rbt_mmap_lower_bound (const RBTMmap* pTree, const char* key)
+{
+  // every time we go left current node is the best candidate so far
+
+  RBTOffset bound = RBT_MMAP_NIL;
+  KeyInfo keyInfo;
+
+  if (pTree->base != NULL && rbt_mmap_key_info (key, &keyInfo))
+  {
+    RBTOffset offset = RBT_MMAP_HEADER (pTree)->root;
+
+    while (offset != RBT_MMAP_NIL)
+    {
+      RBTMmapNode* pNode = RBT_MMAP_NODE (pTree, offset);
+
+      if (rbt_mmap_key_compare (pNode, &keyInfo) >= 0)    // go left
+      {
+        bound = offset;
+        offset = pNode->left;
+      }
+      else    // go right
+      {
+        offset = pNode->right;
+      }
+    }
+  }
+
+  return rbt_mmap_node_or_null (pTree, bound);
+}
+
+const char* rbt_mmap_key (const RBTMmapNode* pNode)
+{
+  return (const char*)(pNode + 1);
+}
+
+void* rbt_mmap_data (const RBTMmapNode* pNode)
+{
+  return (char*)pNode + pNode->dataOffset;
+}
+
+size_t rbt_mmap_data_size (const RBTMmapNode* pNode)
+{
+  return pNode->dataSize;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+bool rbt_mmap_key_info (const char* key, KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    if (key == NULL)
+    {
+      break;
+    }
+
+    size_t keyLen = key_length (key, RBT_KEY_SIZE);
+
+    if (keyLen > RBT_KEY_SIZE - 1)    // for '\0'
+    {
+      break;
+    }
+
+    pKey->key = key;
+    pKey->length = keyLen;
+    pKey->prefix = key_prefix (key, keyLen);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+int rbt_mmap_key_compare (const RBTMmapNode* pNode, const KeyInfo* pKey)
+{
+  // strcmp (node key, pKey->key) equivalent, see rbt_key_compare ()
+
+  int result = 0;
+
+  if (pNode->keyPrefix != pKey->prefix)
+  {
+    result = (pNode->keyPrefix < pKey->prefix) ? -1 : 1;
+  }
+  else if (pNode->keyLength > KEY_PREFIX_SIZE || pKey->length > KEY_PREFIX_SIZE)
+  {
+    size_t length = (pNode->keyLength < pKey->length) ? pNode->keyLength : pKey->length;
+
+    result = key_compare (rbt_mmap_key (pNode) + KEY_PREFIX_SIZE, pKey->key + KEY_PREFIX_SIZE,
+                          length + 1 - KEY_PREFIX_SIZE);
+  }
+
+  return result;
+}
+
+bool rbt_mmap_is_header_valid (const RBTMmapHeader* pHeader, size_t fileSize)
+{
+  bool result = false;
+
+  do
+  {
+    if (pHeader->magic != RBT_MMAP_MAGIC || pHeader->version != RBT_MMAP_VERSION)
+    {
+      break;
+    }
+
+    // not closed or checkpointed after the last change : nodes may be half-written
+    if (pHeader->isDirty != 0)
+    {
+      break;
+    }
+
+    if (pHeader->size != fileSize || pHeader->used > fileSize || pHeader->root >= pHeader->used)
+    {
+      break;
+    }
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_mmap_mark_dirty (RBTMmap* pTree)
+{
+  // the mark must reach the disk before any node changed after it
+
+  bool result = true;
+  RBTMmapHeader* pHeader = RBT_MMAP_HEADER (pTree);
+
+  if (pHeader->isDirty == 0)
+  {
+    pHeader->isDirty = 1;
+    result = (msync (pTree->base, sizeof (RBTMmapHeader), MS_SYNC) == 0);
+  }
+
+  return result;
+}
+
+RBTOffset rbt_mmap_allocate (RBTMmap* pTree, size_t size)
+{
+  // append to the end of used space, the file is doubled when it is full
+
+  RBTOffset offset = RBT_MMAP_NIL;
+  RBTMmapHeader* pHeader = RBT_MMAP_HEADER (pTree);
+  size = RBT_MMAP_ALIGN_UP (size);
+
+  do
+  {
+    if (pHeader->used + size > pHeader->size)
+    {
+      size_t newSize = pHeader->size * 2;
+
+      while (newSize < pHeader->used + size)
+      {
+        newSize *= 2;
+      }
+
+      if (ftruncate (pTree->fd, (off_t)newSize) != 0)
+      {
+        break;
+      }
+
+      void* pMapped = mremap (pTree->base, pTree->mappedSize, newSize, MREMAP_MAYMOVE);
+      if (pMapped == MAP_FAILED)
+      {
+        break;
+      }
+
+      pTree->base = (char*)pMapped;
+      pTree->mappedSize = newSize;
+
+      pHeader = RBT_MMAP_HEADER (pTree);
+      pHeader->size = newSize;
+    }
+
+    offset = pHeader->used;
+    pHeader->used += size;
+
+  } while (0);
+
+  return offset;
+}
+
+void rbt_mmap_rot_left (RBTMmap* pTree, RBTOffset offset)
+{
+  // the same as rbt_rot_left (), the root is kept in the header
+
+  RBTMmapNode* pNode = RBT_MMAP_NODE (pTree, offset);
+  RBTOffset temp = pNode->right;
+  RBTMmapNode* pTemp = RBT_MMAP_NODE (pTree, temp);
+  RBTOffset parent = pNode->parent;
+
+  // Node and B
+  pNode->parent = temp;
+  pNode->right = pTemp->left;
+  if (pNode->right != RBT_MMAP_NIL)
+  {
+    RBT_MMAP_NODE (pTree, pNode->right)->parent = offset;
+  }
+
+  // Temp
+  pTemp->parent = parent;
+  pTemp->left = offset;
+
+  // Parent
+  if (parent == RBT_MMAP_NIL)
+  {
+    RBT_MMAP_HEADER (pTree)->root = temp;
+  }
+  else if (RBT_MMAP_NODE (pTree, parent)->left == offset)
+  {
+    RBT_MMAP_NODE (pTree, parent)->left = temp;
+  }
+  else
+  {
+    RBT_MMAP_NODE (pTree, parent)->right = temp;
+  }
+}
+
+void rbt_mmap_rot_right (RBTMmap* pTree, RBTOffset offset)
+{
+  // the same as rbt_rot_right (), the root is kept in the header
+
+  RBTMmapNode* pNode = RBT_MMAP_NODE (pTree, offset);
+  RBTOffset temp = pNode->left;
+  RBTMmapNode* pTemp = RBT_MMAP_NODE (pTree, temp);
+  RBTOffset parent = pNode->parent;
+
+  // Node and B
+  pNode->parent = temp;
+  pNode->left = pTemp->right;
+  if (pNode->left != RBT_MMAP_NIL)
+  {
+    RBT_MMAP_NODE (pTree, pNode->left)->parent = offset;
+  }
+
+  // Temp
+  pTemp->parent = parent;
+  pTemp->right = offset;
+
+  // Parent
+  if (parent == RBT_MMAP_NIL)
+  {
+    RBT_MMAP_HEADER (pTree)->root = temp;
+  }
+  else if (RBT_MMAP_NODE (pTree, parent)->left == offset)
+  {
+    RBT_MMAP_NODE (pTree, parent)->left = temp;
+  }
+  else
+  {
+    RBT_MMAP_NODE (pTree, parent)->right = temp;
+  }
+}
+
+void rbt_mmap_insert_balance (RBTMmap* pTree, RBTOffset offset)
+{
+  // the same cases as rbt_insert_balance (), see the schemes there
+
+  while (true)
+  {
+    RBTMmapNode* pNode = RBT_MMAP_NODE (pTree, offset);
+    RBTOffset parent = pNode->parent;
+
+    if (pNode->color == BLACK || parent == RBT_MMAP_NIL
+        || RBT_MMAP_NODE (pTree, parent)->color == BLACK)
+    {
+      break;
+    }
+
+    // red parent is never the root, so grandparent exists
+    RBTMmapNode* pParent = RBT_MMAP_NODE (pTree, parent);
+    RBTOffset grand = pParent->parent;
+    RBTMmapNode* pGrand = RBT_MMAP_NODE (pTree, grand);
+
+    // v1, v2: X on the LEFT of A
+    if (pGrand->left == parent)
+    {
+      RBTMmapNode* pUncle = RBT_MMAP_NODE (pTree, pGrand->right);
+
+      // C is RED
+      if (pUncle->color == RED)
+      {
+        pParent->color = BLACK;
+        pGrand->color = RED;
+        pUncle->color = BLACK;
+
+        offset = grand;    // A is next we deal with
+      }
+      else
+      {
+        // v1: X on the RIGHT of B
+        if (pParent->right == offset)
+        {
+          rbt_mmap_rot_left (pTree, parent);
+
+          // to make following code universal : X and B have swapped places
+          offset = parent;
+          parent = pParent->parent;
+          pParent = pNode;
+        }
+
+        pParent->color = BLACK;
+        pGrand->color = RED;
+        rbt_mmap_rot_right (pTree, grand);
+
+        offset = parent;
+      }
+    }
+    // v3, v4: X on the RIGHT of A
+    else
+    {
+      RBTMmapNode* pUncle = RBT_MMAP_NODE (pTree, pGrand->left);
+
+      // B is RED
+      if (pUncle->color == RED)
+      {
+        pParent->color = BLACK;
+        pGrand->color = RED;
+        pUncle->color = BLACK;
+
+        offset = grand;    // A is next we deal with
+      }
+      else
+      {
+        // v3: X on the LEFT of C
+        if (pParent->left == offset)
+        {
+          rbt_mmap_rot_right (pTree, parent);
+
+          // to make following code universal : X and B have swapped places
+          offset = parent;
+          parent = pParent->parent;
+          pParent = pNode;
+        }
+
+        pParent->color = BLACK;
+        pGrand->color = RED;
+        rbt_mmap_rot_left (pTree, grand);
+
+        offset = parent;
+      }
+    }
+  }
+}
+
+RBTOffset rbt_mmap_min_node (const RBTMmap* pTree, RBTOffset offset)
+{
+  while (RBT_MMAP_NODE (pTree, offset)->left != RBT_MMAP_NIL)
+  {
+    offset = RBT_MMAP_NODE (pTree, offset)->left;
+  }
+
+  return offset;
+}
+
+RBTMmapNode* rbt_mmap_node_or_null (const RBTMmap* pTree, RBTOffset offset)
+{
+  return (offset == RBT_MMAP_NIL) ? NULL : RBT_MMAP_NODE (pTree, offset);
+}
@@ -0,0 +1,455 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../include/c/key_utils.h"
+#include "../../include/c/rb_tree_stream.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define RBT_STREAM_CRC_X86
+#include <immintrin.h>
+#endif
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define RBT_STREAM_MAGIC (0x504d554454425200ULL)    // "\0RBTDUMP" little-endian
+#define RBT_STREAM_VERSION (1)
+#define RBT_STREAM_CRC_POLY (0x82F63B78U)    // CRC-32C reflected
+#define RBT_STREAM_MIN_KEYS_SIZE ((size_t)1 << 12)
+
+typedef struct RBTStreamHeaderS
+{
+  uint64_t magic;
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t count;
+  uint64_t itemSize;
+} RBTStreamHeader;
+
+// chunked buffer of one dump or load, 'position' is the write or read point
+typedef struct RBTStreamS
+{
+  char* pBuffer;
+  size_t bufferSize;
+  size_t position;
+  size_t available;    // load only : bytes read into the buffer
+
+  RBTStreamWrite writeChunk;
+  RBTStreamRead readChunk;
+  void* pContext;
+
+  uint32_t crc;
+} RBTStream;
+
+static bool rbt_stream_put (RBTStream* pStream, const void* pData, size_t size);
+static bool rbt_stream_flush (RBTStream* pStream);
+static bool rbt_stream_get (RBTStream* pStream, void* pData, size_t size);
+static bool rbt_stream_write_fd (const void* pChunk, size_t size, void* pContext);
+static size_t rbt_stream_read_fd (void* pChunk, size_t size, void* pContext);
+
+static uint32_t rbt_crc32c_scalar (uint32_t crc, const void* pData, size_t size);
+#ifdef RBT_STREAM_CRC_X86
+static uint32_t rbt_crc32c_sse42 (uint32_t crc, const void* pData, size_t size);
+#endif
+
+// scalar until the startup selection
+static uint32_t (*rbt_crc32c) (uint32_t crc, const void* pData, size_t size) = rbt_crc32c_scalar;
+
+static void rbt_crc32c_init (void) __attribute__ ((constructor));
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool rbt_dump (RBTNode* pRoot, size_t itemSize, void* pBuffer, size_t bufferSize,
+               RBTStreamWrite writeChunk, void* pContext)
+{
+  bool result = false;
+  RBTStream stream = { (char*)pBuffer, bufferSize, 0, 0, writeChunk, NULL, pContext, ~0U };
+
+  do
+  {
+    if (pBuffer == NULL || bufferSize == 0 || writeChunk == NULL || itemSize > UINT32_MAX)
+    {
+      break;
+    }
+
+    RBTStreamHeader header = { RBT_STREAM_MAGIC, RBT_STREAM_VERSION, 0,
+                               (pRoot != NULL) ? pRoot->size : 0, itemSize };
+
+    if (!rbt_stream_put (&stream, &header, sizeof (header)))
+    {
+      break;
+    }
+
+    bool isFailed = false;
+    uint32_t payloadLength = (uint32_t)itemSize;
+
+    for (RBTNode* pNode = rbt_first (pRoot); pNode != NULL && !isFailed; pNode = rbt_next (pNode))
+    {
+      uint32_t keyLength = (uint32_t)pNode->keyLength;
+
+      isFailed = pNode->dataSize != itemSize    // bulk build takes one payload size
+                 || !rbt_stream_put (&stream, &keyLength, sizeof (keyLength))
+                 || !rbt_stream_put (&stream, pNode->key, keyLength)
+                 || !rbt_stream_put (&stream, &payloadLength, sizeof (payloadLength))
+                 || !rbt_stream_put (&stream, pNode->data, itemSize);
+    }
+
+    uint32_t crc = ~stream.crc;
+
+    if (isFailed || !rbt_stream_put (&stream, &crc, sizeof (crc)) || !rbt_stream_flush (&stream))
+    {
+      break;
+    }
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_load (RBTNode** pRoot, size_t itemSize, void* pBuffer, size_t bufferSize,
+               RBTStreamRead readChunk, void* pContext)
+{
+  /* records are collected into sorted arrays of keys and items first,
+   * then the tree is built in linear time from them
+   * key texts are kept by offsets while their storage grows, pointers are set at the end
+   */
+
+  bool result = false;
+  RBTStream stream = { (char*)pBuffer, bufferSize, 0, 0, NULL, readChunk, pContext, ~0U };
+
+  size_t* pKeyOffsets = NULL;
+  char* pKeys = NULL;
+  char* pItems = NULL;
+
+  do
+  {
+    if (*pRoot != NULL || pBuffer == NULL || bufferSize == 0 || readChunk == NULL)
+    {
+      break;
+    }
+
+    RBTStreamHeader header;
+
+    if (!rbt_stream_get (&stream, &header, sizeof (header)))
+    {
+      break;
+    }
+
+    if (header.magic != RBT_STREAM_MAGIC || header.version != RBT_STREAM_VERSION
+        || header.itemSize != itemSize)
+    {
+      break;
+    }
+
+    size_t count = header.count;
+
+    if (count > SIZE_MAX / sizeof (size_t) || (itemSize != 0 && count > SIZE_MAX / itemSize))
+    {
+      break;
+    }
+
+    size_t keysCapacity = RBT_STREAM_MIN_KEYS_SIZE;
+    size_t keysSize = 0;
+
+    pKeyOffsets = (size_t*)malloc ((count > 0) ? count * sizeof (size_t) : 1);
+    pKeys = (char*)malloc (keysCapacity);
+    pItems = (char*)malloc ((count * itemSize > 0) ? count * itemSize : 1);
+
+    if (pKeyOffsets == NULL || pKeys == NULL || pItems == NULL)
+    {
+      break;
+    }
+
+    bool isFailed = false;
+
+    for (size_t i = 0; i < count && !isFailed; ++i)
+    {
+      uint32_t keyLength = 0;
+      uint32_t payloadLength = 0;
+
+      if (!rbt_stream_get (&stream, &keyLength, sizeof (keyLength))
+          || keyLength > RBT_KEY_SIZE - 1)
+      {
+        isFailed = true;
+        break;
+      }
+
+      if (keysSize + keyLength + 1 > keysCapacity)
+      {
+        char* pGrown = (char*)realloc (pKeys, keysCapacity * 2);
+        if (pGrown == NULL)
+        {
+          isFailed = true;
+          break;
+        }
+
+        pKeys = pGrown;
+        keysCapacity *= 2;
+      }
+
+      char* key = pKeys + keysSize;
+
+      isFailed = !rbt_stream_get (&stream, key, keyLength)
+                 || key_length (key, keyLength) != keyLength    // '\0' inside
+                 || !rbt_stream_get (&stream, &payloadLength, sizeof (payloadLength))
+                 || payloadLength != itemSize
+                 || !rbt_stream_get (&stream, pItems + i * itemSize, itemSize);
+
+      key[keyLength] = '\0';
+      pKeyOffsets[i] = keysSize;
+      keysSize += keyLength + 1;
+    }
+
+    uint32_t expectedCrc = ~stream.crc;
+    uint32_t crc = 0;
+
+    if (isFailed || !rbt_stream_get (&stream, &crc, sizeof (crc)) || crc != expectedCrc)
+    {
+      break;
+    }
+
+    if (count == 0)
+    {
+      result = true;
+      break;
+    }
+
+    // offsets become pointers in place, sizes are the same
+    const char** keys = (const char**)pKeyOffsets;
+    for (size_t i = 0; i < count; ++i)
+    {
+      keys[i] = pKeys + pKeyOffsets[i];
+    }
+
+    // unsorted or duplicated keys are rejected here
+    result = rbt_build_from_sorted (pRoot, keys, pItems, itemSize, count, true);
+
+  } while (0);
+
+  free (pKeyOffsets);
+  free (pKeys);
+  free (pItems);
+
+  return result;
+}
+
+bool rbt_dump_fd (RBTNode* pRoot, size_t itemSize, int fd)
+{
+  bool result = false;
+  void* pBuffer = malloc (RBT_STREAM_CHUNK_SIZE);
+
+  if (pBuffer != NULL)
+  {
+    result = rbt_dump (pRoot, itemSize, pBuffer, RBT_STREAM_CHUNK_SIZE, rbt_stream_write_fd, &fd);
+  }
+
+  free (pBuffer);
+
+  return result;
+}
+
+bool rbt_load_fd (RBTNode** pRoot, size_t itemSize, int fd)
+{
+  bool result = false;
+  void* pBuffer = malloc (RBT_STREAM_CHUNK_SIZE);
+
+  if (pBuffer != NULL)
+  {
+    result = rbt_load (pRoot, itemSize, pBuffer, RBT_STREAM_CHUNK_SIZE, rbt_stream_read_fd, &fd);
+  }
+
+  free (pBuffer);
+
+  return result;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+bool rbt_stream_put (RBTStream* pStream, const void* pData, size_t size)
+{
+  bool result = true;
+  const char* pFrom = (const char*)pData;
+
+  pStream->crc = rbt_crc32c (pStream->crc, pData, size);
+
+  while (size > 0)
+  {
+    if (pStream->position == pStream->bufferSize && !rbt_stream_flush (pStream))
+    {
+      result = false;
+      break;
+    }
+
+    size_t part = pStream->bufferSize - pStream->position;
+    part = (part < size) ? part : size;
+
+    memcpy (pStream->pBuffer + pStream->position, pFrom, part);
+    pStream->position += part;
+    pFrom += part;
+    size -= part;
+  }
+
+  return result;
+}
+
+bool rbt_stream_flush (RBTStream* pStream)
+{
+  bool result = true;
+
+  if (pStream->position > 0)
+  {
+    result = pStream->writeChunk (pStream->pBuffer, pStream->position, pStream->pContext);
+    pStream->position = 0;
+  }
+
+  return result;
+}
+
+bool rbt_stream_get (RBTStream* pStream, void* pData, size_t size)
+{
+  bool result = true;
+  char* pTo = (char*)pData;
+  size_t total = size;
+
+  while (size > 0)
+  {
+    if (pStream->position == pStream->available)
+    {
+      pStream->available = pStream->readChunk (pStream->pBuffer, pStream->bufferSize,
+                                               pStream->pContext);
+      pStream->position = 0;
+
+      if (pStream->available == 0 || pStream->available > pStream->bufferSize)
+      {
+        pStream->available = 0;
+        result = false;
+        break;
+      }
+    }
+
+    size_t part = pStream->available - pStream->position;
+    part = (part < size) ? part : size;
+
+    memcpy (pTo, pStream->pBuffer + pStream->position, part);
+    pStream->position += part;
+    pTo += part;
+    size -= part;
+  }
+
+  if (result)
+  {
+    pStream->crc = rbt_crc32c (pStream->crc, pData, total);
+  }
+
+  return result;
+}
+
+bool rbt_stream_write_fd (const void* pChunk, size_t size, void* pContext)
+{
+  bool result = true;
+  int fd = *(int*)pContext;
+  const char* pFrom = (const char*)pChunk;
+
+  while (size > 0)
+  {
+    ssize_t written = write (fd, pFrom, size);
+
+    if (written < 0 && errno == EINTR)
+    {
+      continue;
+    }
+
+    if (written <= 0)
+    {
+      result = false;
+      break;
+    }
+
+    pFrom += written;
+    size -= (size_t)written;
+  }
+
+  return result;
+}
+
+size_t rbt_stream_read_fd (void* pChunk, size_t size, void* pContext)
+{
+  int fd = *(int*)pContext;
+  ssize_t received = 0;
+
+  do
+  {
+    received = read (fd, pChunk, size);
+  } while (received < 0 && errno == EINTR);
+
+  return (received > 0) ? (size_t)received : 0;
+}
+
+uint32_t rbt_crc32c_scalar (uint32_t crc, const void* pData, size_t size)
+{
+  const unsigned char* pByte = (const unsigned char*)pData;
+
+  while (size-- > 0)
+  {
+    crc ^= *pByte++;
+
+    for (int bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc >> 1) ^ (RBT_STREAM_CRC_POLY & (0U - (crc & 1)));
+    }
+  }
+
+  return crc;
+}
+
+#ifdef RBT_STREAM_CRC_X86
+__attribute__ ((target ("sse4.2"))) uint32_t rbt_crc32c_sse42 (uint32_t crc, const void* pData,
+                                                               size_t size)
+{
+  const char* pByte = (const char*)pData;
+
+#ifdef __x86_64__
+  uint64_t crc64 = crc;
+
+  for (; size >= sizeof (uint64_t); size -= sizeof (uint64_t), pByte += sizeof (uint64_t))
+  {
+    uint64_t word;
+    memcpy (&word, pByte, sizeof (word));
+    crc64 = _mm_crc32_u64 (crc64, word);
+  }
+
+  crc = (uint32_t)crc64;
+#endif
+
+  for (; size > 0; --size, ++pByte)
+  {
+    crc = _mm_crc32_u8 (crc, (unsigned char)*pByte);
+  }
+
+  return crc;
+}
+#endif
+
+void rbt_crc32c_init (void)
+{
+#ifdef RBT_STREAM_CRC_X86
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("sse4.2"))
+  {
+    rbt_crc32c = rbt_crc32c_sse42;
+  }
+#endif
+}
@@ -0,0 +1,468 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/c/key_utils.h"
+#include "../../include/c/rb_tree_typed.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+// searched binary key
+typedef struct BinKeyS
+{
+  const void* key;
+  size_t keySize;
+} BinKey;
+
+static RBTU64Node U64_NIL = { 0, NULL, 0, NULL, BLACK, NULL, NULL, NULL };
+static RBTBinNode BIN_NIL = { NULL, 0, NULL, BLACK, 0, NULL, NULL, NULL };
+
+static void rbt_u64_release_node (RBTU64Node* pNode);
+static void rbt_bin_release_node (RBTBinNode* pNode);
+
+// one comparison per level : no length, no prefix, no terminator
+#define RBT_CORE_NODE RBTU64Node
+#define RBT_CORE_NIL (&U64_NIL)
+#define RBT_CORE_KEY uint64_t
+#define RBT_CORE_COMPARE(pNode, key) (((pNode)->key > (key)) - ((pNode)->key < (key)))
+#define RBT_CORE_RELEASE(pNode) rbt_u64_release_node (pNode)
+#define RBT_CORE_FOUND U64FoundInfo
+#define RBT_CORE_FN(name) rbt_u64_##name
+#include "rb_tree_core.h"
+
+#define RBT_CORE_NODE RBTBinNode
+#define RBT_CORE_NIL (&BIN_NIL)
+#define RBT_CORE_KEY const BinKey*
+#define RBT_CORE_COMPARE(pNode, pKey) key_compare ((pNode)->key, (pKey)->key, (pKey)->keySize)
+#define RBT_CORE_RELEASE(pNode) rbt_bin_release_node (pNode)
+#define RBT_CORE_FOUND BinFoundInfo
+#define RBT_CORE_FN(name) rbt_bin_##name
+#include "rb_tree_core.h"
+
+static bool is_bin_key_valid (RBTBinNode* pRoot, const void* key, size_t keySize);
+static bool rbt_u64_insert_node (RBTU64Node** pRoot, Heap* pHeap, void* pItem, size_t itemSize,
+                                 uint64_t key);
+static bool rbt_bin_insert_node (RBTBinNode** pRoot, Heap* pHeap, void* pItem, size_t itemSize,
+                                 const void* key, size_t keySize);
+
+
+/************************************************************************
+ *                           PUBLIC : U64   	                            *
+ ************************************************************************/
+
+bool is_u64_NIL_same (RBTU64Node* pNIL)
+{
+  return pNIL == &U64_NIL;
+}
+
+bool rbt_u64_destroy (RBTU64Node** pRoot)
+{
+  bool result = false;
+
+  if (*pRoot != NULL)
+  {
+    rbt_u64_free_memory (*pRoot);
+    *pRoot = NULL;
+
+    result = true;
+  }
+
+  return result;
+}
+
+bool rbt_u64_insert (RBTU64Node** pRoot, void* pItem, size_t itemSize, uint64_t key)
+{
+  return rbt_u64_insert_node (pRoot, NULL, pItem, itemSize, key);
+}
+
+bool rbt_u64_get (RBTU64Node* pRoot, void* pItem, size_t itemSize, uint64_t key)
+{
+  bool result = false;
+
+  do
+  {
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    U64FoundInfo info = rbt_u64_find_node (pRoot, key);
+
+    if (info.pNode == NULL || info.pNode == &U64_NIL)    // tree is empty or node was not found
+    {
+      break;
+    }
+
+    if (info.pNode->dataSize > itemSize)    // doesn't fit the buffer
+    {
+      break;
+    }
+
+    memcpy (pItem, info.pNode->data, info.pNode->dataSize);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_u64_delete (RBTU64Node** pRoot, uint64_t key)
+{
+  bool result = false;
+
+  U64FoundInfo info = rbt_u64_find_node (*pRoot, key);
+
+  if (info.pNode != NULL && info.pNode != &U64_NIL)
+  {
+    rbt_u64_detach_node (pRoot, info.pNode);
+    rbt_u64_release_node (info.pNode);
+
+    result = true;
+  }
+
+  return result;
+}
+
+bool rbt_u64_tree_init (RBTU64Tree* pTree, const Allocator* pAllocator)
+{
+  bool result = false;
+
+  if (pTree != NULL && heap_init (&pTree->heap, pAllocator))
+  {
+    pTree->root = NULL;
+
+    result = true;
+  }
+
+  return result;
+}
+
+bool rbt_u64_tree_insert (RBTU64Tree* pTree, void* pItem, size_t itemSize, uint64_t key)
+{
+  return rbt_u64_insert_node (&pTree->root, &pTree->heap, pItem, itemSize, key);
+}
+
+RBTU64Node* rbt_u64_first (RBTU64Node* pRoot)
+{
+  return (pRoot == NULL) ? NULL : rbt_u64_min_node (pRoot);
+}
+
+RBTU64Node* rbt_u64_last (RBTU64Node* pRoot)
+{
+  return (pRoot == NULL) ? NULL : rbt_u64_max_node (pRoot);
+}
+
+RBTU64Node* rbt_u64_next (RBTU64Node* pNode)
+{
+  return rbt_u64_next_node (pNode);
+}
+
+RBTU64Node* rbt_u64_prev (RBTU64Node* pNode)
+{
+  return rbt_u64_prev_node (pNode);
+}
+
+RBTU64Node* rbt_u64_lower_bound (RBTU64Node* pRoot, uint64_t key)
+{
+  return rbt_u64_bound (pRoot, key, false);
+}
+
+RBTU64Node* rbt_u64_upper_bound (RBTU64Node* pRoot, uint64_t key)
+{
+  return rbt_u64_bound (pRoot, key, true);
+}
+
+
+/************************************************************************
+ *                           PUBLIC : BIN   	                            *
+ ************************************************************************/
+
+bool is_bin_NIL_same (RBTBinNode* pNIL)
+{
+  return pNIL == &BIN_NIL;
+}
+
+bool rbt_bin_destroy (RBTBinNode** pRoot)
+{
+  bool result = false;
+
+  if (*pRoot != NULL)
+  {
+    rbt_bin_free_memory (*pRoot);
+    *pRoot = NULL;
+
+    result = true;
+  }
+
+  return result;
+}
+
+bool rbt_bin_insert (RBTBinNode** pRoot, void* pItem, size_t itemSize, const void* key,
+                     size_t keySize)
+{
+  return rbt_bin_insert_node (pRoot, NULL, pItem, itemSize, key, keySize);
+}
+
+bool rbt_bin_get (RBTBinNode* pRoot, void* pItem, size_t itemSize, const void* key,
+                  size_t keySize)
+{
+  bool result = false;
+
+  do
+  {
+    if (pItem == NULL || !is_bin_key_valid (pRoot, key, keySize))
+    {
+      break;
+    }
+
+    BinKey binKey = { key, keySize };
+    BinFoundInfo info = rbt_bin_find_node (pRoot, &binKey);
+
+    if (info.pNode == NULL || info.pNode == &BIN_NIL)    // tree is empty or node was not found
+    {
+      break;
+    }
+
+    if (info.pNode->dataSize > itemSize)    // doesn't fit the buffer
+    {
+      break;
+    }
+
+    memcpy (pItem, info.pNode->data, info.pNode->dataSize);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_bin_delete (RBTBinNode** pRoot, const void* key, size_t keySize)
+{
+  bool result = false;
+
+  do
+  {
+    if (!is_bin_key_valid (*pRoot, key, keySize))
+    {
+      break;
+    }
+
+    BinKey binKey = { key, keySize };
+    BinFoundInfo info = rbt_bin_find_node (*pRoot, &binKey);
+
+    if (info.pNode == NULL || info.pNode == &BIN_NIL)    // tree is empty or node was not found
+    {
+      break;
+    }
+
+    rbt_bin_detach_node (pRoot, info.pNode);
+    rbt_bin_release_node (info.pNode);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_bin_tree_init (RBTBinTree* pTree, const Allocator* pAllocator)
+{
+  bool result = false;
+
+  if (pTree != NULL && heap_init (&pTree->heap, pAllocator))
+  {
+    pTree->root = NULL;
+
+    result = true;
+  }
+
+  return result;
+}
+
+bool rbt_bin_tree_insert (RBTBinTree* pTree, void* pItem, size_t itemSize, const void* key,
+                          size_t keySize)
+{
+  return rbt_bin_insert_node (&pTree->root, &pTree->heap, pItem, itemSize, key, keySize);
+}
+
+RBTBinNode* rbt_bin_first (RBTBinNode* pRoot)
+{
+  return (pRoot == NULL) ? NULL : rbt_bin_min_node (pRoot);
+}
+
+RBTBinNode* rbt_bin_last (RBTBinNode* pRoot)
+{
+  return (pRoot == NULL) ? NULL : rbt_bin_max_node (pRoot);
+}
+
+RBTBinNode* rbt_bin_next (RBTBinNode* pNode)
+{
+  return rbt_bin_next_node (pNode);
+}
+
+RBTBinNode* rbt_bin_prev (RBTBinNode* pNode)
+{
+  return rbt_bin_prev_node (pNode);
+}
+
+RBTBinNode* rbt_bin_lower_bound (RBTBinNode* pRoot, const void* key, size_t keySize)
+{
+  BinKey binKey = { key, keySize };
+
+  return is_bin_key_valid (pRoot, key, keySize) ? rbt_bin_bound (pRoot, &binKey, false) : NULL;
+}
+
+RBTBinNode* rbt_bin_upper_bound (RBTBinNode* pRoot, const void* key, size_t keySize)
+{
+  BinKey binKey = { key, keySize };
+
+  return is_bin_key_valid (pRoot, key, keySize) ? rbt_bin_bound (pRoot, &binKey, true) : NULL;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+void rbt_u64_release_node (RBTU64Node* pNode)
+{
+  heap_free (pNode->pHeap, pNode->data, pNode->dataSize);
+  heap_free (pNode->pHeap, pNode, sizeof (RBTU64Node));
+}
+
+void rbt_bin_release_node (RBTBinNode* pNode)
+{
+  heap_free (pNode->pHeap, pNode->data, pNode->dataSize);
+  heap_free (pNode->pHeap, pNode, sizeof (RBTBinNode) + pNode->keySize);
+}
+
+bool is_bin_key_valid (RBTBinNode* pRoot, const void* key, size_t keySize)
+{
+  bool result = false;
+
+  do
+  {
+    if (key == NULL || keySize == 0 || keySize > UINT_MAX)
+    {
+      break;
+    }
+
+    // all keys of a tree have the same size
+    if (pRoot != NULL && pRoot->keySize != keySize)
+    {
+      break;
+    }
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_u64_insert_node (RBTU64Node** pRoot, Heap* pHeap, void* pItem, size_t itemSize,
+                          uint64_t key)
+{
+  bool result = false;
+
+  do
+  {
+    if (pItem == NULL)
+    {
+      break;
+    }
+
+    U64FoundInfo info = rbt_u64_find_node (*pRoot, key);
+
+    if (info.pNode != NULL && info.pNode != &U64_NIL)    // node with such key already exists
+    {
+      break;
+    }
+
+    RBTU64Node* pNode = (RBTU64Node*)heap_alloc (pHeap, sizeof (RBTU64Node));
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    pNode->data = heap_alloc (pHeap, itemSize);
+    if (pNode->data == NULL)
+    {
+      heap_free (pHeap, pNode, sizeof (RBTU64Node));
+      break;
+    }
+
+    memcpy (pNode->data, pItem, itemSize);
+    pNode->dataSize = itemSize;
+    pNode->pHeap = pHeap;
+    pNode->key = key;
+    pNode->color = RED;
+    pNode->left = &U64_NIL;
+    pNode->right = &U64_NIL;
+    pNode->parent = NULL;
+
+    rbt_u64_attach_node (pRoot, info, pNode);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+bool rbt_bin_insert_node (RBTBinNode** pRoot, Heap* pHeap, void* pItem, size_t itemSize,
+                          const void* key, size_t keySize)
+{
+  bool result = false;
+
+  do
+  {
+    if (pItem == NULL || !is_bin_key_valid (*pRoot, key, keySize))
+    {
+      break;
+    }
+
+    BinKey binKey = { key, keySize };
+    BinFoundInfo info = rbt_bin_find_node (*pRoot, &binKey);
+
+    if (info.pNode != NULL && info.pNode != &BIN_NIL)    // node with such key already exists
+    {
+      break;
+    }
+
+    // key is stored right after the node
+    RBTBinNode* pNode = (RBTBinNode*)heap_alloc (pHeap, sizeof (RBTBinNode) + keySize);
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    pNode->data = heap_alloc (pHeap, itemSize);
+    if (pNode->data == NULL)
+    {
+      heap_free (pHeap, pNode, sizeof (RBTBinNode) + keySize);
+      break;
+    }
+
+    memcpy (pNode->data, pItem, itemSize);
+    pNode->dataSize = itemSize;
+    pNode->pHeap = pHeap;
+    memcpy (pNode->key, key, keySize);
+    pNode->keySize = (unsigned int)keySize;
+    pNode->color = RED;
+    pNode->left = &BIN_NIL;
+    pNode->right = &BIN_NIL;
+    pNode->parent = NULL;
+
+    rbt_bin_attach_node (pRoot, info, pNode);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
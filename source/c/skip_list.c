@@ -0,0 +1,666 @@
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/c/key_utils.h"
+#include "../../include/c/skip_list.h"
+
+
+/************************************************************************
+ *                              UTILS     	                            *
+ ************************************************************************/
+
+#define SL_ALIGNMENT (_Alignof (max_align_t))
+#define SL_ALIGN_UP(size) (((size) + SL_ALIGNMENT - 1) & ~(SL_ALIGNMENT - 1))
+
+#define SL_LOAD(pValue) __atomic_load_n (pValue, __ATOMIC_ACQUIRE)
+#define SL_STORE(pValue, value) __atomic_store_n (pValue, value, __ATOMIC_RELEASE)
+
+// node : [ SkipListNode | next links | payload | key '\0' ]
+struct SkipListNodeS
+{
+  MUTEX_TYPE mutex;    // taken by writers changing the links of this node or deleting it
+
+  uint64_t keyPrefix;    // first key bytes in big-endian order, compared before the key itself
+  size_t keyLength;
+  const char* key;
+
+  void* data;
+  size_t dataSize;
+
+  int topLevel;
+  bool isMarked;         // logically deleted, atomic
+  bool isFullyLinked;    // linked at all its levels, atomic
+
+  SkipListNode* next[];    // topLevel + 1 links, atomic
+};
+
+// payload offset in the node block, the block size is known from the node fields
+#define SL_NODE_DATA_OFFSET(topLevel) \
+  SL_ALIGN_UP (sizeof (SkipListNode) + (size_t)((topLevel) + 1) * sizeof (SkipListNode*))
+
+// searched key : length and prefix are computed once per call
+typedef struct KeyInfoS
+{
+  const char* key;
+  size_t length;
+  uint64_t prefix;
+} KeyInfo;
+
+static bool sl_key_info (const char* key, KeyInfo* pKey);
+static int sl_key_compare (const SkipListNode* pNode, const KeyInfo* pKey);
+static SkipListNode* sl_create_node (Heap* pHeap, int topLevel, const KeyInfo* pKey,
+                                     const void* pItem, size_t itemSize);
+static void sl_release_node (Heap* pHeap, SkipListNode* pNode);
+static void sl_reclaim_node (void* pNode, void* pContext);
+static int sl_random_level (void);
+static int sl_find (SkipList* pList, const KeyInfo* pKey, int fromLevel, SkipListNode** pPreds,
+                    SkipListNode** pSuccs);
+static SkipListNode* sl_find_node (SkipList* pList, const KeyInfo* pKey, bool isLowerBound);
+static void sl_unlock_preds (SkipListNode** pPreds, int highestLocked);
+
+
+/************************************************************************
+ *                             PUBLIC    	                            *
+ ************************************************************************/
+
+bool sl_init (SkipList* pList)
+{
+  return sl_init_allocator (pList, NULL);
+}
+
+bool sl_init_allocator (SkipList* pList, const Allocator* pAllocator)
+{
+  bool result = false;
+
+  do
+  {
+    if (!heap_init (&pList->heap, pAllocator))
+    {
+      break;
+    }
+
+    pList->level = 0;
+    pList->count = 0;
+
+    // head has all the levels and is never compared
+    KeyInfo emptyKey = { "", 0, 0 };
+
+    pList->head = sl_create_node (&pList->heap, SL_MAX_LEVEL - 1, &emptyKey, "", 0);
+    if (pList->head == NULL)
+    {
+      break;
+    }
+
+    if (!smr_init (&pList->smr, SMR_EPOCH, sl_reclaim_node, &pList->heap))
+    {
+      sl_release_node (&pList->heap, pList->head);
+      pList->head = NULL;
+      break;
+    }
+
+    pList->head->isFullyLinked = true;
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+void sl_destroy (SkipList* pList)
+{
+  // no concurrent access is allowed here
+
+  SkipListNode* pNode = pList->head;
+
+  while (pNode != NULL)
+  {
+    SkipListNode* pNext = pNode->next[0];
+    sl_release_node (&pList->heap, pNode);
+    pNode = pNext;
+  }
+
+  smr_destroy (&pList->smr);
+
+  pList->head = NULL;
+  pList->count = 0;
+}
+
+bool sl_insert (SkipList* pList, void* pItem, size_t itemSize, const char* key)
+{
+  /* lazy insertion:
+   *   > predecessors at every level of the new node are locked and validated:
+   *     still in the list and still pointing to the found successors, otherwise retry
+   *   > links are set bottom-up, so a node reachable at some level is linked below it
+   *   > the node becomes visible for readers by 'isFullyLinked'
+   */
+
+  bool result = false;
+  KeyInfo keyInfo;
+  SkipListNode* pNode = NULL;
+
+  do
+  {
+    if (!sl_key_info (key, &keyInfo) || pItem == NULL)
+    {
+      break;
+    }
+
+    int topLevel = sl_random_level ();
+
+    pNode = sl_create_node (&pList->heap, topLevel, &keyInfo, pItem, itemSize);
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    // the level is raised before linking, so searches from the list level reach every node
+    int level = SL_LOAD (&pList->level);
+    while (level < topLevel
+           && !__atomic_compare_exchange_n (&pList->level, &level, topLevel, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+    }
+
+    SkipListNode* pPreds[SL_MAX_LEVEL];
+    SkipListNode* pSuccs[SL_MAX_LEVEL];
+    bool isInserted = false;
+    bool isDuplicated = false;
+    SmrRecord* pRecord = smr_enter (&pList->smr);
+
+    while (!isInserted && !isDuplicated)
+    {
+      int fromLevel = SL_LOAD (&pList->level);
+      int foundLevel = sl_find (pList, &keyInfo, fromLevel, pPreds, pSuccs);
+
+      if (foundLevel != -1)
+      {
+        SkipListNode* pFound = pSuccs[foundLevel];
+
+        if (!SL_LOAD (&pFound->isMarked))
+        {
+          // being inserted by another thread : it's complete once linked
+          while (!SL_LOAD (&pFound->isFullyLinked))
+          {
+            sched_yield ();
+          }
+
+          isDuplicated = true;
+        }
+        else
+        {
+          sched_yield ();    // being deleted : retry after its unlinking
+        }
+
+        continue;
+      }
+
+      int highestLocked = -1;
+      bool isValid = true;
+      SkipListNode* pPrevPred = NULL;
+
+      for (int i = 0; isValid && i <= topLevel; ++i)
+      {
+        SkipListNode* pPred = pPreds[i];
+        SkipListNode* pSucc = pSuccs[i];
+
+        if (pPred != pPrevPred)
+        {
+          LOCK_MUTEX (pPred->mutex);
+          highestLocked = i;
+          pPrevPred = pPred;
+        }
+
+        isValid = !SL_LOAD (&pPred->isMarked) && (pSucc == NULL || !SL_LOAD (&pSucc->isMarked))
+                  && SL_LOAD (&pPred->next[i]) == pSucc;
+      }
+
+      if (isValid)
+      {
+        for (int i = 0; i <= topLevel; ++i)
+        {
+          pNode->next[i] = pSuccs[i];
+        }
+
+        for (int i = 0; i <= topLevel; ++i)
+        {
+          SL_STORE (&pPreds[i]->next[i], pNode);
+        }
+
+        SL_STORE (&pNode->isFullyLinked, true);
+        isInserted = true;
+      }
+
+      sl_unlock_preds (pPreds, highestLocked);
+    }
+
+    smr_exit (&pList->smr, pRecord);
+
+    if (isDuplicated)
+    {
+      break;
+    }
+
+    __atomic_add_fetch (&pList->count, 1, __ATOMIC_RELAXED);
+    pNode = NULL;
+
+    result = true;
+
+  } while (0);
+
+  if (pNode != NULL)
+  {
+    sl_release_node (&pList->heap, pNode);
+  }
+
+  return result;
+}
+
+bool sl_get (SkipList* pList, void* pItem, size_t itemSize, const char* key)
+{
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (!sl_key_info (key, &keyInfo) || pItem == NULL)
+    {
+      break;
+    }
+
+    SmrRecord* pRecord = smr_enter (&pList->smr);
+    SkipListNode* pNode = sl_find_node (pList, &keyInfo, false);
+
+    if (pNode != NULL && pNode->dataSize <= itemSize)
+    {
+      // payload is immutable after insertion
+      memcpy (pItem, pNode->data, pNode->dataSize);
+
+      result = true;
+    }
+
+    smr_exit (&pList->smr, pRecord);
+
+  } while (0);
+
+  return result;
+}
+
+bool sl_delete (SkipList* pList, const char* key)
+{
+  /* lazy deletion:
+   *   > the victim is marked under its own lock, that's the linearization point
+   *   > its predecessors are locked and validated, then it's unlinked top-down
+   *   > the victim is retired : released once no reader may still be walking through it
+   */
+
+  bool result = false;
+  KeyInfo keyInfo;
+
+  do
+  {
+    if (!sl_key_info (key, &keyInfo))
+    {
+      break;
+    }
+
+    SkipListNode* pPreds[SL_MAX_LEVEL];
+    SkipListNode* pSuccs[SL_MAX_LEVEL];
+    SkipListNode* pVictim = NULL;
+    bool isUnlinked = false;
+    SmrRecord* pRecord = smr_enter (&pList->smr);
+
+    while (!isUnlinked)
+    {
+      int foundLevel = sl_find (pList, &keyInfo, SL_LOAD (&pList->level), pPreds, pSuccs);
+
+      if (pVictim == NULL)
+      {
+        // only a completely inserted node found at its top level is deletable
+        SkipListNode* pFound = (foundLevel != -1) ? pSuccs[foundLevel] : NULL;
+
+        if (pFound == NULL || !SL_LOAD (&pFound->isFullyLinked) || pFound->topLevel != foundLevel
+            || SL_LOAD (&pFound->isMarked))
+        {
+          break;
+        }
+
+        LOCK_MUTEX (pFound->mutex);
+
+        if (SL_LOAD (&pFound->isMarked))    // deleted by another thread
+        {
+          UNLOCK_MUTEX (pFound->mutex);
+          break;
+        }
+
+        SL_STORE (&pFound->isMarked, true);
+        pVictim = pFound;
+      }
+
+      int highestLocked = -1;
+      bool isValid = true;
+      SkipListNode* pPrevPred = NULL;
+
+      for (int i = 0; isValid && i <= pVictim->topLevel; ++i)
+      {
+        SkipListNode* pPred = pPreds[i];
+
+        if (pPred != pPrevPred)
+        {
+          LOCK_MUTEX (pPred->mutex);
+          highestLocked = i;
+          pPrevPred = pPred;
+        }
+
+        isValid = !SL_LOAD (&pPred->isMarked) && SL_LOAD (&pPred->next[i]) == pVictim;
+      }
+
+      if (isValid)
+      {
+        for (int i = pVictim->topLevel; i >= 0; --i)
+        {
+          SL_STORE (&pPreds[i]->next[i], pVictim->next[i]);
+        }
+
+        isUnlinked = true;
+      }
+
+      sl_unlock_preds (pPreds, highestLocked);
+    }
+
+    if (pVictim != NULL)
+    {
+      UNLOCK_MUTEX (pVictim->mutex);
+      smr_retire (&pList->smr, pRecord, pVictim);
+
+      __atomic_sub_fetch (&pList->count, 1, __ATOMIC_RELAXED);
+
+      result = true;
+    }
+
+    smr_exit (&pList->smr, pRecord);
+
+  } while (0);
+
+  return result;
+}
+
+size_t sl_count (SkipList* pList)
+{
+  return __atomic_load_n (&pList->count, __ATOMIC_RELAXED);
+}
+
+bool sl_scan_range (SkipList* pList, const char* keyFrom, const char* keyTo,
+                    SkipListScanCallback callback, void* pContext)
+{
+  bool result = false;
+  KeyInfo fromInfo = { NULL, 0, 0 };
+  KeyInfo toInfo = { NULL, 0, 0 };    // set only for bounded range
+
+  do
+  {
+    if (callback == NULL)
+    {
+      break;
+    }
+
+    if ((keyFrom != NULL && !sl_key_info (keyFrom, &fromInfo))
+        || (keyTo != NULL && !sl_key_info (keyTo, &toInfo)))
+    {
+      break;
+    }
+
+    SmrRecord* pRecord = smr_enter (&pList->smr);
+    SkipListNode* pNode = (keyFrom != NULL) ? sl_find_node (pList, &fromInfo, true)
+                                            : SL_LOAD (&pList->head->next[0]);
+
+    for (; pNode != NULL; pNode = SL_LOAD (&pNode->next[0]))
+    {
+      if (keyTo != NULL && sl_key_compare (pNode, &toInfo) >= 0)
+      {
+        break;
+      }
+
+      if (SL_LOAD (&pNode->isMarked) || !SL_LOAD (&pNode->isFullyLinked))
+      {
+        continue;
+      }
+
+      if (!callback (pNode->key, pNode->data, pNode->dataSize, pContext))
+      {
+        break;
+      }
+    }
+
+    smr_exit (&pList->smr, pRecord);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+
+/************************************************************************
+ *                             STATIC    	                            *
+ ************************************************************************/
+
+bool sl_key_info (const char* key, KeyInfo* pKey)
+{
+  bool result = false;
+
+  do
+  {
+    if (key == NULL)
+    {
+      break;
+    }
+
+    size_t keyLen = key_length (key, SL_KEY_SIZE);
+
+    if (keyLen > SL_KEY_SIZE - 1)    // for '\0'
+    {
+      break;
+    }
+
+    pKey->key = key;
+    pKey->length = keyLen;
+    pKey->prefix = key_prefix (key, keyLen);
+
+    result = true;
+
+  } while (0);
+
+  return result;
+}
+
+int sl_key_compare (const SkipListNode* pNode, const KeyInfo* pKey)
+{
+  // strcmp (pNode->key, pKey->key) equivalent, see rbt_key_compare ()
+
+  int result = 0;
+
+  if (pNode->keyPrefix != pKey->prefix)
+  {
+    result = (pNode->keyPrefix < pKey->prefix) ? -1 : 1;
+  }
+  else if (pNode->keyLength > KEY_PREFIX_SIZE || pKey->length > KEY_PREFIX_SIZE)
+  {
+    size_t length = (pNode->keyLength < pKey->length) ? pNode->keyLength : pKey->length;
+
+    result = key_compare (pNode->key + KEY_PREFIX_SIZE, pKey->key + KEY_PREFIX_SIZE,
+                          length + 1 - KEY_PREFIX_SIZE);
+  }
+
+  return result;
+}
+
+SkipListNode* sl_create_node (Heap* pHeap, int topLevel, const KeyInfo* pKey, const void* pItem,
+                              size_t itemSize)
+{
+  SkipListNode* pNode = NULL;
+
+  do
+  {
+    size_t dataOffset = SL_NODE_DATA_OFFSET (topLevel);
+    size_t nodeSize = dataOffset + itemSize + pKey->length + 1;
+
+    pNode = (SkipListNode*)heap_alloc (pHeap, nodeSize);
+    if (pNode == NULL)
+    {
+      break;
+    }
+
+    if (INIT_MUTEX (pNode->mutex) != 0)
+    {
+      heap_free (pHeap, pNode, nodeSize);
+      pNode = NULL;
+      break;
+    }
+
+    char* pData = (char*)pNode + dataOffset;
+    char* pKeyCopy = pData + itemSize;
+
+    memcpy (pData, pItem, itemSize);
+    memcpy (pKeyCopy, pKey->key, pKey->length + 1);
+
+    pNode->keyPrefix = pKey->prefix;
+    pNode->keyLength = pKey->length;
+    pNode->key = pKeyCopy;
+    pNode->data = pData;
+    pNode->dataSize = itemSize;
+    pNode->topLevel = topLevel;
+    pNode->isMarked = false;
+    pNode->isFullyLinked = false;
+
+    for (int i = 0; i <= topLevel; ++i)
+    {
+      pNode->next[i] = NULL;
+    }
+
+  } while (0);
+
+  return pNode;
+}
+
+void sl_release_node (Heap* pHeap, SkipListNode* pNode)
+{
+  size_t nodeSize = SL_NODE_DATA_OFFSET (pNode->topLevel) + pNode->dataSize + pNode->keyLength + 1;
+
+  DESTROY_MUTEX (pNode->mutex);
+  heap_free (pHeap, pNode, nodeSize);
+}
+
+void sl_reclaim_node (void* pNode, void* pContext)
+{
+  sl_release_node ((Heap*)pContext, (SkipListNode*)pNode);
+}
+
+int sl_random_level (void)
+{
+  // geometric with p = 1/4 : two random bits per level, xorshift state per thread
+
+  static __thread uint64_t state = 0;
+
+  if (state == 0)
+  {
+    state = (uint64_t)(uintptr_t)&state * 0x9E3779B97F4A7C15ULL | 1;
+  }
+
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+
+  int level = __builtin_ctzll (state | (1ULL << 63)) / 2;
+
+  return (level < SL_MAX_LEVEL - 1) ? level : SL_MAX_LEVEL - 1;
+}
+
+int sl_find (SkipList* pList, const KeyInfo* pKey, int fromLevel, SkipListNode** pPreds,
+             SkipListNode** pSuccs)
+{
+  // predecessors and successors of the key at every level, the highest level it's found on or -1
+
+  int foundLevel = -1;
+  SkipListNode* pPred = pList->head;
+
+  for (int level = SL_MAX_LEVEL - 1; level > fromLevel; --level)
+  {
+    pPreds[level] = pPred;
+    pSuccs[level] = SL_LOAD (&pPred->next[level]);
+  }
+
+  for (int level = fromLevel; level >= 0; --level)
+  {
+    SkipListNode* pCurr = SL_LOAD (&pPred->next[level]);
+    int order = -1;
+
+    while (pCurr != NULL && (order = sl_key_compare (pCurr, pKey)) < 0)
+    {
+      pPred = pCurr;
+      pCurr = SL_LOAD (&pPred->next[level]);
+    }
+
+    if (foundLevel == -1 && pCurr != NULL && order == 0)
+    {
+      foundLevel = level;
+    }
+
+    pPreds[level] = pPred;
+    pSuccs[level] = pCurr;
+  }
+
+  return foundLevel;
+}
+
+SkipListNode* sl_find_node (SkipList* pList, const KeyInfo* pKey, bool isLowerBound)
+{
+  // lock-free search : present node with the key or the first node >= key
+
+  SkipListNode* pPred = pList->head;
+  SkipListNode* pCurr = NULL;
+
+  for (int level = SL_LOAD (&pList->level); level >= 0; --level)
+  {
+    int order = -1;
+    pCurr = SL_LOAD (&pPred->next[level]);
+
+    while (pCurr != NULL && (order = sl_key_compare (pCurr, pKey)) < 0)
+    {
+      pPred = pCurr;
+      pCurr = SL_LOAD (&pPred->next[level]);
+    }
+
+    if (pCurr != NULL && order == 0 && !isLowerBound)
+    {
+      break;
+    }
+  }
+
+  if (!isLowerBound
+      && (pCurr == NULL || sl_key_compare (pCurr, pKey) != 0 || !SL_LOAD (&pCurr->isFullyLinked)
+          || SL_LOAD (&pCurr->isMarked)))
+  {
+    pCurr = NULL;
+  }
+
+  return pCurr;
+}
+
+void sl_unlock_preds (SkipListNode** pPreds, int highestLocked)
+{
+  // the same predecessor of several levels is locked once
+
+  SkipListNode* pPrevPred = NULL;
+
+  for (int i = 0; i <= highestLocked; ++i)
+  {
+    if (pPreds[i] != pPrevPred)
+    {
+      UNLOCK_MUTEX (pPreds[i]->mutex);
+      pPrevPred = pPreds[i];
+    }
+  }
+}
@@ -1,8 +1,41 @@
 #include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "../../include/c/thread_utils.h"
 #include "../../include/c/logging.h"
 
+#define SMR_CACHE_LINE	(64)
+#define SMR_UNMARK(pNode)	((void*)((uintptr_t)(pNode) & ~(uintptr_t)1))
+
+typedef struct SmrRetiredS
+{
+	void* pNode;
+	uint64_t epoch;		// global epoch at retirement
+} SmrRetired;
+
+struct SmrRecordS
+{
+	bool isBusy;					// owned by a critical section, atomic
+	uint64_t activeEpoch;			// epoch seen by smr_enter, 0 outside of critical section, atomic
+	void* hazards[SMR_HAZARDS];		// atomic
+
+	// accessed by the record owner only, kept with the record between critical sections
+	SmrRetired* retired;
+	size_t retiredCount;
+	size_t retiredCapacity;
+} __attribute__((aligned(SMR_CACHE_LINE)));
+
+static unsigned int threadsCount = 0;
+static __thread unsigned int threadSlot = 0;	// 0 : not assigned yet
+
+static unsigned int smr_thread_slot(void);
+static bool smr_try_advance(SmrDomain* pDomain);
+static void smr_reclaim_record(SmrDomain* pDomain, SmrRecord* pRecord, void** pHazards,
+							   size_t hazardsCount, uint64_t epoch);
+static int smr_compare_pointers(const void* p1, const void* p2);
+
 static void trace_last_error(const char* pMessage)
 {
 	int errCode = errno;
@@ -107,4 +140,292 @@ bool condition_wait(CONDITION_TYPE* cond, MUTEX_TYPE* mutex, unsigned int timeou
 	received = waitResult == 0;
 
 	return received;
+}
+
+
+bool smr_init(SmrDomain* pDomain, SMR_MODE mode, SmrReclaim reclaim, void* pContext)
+{
+	if (reclaim == NULL || (mode != SMR_EPOCH && mode != SMR_HAZARD))
+	{
+		return false;
+	}
+
+	size_t size = SMR_MAX_RECORDS * sizeof(SmrRecord);
+
+	pDomain->records = (SmrRecord*)aligned_alloc(SMR_CACHE_LINE, size);
+	if (pDomain->records == NULL)
+	{
+		trace_last_error("Failed to allocate reclamation records");
+		return false;
+	}
+
+	memset(pDomain->records, 0, size);
+
+	pDomain->mode = mode;
+	pDomain->epoch = 1;
+	pDomain->reclaim = reclaim;
+	pDomain->pContext = pContext;
+
+	return true;
+}
+
+void smr_destroy(SmrDomain* pDomain)
+{
+	if (pDomain->records == NULL)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < SMR_MAX_RECORDS; ++i)
+	{
+		SmrRecord* pRecord = &pDomain->records[i];
+
+		for (size_t j = 0; j < pRecord->retiredCount; ++j)
+		{
+			pDomain->reclaim(pRecord->retired[j].pNode, pDomain->pContext);
+		}
+
+		free(pRecord->retired);
+	}
+
+	free(pDomain->records);
+	pDomain->records = NULL;
+}
+
+SmrRecord* smr_enter(SmrDomain* pDomain)
+{
+	// a free record is looked for from the thread own slot, so threads rarely compete for it
+
+	unsigned int slot = smr_thread_slot();
+	SmrRecord* pRecord = NULL;
+
+	while (pRecord == NULL)
+	{
+		for (size_t i = 0; i < SMR_MAX_RECORDS && pRecord == NULL; ++i)
+		{
+			SmrRecord* pCandidate = &pDomain->records[(slot + i) % SMR_MAX_RECORDS];
+			bool isBusy = false;
+
+			if (!__atomic_load_n(&pCandidate->isBusy, __ATOMIC_RELAXED)
+				&& __atomic_compare_exchange_n(&pCandidate->isBusy, &isBusy, true, false,
+											   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			{
+				pRecord = pCandidate;
+			}
+		}
+
+		if (pRecord == NULL)	// more critical sections than records
+		{
+			sched_yield();
+		}
+	}
+
+	if (pDomain->mode == SMR_EPOCH)
+	{
+		// the published epoch must be still current : otherwise reclaimer might not see it
+		uint64_t epoch;
+
+		do
+		{
+			epoch = __atomic_load_n(&pDomain->epoch, __ATOMIC_SEQ_CST);
+			__atomic_store_n(&pRecord->activeEpoch, epoch, __ATOMIC_SEQ_CST);
+		} while (epoch != __atomic_load_n(&pDomain->epoch, __ATOMIC_SEQ_CST));
+	}
+
+	return pRecord;
+}
+
+void smr_exit(SmrDomain* pDomain, SmrRecord* pRecord)
+{
+	if (pDomain->mode == SMR_EPOCH)
+	{
+		__atomic_store_n(&pRecord->activeEpoch, 0, __ATOMIC_RELEASE);
+	}
+	else
+	{
+		for (size_t i = 0; i < SMR_HAZARDS; ++i)
+		{
+			__atomic_store_n(&pRecord->hazards[i], NULL, __ATOMIC_RELEASE);
+		}
+	}
+
+	// out of critical section : the record doesn't hold the epoch back any more
+	if (pRecord->retiredCount >= SMR_SCAN_THRESHOLD)
+	{
+		smr_reclaim(pDomain, pRecord);
+	}
+
+	__atomic_store_n(&pRecord->isBusy, false, __ATOMIC_RELEASE);
+}
+
+void* smr_protect(SmrDomain* pDomain, SmrRecord* pRecord, int slot, void* const* pLink)
+{
+	// hazard pointer is valid only if the link still refers to the node after publishing
+
+	void* pNode = __atomic_load_n(pLink, __ATOMIC_ACQUIRE);
+
+	if (pDomain->mode == SMR_HAZARD)
+	{
+		void* pPublished = NULL;
+
+		do
+		{
+			pPublished = pNode;
+			__atomic_store_n(&pRecord->hazards[slot], SMR_UNMARK(pPublished), __ATOMIC_SEQ_CST);
+			pNode = __atomic_load_n(pLink, __ATOMIC_SEQ_CST);
+		} while (pNode != pPublished);
+	}
+
+	return pNode;
+}
+
+void smr_retire(SmrDomain* pDomain, SmrRecord* pRecord, void* pNode)
+{
+	if (pRecord->retiredCount == pRecord->retiredCapacity)
+	{
+		size_t capacity = (pRecord->retiredCapacity == 0) ? 2 * SMR_SCAN_THRESHOLD
+															: 2 * pRecord->retiredCapacity;
+		SmrRetired* pRetired = (SmrRetired*)realloc(pRecord->retired, capacity * sizeof(SmrRetired));
+
+		if (pRetired == NULL)	// nobody knows when the node is safe to release : it's leaked
+		{
+			trace_last_error("Failed to retire node");
+			return;
+		}
+
+		pRecord->retired = pRetired;
+		pRecord->retiredCapacity = capacity;
+	}
+
+	SmrRetired* pRetired = &pRecord->retired[pRecord->retiredCount++];
+
+	pRetired->pNode = pNode;
+	pRetired->epoch = __atomic_load_n(&pDomain->epoch, __ATOMIC_SEQ_CST);
+}
+
+void smr_reclaim(SmrDomain* pDomain, SmrRecord* pRecord)
+{
+	/* retired nodes were unlinked before : the fence orders it with reading epochs and hazards
+	 *
+	 * the nodes left in idle records by the threads which didn't come back are released too
+	 */
+
+	void* hazards[SMR_MAX_RECORDS * SMR_HAZARDS];
+	size_t hazardsCount = 0;
+	uint64_t epoch = 0;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if (pDomain->mode == SMR_EPOCH)
+	{
+		(void)smr_try_advance(pDomain);
+		epoch = __atomic_load_n(&pDomain->epoch, __ATOMIC_SEQ_CST);
+	}
+	else
+	{
+		for (size_t i = 0; i < SMR_MAX_RECORDS; ++i)
+		{
+			for (size_t j = 0; j < SMR_HAZARDS; ++j)
+			{
+				void* pHazard = __atomic_load_n(&pDomain->records[i].hazards[j], __ATOMIC_SEQ_CST);
+
+				if (pHazard != NULL)
+				{
+					hazards[hazardsCount++] = pHazard;
+				}
+			}
+		}
+
+		qsort(hazards, hazardsCount, sizeof(void*), smr_compare_pointers);
+	}
+
+	smr_reclaim_record(pDomain, pRecord, hazards, hazardsCount, epoch);
+
+	for (size_t i = 0; i < SMR_MAX_RECORDS; ++i)
+	{
+		SmrRecord* pIdle = &pDomain->records[i];
+		bool isBusy = false;
+
+		if (pIdle != pRecord && !__atomic_load_n(&pIdle->isBusy, __ATOMIC_RELAXED)
+			&& __atomic_compare_exchange_n(&pIdle->isBusy, &isBusy, true, false, __ATOMIC_ACQUIRE,
+										   __ATOMIC_RELAXED))
+		{
+			smr_reclaim_record(pDomain, pIdle, hazards, hazardsCount, epoch);
+			__atomic_store_n(&pIdle->isBusy, false, __ATOMIC_RELEASE);
+		}
+	}
+}
+
+
+static unsigned int smr_thread_slot(void)
+{
+	if (threadSlot == 0)
+	{
+		threadSlot = __atomic_add_fetch(&threadsCount, 1, __ATOMIC_RELAXED);
+	}
+
+	return threadSlot;
+}
+
+static bool smr_try_advance(SmrDomain* pDomain)
+{
+	// the epoch moves on only when every critical section has seen the current one
+
+	uint64_t epoch = __atomic_load_n(&pDomain->epoch, __ATOMIC_SEQ_CST);
+
+	for (size_t i = 0; i < SMR_MAX_RECORDS; ++i)
+	{
+		uint64_t activeEpoch = __atomic_load_n(&pDomain->records[i].activeEpoch, __ATOMIC_SEQ_CST);
+
+		if (activeEpoch != 0 && activeEpoch != epoch)
+		{
+			return false;
+		}
+	}
+
+	return __atomic_compare_exchange_n(&pDomain->epoch, &epoch, epoch + 1, false, __ATOMIC_SEQ_CST,
+									   __ATOMIC_RELAXED);
+}
+
+static void smr_reclaim_record(SmrDomain* pDomain, SmrRecord* pRecord, void** pHazards,
+							   size_t hazardsCount, uint64_t epoch)
+{
+	// hazards are sorted, epoch is the current one
+
+	size_t kept = 0;
+
+	for (size_t i = 0; i < pRecord->retiredCount; ++i)
+	{
+		SmrRetired retired = pRecord->retired[i];
+		bool isSafe = false;
+
+		if (pDomain->mode == SMR_EPOCH)
+		{
+			isSafe = retired.epoch + 2 <= epoch;
+		}
+		else
+		{
+			isSafe = bsearch(&retired.pNode, pHazards, hazardsCount, sizeof(void*),
+							 smr_compare_pointers) == NULL;
+		}
+
+		if (isSafe)
+		{
+			pDomain->reclaim(retired.pNode, pDomain->pContext);
+		}
+		else
+		{
+			pRecord->retired[kept++] = retired;
+		}
+	}
+
+	pRecord->retiredCount = kept;
+}
+
+static int smr_compare_pointers(const void* p1, const void* p2)
+{
+	uintptr_t pointer1 = (uintptr_t)(*(void* const*)p1);
+	uintptr_t pointer2 = (uintptr_t)(*(void* const*)p2);
+
+	return (pointer1 > pointer2) - (pointer1 < pointer2);
 }
\ No newline at end of file
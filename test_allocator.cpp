@@ -0,0 +1,537 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/allocator.h"
+#include "include/c/bp_tree.h"
+#include "include/c/cache.h"
+#include "include/c/hash_map.h"
+#include "include/c/lf_list.h"
+#include "include/c/queue.h"
+#include "include/c/rb_tree.h"
+#include "include/c/rb_tree_typed.h"
+#include "include/c/skip_list.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+// libc underneath : every allocation is remembered with its size, free checks it
+struct CountingArena
+{
+  std::map<void*, size_t> live;
+  size_t sizeMismatches = 0;
+  size_t failAfter = SIZE_MAX;    // allocations left before failures
+};
+
+static void* countingAlloc (size_t size, void* pContext)
+{
+  auto* pArena = static_cast<CountingArena*> (pContext);
+
+  if (pArena->failAfter == 0)
+  {
+    return NULL;
+  }
+  --pArena->failAfter;
+
+  void* pMemory = malloc (size);
+  pArena->live[pMemory] = size;
+  return pMemory;
+}
+
+static void countingFree (void* pMemory, size_t size, void* pContext)
+{
+  auto* pArena = static_cast<CountingArena*> (pContext);
+  auto it = pArena->live.find (pMemory);
+
+  if (it == pArena->live.end () || it->second != size)
+  {
+    ++pArena->sizeMismatches;
+  }
+  if (it != pArena->live.end ())
+  {
+    pArena->live.erase (it);
+  }
+
+  free (pMemory);
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class AllocatorTestClass : public ::testing::Test
+{
+public:
+  CountingArena arena;
+  Allocator allocator = { countingAlloc, countingFree, &arena };
+
+  size_t arenaBytes ()
+  {
+    size_t bytes = 0;
+    for (const auto& it : arena.live)
+    {
+      bytes += it.second;
+    }
+    return bytes;
+  }
+
+  void TearDown () override
+  {
+    EXPECT_TRUE (arena.live.empty ());
+    EXPECT_EQ (arena.sizeMismatches, 0u);
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (AllocatorTestClass, HeapTest)
+{
+  Heap heap;
+  Allocator broken = { countingAlloc, NULL, &arena };
+
+  EXPECT_FALSE (heap_init (&heap, &broken));
+  EXPECT_FALSE (heap_init (NULL, &allocator));
+
+  // libc by default
+  ASSERT_TRUE (heap_init (&heap, NULL));
+  EXPECT_EQ (heap.allocator.alloc, allocator_libc ()->alloc);
+
+  void* pMemory = heap_alloc (&heap, 100);
+  ASSERT_NE (pMemory, nullptr);
+  EXPECT_EQ (heap_bytes (&heap), 100u);
+  heap_free (&heap, pMemory, 100);
+  EXPECT_EQ (heap_allocations (&heap), 0u);
+
+  ASSERT_TRUE (heap_init (&heap, &allocator));
+
+  std::vector<void*> blocks;
+  for (size_t size = 1; size <= 64; ++size)
+  {
+    blocks.push_back (heap_alloc (&heap, size));
+  }
+  EXPECT_EQ (heap_bytes (&heap), 64u * 65 / 2);
+  EXPECT_EQ (heap_allocations (&heap), 64u);
+  EXPECT_EQ (heap_bytes (&heap), arenaBytes ());
+
+  for (size_t size = 1; size <= 64; ++size)
+  {
+    heap_free (&heap, blocks[size - 1], size);
+  }
+  EXPECT_EQ (heap_bytes (&heap), 0u);
+
+  // failed allocations aren't counted, NULL heap is libc without counting
+  arena.failAfter = 0;
+  EXPECT_EQ (heap_alloc (&heap, 8), nullptr);
+  EXPECT_EQ (heap_allocations (&heap), 0u);
+
+  pMemory = heap_alloc (NULL, 8);
+  EXPECT_NE (pMemory, nullptr);
+  heap_free (NULL, pMemory, 8);
+  EXPECT_EQ (heap_bytes (NULL), 0u);
+}
+
+TEST_F (AllocatorTestClass, QueueTest)
+{
+  // items and payloads come from the allocator, the heap holds what is queued
+
+  const int ITEMS_COUNT = 100;
+  const size_t ITEM_SIZE = 24;
+
+  QueueSafe queue;
+  ASSERT_TRUE (concurrent_queue_init_allocator (&queue, &allocator));
+
+  char item[ITEM_SIZE] = { 0 };
+  for (auto i = 0; i < ITEMS_COUNT; ++i)
+  {
+    EXPECT_TRUE (concurrent_queue_push (&queue, item, sizeof (item)));
+  }
+
+  const Heap* pHeap = &queue.queue.heap;
+  EXPECT_EQ (heap_allocations (pHeap), 2u * ITEMS_COUNT);
+  EXPECT_EQ (heap_bytes (pHeap), ITEMS_COUNT * (sizeof (QueueItem) + ITEM_SIZE));
+  EXPECT_EQ (heap_bytes (pHeap), arenaBytes ());
+
+  // the trace is the queue memory as well
+  ASSERT_TRUE (concurrent_queue_trace_enable (&queue));
+  EXPECT_EQ (heap_bytes (pHeap), arenaBytes ());
+
+  for (auto i = 0; i < ITEMS_COUNT / 2; ++i)
+  {
+    EXPECT_TRUE (concurrent_queue_pop (&queue, item, sizeof (item), 0));
+  }
+  EXPECT_EQ (heap_allocations (pHeap), (size_t)ITEMS_COUNT + 1);
+
+  // out of memory : the push fails, nothing leaks
+  arena.failAfter = 1;
+  EXPECT_FALSE (concurrent_queue_push (&queue, item, sizeof (item)));
+  arena.failAfter = SIZE_MAX;
+  EXPECT_EQ (heap_bytes (pHeap), arenaBytes ());
+
+  concurrent_queue_destroy (&queue);
+  EXPECT_EQ (heap_bytes (pHeap), 0u);
+}
+
+TEST_F (AllocatorTestClass, RBTreeTest)
+{
+  // nodes and own payloads come from the allocator, rbt_delete/rbt_destroy return them
+
+  const int KEYS_COUNT = 1000;
+
+  RBTree tree;
+  ASSERT_TRUE (rbt_tree_init (&tree, &allocator));
+
+  int small = 0;
+  for (auto i = 0; i < KEYS_COUNT; ++i)
+  {
+    EXPECT_TRUE (rbt_tree_insert (&tree, &small, sizeof (small), std::to_string (i).c_str ()));
+  }
+  EXPECT_FALSE (rbt_tree_insert (&tree, &small, sizeof (small), "0"));
+
+  // inline payloads : a node is one allocation
+  EXPECT_EQ (heap_allocations (&tree.heap), (size_t)KEYS_COUNT);
+  EXPECT_EQ (heap_bytes (&tree.heap), KEYS_COUNT * sizeof (RBTNode));
+
+  // a payload over the inline size gets own allocation, a smaller one reuses it
+  char big[RBT_INLINE_DATA_SIZE * 4] = { 0 };
+  EXPECT_TRUE (rbt_tree_upsert (&tree, big, sizeof (big), "1", NULL, NULL));
+  EXPECT_TRUE (rbt_tree_upsert (&tree, big, sizeof (big) / 2, "1", NULL, NULL));
+  EXPECT_TRUE (rbt_tree_upsert (&tree, big, sizeof (big), "new", NULL, NULL));
+  EXPECT_EQ (heap_allocations (&tree.heap), (size_t)KEYS_COUNT + 3);
+  EXPECT_EQ (heap_bytes (&tree.heap), arenaBytes ());
+
+  // the plain functions work on the root : released nodes go back to their heap
+  EXPECT_TRUE (rbt_delete (&tree.root, "1"));
+  EXPECT_EQ (heap_allocations (&tree.heap), (size_t)KEYS_COUNT + 1);
+
+  int actual = -1;
+  EXPECT_TRUE (rbt_get (tree.root, &actual, sizeof (actual), "2"));
+  EXPECT_EQ (actual, small);
+
+  // libc nodes in the same tree are not counted
+  EXPECT_TRUE (rbt_insert (&tree.root, &small, sizeof (small), "libc"));
+  EXPECT_EQ (heap_bytes (&tree.heap), arenaBytes ());
+
+  EXPECT_TRUE (rbt_destroy (&tree.root));
+  EXPECT_EQ (heap_bytes (&tree.heap), 0u);
+  EXPECT_EQ (heap_allocations (&tree.heap), 0u);
+}
+
+TEST_F (AllocatorTestClass, RBTreeBulkTest)
+{
+  // hinted and bulk nodes come from the heap as well, a contiguous block is one allocation
+  // (single threaded : the counting arena isn't thread safe)
+
+  const int KEYS_COUNT = 1000;
+
+  std::vector<std::string> keys;
+  for (auto i = 0; i < KEYS_COUNT; ++i)
+  {
+    keys.push_back ("key:" + std::to_string (10000 + 2 * i));
+  }
+
+  std::vector<const char*> pKeys;
+  for (const auto& key : keys)
+  {
+    pKeys.push_back (key.c_str ());
+  }
+
+  std::vector<int> items (KEYS_COUNT, 7);
+  char big[RBT_INLINE_DATA_SIZE * 4] = { 0 };
+
+  for (bool isContiguous : { false, true })
+  {
+    RBTree tree;
+    ASSERT_TRUE (rbt_tree_init (&tree, &allocator));
+
+    ASSERT_TRUE (rbt_tree_build_from_sorted (&tree, pKeys.data (), items.data (), sizeof (int),
+                                             KEYS_COUNT, isContiguous));
+    EXPECT_EQ (heap_allocations (&tree.heap), isContiguous ? 1u : (size_t)KEYS_COUNT);
+    EXPECT_EQ (heap_bytes (&tree.heap), arenaBytes ());
+
+    // the odd keys in between : merged and hinted ones
+    std::vector<std::string> oddKeys;
+    for (auto i = 0; i < KEYS_COUNT; ++i)
+    {
+      oddKeys.push_back ("key:" + std::to_string (10000 + 2 * i + 1));
+    }
+
+    std::vector<const char*> pOddKeys;
+    for (auto i = 0; i < KEYS_COUNT / 2; ++i)
+    {
+      pOddKeys.push_back (oddKeys[i].c_str ());
+    }
+
+    size_t allocations = heap_allocations (&tree.heap);
+    ASSERT_TRUE (rbt_tree_merge_sorted (&tree, pOddKeys.data (), items.data (), sizeof (int),
+                                        pOddKeys.size (), 1));
+    EXPECT_EQ (heap_allocations (&tree.heap), allocations + pOddKeys.size ());
+
+    // the next even key is adjacent to the next odd one
+    RBTNode* pHint = rbt_lower_bound (tree.root, pKeys[KEYS_COUNT / 2]);
+    for (auto i = KEYS_COUNT / 2; i < KEYS_COUNT; ++i)
+    {
+      RBTNode* pNode
+          = rbt_tree_insert_hint (&tree, pHint, &items[i], sizeof (int), oddKeys[i].c_str ());
+      ASSERT_NE (pNode, nullptr);
+      pHint = rbt_next (pNode);
+    }
+    EXPECT_EQ (heap_allocations (&tree.heap), allocations + KEYS_COUNT);
+
+    // a pool node payload outgrowing its slot is the heap memory too
+    EXPECT_TRUE (rbt_tree_upsert (&tree, big, sizeof (big), pKeys[0], NULL, NULL));
+    EXPECT_EQ (heap_bytes (&tree.heap), arenaBytes ());
+
+    // the block is returned with its last node
+    for (auto i = 0; i < KEYS_COUNT; ++i)
+    {
+      EXPECT_TRUE (rbt_delete (&tree.root, pKeys[i]));
+    }
+    EXPECT_EQ (heap_allocations (&tree.heap), (size_t)KEYS_COUNT);
+    EXPECT_EQ (heap_bytes (&tree.heap), arenaBytes ());
+
+    EXPECT_TRUE (rbt_destroy (&tree.root));
+    EXPECT_EQ (heap_bytes (&tree.heap), 0u);
+    EXPECT_EQ (heap_allocations (&tree.heap), 0u);
+  }
+}
+
+TEST_F (AllocatorTestClass, HashMapTest)
+{
+  // the table, long keys and payloads come from the allocator, rehashing returns the old table
+
+  const int KEYS_COUNT = 1000;
+
+  HashMap map;
+  ASSERT_TRUE (hm_init_allocator (&map, 0, &allocator));
+  EXPECT_EQ (heap_allocations (&map.heap), 0u);
+
+  int item = 0;
+  for (auto i = 0; i < KEYS_COUNT; ++i)
+  {
+    // odd keys are long : the payload follows the key in the same block
+    std::string key = std::to_string (i);
+    if (i % 2 != 0)
+    {
+      key = std::string (40, 'k') + key;
+    }
+
+    EXPECT_TRUE (hm_insert (&map, &item, sizeof (item), key.c_str ()));
+  }
+
+  // a block per item, control bytes and slots of the table
+  EXPECT_EQ (heap_allocations (&map.heap), (size_t)KEYS_COUNT + 2);
+  EXPECT_EQ (heap_bytes (&map.heap), arenaBytes ());
+
+  for (auto i = 0; i < KEYS_COUNT; i += 2)
+  {
+    EXPECT_TRUE (hm_delete (&map, std::to_string (i).c_str ()));
+  }
+  EXPECT_EQ (heap_allocations (&map.heap), (size_t)KEYS_COUNT / 2 + 2);
+  EXPECT_EQ (heap_bytes (&map.heap), arenaBytes ());
+
+  // out of memory : the insert fails, nothing leaks
+  arena.failAfter = 0;
+  EXPECT_FALSE (hm_insert (&map, &item, sizeof (item), "failed"));
+  arena.failAfter = SIZE_MAX;
+
+  hm_destroy (&map);
+  EXPECT_EQ (heap_bytes (&map.heap), 0u);
+  EXPECT_EQ (heap_allocations (&map.heap), 0u);
+
+  // the stripe maps take their tables and items from the allocator as well
+  HashMapSafe safeMap;
+  ASSERT_TRUE (concurrent_hm_init_allocator (&safeMap, 64, 4, &allocator));
+  EXPECT_EQ (arena.live.size (), 4u * 2);
+
+  EXPECT_TRUE (concurrent_hm_insert (&safeMap, &item, sizeof (item), "key"));
+  EXPECT_EQ (arena.live.size (), 4u * 2 + 1);
+
+  concurrent_hm_destroy (&safeMap);
+}
+
+TEST_F (AllocatorTestClass, BPTreeTest)
+{
+  // nodes, separators and items come from the allocator, merges return them
+
+  const int KEYS_COUNT = 1000;
+
+  BPTree tree;
+  ASSERT_TRUE (bpt_init_allocator (&tree, &allocator));
+
+  int item = 0;
+  for (auto i = 0; i < KEYS_COUNT; ++i)
+  {
+    EXPECT_TRUE (bpt_insert (&tree, &item, sizeof (item), std::to_string (i).c_str ()));
+  }
+  EXPECT_GT (heap_allocations (&tree.heap), (size_t)KEYS_COUNT);
+  EXPECT_EQ (heap_bytes (&tree.heap), arenaBytes ());
+
+  // out of memory in the middle of a split : the insert fails, nothing leaks
+  for (size_t failAfter = 0; failAfter < 4; ++failAfter)
+  {
+    arena.failAfter = failAfter;
+    bpt_insert (&tree, &item, sizeof (item), ("new" + std::to_string (failAfter)).c_str ());
+  }
+  arena.failAfter = SIZE_MAX;
+  EXPECT_EQ (heap_bytes (&tree.heap), arenaBytes ());
+
+  for (auto i = 0; i < KEYS_COUNT; i += 2)
+  {
+    EXPECT_TRUE (bpt_delete (&tree, std::to_string (i).c_str ()));
+  }
+  EXPECT_EQ (heap_bytes (&tree.heap), arenaBytes ());
+
+  bpt_destroy (&tree);
+  EXPECT_EQ (heap_bytes (&tree.heap), 0u);
+  EXPECT_EQ (heap_allocations (&tree.heap), 0u);
+}
+
+TEST_F (AllocatorTestClass, SkipListTest)
+{
+  // nodes come from the allocator, deleted ones wait for their epoch in the heap
+
+  const int KEYS_COUNT = 1000;
+
+  SkipList list;
+  ASSERT_TRUE (sl_init_allocator (&list, &allocator));
+  EXPECT_EQ (heap_allocations (&list.heap), 1u);    // the head
+
+  int item = 0;
+  for (auto i = 0; i < KEYS_COUNT; ++i)
+  {
+    EXPECT_TRUE (sl_insert (&list, &item, sizeof (item), std::to_string (i).c_str ()));
+  }
+  EXPECT_FALSE (sl_insert (&list, &item, sizeof (item), "0"));
+  EXPECT_EQ (heap_allocations (&list.heap), (size_t)KEYS_COUNT + 1);
+  EXPECT_EQ (heap_bytes (&list.heap), arenaBytes ());
+
+  for (auto i = 0; i < KEYS_COUNT; i += 2)
+  {
+    EXPECT_TRUE (sl_delete (&list, std::to_string (i).c_str ()));
+  }
+  EXPECT_EQ (heap_bytes (&list.heap), arenaBytes ());
+
+  sl_destroy (&list);
+  EXPECT_EQ (heap_bytes (&list.heap), 0u);
+  EXPECT_EQ (heap_allocations (&list.heap), 0u);
+}
+
+TEST_F (AllocatorTestClass, LFListTest)
+{
+  // the same for the lock-free list
+
+  const int KEYS_COUNT = 200;
+
+  LFList list;
+  ASSERT_TRUE (lfl_init_allocator (&list, &allocator));
+
+  int item = 0;
+  for (auto i = 0; i < KEYS_COUNT; ++i)
+  {
+    EXPECT_TRUE (lfl_insert (&list, &item, sizeof (item), std::to_string (i).c_str ()));
+  }
+  EXPECT_FALSE (lfl_insert (&list, &item, sizeof (item), "0"));
+  EXPECT_EQ (heap_allocations (&list.heap), (size_t)KEYS_COUNT);
+  EXPECT_EQ (heap_bytes (&list.heap), arenaBytes ());
+
+  for (auto i = 0; i < KEYS_COUNT; i += 2)
+  {
+    EXPECT_TRUE (lfl_delete (&list, std::to_string (i).c_str ()));
+  }
+  EXPECT_EQ (heap_bytes (&list.heap), arenaBytes ());
+
+  lfl_destroy (&list);
+  EXPECT_EQ (heap_bytes (&list.heap), 0u);
+  EXPECT_EQ (heap_allocations (&list.heap), 0u);
+}
+
+TEST_F (AllocatorTestClass, CacheTest)
+{
+  // entries and LFU buckets come from the allocator, evictions and replacements return them
+
+  const size_t MAX_COUNT = 100;
+
+  for (auto policy : { CACHE_LRU, CACHE_LFU })
+  {
+    Cache cache;
+    ASSERT_TRUE (cache_init_allocator (&cache, policy, MAX_COUNT, 0, NULL, NULL, &allocator));
+
+    // keys come back : the payload size changes replace entries, gets move LFU entries up
+    int item = 0;
+    char big[64] = { 0 };
+    std::string key;
+    for (size_t i = 0; i < 3 * MAX_COUNT; ++i)
+    {
+      key = std::to_string (i % (2 * MAX_COUNT));
+
+      if (i % 3 == 0)
+      {
+        EXPECT_TRUE (cache_put (&cache, big, sizeof (big), key.c_str ()));
+      }
+      else
+      {
+        EXPECT_TRUE (cache_put (&cache, &item, sizeof (item), key.c_str ()));
+      }
+      (void)cache_get (&cache, &big, sizeof (big), std::to_string (i / 2).c_str ());
+    }
+    EXPECT_EQ (cache_count (&cache), MAX_COUNT);
+    EXPECT_GE (heap_allocations (&cache.heap), MAX_COUNT);
+    EXPECT_GT (heap_bytes (&cache.heap), cache_bytes (&cache));
+    EXPECT_EQ (heap_bytes (&cache.heap), arenaBytes ());
+
+    EXPECT_TRUE (cache_delete (&cache, key.c_str ()));
+    EXPECT_EQ (heap_bytes (&cache.heap), arenaBytes ());
+
+    cache_destroy (&cache);
+    EXPECT_EQ (heap_bytes (&cache.heap), 0u);
+    EXPECT_EQ (heap_allocations (&cache.heap), 0u);
+  }
+}
+
+TEST_F (AllocatorTestClass, RBTreeTypedTest)
+{
+  // integer and binary key trees : a node and its payload are two allocations
+
+  const int KEYS_COUNT = 1000;
+
+  RBTU64Tree u64Tree;
+  RBTBinTree binTree;
+  ASSERT_TRUE (rbt_u64_tree_init (&u64Tree, &allocator));
+  ASSERT_TRUE (rbt_bin_tree_init (&binTree, &allocator));
+
+  int item = 0;
+  for (auto i = 0; i < KEYS_COUNT; ++i)
+  {
+    uint64_t key = (uint64_t)i * 7;
+
+    EXPECT_TRUE (rbt_u64_tree_insert (&u64Tree, &item, sizeof (item), key));
+    EXPECT_TRUE (rbt_bin_tree_insert (&binTree, &item, sizeof (item), &key, sizeof (key)));
+  }
+  EXPECT_EQ (heap_allocations (&u64Tree.heap), 2u * KEYS_COUNT);
+  EXPECT_EQ (heap_allocations (&binTree.heap), 2u * KEYS_COUNT);
+  EXPECT_EQ (heap_bytes (&u64Tree.heap) + heap_bytes (&binTree.heap), arenaBytes ());
+
+  // out of memory for the payload : the node is returned
+  arena.failAfter = 1;
+  EXPECT_FALSE (rbt_u64_tree_insert (&u64Tree, &item, sizeof (item), 1));
+  arena.failAfter = SIZE_MAX;
+  EXPECT_EQ (heap_allocations (&u64Tree.heap), 2u * KEYS_COUNT);
+
+  uint64_t key = 7;
+  EXPECT_TRUE (rbt_u64_delete (&u64Tree.root, key));
+  EXPECT_TRUE (rbt_bin_delete (&binTree.root, &key, sizeof (key)));
+  EXPECT_EQ (heap_bytes (&u64Tree.heap) + heap_bytes (&binTree.heap), arenaBytes ());
+
+  EXPECT_TRUE (rbt_u64_destroy (&u64Tree.root));
+  EXPECT_TRUE (rbt_bin_destroy (&binTree.root));
+  EXPECT_EQ (heap_bytes (&u64Tree.heap), 0u);
+  EXPECT_EQ (heap_bytes (&binTree.heap), 0u);
+}
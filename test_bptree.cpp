@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/bp_tree.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct TestStruct
+{
+  int mem0, mem1, mem2;
+
+  bool operator== (const TestStruct& other) const
+  {
+    return mem0 == other.mem0 && mem1 == other.mem1 && mem2 == other.mem2;
+  }
+};
+
+static bool collectKeys (const char* key, void* pData, void* pContext)
+{
+  static_cast<std::vector<std::string>*> (pContext)->push_back (key);
+  return true;
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class BPTreeTestClass : public ::testing::Test
+{
+public:
+  BPTree tree;
+
+  void SetUp () override { ASSERT_TRUE (bpt_init (&tree)); }
+
+  void TearDown () override { bpt_destroy (&tree); }
+
+  std::vector<std::string> getKeys (const char* keyFrom = NULL, const char* keyTo = NULL)
+  {
+    std::vector<std::string> keys;
+    EXPECT_TRUE (bpt_scan_range (&tree, keyFrom, keyTo, collectKeys, &keys));
+    return keys;
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (BPTreeTestClass, BPTRegularTest)
+{
+  // bpt_insert
+  // bpt_get
+  // bpt_scan_range
+
+  bool result;
+  const int keyMaxSize = 10;
+  const int BPT_ITEMS_COUNT = 10000;
+  std::map<std::string, TestStruct> expected;
+
+  std::vector<int> order (BPT_ITEMS_COUNT);
+  for (auto i = 0; i < BPT_ITEMS_COUNT; ++i)
+  {
+    order[i] = i;
+  }
+  std::shuffle (order.begin (), order.end (), std::mt19937 (42));
+
+  for (auto i : order)
+  {
+    TestStruct item = { i, i + 1, i + 2 };
+
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "%i", i);
+
+    result = bpt_insert (&tree, &item, sizeof (TestStruct), key);
+    ASSERT_TRUE (result);
+    expected[key] = item;
+  }
+  EXPECT_EQ (tree.count, (size_t)BPT_ITEMS_COUNT);
+
+  // insertion when key already exists
+  TestStruct item = { 0 };
+  EXPECT_FALSE (bpt_insert (&tree, &item, sizeof (TestStruct), "0"));
+  EXPECT_EQ (tree.count, (size_t)BPT_ITEMS_COUNT);
+
+  for (const auto& [key, value] : expected)
+  {
+    TestStruct actual = { 0 };
+
+    result = bpt_get (&tree, &actual, sizeof (actual), key.c_str ());
+    EXPECT_TRUE (result);
+    EXPECT_TRUE (value == actual);
+  }
+
+  TestStruct actual = { 0 };
+  EXPECT_FALSE (bpt_get (&tree, &actual, sizeof (actual), "missing"));
+
+  // the stored size is copied, a smaller buffer is refused
+  TestStruct larger[2] = { { 0, 0, 0 }, { -1, -1, -1 } };
+  EXPECT_FALSE (bpt_get (&tree, &actual, sizeof (actual) - 1, "7"));
+  ASSERT_TRUE (bpt_get (&tree, larger, sizeof (larger), "7"));
+  EXPECT_TRUE (larger[0] == expected["7"]);
+  EXPECT_TRUE (larger[1] == (TestStruct{ -1, -1, -1 }));
+
+  // full scan is sorted
+  auto keys = getKeys ();
+  ASSERT_EQ (keys.size (), expected.size ());
+  EXPECT_TRUE (std::equal (keys.begin (), keys.end (), expected.begin (),
+                           [] (const auto& key, const auto& pair) { return key == pair.first; }));
+
+  // range scan
+  keys = getKeys ("3", "5");
+  std::vector<std::string> expectedKeys;
+  for (auto it = expected.lower_bound ("3"); it != expected.lower_bound ("5"); ++it)
+  {
+    expectedKeys.push_back (it->first);
+  }
+  EXPECT_EQ (keys, expectedKeys);
+}
+
+TEST_F (BPTreeTestClass, BPTDeletionTest)
+{
+  // bpt_delete
+
+  const int keyMaxSize = 16;
+  const int BPT_ITEMS_COUNT = 20000;
+  std::map<std::string, TestStruct> expected;
+  std::mt19937 generator (42);
+
+  // random inserts and deletes with std::map as a reference
+  for (auto step = 0; step < BPT_ITEMS_COUNT * 4; ++step)
+  {
+    int value = generator () % BPT_ITEMS_COUNT;
+
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "key%i", value);
+
+    if (generator () % 3 != 0)
+    {
+      TestStruct item = { value, value + 1, value + 2 };
+      bool isNew = expected.emplace (key, item).second;
+      ASSERT_EQ (bpt_insert (&tree, &item, sizeof (item), key), isNew);
+    }
+    else
+    {
+      bool isPresent = expected.erase (key) != 0;
+      ASSERT_EQ (bpt_delete (&tree, key), isPresent);
+    }
+
+    ASSERT_EQ (tree.count, expected.size ());
+  }
+
+  auto keys = getKeys ();
+  ASSERT_EQ (keys.size (), expected.size ());
+  EXPECT_TRUE (std::equal (keys.begin (), keys.end (), expected.begin (),
+                           [] (const auto& key, const auto& pair) { return key == pair.first; }));
+
+  // delete everything
+  for (const auto& [key, value] : expected)
+  {
+    TestStruct actual = { 0 };
+
+    ASSERT_TRUE (bpt_get (&tree, &actual, sizeof (actual), key.c_str ()));
+    EXPECT_TRUE (value == actual);
+    ASSERT_TRUE (bpt_delete (&tree, key.c_str ()));
+  }
+
+  EXPECT_EQ (tree.count, 0u);
+  EXPECT_TRUE (tree.root == NULL);
+  EXPECT_FALSE (bpt_delete (&tree, "key0"));
+}
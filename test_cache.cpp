@@ -0,0 +1,301 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/cache.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct TestStruct
+{
+  int mem0, mem1, mem2;
+
+  bool operator== (const TestStruct& other) const
+  {
+    return mem0 == other.mem0 && mem1 == other.mem1 && mem2 == other.mem2;
+  }
+};
+
+static void collectEvicted (const char* key, const void*, size_t, void* pContext)
+{
+  static_cast<std::vector<std::string>*> (pContext)->push_back (key);
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class CacheTestClass : public ::testing::Test
+{
+public:
+  Cache cache = {};    // destroyed by TearDown () even if a test doesn't use it
+  std::vector<std::string> evicted;
+
+  void TearDown () override { cache_destroy (&cache); }
+
+  void put (const std::string& key, int value)
+  {
+    TestStruct item = { value, value + 1, value + 2 };
+    ASSERT_TRUE (cache_put (&cache, &item, sizeof (item), key.c_str ()));
+  }
+
+  bool has (const std::string& key)
+  {
+    TestStruct item;
+    return cache_get (&cache, &item, sizeof (item), key.c_str ());
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (CacheTestClass, CacheLRUTest)
+{
+  // the least recently used entry goes first, get and put refresh entries
+
+  ASSERT_TRUE (cache_init (&cache, CACHE_LRU, 3, 0, collectEvicted, &evicted));
+
+  put ("a", 1);
+  put ("b", 2);
+  put ("c", 3);
+  EXPECT_TRUE (has ("a"));    // 'b' is the oldest now
+
+  put ("d", 4);
+  ASSERT_EQ (evicted, std::vector<std::string> ({ "b" }));
+  EXPECT_EQ (cache_count (&cache), 3u);
+
+  put ("c", 30);    // replaced : 'a' is the oldest now
+  put ("e", 5);
+  ASSERT_EQ (evicted, std::vector<std::string> ({ "b", "a" }));
+
+  TestStruct item = { 0, 0, 0 };
+  ASSERT_TRUE (cache_get (&cache, &item, sizeof (item), "c"));
+  EXPECT_TRUE (item == TestStruct ({ 30, 31, 32 }));
+  EXPECT_FALSE (cache_get (&cache, &item, sizeof (item) - 1, "c"));
+  EXPECT_FALSE (cache_get (&cache, &item, sizeof (item), "a"));
+
+  // deleted entries are not reported
+  EXPECT_TRUE (cache_delete (&cache, "d"));
+  EXPECT_FALSE (cache_delete (&cache, "d"));
+  EXPECT_EQ (cache_count (&cache), 2u);
+  EXPECT_EQ (evicted.size (), 2u);
+
+  EXPECT_FALSE (cache_put (&cache, NULL, 0, "null"));
+  EXPECT_FALSE (cache_put (&cache, &item, sizeof (item), NULL));
+  EXPECT_FALSE (cache_put (&cache, &item, sizeof (item),
+                           std::string (CACHE_KEY_SIZE, 'k').c_str ()));
+}
+
+TEST_F (CacheTestClass, CacheLFUTest)
+{
+  // the least frequently used entry goes first, the least recent one among equals
+
+  ASSERT_TRUE (cache_init (&cache, CACHE_LFU, 3, 0, collectEvicted, &evicted));
+
+  put ("a", 1);
+  put ("b", 2);
+  put ("c", 3);
+
+  // a : 3 uses, b : 1, c : 2
+  EXPECT_TRUE (has ("a"));
+  EXPECT_TRUE (has ("a"));
+  EXPECT_TRUE (has ("c"));
+
+  put ("d", 4);
+  ASSERT_EQ (evicted, std::vector<std::string> ({ "b" }));
+
+  // a new entry is never evicted by its own insertion : 'd' is the only one of single use
+  put ("e", 5);
+  ASSERT_EQ (evicted, std::vector<std::string> ({ "b", "d" }));
+
+  put ("f", 6);    // 'e' and 'c' have one and two uses
+  ASSERT_EQ (evicted, std::vector<std::string> ({ "b", "d", "e" }));
+
+  EXPECT_TRUE (has ("a"));
+  EXPECT_TRUE (has ("c"));
+  EXPECT_TRUE (has ("f"));
+}
+
+TEST_F (CacheTestClass, CacheBytesTest)
+{
+  // keys and payloads of variable size are kept within the byte budget
+
+  const size_t MAX_BYTES = 4096;
+
+  ASSERT_TRUE (cache_init (&cache, CACHE_LRU, 0, MAX_BYTES, collectEvicted, &evicted));
+
+  std::mt19937 generator (42);
+  std::vector<char> payload (1024, 'p');
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    std::string key = "key:" + std::to_string (generator () % 64);
+    size_t size = 1 + generator () % payload.size ();
+
+    ASSERT_TRUE (cache_put (&cache, payload.data (), size, key.c_str ()));
+    EXPECT_LE (cache_bytes (&cache), MAX_BYTES);
+
+    // the last put entry is always there with its last payload
+    std::vector<char> actual (payload.size ());
+    ASSERT_TRUE (cache_get (&cache, actual.data (), actual.size (), key.c_str ()));
+  }
+
+  EXPECT_FALSE (evicted.empty ());
+  EXPECT_FALSE (cache_put (&cache, payload.data (), MAX_BYTES, "too big"));
+
+  while (cache_count (&cache) > 0)
+  {
+    std::string key = "key:" + std::to_string (generator () % 64);
+    cache_delete (&cache, key.c_str ());
+  }
+  EXPECT_EQ (cache_bytes (&cache), 0u);
+}
+
+TEST_F (CacheTestClass, CacheConcurrentTest)
+{
+  // the shards keep the whole budget, every thread reads own and shared keys
+
+  const unsigned int THREADS_COUNT = 8;
+  const int KEYS_PER_THREAD = 5000;
+  const size_t MAX_COUNT = 4096;
+
+  std::atomic<size_t> evictedCount (0);
+  CacheSafe safeCache;
+  EXPECT_FALSE (concurrent_cache_init (&safeCache, CACHE_LFU, MAX_COUNT, 0, 3, NULL, NULL));
+  ASSERT_TRUE (concurrent_cache_init (
+      &safeCache, CACHE_LFU, MAX_COUNT, 0, 16,
+      [] (const char*, const void*, size_t, void* pContext) {
+        ++*static_cast<std::atomic<size_t>*> (pContext);
+      },
+      &evictedCount));
+
+  std::vector<std::thread> threads;
+  for (unsigned int id = 0; id < THREADS_COUNT; ++id)
+  {
+    threads.push_back (std::thread ([&, id] {
+      for (auto i = 0; i < KEYS_PER_THREAD; ++i)
+      {
+        std::string own = "own:" + std::to_string (id) + ":" + std::to_string (i);
+        std::string shared = "shared:" + std::to_string (i % 100);
+        TestStruct item = { (int)id, i, 0 };
+
+        EXPECT_TRUE (concurrent_cache_put (&safeCache, &item, sizeof (item), own.c_str ()));
+        EXPECT_TRUE (concurrent_cache_put (&safeCache, &item, sizeof (item), shared.c_str ()));
+
+        TestStruct actual;
+        if (concurrent_cache_get (&safeCache, &actual, sizeof (actual), own.c_str ()))
+        {
+          EXPECT_TRUE (actual == item);
+        }
+      }
+    }));
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join ();
+  }
+
+  size_t count = concurrent_cache_count (&safeCache);
+  EXPECT_LE (count, MAX_COUNT + 16);
+  EXPECT_EQ (count + evictedCount, THREADS_COUNT * KEYS_PER_THREAD + 100);
+
+  // the shared keys are the most frequently used ones
+  TestStruct item;
+  for (auto i = 0; i < 100; ++i)
+  {
+    std::string shared = "shared:" + std::to_string (i);
+    EXPECT_TRUE (concurrent_cache_get (&safeCache, &item, sizeof (item), shared.c_str ()));
+  }
+
+  EXPECT_TRUE (concurrent_cache_delete (&safeCache, "shared:0"));
+  EXPECT_FALSE (concurrent_cache_delete (&safeCache, "shared:0"));
+
+  concurrent_cache_destroy (&safeCache);
+  EXPECT_TRUE (safeCache.shards == NULL);
+}
+
+TEST_F (CacheTestClass, CacheHitRatioTest)
+{
+  /* the hit ratio of every policy under two workloads, a miss puts the key :
+   *   > uniform keys over twice the capacity : about a half of gets hit for both policies
+   *   > hot keys read twice per round between scans of the capacity cold keys :
+   *     LRU loses the hot keys to every scan, LFU keeps them since the cold ones are read once
+   */
+
+  const size_t MAX_COUNT = 1000;
+  const size_t HOT_COUNT = MAX_COUNT / 2;
+  const int ROUNDS = 10;
+
+  TestStruct item = { 1, 2, 3 };
+  char key[32] = { 0 };
+
+  auto access = [&] (Cache* pCache) {
+    bool isHit = cache_get (pCache, &item, sizeof (item), key);
+    if (!isHit)
+    {
+      EXPECT_TRUE (cache_put (pCache, &item, sizeof (item), key));
+    }
+    return isHit;
+  };
+
+  for (auto policy : { CACHE_LRU, CACHE_LFU })
+  {
+    Cache uniformCache;
+    ASSERT_TRUE (cache_init (&uniformCache, policy, MAX_COUNT, 0, NULL, NULL));
+
+    const size_t OPS_COUNT = 200000;
+    std::mt19937 generator (42);
+    size_t hits = 0;
+
+    for (size_t i = 0; i < OPS_COUNT; ++i)
+    {
+      snprintf (key, sizeof (key), "user:%08zx", (size_t)(generator () % (MAX_COUNT * 2)));
+      hits += access (&uniformCache);
+    }
+
+    EXPECT_EQ (cache_count (&uniformCache), MAX_COUNT);
+    EXPECT_NEAR ((double)hits / OPS_COUNT, 0.5, 0.05) << "policy " << policy;
+    cache_destroy (&uniformCache);
+
+    Cache scanCache;
+    ASSERT_TRUE (cache_init (&scanCache, policy, MAX_COUNT, 0, NULL, NULL));
+
+    size_t hotHits = 0;
+    size_t coldHits = 0;
+    size_t coldIndex = 0;
+
+    for (auto round = 0; round < ROUNDS; ++round)
+    {
+      for (auto pass = 0; pass < 2; ++pass)
+      {
+        for (size_t i = 0; i < HOT_COUNT; ++i)
+        {
+          snprintf (key, sizeof (key), "hot:%zu", i);
+          hotHits += access (&scanCache);
+        }
+      }
+
+      for (size_t i = 0; i < MAX_COUNT; ++i)
+      {
+        snprintf (key, sizeof (key), "cold:%zu", coldIndex++);
+        coldHits += access (&scanCache);
+      }
+    }
+
+    // LRU : the second pass only, LFU : the first round misses once
+    size_t expectedHits = (policy == CACHE_LRU) ? HOT_COUNT * ROUNDS : HOT_COUNT * (2 * ROUNDS - 1);
+    EXPECT_EQ (hotHits, expectedHits) << "policy " << policy;
+    EXPECT_EQ (coldHits, 0u);
+    cache_destroy (&scanCache);
+  }
+}
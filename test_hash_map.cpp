@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/hash_map.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct TestStruct
+{
+  int mem0, mem1, mem2;
+
+  bool operator== (const TestStruct& other) const
+  {
+    return mem0 == other.mem0 && mem1 == other.mem1 && mem2 == other.mem2;
+  }
+};
+
+static std::vector<std::string> generateKeys (size_t count, const char* format)
+{
+  const int keyMaxSize = 64;
+  std::mt19937 generator (42);
+  std::vector<std::string> keys;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, format, generator (), generator ());
+    keys.push_back (key);
+  }
+
+  std::sort (keys.begin (), keys.end ());
+  keys.erase (std::unique (keys.begin (), keys.end ()), keys.end ());
+  std::shuffle (keys.begin (), keys.end (), generator);
+
+  return keys;
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class HashMapTestClass : public ::testing::Test
+{
+public:
+  HashMap map;
+
+  void SetUp () override { ASSERT_TRUE (hm_init (&map, 0)); }
+
+  void TearDown () override { hm_destroy (&map); }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (HashMapTestClass, HMRegularTest)
+{
+  // hm_insert
+  // hm_get
+
+  TestStruct item = { 1, 2, 3 };
+  TestStruct actual;
+
+  // short keys are stored inline, long ones - with the payload
+  auto keys = generateKeys (5000, "k%x%x");
+  auto longKeys = generateKeys (5000, "long-key-to-be-stored-out-of-slot:%08x%08x");
+  keys.insert (keys.end (), longKeys.begin (), longKeys.end ());
+
+  for (size_t i = 0; i < keys.size (); ++i)
+  {
+    item.mem0 = (int)i;
+    ASSERT_TRUE (hm_insert (&map, &item, sizeof (item), keys[i].c_str ()));
+  }
+  EXPECT_EQ (map.count, keys.size ());
+
+  for (size_t i = 0; i < keys.size (); ++i)
+  {
+    item.mem0 = (int)i;
+    ASSERT_TRUE (hm_get (&map, &actual, sizeof (actual), keys[i].c_str ()));
+    EXPECT_EQ (actual, item);
+  }
+
+  // duplicates and bad arguments
+  EXPECT_FALSE (hm_insert (&map, &item, sizeof (item), keys[0].c_str ()));
+  EXPECT_FALSE (hm_insert (&map, NULL, sizeof (item), "absent"));
+  EXPECT_FALSE (hm_insert (&map, &item, sizeof (item), NULL));
+  EXPECT_FALSE (hm_insert (&map, &item, sizeof (item), std::string (HM_KEY_SIZE, 'x').c_str ()));
+  EXPECT_FALSE (hm_get (&map, &actual, sizeof (actual), "absent"));
+  EXPECT_FALSE (hm_get (&map, NULL, sizeof (actual), keys[0].c_str ()));
+  EXPECT_TRUE (hm_insert (&map, &item, sizeof (item), ""));
+  EXPECT_TRUE (hm_get (&map, &actual, sizeof (actual), ""));
+
+  // the stored size is copied, a smaller buffer is refused
+  TestStruct larger[2] = { { 0, 0, 0 }, { -1, -1, -1 } };
+  EXPECT_FALSE (hm_get (&map, &actual, sizeof (actual) - 1, keys[0].c_str ()));
+  ASSERT_TRUE (hm_get (&map, larger, sizeof (larger), keys[0].c_str ()));
+  EXPECT_EQ (larger[0].mem0, 0);
+  EXPECT_EQ (larger[1], (TestStruct{ -1, -1, -1 }));
+
+  // capacity hint : no rehashing
+  HashMap sized;
+  ASSERT_TRUE (hm_init (&sized, 1000));
+  size_t capacity = sized.capacity;
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    ASSERT_TRUE (hm_insert (&sized, &item, sizeof (item), keys[i].c_str ()));
+  }
+  EXPECT_EQ (sized.capacity, capacity);
+  hm_destroy (&sized);
+}
+
+TEST_F (HashMapTestClass, HMDeletionTest)
+{
+  // hm_delete : checked against std::unordered_map under inserts and deletes mix
+
+  std::mt19937 generator (7);
+  std::unordered_map<std::string, int> expected;
+  auto keys = generateKeys (2000, "key:%x:%x");
+  TestStruct item = { 0, 0, 0 };
+  TestStruct actual;
+
+  for (int round = 0; round < 50000; ++round)
+  {
+    const std::string& key = keys[generator () % keys.size ()];
+    bool isPresent = expected.count (key) != 0;
+
+    if (generator () % 2 == 0)
+    {
+      item.mem0 = round;
+      EXPECT_EQ (hm_insert (&map, &item, sizeof (item), key.c_str ()), !isPresent);
+      expected.emplace (key, round);
+    }
+    else
+    {
+      EXPECT_EQ (hm_delete (&map, key.c_str ()), isPresent);
+      expected.erase (key);
+    }
+  }
+
+  EXPECT_EQ (map.count, expected.size ());
+
+  for (const auto& key : keys)
+  {
+    auto it = expected.find (key);
+
+    if (it == expected.end ())
+    {
+      EXPECT_FALSE (hm_get (&map, &actual, sizeof (actual), key.c_str ()));
+    }
+    else
+    {
+      ASSERT_TRUE (hm_get (&map, &actual, sizeof (actual), key.c_str ()));
+      EXPECT_EQ (actual.mem0, it->second);
+    }
+  }
+
+  // everything deleted : map is reusable
+  for (const auto& it : expected)
+  {
+    EXPECT_TRUE (hm_delete (&map, it.first.c_str ()));
+  }
+  EXPECT_EQ (map.count, 0u);
+  EXPECT_FALSE (hm_delete (&map, keys[0].c_str ()));
+  EXPECT_TRUE (hm_insert (&map, &item, sizeof (item), keys[0].c_str ()));
+}
+
+TEST (HashMapSafeTest, HMConcurrentTest)
+{
+  // every thread inserts, reads and deletes own keys, half of them are kept
+
+  const int THREADS_COUNT = 8;
+  const size_t KEYS_PER_THREAD = 5000;
+
+  HashMapSafe map;
+  EXPECT_FALSE (concurrent_hm_init (&map, 0, 3));
+  ASSERT_TRUE (concurrent_hm_init (&map, 0, 16));
+
+  auto keys = generateKeys (THREADS_COUNT * KEYS_PER_THREAD, "%08x%08x");
+  ASSERT_EQ (keys.size (), THREADS_COUNT * KEYS_PER_THREAD);
+
+  std::vector<std::thread> threads;
+  for (int id = 0; id < THREADS_COUNT; ++id)
+  {
+    threads.push_back (std::thread ([&, id] {
+      TestStruct item = { id, 0, 0 };
+      TestStruct actual;
+
+      for (size_t i = id * KEYS_PER_THREAD; i < (id + 1) * KEYS_PER_THREAD; ++i)
+      {
+        item.mem1 = (int)i;
+        EXPECT_TRUE (concurrent_hm_insert (&map, &item, sizeof (item), keys[i].c_str ()));
+        EXPECT_TRUE (concurrent_hm_get (&map, &actual, sizeof (actual), keys[i].c_str ()));
+        EXPECT_EQ (actual, item);
+
+        if (i % 2 == 0)
+        {
+          EXPECT_TRUE (concurrent_hm_delete (&map, keys[i].c_str ()));
+        }
+      }
+    }));
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join ();
+  }
+
+  TestStruct actual;
+  for (size_t i = 0; i < keys.size (); ++i)
+  {
+    EXPECT_EQ (concurrent_hm_get (&map, &actual, sizeof (actual), keys[i].c_str ()), i % 2 != 0);
+  }
+
+  concurrent_hm_destroy (&map);
+}
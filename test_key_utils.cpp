@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/key_utils.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+static const KEY_KERNEL KERNELS[] = { KEY_KERNEL_SCALAR, KEY_KERNEL_SSE2, KEY_KERNEL_AVX2 };
+
+static int sign (int value)
+{
+  return (value > 0) - (value < 0);
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class KeyUtilsTestClass : public ::testing::Test
+{
+public:
+  void TearDown () override { ASSERT_TRUE (key_kernel_select (KEY_KERNEL_AUTO)); }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (KeyUtilsTestClass, KeyKernelsTest)
+{
+  // every kernel is checked against libc at all alignments and lengths
+
+  std::mt19937 generator (42);
+  std::vector<char> buffer1 (1024);
+  std::vector<char> buffer2 (1024);
+
+  for (auto kernel : KERNELS)
+  {
+    if (!key_kernel_select (kernel))
+    {
+      std::cout << "kernel " << kernel << " is not supported, skipped\n";
+      continue;
+    }
+    EXPECT_EQ (key_kernel_active (), kernel);
+
+    for (size_t offset = 0; offset < 64; ++offset)
+    {
+      for (size_t length = 0; length < 300; length += 1 + length / 16)
+      {
+        char* key1 = buffer1.data () + offset;
+        char* key2 = buffer2.data () + (offset * 7) % 64;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+          key1[i] = key2[i] = (char)(1 + generator () % 255);
+        }
+        key1[length] = key2[length] = '\0';
+        key1[length + 1] = key2[length + 1] = 'x';    // garbage after the terminator
+
+        ASSERT_EQ (key_length (key1, 256), strnlen (key1, 256));
+        ASSERT_EQ (key_length (key1, length / 2), strnlen (key1, length / 2));
+        ASSERT_EQ (key_string_compare (key1, key2), 0);
+        ASSERT_EQ (key_mismatch (key1, key2, length + 2), length + 2);
+        ASSERT_EQ (key_compare (key1, key2, length), 0);
+
+        if (length > 0)
+        {
+          size_t at = generator () % length;
+          key2[at] = (char)(key1[at] ^ (1 + generator () % 255));
+
+          ASSERT_EQ (key_mismatch (key1, key2, length), at);
+          ASSERT_EQ (key_compare (key1, key2, length), sign (memcmp (key1, key2, length)));
+          ASSERT_EQ (key_string_compare (key1, key2), sign (strcmp (key1, key2)));
+          ASSERT_EQ (key_string_compare (key2, key1), sign (strcmp (key2, key1)));
+
+          // shorter key is less
+          key2[at] = key1[at];
+          key2[at] = '\0';
+          ASSERT_EQ (key_string_compare (key1, key2), 1);
+          ASSERT_EQ (key_string_compare (key2, key1), -1);
+        }
+      }
+    }
+
+    EXPECT_EQ (key_prefix ("abc", 3), 0x6162630000000000ULL);
+    EXPECT_EQ (key_prefix ("abcdefghij", 10), 0x6162636465666768ULL);
+    EXPECT_EQ (key_prefix ("", 0), 0ULL);
+  }
+}
+
+TEST_F (KeyUtilsTestClass, KeyPageBorderTest)
+{
+  // keys at the end of a page followed by inaccessible one : vector reads must not fault
+
+  size_t pageSize = (size_t)sysconf (_SC_PAGESIZE);
+  char* pPages = (char*)mmap (NULL, pageSize * 2, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE (pPages, MAP_FAILED);
+  ASSERT_EQ (mprotect (pPages + pageSize, pageSize, PROT_NONE), 0);
+
+  std::vector<char> other (128, 'k');
+
+  for (auto kernel : KERNELS)
+  {
+    if (!key_kernel_select (kernel))
+    {
+      continue;
+    }
+
+    for (size_t length = 0; length < 70; ++length)
+    {
+      char* key = pPages + pageSize - length - 1;
+      memset (key, 'k', length);
+      key[length] = '\0';
+      other[length] = '\0';
+
+      EXPECT_EQ (key_length (key, 256), length);
+      EXPECT_EQ (key_string_compare (key, other.data ()), 0);
+      EXPECT_EQ (key_string_compare (other.data (), key), 0);
+      EXPECT_EQ (key_mismatch (key, other.data (), length), length);
+
+      other[length] = 'k';
+    }
+  }
+
+  munmap (pPages, pageSize * 2);
+}
+
+TEST_F (KeyUtilsTestClass, KeyKernelsLongKeysTest)
+{
+  // equal 64..255 bytes keys, the tree keys size : every kernel agrees with libc
+
+  const int KEYS_COUNT = 4096;
+
+  std::mt19937 generator (42);
+  std::vector<std::string> keys;
+  for (auto i = 0; i < KEYS_COUNT; ++i)
+  {
+    keys.push_back (std::string (64 + generator () % 192, 'a' + i % 26));
+  }
+  std::vector<std::string> copies = keys;
+
+  for (auto kernel : KERNELS)
+  {
+    if (!key_kernel_select (kernel))
+    {
+      continue;
+    }
+
+    for (auto i = 0; i < KEYS_COUNT; ++i)
+    {
+      const char* key = keys[i].c_str ();
+      std::string& copy = copies[i];
+
+      ASSERT_EQ (key_length (key, 256), keys[i].size ());
+      ASSERT_EQ (key_string_compare (key, copy.c_str ()), 0);
+
+      // the last byte differs : the whole key is scanned
+      copy.back () = (char)(copy.back () + 1);
+      ASSERT_EQ (key_string_compare (key, copy.c_str ()), -1);
+      ASSERT_EQ (key_mismatch (key, copy.c_str (), copy.size ()), copy.size () - 1);
+      copy.back () = keys[i].back ();
+    }
+  }
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/latency.h"
+#include "include/c/queue.h"
+#include "include/c/rb_tree.h"
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class LatencyTestClass : public ::testing::Test
+{
+public:
+  LatencyHistogram histogram;
+
+  void SetUp () override { latency_reset (); }
+
+  // ns of ticks in the histogram time base
+  double ns (uint64_t ticks) { return (double)ticks / histogram.ticksPerNs; }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (LatencyTestClass, LatencyPercentileTest)
+{
+  // 1..100000 ticks uniformly : quantiles within the bucket precision
+
+  const uint64_t SAMPLES_COUNT = 100000;
+
+  for (uint64_t ticks = 1; ticks <= SAMPLES_COUNT; ++ticks)
+  {
+    latency_record (LATENCY_RBT_GET, ticks);
+  }
+
+  ASSERT_TRUE (latency_merge (LATENCY_RBT_GET, &histogram));
+  ASSERT_EQ (histogram.count, SAMPLES_COUNT);
+  EXPECT_EQ (histogram.maxTicks, SAMPLES_COUNT);
+  EXPECT_GT (histogram.ticksPerNs, 0.0);
+
+  for (double quantile : { 0.5, 0.99, 0.999 })
+  {
+    double expected = ns ((uint64_t)(quantile * SAMPLES_COUNT));
+    double actual = (double)latency_percentile (&histogram, quantile);
+
+    EXPECT_GE (actual, expected * 0.99) << quantile;
+    EXPECT_LE (actual, expected * 1.07 + 1) << quantile;
+  }
+
+  // the maximum is exact, small values have own buckets
+  EXPECT_NEAR ((double)latency_percentile (&histogram, 1.0), ns (SAMPLES_COUNT), 1.0);
+
+  latency_reset ();
+  latency_record (LATENCY_RBT_GET, 7);
+  latency_record (LATENCY_RBT_GET, 1ULL << 50);    // beyond the last bucket
+
+  ASSERT_TRUE (latency_merge (LATENCY_RBT_GET, &histogram));
+  EXPECT_EQ (histogram.count, 2u);
+  EXPECT_NEAR ((double)latency_percentile (&histogram, 0.5), ns (7), 1.0);
+  EXPECT_NEAR ((double)latency_percentile (&histogram, 1.0), ns (1ULL << 50),
+               ns (1ULL << 50) * 0.01);
+
+  // other ops are apart
+  ASSERT_TRUE (latency_merge (LATENCY_RBT_INSERT, &histogram));
+  EXPECT_EQ (histogram.count, 0u);
+  EXPECT_EQ (latency_percentile (&histogram, 0.5), 0u);
+
+  EXPECT_FALSE (latency_merge (LATENCY_OPS_COUNT, &histogram));
+  EXPECT_FALSE (latency_merge (LATENCY_RBT_GET, NULL));
+  EXPECT_EQ (latency_op_name (LATENCY_OPS_COUNT), nullptr);
+}
+
+TEST_F (LatencyTestClass, LatencyThreadsTest)
+{
+  // histograms of exited threads are merged, their records are reused by new threads
+
+  const unsigned int THREADS_COUNT = 8;
+  const uint64_t SAMPLES_PER_THREAD = 10000;
+
+  for (int round = 0; round < 2; ++round)
+  {
+    std::vector<std::thread> threads;
+
+    for (unsigned int id = 0; id < THREADS_COUNT; ++id)
+    {
+      threads.push_back (std::thread ([id] {
+        for (uint64_t i = 0; i < SAMPLES_PER_THREAD; ++i)
+        {
+          latency_record (LATENCY_QUEUE_PUSH, 100 * (id + 1));
+        }
+      }));
+    }
+
+    for (auto& thread : threads)
+    {
+      thread.join ();
+    }
+  }
+
+  ASSERT_TRUE (latency_merge (LATENCY_QUEUE_PUSH, &histogram));
+  EXPECT_EQ (histogram.count, 2 * THREADS_COUNT * SAMPLES_PER_THREAD);
+  EXPECT_EQ (histogram.maxTicks, 100u * THREADS_COUNT);
+}
+
+TEST_F (LatencyTestClass, LatencyDumpTest)
+{
+  latency_record (LATENCY_QUEUE_POP, 1000);
+
+  FILE* pFile = tmpfile ();
+  ASSERT_NE (pFile, nullptr);
+  ASSERT_TRUE (latency_dump (pFile));
+
+  rewind (pFile);
+  std::string text;
+  for (int c = fgetc (pFile); c != EOF; c = fgetc (pFile))
+  {
+    text += (char)c;
+  }
+  fclose (pFile);
+
+  // ops without records are skipped
+  EXPECT_NE (text.find ("p999_ns"), std::string::npos);
+  EXPECT_NE (text.find ("queue_pop"), std::string::npos);
+  EXPECT_EQ (text.find ("rbt_insert"), std::string::npos);
+
+  EXPECT_FALSE (latency_dump (NULL));
+}
+
+#ifdef CONTAINERS_LATENCY
+
+TEST_F (LatencyTestClass, LatencyInstrumentationTest)
+{
+  // the containers record own operations
+
+  const int KEYS_COUNT = 1000;
+
+  RBTNode* pRoot = NULL;
+  QueueSafe queue;
+  ASSERT_TRUE (concurrent_queue_init (&queue));
+
+  for (int i = 0; i < KEYS_COUNT; ++i)
+  {
+    std::string key = std::to_string (i);
+    EXPECT_TRUE (rbt_insert (&pRoot, &i, sizeof (i), key.c_str ()));
+    EXPECT_TRUE (concurrent_queue_push (&queue, &i, sizeof (i)));
+  }
+
+  int item = 0;
+  for (int i = 0; i < KEYS_COUNT; ++i)
+  {
+    EXPECT_TRUE (rbt_get (pRoot, &item, sizeof (item), std::to_string (i).c_str ()));
+    EXPECT_TRUE (concurrent_queue_pop (&queue, &item, sizeof (item), 0));
+  }
+
+  for (int op = 0; op < LATENCY_OPS_COUNT; ++op)
+  {
+    ASSERT_TRUE (latency_merge ((LATENCY_OP)op, &histogram));
+    EXPECT_EQ (histogram.count, (uint64_t)KEYS_COUNT) << latency_op_name ((LATENCY_OP)op);
+    EXPECT_LE (latency_percentile (&histogram, 0.5), latency_percentile (&histogram, 0.999));
+  }
+
+  concurrent_queue_destroy (&queue);
+  rbt_destroy (&pRoot);
+}
+
+#endif
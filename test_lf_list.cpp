@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/lf_list.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct TestStruct
+{
+  int mem0, mem1, mem2;
+
+  bool operator== (const TestStruct& other) const
+  {
+    return mem0 == other.mem0 && mem1 == other.mem1 && mem2 == other.mem2;
+  }
+};
+
+static bool collectKeys (const char* key, const void*, size_t, void* pContext)
+{
+  static_cast<std::vector<std::string>*> (pContext)->push_back (key);
+  return true;
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class LFListTestClass : public ::testing::Test
+{
+public:
+  LFList list;
+
+  void SetUp () override { ASSERT_TRUE (lfl_init (&list)); }
+  void TearDown () override { lfl_destroy (&list); }
+
+  std::vector<std::string> keys ()
+  {
+    std::vector<std::string> keys;
+    EXPECT_TRUE (lfl_for_each (&list, collectKeys, &keys));
+    return keys;
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (LFListTestClass, LFLRegularTest)
+{
+  // lfl_insert, lfl_get, lfl_delete, lfl_for_each against std::map
+
+  const int LFL_NODES_COUNT = 3000;
+
+  std::mt19937 generator (42);
+  std::map<std::string, TestStruct> expected;
+
+  for (auto i = 0; i < LFL_NODES_COUNT; ++i)
+  {
+    char key[64] = { 0 };
+    snprintf (key, sizeof (key), (i % 2) ? "%x" : "long-key-%08x-%08x", generator () % 3000, i);
+    TestStruct item = { i, i + 1, i + 2 };
+
+    bool isNew = expected.emplace (key, item).second;
+    EXPECT_EQ (lfl_insert (&list, &item, sizeof (item), key), isNew);
+
+    if (i % 4 == 0)
+    {
+      snprintf (key, sizeof (key), "%x", generator () % 3000);
+      EXPECT_EQ (lfl_delete (&list, key), expected.erase (key) == 1);
+    }
+  }
+
+  ASSERT_EQ (lfl_count (&list), expected.size ());
+
+  for (const auto& it : expected)
+  {
+    TestStruct actual = { 0, 0, 0 };
+    ASSERT_TRUE (lfl_get (&list, &actual, sizeof (actual), it.first.c_str ()));
+    EXPECT_EQ (actual, it.second);
+    EXPECT_FALSE (lfl_get (&list, &actual, sizeof (actual) - 1, it.first.c_str ()));
+  }
+
+  TestStruct item = { 0, 0, 0 };
+  EXPECT_FALSE (lfl_get (&list, &item, sizeof (item), "absent"));
+  EXPECT_FALSE (lfl_delete (&list, "absent"));
+  EXPECT_FALSE (lfl_insert (&list, NULL, 0, "null"));
+  EXPECT_FALSE (lfl_insert (&list, &item, sizeof (item), NULL));
+  EXPECT_FALSE (lfl_insert (&list, &item, sizeof (item), std::string (LFL_KEY_SIZE, 'k').c_str ()));
+  EXPECT_FALSE (lfl_for_each (&list, NULL, NULL));
+
+  // sorted traversal
+  auto actualKeys = keys ();
+  ASSERT_EQ (actualKeys.size (), expected.size ());
+  EXPECT_TRUE (std::equal (actualKeys.begin (), actualKeys.end (), expected.begin (),
+                           [] (const std::string& key, const auto& it) { return key == it.first; }));
+
+  // the deleted key may be inserted again
+  const std::string key = expected.begin ()->first;
+  EXPECT_TRUE (lfl_delete (&list, key.c_str ()));
+  EXPECT_TRUE (lfl_insert (&list, &item, sizeof (item), key.c_str ()));
+  EXPECT_EQ (lfl_count (&list), expected.size ());
+}
+
+TEST_F (LFListTestClass, LFLConcurrentTest)
+{
+  // writers insert and delete own and shared keys, a reader traverses meanwhile
+
+  const unsigned int THREADS_COUNT = 8;
+  const int KEYS_PER_THREAD = 1000;
+
+  std::atomic<int> sharedInserted (0);
+  std::atomic<int> sharedDeleted (0);
+  std::atomic<bool> isDone (false);
+  std::vector<std::thread> threads;
+
+  for (unsigned int id = 0; id < THREADS_COUNT; ++id)
+  {
+    threads.push_back (std::thread ([&, id] {
+      TestStruct item = { (int)id, 0, 0 };
+
+      for (auto i = 0; i < KEYS_PER_THREAD; ++i)
+      {
+        std::string own = "own:" + std::to_string (id) + ":" + std::to_string (i);
+        std::string shared = "shared:" + std::to_string (i);
+
+        EXPECT_TRUE (lfl_insert (&list, &item, sizeof (item), own.c_str ()));
+        sharedInserted += lfl_insert (&list, &item, sizeof (item), shared.c_str ());
+
+        // every odd own key is deleted right away, shared keys are deleted by anyone
+        if (i % 2)
+        {
+          EXPECT_TRUE (lfl_delete (&list, own.c_str ()));
+          sharedDeleted += lfl_delete (&list, shared.c_str ());
+        }
+      }
+    }));
+  }
+
+  std::thread reader ([&] {
+    while (!isDone)
+    {
+      std::vector<std::string> keys;
+      lfl_for_each (&list, collectKeys, &keys);
+      EXPECT_TRUE (std::is_sorted (keys.begin (), keys.end ()));
+      EXPECT_TRUE (std::adjacent_find (keys.begin (), keys.end ()) == keys.end ());
+    }
+  });
+
+  for (auto& thread : threads)
+  {
+    thread.join ();
+  }
+  isDone = true;
+  reader.join ();
+
+  EXPECT_EQ (lfl_count (&list),
+             THREADS_COUNT * KEYS_PER_THREAD / 2 + sharedInserted - sharedDeleted);
+  EXPECT_EQ (keys ().size (), lfl_count (&list));
+
+  TestStruct item;
+  for (unsigned int id = 0; id < THREADS_COUNT; ++id)
+  {
+    for (auto i = 0; i < KEYS_PER_THREAD; ++i)
+    {
+      std::string own = "own:" + std::to_string (id) + ":" + std::to_string (i);
+      ASSERT_EQ (lfl_get (&list, &item, sizeof (item), own.c_str ()), i % 2 == 0);
+    }
+  }
+}
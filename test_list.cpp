@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <list>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/list.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct TestNode
+{
+  int value;
+  List listItem;    // one list at a time
+  List otherItem;    // the same node in another list
+};
+
+static std::vector<int> values (List* pHead)
+{
+  std::vector<int> result;
+  TestNode* pNode = NULL;
+
+  LIST_FOR_EACH_ENTRY (pNode, pHead, TestNode, listItem)
+  {
+    result.push_back (pNode->value);
+  }
+
+  return result;
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class ListTestClass : public ::testing::Test
+{
+public:
+  List head;
+  std::vector<TestNode> nodes;
+
+  void SetUp () override
+  {
+    list_init (&head);
+
+    nodes.resize (10);
+    for (size_t i = 0; i < nodes.size (); ++i)
+    {
+      nodes[i].value = (int)i;
+      list_init (&nodes[i].listItem);
+      list_init (&nodes[i].otherItem);
+    }
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (ListTestClass, ListRegularTest)
+{
+  // list_add, list_add_tail, list_del, list_replace, list_first, list_last, iteration
+
+  EXPECT_TRUE (list_is_empty (&head));
+  EXPECT_FALSE (list_is_singular (&head));
+  EXPECT_TRUE (list_first (&head) == NULL);
+  EXPECT_TRUE (list_last (&head) == NULL);
+
+  list_add_tail (&head, &nodes[1].listItem);
+  EXPECT_TRUE (list_is_singular (&head));
+  list_add_tail (&head, &nodes[2].listItem);
+  list_add (&head, &nodes[0].listItem);
+  EXPECT_EQ (values (&head), std::vector<int> ({ 0, 1, 2 }));
+  EXPECT_EQ (list_count (&head), 3u);
+
+  EXPECT_EQ (GET_NODE (list_first (&head), TestNode, listItem), &nodes[0]);
+  EXPECT_EQ (GET_NODE (list_last (&head), TestNode, listItem), &nodes[2]);
+
+  std::vector<int> reversed;
+  List* pItem = NULL;
+  LIST_FOR_EACH_REVERSE (pItem, &head)
+  {
+    reversed.push_back (GET_NODE (pItem, TestNode, listItem)->value);
+  }
+  EXPECT_EQ (reversed, std::vector<int> ({ 2, 1, 0 }));
+
+  // deleted item is an empty list : double deletion is harmless
+  list_del (&nodes[1].listItem);
+  list_del (&nodes[1].listItem);
+  EXPECT_TRUE (list_is_empty (&nodes[1].listItem));
+  EXPECT_EQ (values (&head), std::vector<int> ({ 0, 2 }));
+
+  list_replace (&nodes[2].listItem, &nodes[5].listItem);
+  EXPECT_EQ (values (&head), std::vector<int> ({ 0, 5 }));
+  EXPECT_TRUE (list_is_empty (&nodes[2].listItem));
+
+  // the same node in two lists at once
+  List other = LIST_HEAD_INIT (other);
+  list_add_tail (&other, &nodes[5].otherItem);
+  EXPECT_EQ (GET_NODE (list_first (&other), TestNode, otherItem), &nodes[5]);
+  EXPECT_EQ (values (&head), std::vector<int> ({ 0, 5 }));
+}
+
+TEST_F (ListTestClass, ListMoveSpliceTest)
+{
+  // list_move, list_move_tail, list_splice, list_splice_tail, safe iteration
+
+  List other;
+  list_init (&other);
+
+  for (auto i = 0; i < 5; ++i)
+  {
+    list_add_tail (&head, &nodes[i].listItem);
+    list_add_tail (&other, &nodes[i + 5].listItem);
+  }
+
+  list_move (&head, &nodes[4].listItem);
+  list_move_tail (&head, &nodes[0].listItem);
+  EXPECT_EQ (values (&head), std::vector<int> ({ 4, 1, 2, 3, 0 }));
+
+  list_move_tail (&head, &nodes[7].listItem);    // from another list
+  EXPECT_EQ (values (&head), std::vector<int> ({ 4, 1, 2, 3, 0, 7 }));
+  EXPECT_EQ (values (&other), std::vector<int> ({ 5, 6, 8, 9 }));
+
+  list_splice (&head, &other);
+  EXPECT_TRUE (list_is_empty (&other));
+  EXPECT_EQ (values (&head), std::vector<int> ({ 5, 6, 8, 9, 4, 1, 2, 3, 0, 7 }));
+
+  // odd values go to another list while iterating
+  TestNode* pNode = NULL;
+  TestNode* pTemp = NULL;
+  LIST_FOR_EACH_ENTRY_SAFE (pNode, pTemp, &head, TestNode, listItem)
+  {
+    if (pNode->value % 2)
+    {
+      list_move_tail (&other, &pNode->listItem);
+    }
+  }
+  EXPECT_EQ (values (&head), std::vector<int> ({ 6, 8, 4, 2, 0 }));
+  EXPECT_EQ (values (&other), std::vector<int> ({ 5, 9, 1, 3, 7 }));
+
+  list_splice_tail (&head, &other);
+  EXPECT_EQ (values (&head), std::vector<int> ({ 6, 8, 4, 2, 0, 5, 9, 1, 3, 7 }));
+
+  list_splice (&head, &other);    // empty
+  EXPECT_EQ (list_count (&head), 10u);
+
+  List* pItem = NULL;
+  List* pNext = NULL;
+  LIST_FOR_EACH_SAFE (pItem, pNext, &head)
+  {
+    list_del (pItem);
+  }
+  EXPECT_TRUE (list_is_empty (&head));
+}
+
+TEST_F (ListTestClass, ListFifoTest)
+{
+  // the intrusive list as a FIFO : the same order as std::list, nodes are reusable after pop
+
+  const int ITEMS_COUNT = 100000;
+
+  std::vector<TestNode> items (ITEMS_COUNT);
+  std::list<TestNode*> expected;
+
+  for (auto round = 0; round < 2; ++round)
+  {
+    for (auto i = 0; i < ITEMS_COUNT; ++i)
+    {
+      items[i].value = i;
+      list_add_tail (&head, &items[i].listItem);
+      expected.push_back (&items[i]);
+    }
+    ASSERT_EQ (list_count (&head), (size_t)ITEMS_COUNT);
+
+    while (!list_is_empty (&head))
+    {
+      List* pItem = list_first (&head);
+      ASSERT_EQ (GET_NODE (pItem, TestNode, listItem), expected.front ());
+      list_del (pItem);
+      expected.pop_front ();
+
+      ASSERT_TRUE (list_is_empty (pItem));    // left as an empty list
+    }
+    EXPECT_TRUE (expected.empty ());
+  }
+}
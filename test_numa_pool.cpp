@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/numa_pool.h"
+#include "include/c/queue.h"
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class NumaPoolTestClass : public ::testing::Test
+{
+public:
+  NumaPool* pPool = NULL;
+
+  void SetUp () override
+  {
+    pPool = numa_pool_create (-1);
+    ASSERT_NE (pPool, nullptr);
+  }
+
+  void TearDown () override
+  {
+    numa_pool_release (pPool);
+  }
+
+  void* poolAlloc (size_t size)
+  {
+    return pPool->allocator.alloc (size, pPool->allocator.pContext);
+  }
+
+  void poolFree (void* pMemory, size_t size)
+  {
+    pPool->allocator.free (pMemory, size, pPool->allocator.pContext);
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST (NumaTest, NodesTest)
+{
+  // without NUMA support everything is on node 0
+
+  int nodesCount = numa_nodes_count ();
+  ASSERT_GE (nodesCount, 1);
+
+  int node = numa_current_node ();
+  EXPECT_GE (node, 0);
+  EXPECT_LT (node, nodesCount);
+
+  if (!numa_is_available ())
+  {
+    EXPECT_EQ (nodesCount, 1);
+  }
+
+  EXPECT_EQ (numa_pool_create (nodesCount), nullptr);
+
+  NumaPool* pPool = numa_pool_create (nodesCount - 1);
+  ASSERT_NE (pPool, nullptr);
+  EXPECT_EQ (pPool->node, nodesCount - 1);
+  numa_pool_release (pPool);
+}
+
+TEST_F (NumaPoolTestClass, AllocTest)
+{
+  const size_t SIZES[] = { 1, 16, 17, 100, 1000, 4096, 4097, 3 * NUMA_POOL_BLOCK_SIZE };
+
+  std::vector<std::pair<char*, size_t>> chunks;
+
+  for (size_t size : SIZES)
+  {
+    char* pChunk = (char*)poolAlloc (size);
+    ASSERT_NE (pChunk, nullptr);
+    EXPECT_EQ ((uintptr_t)pChunk % alignof (max_align_t), 0u);
+
+    memset (pChunk, (int)size, size);
+    chunks.push_back ({ pChunk, size });
+  }
+
+  // no overlap : every chunk keeps its pattern
+  for (const auto& chunk : chunks)
+  {
+    EXPECT_EQ (chunk.first[0], (char)chunk.second);
+    EXPECT_EQ (chunk.first[chunk.second - 1], (char)chunk.second);
+  }
+
+  for (const auto& chunk : chunks)
+  {
+    poolFree (chunk.first, chunk.second);
+  }
+
+  // a freed chunk is reused by the next allocation of its size class
+  void* pChunk = poolAlloc (100);
+  poolFree (pChunk, 100);
+  EXPECT_EQ (poolAlloc (128), pChunk);
+  poolFree (pChunk, 128);
+}
+
+TEST_F (NumaPoolTestClass, GrowTest)
+{
+  // more than a block of chunks : the pool takes new blocks of the node
+
+  const size_t CHUNK_SIZE = 4096;
+  const size_t CHUNKS_COUNT = 3 * NUMA_POOL_BLOCK_SIZE / CHUNK_SIZE;
+
+  std::set<void*> chunks;
+  for (size_t i = 0; i < CHUNKS_COUNT; ++i)
+  {
+    void* pChunk = poolAlloc (CHUNK_SIZE);
+    ASSERT_NE (pChunk, nullptr);
+    chunks.insert (pChunk);
+  }
+  EXPECT_EQ (chunks.size (), CHUNKS_COUNT);
+
+  for (void* pChunk : chunks)
+  {
+    poolFree (pChunk, CHUNK_SIZE);
+  }
+}
+
+TEST_F (NumaPoolTestClass, QueueTest)
+{
+  // the pool under a concurrent queue, the heap counts what it holds
+
+  const int ITEMS_COUNT = 10000;
+
+  QueueSafe queue;
+  ASSERT_TRUE (concurrent_queue_init_allocator (&queue, &pPool->allocator));
+
+  std::thread producer ([&] {
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      EXPECT_TRUE (concurrent_queue_push (&queue, &i, sizeof (i)));
+    }
+  });
+
+  for (int i = 0; i < ITEMS_COUNT; ++i)
+  {
+    int actual = -1;
+    ASSERT_TRUE (concurrent_queue_pop (&queue, &actual, sizeof (actual), 1000));
+    EXPECT_EQ (actual, i);
+  }
+
+  producer.join ();
+  EXPECT_EQ (heap_allocations (&queue.queue.heap), 0u);
+
+  concurrent_queue_destroy (&queue);
+}
+
+TEST (NumaQueueTest, ShardsTest)
+{
+  // more shards than nodes : a remote shard is what a single node machine has
+
+  QueueNuma queue;
+
+  EXPECT_FALSE (numa_queue_init (&queue, -1));
+
+  ASSERT_TRUE (numa_queue_init (&queue, 0));
+  EXPECT_EQ (queue.shardsCount, numa_nodes_count ());
+  numa_queue_destroy (&queue);
+
+  ASSERT_TRUE (numa_queue_init (&queue, 4));
+  ASSERT_EQ (queue.shardsCount, 4);
+
+  for (int i = 0; i < queue.shardsCount; ++i)
+  {
+    EXPECT_EQ (queue.pools[i]->node, i % numa_nodes_count ());
+  }
+
+  int item = 0;
+  EXPECT_FALSE (numa_queue_push_to (&queue, 4, &item, sizeof (item)));
+  EXPECT_FALSE (numa_queue_pop (&queue, &item, sizeof (item), 0));
+
+  // the local shard first, then the other ones in their order
+  int local = numa_current_node () % queue.shardsCount;
+  int remote = (local + 1) % queue.shardsCount;
+
+  item = 1;
+  EXPECT_TRUE (numa_queue_push_to (&queue, remote, &item, sizeof (item)));
+  item = 2;
+  EXPECT_TRUE (numa_queue_push (&queue, &item, sizeof (item)));
+  EXPECT_EQ (heap_allocations (&queue.shards[local]->queue.heap), 2u);
+
+  EXPECT_TRUE (numa_queue_pop (&queue, &item, sizeof (item), 0));
+  EXPECT_EQ (item, 2);
+  EXPECT_TRUE (numa_queue_pop (&queue, &item, sizeof (item), 0));
+  EXPECT_EQ (item, 1);
+  EXPECT_FALSE (numa_queue_pop (&queue, &item, sizeof (item), 0));
+
+  // items left in the shards are released with them
+  EXPECT_TRUE (numa_queue_push_to (&queue, 3, &item, sizeof (item)));
+  numa_queue_destroy (&queue);
+  EXPECT_EQ (queue.shardsCount, 0);
+}
+
+TEST (NumaQueueTest, ConcurrentTest)
+{
+  // producers spread over the shards, every item is delivered once
+
+  const int PRODUCERS_COUNT = 4;
+  const int CONSUMERS_COUNT = 4;
+  const int ITEMS_COUNT = 10000;
+
+  QueueNuma queue;
+  ASSERT_TRUE (numa_queue_init (&queue, PRODUCERS_COUNT));
+
+  std::vector<std::atomic<int>> delivered (PRODUCERS_COUNT * ITEMS_COUNT);
+  std::atomic<int> deliveredCount (0);
+  std::vector<std::thread> threads;
+
+  for (int p = 0; p < PRODUCERS_COUNT; ++p)
+  {
+    threads.emplace_back ([&, p] {
+      for (int i = 0; i < ITEMS_COUNT; ++i)
+      {
+        int item = p * ITEMS_COUNT + i;
+        EXPECT_TRUE (numa_queue_push_to (&queue, p, &item, sizeof (item)));
+      }
+    });
+  }
+
+  for (int c = 0; c < CONSUMERS_COUNT; ++c)
+  {
+    threads.emplace_back ([&] {
+      int item = -1;
+
+      while (deliveredCount.load () < PRODUCERS_COUNT * ITEMS_COUNT)
+      {
+        if (numa_queue_pop (&queue, &item, sizeof (item), 10))
+        {
+          delivered[item].fetch_add (1);
+          deliveredCount.fetch_add (1);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join ();
+  }
+
+  for (const auto& count : delivered)
+  {
+    EXPECT_EQ (count.load (), 1);
+  }
+
+  numa_queue_destroy (&queue);
+}
@@ -1,12 +1,15 @@
 #include <gtest/gtest.h>
+#include <chrono>
 #include <iostream>
 #include <list>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 extern "C"
 {
 #include "include/c/queue.h"
+#include "include/c/rb_tree_intrusive.h"
 }
 
 class containers_tests : public ::testing::Test
@@ -213,6 +216,257 @@ TEST_F (containers_tests, concurrent_queue_prod_cons_test)
   EXPECT_TRUE (queue.queue.head == NULL);
 }
 
+TEST_F (containers_tests, intrusive_queue_regular_test)
+{
+  struct Object
+  {
+    TestStruct item;
+    QueueLink link;
+  };
+
+  QueueIntrusive queue = { 0 };
+
+  auto result = intrusive_queue_init (&queue);
+  EXPECT_TRUE (result);
+  EXPECT_TRUE (intrusive_queue_pop (&queue) == NULL);
+  EXPECT_TRUE (intrusive_queue_peek (&queue) == NULL);
+  EXPECT_FALSE (intrusive_queue_push (&queue, NULL));
+
+  std::vector<Object> objects (TEST_ITEMS_COUNT);
+  for (auto i = 0; i < TEST_ITEMS_COUNT; ++i)
+  {
+    objects[i].item = { i, i + 1, i + 2 };
+    result = intrusive_queue_push (&queue, &objects[i].link);
+    EXPECT_TRUE (result);
+  }
+
+  EXPECT_EQ (intrusive_queue_peek (&queue), &objects[0].link);
+
+  for (auto i = 0; i < TEST_ITEMS_COUNT; ++i)
+  {
+    TestStruct expectedItem = { i, i + 1, i + 2 };
+
+    // the same object comes back : nothing was copied
+    QueueLink* pLink = intrusive_queue_pop (&queue);
+    ASSERT_EQ (pLink, &objects[i].link);
+    EXPECT_TRUE (expectedItem == GET_NODE (pLink, Object, link)->item);
+  }
+
+  EXPECT_TRUE (queue.head == NULL);
+  EXPECT_TRUE (queue.tail == NULL);
+}
+
+TEST_F (containers_tests, intrusive_queue_and_tree_test)
+{
+  // one object is queued and indexed at the same time : the queue gives the order,
+  // the tree finds the object by key and removes it, both without allocation
+
+  struct Object
+  {
+    uint64_t key;
+    QueueLink queueLink;
+    RBTLink treeLink;
+  };
+
+  auto compare = [] (const RBTLink* pLink, const void* key) {
+    uint64_t nodeKey = GET_NODE (pLink, Object, treeLink)->key;
+    uint64_t searchedKey = *(const uint64_t*)key;
+    return (nodeKey > searchedKey) - (nodeKey < searchedKey);
+  };
+
+  QueueIntrusive queue = { 0 };
+  RBTIntrusive tree;
+  ASSERT_TRUE (intrusive_queue_init (&queue));
+  ASSERT_TRUE (rbt_intrusive_init (&tree, compare));
+
+  std::vector<Object> objects (TEST_ITEMS_COUNT);
+  for (auto i = 0; i < TEST_ITEMS_COUNT; ++i)
+  {
+    objects[i] = { (uint64_t)(TEST_ITEMS_COUNT - i), { NULL }, { BLACK, NULL, NULL, NULL } };
+    ASSERT_TRUE (intrusive_queue_push (&queue, &objects[i].queueLink));
+    ASSERT_TRUE (rbt_intrusive_insert (&tree, &objects[i].treeLink, &objects[i].key));
+  }
+
+  // the tree sees objects in key order, the queue in push order
+  EXPECT_EQ (GET_NODE (rbt_intrusive_first (&tree), Object, treeLink), &objects.back ());
+  EXPECT_EQ (GET_NODE (intrusive_queue_peek (&queue), Object, queueLink), &objects.front ());
+
+  for (auto i = 0; i < TEST_ITEMS_COUNT; ++i)
+  {
+    Object* pObject = GET_NODE (intrusive_queue_pop (&queue), Object, queueLink);
+    ASSERT_EQ (rbt_intrusive_find (&tree, &pObject->key), &pObject->treeLink);
+
+    rbt_intrusive_remove (&tree, &pObject->treeLink);
+  }
+
+  EXPECT_TRUE (intrusive_queue_pop (&queue) == NULL);
+  EXPECT_TRUE (rbt_intrusive_first (&tree) == NULL);
+}
+
+TEST_F (containers_tests, concurrent_intrusive_queue_prod_cons_test)
+{
+  const size_t PRODUCERS_COUNT = 3;
+  const size_t CONSUMERS_COUNT = 3;
+  unsigned int waitAsyncTimeoutMs = 100;
+
+  struct Object
+  {
+    int producerId;
+    QueueLink link;
+  };
+
+  QueueIntrusiveSafe queue;
+  ASSERT_TRUE (concurrent_intrusive_queue_init (&queue));
+
+  std::vector<std::vector<Object>> objects (PRODUCERS_COUNT,
+                                            std::vector<Object> (TEST_ITEMS_COUNT));
+  std::vector<int> received (PRODUCERS_COUNT, 0);
+  std::mutex receivedMutex;
+
+  std::list<std::thread> producers;
+  for (size_t id = 0; id < PRODUCERS_COUNT; id++)
+  {
+    producers.push_back (std::thread ([&, id] {
+      for (auto& object : objects[id])
+      {
+        object.producerId = (int)id;
+        EXPECT_TRUE (concurrent_intrusive_queue_push (&queue, &object.link));
+      }
+    }));
+  }
+
+  std::list<std::thread> consumers;
+  for (size_t id = 0; id < CONSUMERS_COUNT; id++)
+  {
+    consumers.push_back (std::thread ([&] {
+      QueueLink* pLink = NULL;
+      while ((pLink = concurrent_intrusive_queue_pop (&queue, waitAsyncTimeoutMs)) != NULL)
+      {
+        std::lock_guard<std::mutex> lock (receivedMutex);
+        ++received[GET_NODE (pLink, Object, link)->producerId];
+      }
+    }));
+  }
+
+  for (auto& thread : producers)
+  {
+    thread.join ();
+  }
+  for (auto& thread : consumers)
+  {
+    thread.join ();
+  }
+
+  for (auto count : received)
+  {
+    EXPECT_EQ (count, TEST_ITEMS_COUNT);
+  }
+
+  concurrent_intrusive_queue_destroy (&queue);
+  EXPECT_TRUE (queue.queue.head == NULL);
+  EXPECT_TRUE (queue.queue.tail == NULL);
+}
+
+TEST_F (containers_tests, queue_trace_test)
+{
+  // sojourn of the traced items : pushed, waited for, popped
+
+  const auto SOJOURN = std::chrono::milliseconds (2);
+
+  Queue queue = { 0 };
+  ASSERT_TRUE (queue_init (&queue));
+
+  QueueTrace trace;
+  EXPECT_FALSE (queue_trace_get (&queue, &trace));
+
+  TestStruct item = { 0, 1, 2 };
+  EXPECT_TRUE (queue_push (&queue, &item, sizeof (TestStruct)));    // not traced
+
+  ASSERT_TRUE (queue_trace_enable (&queue));
+  for (auto i = 0; i < TEST_ITEMS_COUNT; ++i)
+  {
+    EXPECT_TRUE (queue_push (&queue, &item, sizeof (TestStruct)));
+  }
+
+  std::this_thread::sleep_for (SOJOURN);
+
+  // the size mismatch doesn't count
+  EXPECT_FALSE (queue_pop (&queue, &item, sizeof (TestStruct) - 1));
+
+  while (queue_pop (&queue, &item, sizeof (TestStruct)))
+  {
+  }
+
+  ASSERT_TRUE (queue_trace_get (&queue, &trace));
+  EXPECT_EQ (trace.sojourn.count, (uint64_t)TEST_ITEMS_COUNT);
+  EXPECT_GE (latency_percentile (&trace.sojourn, 0.5),
+             (uint64_t)std::chrono::nanoseconds (SOJOURN).count () * 9 / 10);
+  EXPECT_EQ (trace.droppedCount + trace.markedCount + trace.overTargetCount, 0u);
+
+  EXPECT_FALSE (queue_codel_set (&queue, QUEUE_CODEL_DROP, 0, 1000));
+  EXPECT_FALSE (queue_codel_set (&queue, (QUEUE_CODEL)(QUEUE_CODEL_DROP + 1), 1000, 1000));
+
+  queue_destroy (&queue);
+  EXPECT_TRUE (queue.pTrace == NULL);
+}
+
+TEST_F (containers_tests, concurrent_queue_codel_test)
+{
+  // a standing queue : the consumer is as fast as the producer, but 20 items behind
+
+  const int BACKLOG = 20;
+  const int STEPS_COUNT = 100;
+
+  for (auto codel : { QUEUE_CODEL_MARK, QUEUE_CODEL_DROP })
+  {
+    QueueSafe queue;
+    ASSERT_TRUE (concurrent_queue_init (&queue));
+    ASSERT_TRUE (concurrent_queue_codel_set (&queue, codel, 1000000, 10000000));    // 1, 10 ms
+
+    int pushed = 0;
+    int popped = 0;
+
+    for (; pushed < BACKLOG; ++pushed)
+    {
+      EXPECT_TRUE (concurrent_queue_push (&queue, &pushed, sizeof (pushed)));
+    }
+
+    for (auto i = 0; i < STEPS_COUNT; ++i, ++pushed)
+    {
+      EXPECT_TRUE (concurrent_queue_push (&queue, &pushed, sizeof (pushed)));
+      std::this_thread::sleep_for (std::chrono::milliseconds (1));
+
+      int value = -1;
+      if (concurrent_queue_pop (&queue, &value, sizeof (value), 0))
+      {
+        EXPECT_GT (value, popped - 1);    // in order, some may be dropped
+        popped = value + 1;
+      }
+    }
+
+    QueueTrace trace;
+    ASSERT_TRUE (concurrent_queue_trace_get (&queue, &trace));
+
+    EXPECT_GT (trace.overTargetCount, 0u);
+
+    if (codel == QUEUE_CODEL_MARK)
+    {
+      EXPECT_GT (trace.markedCount, 0u);
+      EXPECT_EQ (trace.droppedCount, 0u);
+      EXPECT_EQ (popped, STEPS_COUNT);
+    }
+    else
+    {
+      // the backlog is dropped : the queue keeps up
+      EXPECT_GT (trace.droppedCount, 0u);
+      EXPECT_EQ (trace.markedCount, 0u);
+      EXPECT_GT (popped, STEPS_COUNT);
+    }
+
+    concurrent_queue_destroy (&queue);
+  }
+}
+
 int main (int argc, char* argv[])
 {
   ::testing::InitGoogleTest (&argc, argv);
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <random>
 #include <string>
 #include <queue>
+#include <set>
 #include <vector>
 #include <fstream>
 #include <utility>
@@ -8,6 +13,8 @@
 extern "C"
 {
 #include "include/c/rb_tree.h"
+#include "include/c/rb_tree_intrusive.h"
+#include "include/c/rb_tree_typed.h"
 }
 
 
@@ -32,6 +39,38 @@ struct TestStruct
   }
 };
 
+template <typename Node, typename IsNIL>
+int BlackHeight (Node* pNode, IsNIL isNIL)
+{
+  // any tree variant : -1 if red-black rules are broken
+
+  if (isNIL (pNode))
+  {
+    return 1;
+  }
+
+  if (pNode->color == RED && (pNode->left->color == RED || pNode->right->color == RED))
+  {
+    return -1;
+  }
+
+  if ((!isNIL (pNode->left) && pNode->left->parent != pNode)
+      || (!isNIL (pNode->right) && pNode->right->parent != pNode))
+  {
+    return -1;
+  }
+
+  int left = BlackHeight (pNode->left, isNIL);
+  int right = BlackHeight (pNode->right, isNIL);
+
+  if (left < 0 || left != right)
+  {
+    return -1;
+  }
+
+  return left + ((pNode->color == BLACK) ? 1 : 0);
+}
+
 /************************************************************************
  *                             CLASS    	                            *
  ************************************************************************/
@@ -65,6 +104,42 @@ class RBTreeTestClass : public ::testing::Test
     }
   }
 
+  bool IsRedRuleKept (RBTNode* pNode)
+  {
+    // RED node has only BLACK children, parent pointers are consistent
+
+    if (is_NIL_same (pNode))
+    {
+      return true;
+    }
+
+    if (pNode->color == RED && (pNode->left->color == RED || pNode->right->color == RED))
+    {
+      return false;
+    }
+
+    if ((!is_NIL_same (pNode->left) && pNode->left->parent != pNode)
+        || (!is_NIL_same (pNode->right) && pNode->right->parent != pNode))
+    {
+      return false;
+    }
+
+    return IsRedRuleKept (pNode->left) && IsRedRuleKept (pNode->right);
+  }
+
+  bool IsSizeKept (RBTNode* pNode)
+  {
+    // subtree sizes used by order statistics
+
+    if (is_NIL_same (pNode))
+    {
+      return pNode->size == 0;
+    }
+
+    return pNode->size == pNode->left->size + pNode->right->size + 1 && IsSizeKept (pNode->left)
+           && IsSizeKept (pNode->right);
+  }
+
   void CountDepth (RBTNode* pNode, int depth)
   {
     // count BLACK depth
@@ -158,17 +233,15 @@ public:
     return result;
   }
 
-  ~RBTreeTestClass () override
+  bool isTreeValid ()
   {
-    if (pRoot != NULL)
-    {
-      if (pRoot->data != NULL)
-      {
-        free (pRoot->data);
-      }
+    return pRoot->color == BLACK && pRoot->parent == NULL && IsRedRuleKept (pRoot)
+           && IsSizeKept (pRoot) && isTreeBalanced ();
+  }
 
-      free (pRoot);
-    }
+  ~RBTreeTestClass () override
+  {
+    rbt_destroy (&pRoot);
   }
 };
 
@@ -241,10 +314,1204 @@ TEST_F (RBTreeTestClass, RBTRegularTest)
   }
 }
 
-TEST_F (RBTreeTestClass, RBTDeletionTest)
+TEST_F (RBTreeTestClass, RBTIterationTest)
 {
-  // rbt_delete
-  // rbt_destroy
+  // rbt_first, rbt_last, rbt_next, rbt_prev
+  // rbt_lower_bound, rbt_upper_bound
+  // rbt_scan_range, rbt_scan_prefix
+
+  bool result;
+  const int keyMaxSize = 10;
+  const int RBT_NODES_COUNT = 1000;
+  std::set<std::string> expectedKeys;
+
+  // empty tree
+  EXPECT_TRUE (rbt_first (pRoot) == NULL);
+  EXPECT_TRUE (rbt_last (pRoot) == NULL);
+  EXPECT_TRUE (rbt_lower_bound (pRoot, "0") == NULL);
+
+  // only even numbers to have gaps between keys
+  for (auto i = 0; i < RBT_NODES_COUNT; i += 2)
+  {
+    TestStruct item = { i, i + 1, i + 2 };
+
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "%i", i);
+
+    result = rbt_insert (&pRoot, &item, sizeof (TestStruct), key);
+    ASSERT_TRUE (result);
+    expectedKeys.insert (key);
+  }
+
+  // forward iteration
+  std::vector<std::string> actualKeys;
+  for (RBTNode* pNode = rbt_first (pRoot); pNode != NULL; pNode = rbt_next (pNode))
+  {
+    actualKeys.push_back (pNode->key);
+  }
+  EXPECT_TRUE (std::equal (actualKeys.begin (), actualKeys.end (), expectedKeys.begin (),
+                           expectedKeys.end ()));
+
+  // backward iteration
+  actualKeys.clear ();
+  for (RBTNode* pNode = rbt_last (pRoot); pNode != NULL; pNode = rbt_prev (pNode))
+  {
+    actualKeys.push_back (pNode->key);
+  }
+  EXPECT_TRUE (std::equal (actualKeys.begin (), actualKeys.end (), expectedKeys.rbegin (),
+                           expectedKeys.rend ()));
+
+  // bounds for existing and missing keys
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "%i", i);
+
+    auto lower = expectedKeys.lower_bound (key);
+    RBTNode* pLower = rbt_lower_bound (pRoot, key);
+    if (lower == expectedKeys.end ())
+    {
+      EXPECT_TRUE (pLower == NULL);
+    }
+    else
+    {
+      ASSERT_TRUE (pLower != NULL);
+      EXPECT_EQ (*lower, pLower->key);
+    }
+
+    auto upper = expectedKeys.upper_bound (key);
+    RBTNode* pUpper = rbt_upper_bound (pRoot, key);
+    if (upper == expectedKeys.end ())
+    {
+      EXPECT_TRUE (pUpper == NULL);
+    }
+    else
+    {
+      ASSERT_TRUE (pUpper != NULL);
+      EXPECT_EQ (*upper, pUpper->key);
+    }
+  }
+
+  auto collect = [] (const RBTNode* pNode, void* pContext) {
+    static_cast<std::vector<std::string>*> (pContext)->push_back (pNode->key);
+    return true;
+  };
+
+  // range scan : [ "3", "5" )
+  actualKeys.clear ();
+  result = rbt_scan_range (pRoot, "3", "5", collect, &actualKeys);
+  EXPECT_TRUE (result);
+  EXPECT_TRUE (std::equal (actualKeys.begin (), actualKeys.end (), expectedKeys.lower_bound ("3"),
+                           expectedKeys.lower_bound ("5")));
+
+  // unbounded range scan visits everything
+  actualKeys.clear ();
+  result = rbt_scan_range (pRoot, NULL, NULL, collect, &actualKeys);
+  EXPECT_TRUE (result);
+  EXPECT_EQ (actualKeys.size (), expectedKeys.size ());
+
+  // early stop
+  int visited = 0;
+  auto stopAtTen = [] (const RBTNode* pNode, void* pContext) {
+    return ++*static_cast<int*> (pContext) < 10;
+  };
+  result = rbt_scan_range (pRoot, NULL, NULL, stopAtTen, &visited);
+  EXPECT_TRUE (result);
+  EXPECT_EQ (visited, 10);
+
+  // prefix scan
+  actualKeys.clear ();
+  result = rbt_scan_prefix (pRoot, "12", collect, &actualKeys);
+  EXPECT_TRUE (result);
+  std::vector<std::string> expectedPrefixed;
+  for (const auto& key : expectedKeys)
+  {
+    if (key.rfind ("12", 0) == 0)
+    {
+      expectedPrefixed.push_back (key);
+    }
+  }
+  EXPECT_EQ (actualKeys, expectedPrefixed);
+
+  rbt_destroy (&pRoot);
+}
+
+TEST_F (RBTreeTestClass, RBTBulkBuildTest)
+{
+  // rbt_build_from_sorted
+
+  bool result;
+  const int keyMaxSize = 10;
+  const int RBT_NODES_COUNT = 10000;
+
+  std::vector<std::string> keysStorage;
+  std::vector<const char*> keys;
+  std::vector<TestStruct> items;
+
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "%08i", i);
+
+    keysStorage.push_back (key);
+    items.push_back ({ i, i + 1, i + 2 });
+  }
+
+  for (const auto& key : keysStorage)
+  {
+    keys.push_back (key.c_str ());
+  }
+
+  // every tree shape up to a few full levels, then the big one
+  std::vector<int> counts;
+  for (auto count = 1; count < 70; ++count)
+  {
+    counts.push_back (count);
+  }
+  counts.push_back (RBT_NODES_COUNT);
+
+  for (auto isContiguous : { false, true })
+  {
+    for (auto count : counts)
+    {
+      result = rbt_build_from_sorted (&pRoot, keys.data (), items.data (), sizeof (TestStruct),
+                                      count, isContiguous);
+      ASSERT_TRUE (result);
+      ASSERT_TRUE (isTreeValid ()) << "nodes count : " << count;
+
+      int index = 0;
+      for (RBTNode* pNode = rbt_first (pRoot); pNode != NULL; pNode = rbt_next (pNode), ++index)
+      {
+        EXPECT_EQ (keysStorage[index], pNode->key);
+      }
+      EXPECT_EQ (index, count);
+
+      for (auto i = 0; i < count; ++i)
+      {
+        TestStruct actual = { 0 };
+
+        result = rbt_get (pRoot, &actual, sizeof (actual), keys[i]);
+        EXPECT_TRUE (result);
+        EXPECT_TRUE (items[i] == actual);
+      }
+
+      // the new key still goes through regular balancing
+      TestStruct item = { 0 };
+      result = rbt_insert (&pRoot, &item, sizeof (item), "a");
+      EXPECT_TRUE (result);
+      EXPECT_TRUE (isTreeValid ());
+
+      rbt_destroy (&pRoot);
+      ASSERT_TRUE (pRoot == NULL);
+    }
+  }
+
+  // unsorted input
+  std::vector<const char*> unsorted = { "1", "3", "2" };
+  result = rbt_build_from_sorted (&pRoot, unsorted.data (), items.data (), sizeof (TestStruct),
+                                  unsorted.size (), false);
+  EXPECT_FALSE (result);
+
+  // duplicated input
+  std::vector<const char*> duplicated = { "1", "2", "2" };
+  result = rbt_build_from_sorted (&pRoot, duplicated.data (), items.data (), sizeof (TestStruct),
+                                  duplicated.size (), false);
+  EXPECT_FALSE (result);
+  EXPECT_TRUE (pRoot == NULL);
+
+  // tree is not empty
+  result = rbt_insert (&pRoot, &items[0], sizeof (TestStruct), "0");
+  ASSERT_TRUE (result);
+  result = rbt_build_from_sorted (&pRoot, keys.data (), items.data (), sizeof (TestStruct), 10,
+                                  false);
+  EXPECT_FALSE (result);
+}
+
+TEST_F (RBTreeTestClass, RBTBulkMergeTest)
+{
+  // rbt_merge_sorted
+
+  bool result;
+  const int keyMaxSize = 10;
+  const int RBT_NODES_COUNT = 10000;
+
+  std::vector<std::string> keysStorage;
+  std::vector<TestStruct> items;
+
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "%08i", i);
+
+    keysStorage.push_back (key);
+    items.push_back ({ i, i + 1, i + 2 });
+  }
+
+  // every third key is in the tree, the others are merged
+  std::vector<const char*> batchKeys;
+  std::vector<TestStruct> batchItems;
+
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    if (i % 3 == 0)
+    {
+      result = rbt_insert (&pRoot, &items[i], sizeof (TestStruct), keysStorage[i].c_str ());
+      ASSERT_TRUE (result);
+    }
+    else
+    {
+      batchKeys.push_back (keysStorage[i].c_str ());
+      batchItems.push_back (items[i]);
+    }
+  }
+
+  // key which already exists : tree stays untouched
+  std::vector<const char*> duplicated = { batchKeys[0], keysStorage[3].c_str () };
+  result = rbt_merge_sorted (&pRoot, duplicated.data (), batchItems.data (), sizeof (TestStruct),
+                             duplicated.size (), 4);
+  EXPECT_FALSE (result);
+  EXPECT_FALSE (rbt_get (pRoot, &batchItems[0], sizeof (TestStruct), batchKeys[0]));
+
+  result = rbt_merge_sorted (&pRoot, batchKeys.data (), batchItems.data (), sizeof (TestStruct),
+                             batchKeys.size (), 4);
+  ASSERT_TRUE (result);
+  ASSERT_TRUE (isTreeValid ());
+
+  int index = 0;
+  for (RBTNode* pNode = rbt_first (pRoot); pNode != NULL; pNode = rbt_next (pNode), ++index)
+  {
+    EXPECT_EQ (keysStorage[index], pNode->key);
+  }
+  EXPECT_EQ (index, RBT_NODES_COUNT);
+
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    TestStruct actual = { 0 };
+
+    result = rbt_get (pRoot, &actual, sizeof (actual), keysStorage[i].c_str ());
+    EXPECT_TRUE (result);
+    EXPECT_TRUE (items[i] == actual);
+  }
+
+  rbt_destroy (&pRoot);
+
+  // merge into empty tree with threads count which isn't power of two
+  result = rbt_merge_sorted (&pRoot, batchKeys.data (), batchItems.data (), sizeof (TestStruct),
+                             batchKeys.size (), 3);
+  ASSERT_TRUE (result);
+  ASSERT_TRUE (isTreeValid ());
+
+  rbt_destroy (&pRoot);
+}
+
+TEST_F (RBTreeTestClass, RBTKeyPrefixTest)
+{
+  // random hex keys differ in the cached prefix : the descent is decided by prefix compares,
+  // url keys share "https://" : every step falls back to the full compare, order is kept
+
+  const int RBT_NODES_COUNT = 20000;
+  const int keyMaxSize = 128;
+
+  std::mt19937 generator (42);
+
+  for (auto family : { "url", "hex" })
+  {
+    std::vector<std::string> keys;
+    bool isHex = (std::string (family) == "hex");
+
+    for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+    {
+      char key[keyMaxSize] = { 0 };
+
+      if (isHex)
+      {
+        snprintf (key, keyMaxSize, "%08x%08x", generator (), generator ());
+      }
+      else
+      {
+        snprintf (key, keyMaxSize, "https://cdn%u.example.com/static/v2/assets/%u/image.png",
+                  generator () % 16, generator ());
+      }
+
+      TestStruct item = { i, i + 1, i + 2 };
+      if (rbt_insert (&pRoot, &item, sizeof (item), key))
+      {
+        keys.push_back (key);
+      }
+    }
+
+    ASSERT_TRUE (isTreeValid ());
+
+    // prefixes are big-endian : their order is the key order
+    for (RBTNode* pNode = rbt_first (pRoot); rbt_next (pNode) != NULL; pNode = rbt_next (pNode))
+    {
+      ASSERT_LT (strcmp (pNode->key, rbt_next (pNode)->key), 0);
+      ASSERT_LE (pNode->keyPrefix, rbt_next (pNode)->keyPrefix);
+    }
+
+    // ancestors on the search path sharing the prefix of the found key need the full compare
+    size_t comparisons = 0;
+    size_t prefixTies = 0;
+
+    for (const auto& key : keys)
+    {
+      TestStruct actual;
+      ASSERT_TRUE (rbt_get (pRoot, &actual, sizeof (actual), key.c_str ()));
+
+      RBTNode* pFound = rbt_lower_bound (pRoot, key.c_str ());
+      ASSERT_TRUE (pFound != NULL);
+      ASSERT_EQ (key, pFound->key);
+
+      for (RBTNode* pNode = pFound->parent; pNode != NULL; pNode = pNode->parent)
+      {
+        ++comparisons;
+        prefixTies += (pNode->keyPrefix == pFound->keyPrefix) ? 1 : 0;
+      }
+    }
+
+    if (isHex)
+    {
+      EXPECT_LT (prefixTies * 100, comparisons);    // over 99% resolved by prefix
+    }
+    else
+    {
+      EXPECT_EQ (prefixTies, comparisons);
+    }
+
+    rbt_destroy (&pRoot);
+  }
+}
+
+TEST (RBTreeTypedTest, RBTU64Test)
+{
+  // rbt_u64_insert, rbt_u64_get, rbt_u64_destroy
+  // rbt_u64_first, rbt_u64_next, rbt_u64_prev, rbt_u64_lower_bound, rbt_u64_upper_bound
+
+  bool result;
+  const uint64_t RBT_NODES_COUNT = 10000;
+  RBTU64Node* pRoot = NULL;
+
+  EXPECT_GE (sizeof (RBTNode) - sizeof (RBTU64Node), 250u);
+
+  // even keys in shuffled order
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    keys.push_back (i * 2);
+  }
+  std::shuffle (keys.begin (), keys.end (), std::mt19937 (42));
+
+  for (auto key : keys)
+  {
+    TestStruct item = { (int)key, (int)key + 1, (int)key + 2 };
 
-  ASSERT_TRUE (true);
-}
\ No newline at end of file
+    result = rbt_u64_insert (&pRoot, &item, sizeof (item), key);
+    ASSERT_TRUE (result);
+  }
+  ASSERT_EQ (pRoot->color, BLACK);
+  ASSERT_GT (BlackHeight (pRoot, is_u64_NIL_same), 0);
+
+  // duplicated key
+  TestStruct item = { 0 };
+  EXPECT_FALSE (rbt_u64_insert (&pRoot, &item, sizeof (item), 0));
+
+  for (uint64_t key = 0; key < RBT_NODES_COUNT * 2; ++key)
+  {
+    TestStruct expected = { (int)key, (int)key + 1, (int)key + 2 };
+    TestStruct actual = { 0 };
+
+    result = rbt_u64_get (pRoot, &actual, sizeof (actual), key);
+    EXPECT_EQ (result, key % 2 == 0);
+    if (result)
+    {
+      EXPECT_TRUE (expected == actual);
+    }
+  }
+
+  uint64_t expectedKey = 0;
+  for (RBTU64Node* pNode = rbt_u64_first (pRoot); pNode != NULL; pNode = rbt_u64_next (pNode))
+  {
+    EXPECT_EQ (pNode->key, expectedKey);
+    expectedKey += 2;
+  }
+  EXPECT_EQ (expectedKey, RBT_NODES_COUNT * 2);
+
+  // the stored size is copied : a smaller buffer is refused, a larger one is not over-read
+  struct
+  {
+    TestStruct item;
+    int tail;
+  } larger = { { 0, 0, 0 }, -1 };
+  TestStruct expected = { 2, 3, 4 };
+  EXPECT_FALSE (rbt_u64_get (pRoot, &larger, sizeof (TestStruct) - 1, 2));
+  EXPECT_TRUE (rbt_u64_get (pRoot, &larger, sizeof (larger), 2));
+  EXPECT_TRUE (larger.item == expected);
+  EXPECT_EQ (larger.tail, -1);
+
+  EXPECT_EQ (rbt_u64_prev (rbt_u64_last (pRoot))->key, RBT_NODES_COUNT * 2 - 4);
+  EXPECT_EQ (rbt_u64_lower_bound (pRoot, 7)->key, 8u);
+  EXPECT_EQ (rbt_u64_lower_bound (pRoot, 8)->key, 8u);
+  EXPECT_EQ (rbt_u64_upper_bound (pRoot, 8)->key, 10u);
+  EXPECT_TRUE (rbt_u64_upper_bound (pRoot, RBT_NODES_COUNT * 2) == NULL);
+
+  // rbt_u64_delete : every second key
+  for (uint64_t key = 0; key < RBT_NODES_COUNT * 2; key += 4)
+  {
+    EXPECT_TRUE (rbt_u64_delete (&pRoot, key));
+    EXPECT_FALSE (rbt_u64_delete (&pRoot, key));
+  }
+  ASSERT_GT (BlackHeight (pRoot, is_u64_NIL_same), 0);
+  EXPECT_EQ (rbt_u64_first (pRoot)->key, 2u);
+
+  EXPECT_TRUE (rbt_u64_destroy (&pRoot));
+  EXPECT_TRUE (pRoot == NULL);
+}
+
+TEST (RBTreeTypedTest, RBTBinTest)
+{
+  // rbt_bin_insert, rbt_bin_get, rbt_bin_destroy
+  // rbt_bin_first, rbt_bin_next, rbt_bin_lower_bound
+
+  bool result;
+  const int RBT_NODES_COUNT = 10000;
+  RBTBinNode* pRoot = NULL;
+
+  // 16-byte keys : big-endian counter in the last bytes, zeros are valid key bytes
+  using Key = std::array<unsigned char, 16>;
+  auto makeKey = [] (uint32_t value) {
+    Key key = { 0 };
+    for (int i = 0; i < 4; ++i)
+    {
+      key[15 - i] = (unsigned char)(value >> (8 * i));
+    }
+    return key;
+  };
+
+  std::vector<uint32_t> values;
+  for (uint32_t i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    values.push_back (i);
+  }
+  std::shuffle (values.begin (), values.end (), std::mt19937 (42));
+
+  for (auto value : values)
+  {
+    TestStruct item = { (int)value, (int)value + 1, (int)value + 2 };
+    Key key = makeKey (value);
+
+    result = rbt_bin_insert (&pRoot, &item, sizeof (item), key.data (), key.size ());
+    ASSERT_TRUE (result);
+  }
+  ASSERT_GT (BlackHeight (pRoot, is_bin_NIL_same), 0);
+
+  // duplicated key and key of another size
+  TestStruct item = { 0 };
+  Key key = makeKey (0);
+  EXPECT_FALSE (rbt_bin_insert (&pRoot, &item, sizeof (item), key.data (), key.size ()));
+  EXPECT_FALSE (rbt_bin_insert (&pRoot, &item, sizeof (item), key.data (), 8));
+
+  for (uint32_t value = 0; value < RBT_NODES_COUNT; ++value)
+  {
+    TestStruct expected = { (int)value, (int)value + 1, (int)value + 2 };
+    TestStruct actual = { 0 };
+    Key key = makeKey (value);
+
+    result = rbt_bin_get (pRoot, &actual, sizeof (actual), key.data (), key.size ());
+    EXPECT_TRUE (result);
+    EXPECT_TRUE (expected == actual);
+  }
+
+  uint32_t expectedValue = 0;
+  for (RBTBinNode* pNode = rbt_bin_first (pRoot); pNode != NULL; pNode = rbt_bin_next (pNode))
+  {
+    Key expected = makeKey (expectedValue++);
+    EXPECT_EQ (memcmp (pNode->key, expected.data (), expected.size ()), 0);
+  }
+  EXPECT_EQ (expectedValue, (uint32_t)RBT_NODES_COUNT);
+
+  // the stored size is copied : a smaller buffer is refused, a larger one is not over-read
+  struct
+  {
+    TestStruct item;
+    int tail;
+  } larger = { { 0, 0, 0 }, -1 };
+  TestStruct expected = { 2, 3, 4 };
+  key = makeKey (2);
+  EXPECT_FALSE (rbt_bin_get (pRoot, &larger, sizeof (TestStruct) - 1, key.data (), key.size ()));
+  EXPECT_TRUE (rbt_bin_get (pRoot, &larger, sizeof (larger), key.data (), key.size ()));
+  EXPECT_TRUE (larger.item == expected);
+  EXPECT_EQ (larger.tail, -1);
+
+  key = makeKey (RBT_NODES_COUNT);
+  EXPECT_TRUE (rbt_bin_lower_bound (pRoot, key.data (), key.size ()) == NULL);
+
+  // rbt_bin_delete : all but the last key
+  for (auto value : values)
+  {
+    key = makeKey (value);
+    if (value != RBT_NODES_COUNT - 1)
+    {
+      EXPECT_TRUE (rbt_bin_delete (&pRoot, key.data (), key.size ()));
+    }
+  }
+  ASSERT_GT (BlackHeight (pRoot, is_bin_NIL_same), 0);
+  EXPECT_TRUE (rbt_bin_first (pRoot) == rbt_bin_last (pRoot));
+
+  EXPECT_TRUE (rbt_bin_destroy (&pRoot));
+  EXPECT_TRUE (pRoot == NULL);
+}
+
+TEST (RBTreeTypedTest, RBTIntrusiveTest)
+{
+  // rbt_intrusive_insert, rbt_intrusive_find, rbt_intrusive_remove, rbt_intrusive_clear
+  // rbt_intrusive_first, rbt_intrusive_next, rbt_intrusive_prev, bounds
+
+  struct Object
+  {
+    uint64_t key;
+    RBTLink link;
+  };
+
+  const uint64_t RBT_NODES_COUNT = 10000;
+
+  auto compare = [] (const RBTLink* pLink, const void* key) {
+    uint64_t nodeKey = GET_NODE (pLink, Object, link)->key;
+    uint64_t searchedKey = *(const uint64_t*)key;
+    return (nodeKey > searchedKey) - (nodeKey < searchedKey);
+  };
+  auto isNIL = [] (RBTLink* pLink) { return pLink->left == NULL; };
+
+  RBTIntrusive tree;
+  EXPECT_FALSE (rbt_intrusive_init (&tree, NULL));
+  ASSERT_TRUE (rbt_intrusive_init (&tree, compare));
+  EXPECT_TRUE (rbt_intrusive_first (&tree) == NULL);
+
+  // even keys in shuffled order : the tree points into the vector, nothing is copied
+  std::vector<Object> objects (RBT_NODES_COUNT);
+  for (uint64_t i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    objects[i] = { i * 2, { BLACK, NULL, NULL, NULL } };
+  }
+  std::shuffle (objects.begin (), objects.end (), std::mt19937 (42));
+
+  for (auto& object : objects)
+  {
+    EXPECT_FALSE (rbt_intrusive_is_linked (&object.link));
+    ASSERT_TRUE (rbt_intrusive_insert (&tree, &object.link, &object.key));
+    EXPECT_TRUE (rbt_intrusive_is_linked (&object.link));
+  }
+  ASSERT_EQ (tree.root->color, BLACK);
+  ASSERT_GT (BlackHeight (tree.root, isNIL), 0);
+
+  // duplicated key, already linked object
+  Object duplicate = { 0, { BLACK, NULL, NULL, NULL } };
+  EXPECT_FALSE (rbt_intrusive_insert (&tree, &duplicate.link, &duplicate.key));
+  EXPECT_FALSE (rbt_intrusive_insert (&tree, &objects[0].link, &objects[0].key));
+
+  for (uint64_t key = 0; key < RBT_NODES_COUNT * 2; ++key)
+  {
+    RBTLink* pLink = rbt_intrusive_find (&tree, &key);
+    ASSERT_EQ (pLink != NULL, key % 2 == 0);
+    if (pLink != NULL)
+    {
+      EXPECT_EQ (GET_NODE (pLink, Object, link)->key, key);
+    }
+  }
+
+  uint64_t expectedKey = 0;
+  for (RBTLink* pLink = rbt_intrusive_first (&tree); pLink != NULL;
+       pLink = rbt_intrusive_next (pLink))
+  {
+    EXPECT_EQ (GET_NODE (pLink, Object, link)->key, expectedKey);
+    expectedKey += 2;
+  }
+  EXPECT_EQ (expectedKey, RBT_NODES_COUNT * 2);
+
+  auto keyOf = [] (RBTLink* pLink) { return GET_NODE (pLink, Object, link)->key; };
+  uint64_t key = 7;
+  EXPECT_EQ (keyOf (rbt_intrusive_prev (rbt_intrusive_last (&tree))), RBT_NODES_COUNT * 2 - 4);
+  EXPECT_EQ (keyOf (rbt_intrusive_lower_bound (&tree, &key)), 8u);
+  key = 8;
+  EXPECT_EQ (keyOf (rbt_intrusive_lower_bound (&tree, &key)), 8u);
+  EXPECT_EQ (keyOf (rbt_intrusive_upper_bound (&tree, &key)), 10u);
+  key = RBT_NODES_COUNT * 2;
+  EXPECT_TRUE (rbt_intrusive_upper_bound (&tree, &key) == NULL);
+
+  // removal by the object itself : every second key
+  for (auto& object : objects)
+  {
+    if (object.key % 4 == 0)
+    {
+      rbt_intrusive_remove (&tree, &object.link);
+      EXPECT_FALSE (rbt_intrusive_is_linked (&object.link));
+      rbt_intrusive_remove (&tree, &object.link);    // not linked : nothing happens
+      EXPECT_TRUE (rbt_intrusive_find (&tree, &object.key) == NULL);
+    }
+  }
+  ASSERT_GT (BlackHeight (tree.root, isNIL), 0);
+  EXPECT_EQ (keyOf (rbt_intrusive_first (&tree)), 2u);
+
+  // removed object is reusable
+  ASSERT_TRUE (rbt_intrusive_insert (&tree, &duplicate.link, &duplicate.key));
+  EXPECT_EQ (keyOf (rbt_intrusive_first (&tree)), 0u);
+
+  rbt_intrusive_clear (&tree);
+  EXPECT_TRUE (tree.root == NULL);
+  for (auto& object : objects)
+  {
+    EXPECT_FALSE (rbt_intrusive_is_linked (&object.link));
+  }
+}
+
+TEST_F (RBTreeTestClass, RBTDeletionTest)
+{
+  // rbt_delete
+  // rbt_destroy
+
+  const int keyMaxSize = 16;
+  const int RBT_NODES_COUNT = 3000;
+
+  std::mt19937 generator (42);
+  std::set<std::string> expected;
+  std::vector<std::string> keys;
+
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "%08x", generator ());
+    keys.push_back (key);
+  }
+
+  // random inserts and deletes, tree is checked after every change
+  TestStruct item = { 1, 2, 3 };
+  for (auto round = 0; round < RBT_NODES_COUNT * 4; ++round)
+  {
+    const std::string& key = keys[generator () % keys.size ()];
+    bool isPresent = expected.count (key) != 0;
+
+    if (generator () % 3 != 0)
+    {
+      EXPECT_EQ (rbt_insert (&pRoot, &item, sizeof (item), key.c_str ()), !isPresent);
+      expected.insert (key);
+    }
+    else
+    {
+      EXPECT_EQ (rbt_delete (&pRoot, key.c_str ()), isPresent);
+      expected.erase (key);
+    }
+
+    if (pRoot != NULL && round % 64 == 0)
+    {
+      ASSERT_TRUE (isTreeValid ()) << "round : " << round;
+    }
+  }
+
+  ASSERT_TRUE (isTreeValid ());
+
+  std::vector<std::string> actual;
+  for (RBTNode* pNode = rbt_first (pRoot); pNode != NULL; pNode = rbt_next (pNode))
+  {
+    actual.push_back (pNode->key);
+  }
+  EXPECT_TRUE (std::equal (actual.begin (), actual.end (), expected.begin (), expected.end ()));
+
+  // node pointers stay valid : deletion relinks nodes instead of moving keys between them
+  RBTNode* pKept = rbt_select (pRoot, expected.size () / 2);
+  std::string keptKey = pKept->key;
+
+  for (auto it = expected.begin (); it != expected.end ();)
+  {
+    if (*it != keptKey)
+    {
+      ASSERT_TRUE (rbt_delete (&pRoot, it->c_str ()));
+      it = expected.erase (it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  EXPECT_EQ (pRoot, pKept);
+  EXPECT_EQ (keptKey, pKept->key);
+  EXPECT_TRUE (isTreeValid ());
+
+  EXPECT_FALSE (rbt_delete (&pRoot, "absent"));
+  EXPECT_FALSE (rbt_delete (&pRoot, NULL));
+  EXPECT_TRUE (rbt_delete (&pRoot, keptKey.c_str ()));
+  EXPECT_TRUE (pRoot == NULL);
+  EXPECT_FALSE (rbt_delete (&pRoot, keptKey.c_str ()));
+
+  // nodes of contiguous block are freed with the last of them
+  std::vector<const char*> sortedKeys;
+  std::vector<TestStruct> items (50, item);
+  std::vector<std::string> sorted (keys.begin (), keys.begin () + 50);
+  std::sort (sorted.begin (), sorted.end ());
+  for (const auto& key : sorted)
+  {
+    sortedKeys.push_back (key.c_str ());
+  }
+
+  ASSERT_TRUE (rbt_build_from_sorted (&pRoot, sortedKeys.data (), items.data (),
+                                      sizeof (TestStruct), sortedKeys.size (), true));
+  for (auto key : sortedKeys)
+  {
+    ASSERT_TRUE (rbt_delete (&pRoot, key));
+    if (pRoot != NULL)
+    {
+      ASSERT_TRUE (isTreeValid ());
+    }
+  }
+  EXPECT_TRUE (pRoot == NULL);
+}
+
+TEST_F (RBTreeTestClass, RBTOrderStatisticsTest)
+{
+  // rbt_select
+  // rbt_rank
+
+  const int keyMaxSize = 16;
+  const int RBT_NODES_COUNT = 2000;
+
+  std::mt19937 generator (7);
+  std::set<std::string> expected;
+  TestStruct item = { 1, 2, 3 };
+  size_t rank = 0;
+
+  EXPECT_TRUE (rbt_select (pRoot, 0) == NULL);
+  EXPECT_TRUE (rbt_rank (pRoot, "key", &rank));
+  EXPECT_EQ (rank, 0u);
+
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "%x", generator () % 5000);
+    rbt_insert (&pRoot, &item, sizeof (item), key);
+    expected.insert (key);
+
+    if (i % 3 == 0)
+    {
+      snprintf (key, keyMaxSize, "%x", generator () % 5000);
+      rbt_delete (&pRoot, key);
+      expected.erase (key);
+    }
+  }
+
+  ASSERT_TRUE (isTreeValid ());
+  ASSERT_EQ (pRoot->size, expected.size ());
+
+  size_t index = 0;
+  for (const auto& key : expected)
+  {
+    RBTNode* pNode = rbt_select (pRoot, index);
+    ASSERT_TRUE (pNode != NULL);
+    EXPECT_EQ (key, pNode->key);
+
+    EXPECT_TRUE (rbt_rank (pRoot, key.c_str (), &rank));
+    EXPECT_EQ (rank, index);
+
+    // a key between neighbours has the same rank as the next one
+    EXPECT_TRUE (rbt_rank (pRoot, (key + "!").c_str (), &rank));
+    EXPECT_EQ (rank, index + 1);
+
+    ++index;
+  }
+
+  EXPECT_TRUE (rbt_select (pRoot, expected.size ()) == NULL);
+  EXPECT_TRUE (rbt_rank (pRoot, "~", &rank));
+  EXPECT_EQ (rank, expected.size ());
+  EXPECT_FALSE (rbt_rank (pRoot, NULL, &rank));
+  EXPECT_FALSE (rbt_rank (pRoot, "key", NULL));
+
+  rbt_destroy (&pRoot);
+
+  // sizes of bulk built and merged trees
+  std::vector<std::string> sorted (expected.begin (), expected.end ());
+  std::vector<const char*> keys;
+  for (const auto& key : sorted)
+  {
+    keys.push_back (key.c_str ());
+  }
+  std::vector<TestStruct> items (keys.size (), item);
+
+  ASSERT_TRUE (rbt_build_from_sorted (&pRoot, keys.data (), items.data (), sizeof (TestStruct),
+                                      keys.size () / 2, true));
+  ASSERT_TRUE (rbt_merge_sorted (&pRoot, keys.data () + keys.size () / 2,
+                                 items.data () + keys.size () / 2, sizeof (TestStruct),
+                                 keys.size () - keys.size () / 2, 4));
+  ASSERT_TRUE (isTreeValid ());
+  EXPECT_EQ (rbt_select (pRoot, keys.size () - 1)->key, sorted.back ());
+
+  rbt_destroy (&pRoot);
+}
+TEST_F (RBTreeTestClass, RBTDestroyTest)
+{
+  // rbt_destroy : no recursion even for degenerate tree
+  // rbt_destroy_parallel : regular and contiguous trees, timings are in bench_containers
+
+  const int CHAIN_LENGTH = 100000;
+  const int RBT_NODES_COUNT = 10000;
+  const int keyMaxSize = 16;
+  TestStruct item = { 1, 2, 3 };
+
+  // single node trees are linked into a chain : a recursive teardown goes CHAIN_LENGTH deep
+  RBTNode* pTail = NULL;
+  for (auto i = 0; i < CHAIN_LENGTH; ++i)
+  {
+    RBTNode* pNode = NULL;
+    ASSERT_TRUE (rbt_insert (&pNode, &item, sizeof (item), "chain"));
+
+    if (pTail == NULL)
+    {
+      pRoot = pNode;
+    }
+    else
+    {
+      pTail->right = pNode;
+      pNode->parent = pTail;
+    }
+    pTail = pNode;
+  }
+
+  EXPECT_TRUE (rbt_destroy (&pRoot));
+  EXPECT_TRUE (pRoot == NULL);
+  EXPECT_FALSE (rbt_destroy (&pRoot));
+
+  std::vector<std::string> keysStorage;
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, "%08d", i);
+    keysStorage.push_back (key);
+  }
+
+  std::vector<const char*> keys;
+  for (const auto& key : keysStorage)
+  {
+    keys.push_back (key.c_str ());
+  }
+  std::vector<TestStruct> items (keys.size (), item);
+
+  for (auto isContiguous : { false, true })
+  {
+    for (auto threadsCount : { 1u, 3u, 8u, 100u })    // over the threads limit : clamped
+    {
+      ASSERT_TRUE (rbt_build_from_sorted (&pRoot, keys.data (), items.data (),
+                                          sizeof (TestStruct), keys.size (), isContiguous));
+
+      EXPECT_TRUE (rbt_destroy_parallel (&pRoot, threadsCount));
+      EXPECT_TRUE (pRoot == NULL);
+    }
+  }
+
+  // tree smaller than the split depth
+  ASSERT_TRUE (rbt_insert (&pRoot, &item, sizeof (item), "single"));
+  EXPECT_FALSE (rbt_destroy_parallel (&pRoot, 0));
+  EXPECT_TRUE (rbt_destroy_parallel (&pRoot, 16));
+  EXPECT_TRUE (pRoot == NULL);
+}
+
+TEST_F (RBTreeTestClass, RBTPayloadTest)
+{
+  // rbt_get_ref
+  // rbt_upsert
+  // payloads of different sizes : inline, allocated, pool slots
+
+  const int RBT_NODES_COUNT = 1000;
+
+  std::map<std::string, std::string> expected;
+  std::mt19937 generator (11);
+
+  for (auto round = 0; round < 4; ++round)
+  {
+    for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+    {
+      std::string key = std::to_string (generator () % (RBT_NODES_COUNT / 2));
+      std::string payload (generator () % 40, 'a' + round);
+
+      ASSERT_TRUE (
+          rbt_upsert (&pRoot, payload.data (), payload.size (), key.c_str (), NULL, NULL));
+      expected[key] = payload;
+    }
+
+    ASSERT_TRUE (isTreeValid ());
+    ASSERT_EQ (pRoot->size, expected.size ());
+
+    for (const auto& it : expected)
+    {
+      const void* pData = NULL;
+      size_t size = 0;
+
+      ASSERT_TRUE (rbt_get_ref (pRoot, it.first.c_str (), &pData, &size));
+      ASSERT_EQ (std::string (static_cast<const char*> (pData), size), it.second);
+
+      // rbt_get copies the stored size and refuses smaller buffers
+      char buffer[64] = { 0 };
+      EXPECT_TRUE (rbt_get (pRoot, buffer, sizeof (buffer), it.first.c_str ()));
+      EXPECT_EQ (std::string (buffer, size), it.second);
+
+      if (size > 0)
+      {
+        EXPECT_FALSE (rbt_get (pRoot, buffer, size - 1, it.first.c_str ()));
+      }
+    }
+  }
+
+  const void* pData = NULL;
+  size_t size = 0;
+  EXPECT_FALSE (rbt_get_ref (pRoot, "absent", &pData, &size));
+  EXPECT_FALSE (rbt_upsert (&pRoot, NULL, 0, "null", NULL, NULL));
+  EXPECT_FALSE (rbt_insert (&pRoot, pRoot->data, 1, pRoot->key));
+
+  // update of the same or smaller size keeps the storage
+  TestStruct item = { 1, 2, 3 };
+  ASSERT_TRUE (rbt_upsert (&pRoot, &item, sizeof (item), "same", NULL, NULL));
+  ASSERT_TRUE (rbt_get_ref (pRoot, "same", &pData, &size));
+
+  const void* pPrevious = pData;
+  item.mem0 = 7;
+  ASSERT_TRUE (rbt_upsert (&pRoot, &item, sizeof (item), "same", NULL, NULL));
+  ASSERT_TRUE (rbt_get_ref (pRoot, "same", &pData, &size));
+  EXPECT_EQ (pData, pPrevious);
+  EXPECT_EQ (size, sizeof (item));
+  EXPECT_EQ (*static_cast<const TestStruct*> (pData), item);
+
+  rbt_destroy (&pRoot);
+
+  // pool nodes : inline and slot payloads, growing out of a slot
+  for (size_t itemSize : { sizeof (TestStruct), (size_t)100 })
+  {
+    std::vector<std::string> keys;
+    std::vector<const char*> keyPointers;
+    std::vector<char> items (itemSize * 100, 'p');
+
+    for (auto i = 0; i < 100; ++i)
+    {
+      keys.push_back ("pool" + std::to_string (1000 + i));
+    }
+    for (const auto& key : keys)
+    {
+      keyPointers.push_back (key.c_str ());
+    }
+
+    ASSERT_TRUE (rbt_build_from_sorted (&pRoot, keyPointers.data (), items.data (), itemSize,
+                                        keys.size (), true));
+    ASSERT_TRUE (rbt_get_ref (pRoot, "pool1050", &pData, &size));
+    EXPECT_EQ (size, itemSize);
+
+    std::string larger (300, 'L');
+    ASSERT_TRUE (rbt_upsert (&pRoot, larger.data (), larger.size (), "pool1050", NULL, NULL));
+    ASSERT_TRUE (rbt_upsert (&pRoot, &item, sizeof (item), "pool1051", NULL, NULL));
+    ASSERT_TRUE (rbt_get_ref (pRoot, "pool1050", &pData, &size));
+    EXPECT_EQ (std::string (static_cast<const char*> (pData), size), larger);
+    ASSERT_TRUE (rbt_get_ref (pRoot, "pool1051", &pData, &size));
+    EXPECT_EQ (*static_cast<const TestStruct*> (pData), item);
+
+    rbt_delete (&pRoot, "pool1050");
+    rbt_destroy (&pRoot);
+  }
+}
+
+TEST_F (RBTreeTestClass, RBTUpsertHintTest)
+{
+  // rbt_upsert with merge
+  // rbt_insert_hint : good, bad and stale hints
+
+  std::mt19937 generator (5);
+  std::map<std::string, int> counts;
+
+  auto addCount = [] (void* pData, size_t dataSize, const void* pItem, size_t, void*) {
+    ASSERT_EQ (dataSize, sizeof (int));
+    *static_cast<int*> (pData) += *static_cast<const int*> (pItem);
+  };
+
+  for (auto i = 0; i < 5000; ++i)
+  {
+    std::string key = "word" + std::to_string (generator () % 300);
+    int one = 1;
+
+    ASSERT_TRUE (rbt_upsert (&pRoot, &one, sizeof (one), key.c_str (), addCount, NULL));
+    ++counts[key];
+  }
+
+  ASSERT_TRUE (isTreeValid ());
+  for (const auto& it : counts)
+  {
+    int count = 0;
+    ASSERT_TRUE (rbt_get (pRoot, &count, sizeof (count), it.first.c_str ()));
+    EXPECT_EQ (count, it.second);
+  }
+
+  rbt_destroy (&pRoot);
+
+  // ascending appends chained through the returned node
+  TestStruct item = { 1, 2, 3 };
+  RBTNode* pHint = NULL;
+  std::set<std::string> expected;
+
+  for (auto i = 0; i < 3000; ++i)
+  {
+    char key[32] = { 0 };
+    snprintf (key, sizeof (key), "ts%012d", i * 2);
+
+    pHint = rbt_insert_hint (&pRoot, pHint, &item, sizeof (item), key);
+    ASSERT_TRUE (pHint != NULL);
+    EXPECT_EQ (std::string (pHint->key), key);
+    expected.insert (key);
+  }
+
+  // any node of the tree is a valid hint, the far ones just fall back to the search
+  std::vector<RBTNode*> nodes;
+  for (RBTNode* pNode = rbt_first (pRoot); pNode != NULL; pNode = rbt_next (pNode))
+  {
+    nodes.push_back (pNode);
+  }
+
+  for (auto i = 0; i < 3000; ++i)
+  {
+    char key[32] = { 0 };
+    snprintf (key, sizeof (key), "ts%012d", (int)(generator () % 6000));
+
+    RBTNode* pNode = rbt_insert_hint (&pRoot, nodes[generator () % nodes.size ()], &item,
+                                      sizeof (item), key);
+    EXPECT_EQ (pNode != NULL, expected.insert (key).second);
+  }
+
+  ASSERT_TRUE (isTreeValid ());
+  ASSERT_EQ (pRoot->size, expected.size ());
+
+  auto it = expected.begin ();
+  for (RBTNode* pNode = rbt_first (pRoot); pNode != NULL; pNode = rbt_next (pNode), ++it)
+  {
+    ASSERT_EQ (*it, pNode->key);
+  }
+
+  EXPECT_TRUE (rbt_insert_hint (&pRoot, pRoot, NULL, 0, "null") == NULL);
+  EXPECT_TRUE (rbt_insert_hint (&pRoot, pRoot, &item, sizeof (item), NULL) == NULL);
+
+  rbt_destroy (&pRoot);
+
+  // empty tree
+  pHint = rbt_insert_hint (&pRoot, NULL, &item, sizeof (item), "first");
+  EXPECT_EQ (pHint, pRoot);
+}
+
+TEST_F (RBTreeTestClass, RBTInsertHintAscendingTest)
+{
+  // timestamps-like ascending keys : every hinted insert lands next to the previous one,
+  // the tree is the same as the one of plain inserts
+
+  const int RBT_NODES_COUNT = 20000;
+
+  TestStruct item = { 1, 2, 3 };
+  RBTNode* pPlainRoot = NULL;
+  RBTNode* pHint = NULL;
+
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    char key[32] = { 0 };
+    snprintf (key, sizeof (key), "event:%016d", i);
+
+    ASSERT_TRUE (rbt_insert (&pPlainRoot, &item, sizeof (item), key));
+
+    RBTNode* pPrev = pHint;
+    pHint = rbt_insert_hint (&pRoot, pHint, &item, sizeof (item), key);
+
+    ASSERT_TRUE (pHint != NULL);
+    ASSERT_EQ (std::string (pHint->key), key);
+    ASSERT_EQ (rbt_prev (pHint), pPrev);
+
+    if ((i & 1023) == 0)
+    {
+      ASSERT_TRUE (isTreeValid ());
+    }
+  }
+
+  ASSERT_TRUE (isTreeValid ());
+  ASSERT_EQ (pRoot->size, (size_t)RBT_NODES_COUNT);
+
+  // the same keys in the same order, rank by rank
+  RBTNode* pPlain = rbt_first (pPlainRoot);
+  for (RBTNode* pNode = rbt_first (pRoot); pNode != NULL; pNode = rbt_next (pNode))
+  {
+    ASSERT_TRUE (pPlain != NULL);
+    EXPECT_STREQ (pNode->key, pPlain->key);
+    pPlain = rbt_next (pPlain);
+  }
+  EXPECT_TRUE (pPlain == NULL);
+
+  rbt_destroy (&pPlainRoot);
+}
+
+TEST_F (RBTreeTestClass, RBTTreeAppendTest)
+{
+  // ascending keys are appended to the cached rightmost node, interior keys search as usual
+
+  const int RBT_NODES_COUNT = 20000;
+
+  TestStruct item = { 1, 2, 3 };
+  RBTree tree;
+  ASSERT_TRUE (rbt_tree_init (&tree, NULL));
+  EXPECT_TRUE (tree.last == NULL);
+
+  auto keyOf = [] (int i)
+  {
+    char key[32] = { 0 };
+    snprintf (key, sizeof (key), "event:%016d", i);
+    return std::string (key);
+  };
+
+  for (auto i = 0; i < RBT_NODES_COUNT; i += 2)
+  {
+    ASSERT_TRUE (rbt_tree_insert (&tree, &item, sizeof (item), keyOf (i).c_str ()));
+    ASSERT_EQ (tree.last, rbt_last (tree.root));
+    ASSERT_EQ (std::string (tree.last->key), keyOf (i));
+  }
+  EXPECT_FALSE (rbt_tree_insert (&tree, &item, sizeof (item), keyOf (0).c_str ()));
+  EXPECT_FALSE (
+      rbt_tree_insert (&tree, &item, sizeof (item), keyOf (RBT_NODES_COUNT - 2).c_str ()));
+
+  // the gaps : the rightmost node stays
+  RBTNode* pLast = tree.last;
+  for (auto i = RBT_NODES_COUNT - 3; i > 0; i -= 2)
+  {
+    ASSERT_TRUE (rbt_tree_insert (&tree, &item, sizeof (item), keyOf (i).c_str ()));
+  }
+  EXPECT_EQ (tree.last, pLast);
+
+  pRoot = tree.root;
+  ASSERT_TRUE (isTreeValid ());
+  ASSERT_EQ (pRoot->size, (size_t)RBT_NODES_COUNT - 1);
+
+  // deleting the rightmost node steps the cache back
+  for (auto i = RBT_NODES_COUNT - 2; i > RBT_NODES_COUNT - 100; --i)
+  {
+    ASSERT_TRUE (rbt_tree_delete (&tree, keyOf (i).c_str ()));
+    ASSERT_EQ (tree.last, rbt_last (tree.root));
+  }
+  EXPECT_FALSE (rbt_tree_delete (&tree, keyOf (RBT_NODES_COUNT - 2).c_str ()));
+
+  for (auto i = RBT_NODES_COUNT - 99; i < RBT_NODES_COUNT * 2; ++i)
+  {
+    ASSERT_TRUE (rbt_tree_insert (&tree, &item, sizeof (item), keyOf (i).c_str ()));
+    ASSERT_EQ (tree.last, rbt_last (tree.root));
+  }
+
+  pRoot = tree.root;
+  ASSERT_TRUE (isTreeValid ());
+  ASSERT_EQ (pRoot->size, (size_t)RBT_NODES_COUNT * 2);
+
+  // the rightmost node follows the other creating functions too
+  TestStruct actual = { 0, 0, 0 };
+  ASSERT_TRUE (rbt_tree_upsert (&tree, &item, sizeof (item), "f", NULL, NULL));
+  EXPECT_EQ (std::string (tree.last->key), "f");
+  ASSERT_TRUE (rbt_tree_insert_hint (&tree, tree.last, &item, sizeof (item), "g") != NULL);
+  EXPECT_EQ (std::string (tree.last->key), "g");
+  ASSERT_TRUE (rbt_tree_insert (&tree, &item, sizeof (item), "h"));
+  EXPECT_TRUE (rbt_get (tree.root, &actual, sizeof (actual), "h"));
+  EXPECT_EQ (tree.last, rbt_last (tree.root));
+
+  EXPECT_TRUE (rbt_tree_destroy (&tree));
+  EXPECT_TRUE (tree.root == NULL);
+  EXPECT_TRUE (tree.last == NULL);
+  pRoot = NULL;
+}
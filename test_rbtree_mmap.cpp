@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/rb_tree_mmap.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct TestStruct
+{
+  int mem0, mem1, mem2;
+
+  bool operator== (const TestStruct& other) const
+  {
+    return mem0 == other.mem0 && mem1 == other.mem1 && mem2 == other.mem2;
+  }
+};
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class RBTMmapTestClass : public ::testing::Test
+{
+public:
+  RBTMmap tree;
+  std::string path;
+
+  void SetUp () override
+  {
+    char name[] = "/tmp/rbt_mmap_XXXXXX";
+    int fd = mkstemp (name);
+    ASSERT_GE (fd, 0);
+    close (fd);
+
+    path = name;
+    ASSERT_TRUE (rbt_mmap_open (&tree, path.c_str (), 0));
+  }
+
+  void TearDown () override
+  {
+    rbt_mmap_close (&tree);
+    unlink (path.c_str ());
+  }
+
+  std::vector<std::string> getKeys ()
+  {
+    std::vector<std::string> keys;
+    for (RBTMmapNode* pNode = rbt_mmap_first (&tree); pNode != NULL;
+         pNode = rbt_mmap_next (&tree, pNode))
+    {
+      keys.push_back (rbt_mmap_key (pNode));
+    }
+    return keys;
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (RBTMmapTestClass, RBTMmapRegularTest)
+{
+  // rbt_mmap_insert, rbt_mmap_get, iteration, reopening
+
+  const int keyMaxSize = 48;
+  const int RBT_NODES_COUNT = 20000;
+
+  std::mt19937 generator (42);
+  std::map<std::string, TestStruct> expected;
+
+  for (auto i = 0; i < RBT_NODES_COUNT; ++i)
+  {
+    char key[keyMaxSize] = { 0 };
+    snprintf (key, keyMaxSize, (i % 2) ? "%x" : "long-key-%08x-%08x", generator (), i);
+    TestStruct item = { i, i + 1, i + 2 };
+
+    bool isNew = expected.emplace (key, item).second;
+    EXPECT_EQ (rbt_mmap_insert (&tree, &item, sizeof (item), key), isNew);
+  }
+
+  EXPECT_FALSE (rbt_mmap_insert (&tree, NULL, 0, "null"));
+  EXPECT_FALSE (rbt_mmap_insert (&tree, &generator, 4, NULL));
+
+  // grown file is reopened at another address, offsets stay valid
+  for (auto isReopened : { false, true })
+  {
+    if (isReopened)
+    {
+      ASSERT_TRUE (rbt_mmap_close (&tree));
+      ASSERT_TRUE (rbt_mmap_open (&tree, path.c_str (), 0));
+    }
+
+    ASSERT_EQ (rbt_mmap_count (&tree), expected.size ());
+
+    for (const auto& it : expected)
+    {
+      TestStruct actual = { 0 };
+      ASSERT_TRUE (rbt_mmap_get (&tree, &actual, sizeof (actual), it.first.c_str ()));
+      EXPECT_EQ (actual, it.second);
+    }
+    EXPECT_FALSE (rbt_mmap_get (&tree, &generator, 4, "absent"));
+
+    // the stored size is copied, a smaller buffer is refused
+    const std::string& key = expected.begin ()->first;
+    std::array<char, sizeof (TestStruct) * 2> larger;
+    larger.fill ('#');
+    EXPECT_FALSE (rbt_mmap_get (&tree, larger.data (), sizeof (TestStruct) - 1, key.c_str ()));
+    ASSERT_TRUE (rbt_mmap_get (&tree, larger.data (), larger.size (), key.c_str ()));
+    EXPECT_EQ (larger[sizeof (TestStruct)], '#');
+
+    RBTMmapNode* pNode = rbt_mmap_lower_bound (&tree, key.c_str ());
+    ASSERT_TRUE (pNode != NULL);
+    EXPECT_EQ (rbt_mmap_data_size (pNode), sizeof (TestStruct));
+
+    auto keys = getKeys ();
+    ASSERT_EQ (keys.size (), expected.size ());
+    EXPECT_TRUE (std::equal (keys.begin (), keys.end (), expected.begin (),
+                             [] (const std::string& key, const auto& it) { return key == it.first; }));
+
+    RBTMmapNode* pBound = rbt_mmap_lower_bound (&tree, "long-key-");
+    ASSERT_TRUE (pBound != NULL);
+    EXPECT_EQ (expected.lower_bound ("long-key-")->first, rbt_mmap_key (pBound));
+    EXPECT_TRUE (rbt_mmap_lower_bound (&tree, "~") == NULL);
+  }
+
+  // insertions go on after reopening
+  TestStruct item = { 7, 7, 7 };
+  EXPECT_TRUE (rbt_mmap_insert (&tree, &item, sizeof (item), "after reopen"));
+  EXPECT_EQ (rbt_mmap_count (&tree), expected.size () + 1);
+}
+
+TEST_F (RBTMmapTestClass, RBTMmapCheckpointTest)
+{
+  // changes after the last checkpoint without close make the file invalid
+
+  TestStruct item = { 1, 2, 3 };
+  ASSERT_TRUE (rbt_mmap_insert (&tree, &item, sizeof (item), "checkpointed"));
+  ASSERT_TRUE (rbt_mmap_checkpoint (&tree));
+
+  // a clean file can be opened by another mapping
+  RBTMmap reader;
+  ASSERT_TRUE (rbt_mmap_open (&reader, path.c_str (), 0));
+  EXPECT_EQ (rbt_mmap_count (&reader), 1u);
+  munmap (reader.base, reader.mappedSize);    // dropped without close, like after a crash
+  close (reader.fd);
+
+  ASSERT_TRUE (rbt_mmap_insert (&tree, &item, sizeof (item), "not checkpointed"));
+  ASSERT_TRUE (rbt_mmap_open (&reader, path.c_str (), 0) == false);
+
+  ASSERT_TRUE (rbt_mmap_checkpoint (&tree));
+  ASSERT_TRUE (rbt_mmap_open (&reader, path.c_str (), 0));
+  EXPECT_EQ (rbt_mmap_count (&reader), 2u);
+  munmap (reader.base, reader.mappedSize);
+  close (reader.fd);
+
+  // not a tree file
+  EXPECT_FALSE (rbt_mmap_open (&reader, "/proc/self/status", 0));
+  EXPECT_FALSE (rbt_mmap_open (&reader, NULL, 0));
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/rb_tree_stream.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct TestStruct
+{
+  int mem0, mem1, mem2;
+
+  bool operator== (const TestStruct& other) const
+  {
+    return mem0 == other.mem0 && mem1 == other.mem1 && mem2 == other.mem2;
+  }
+};
+
+// in-memory stream : dump appends to 'bytes', load reads it from 'position'
+struct MemoryStream
+{
+  std::string bytes;
+  size_t position = 0;
+  size_t chunksCount = 0;
+
+  static bool write (const void* pChunk, size_t size, void* pContext)
+  {
+    auto* pStream = static_cast<MemoryStream*> (pContext);
+    pStream->bytes.append (static_cast<const char*> (pChunk), size);
+    ++pStream->chunksCount;
+    return true;
+  }
+
+  static size_t read (void* pChunk, size_t size, void* pContext)
+  {
+    auto* pStream = static_cast<MemoryStream*> (pContext);
+    size_t part = std::min (size, pStream->bytes.size () - pStream->position);
+    memcpy (pChunk, pStream->bytes.data () + pStream->position, part);
+    pStream->position += part;
+    return part;
+  }
+};
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class RBTStreamTestClass : public ::testing::Test
+{
+public:
+  RBTNode* pRoot = NULL;
+  RBTNode* pLoaded = NULL;
+  std::map<std::string, TestStruct> expected;
+
+  void TearDown () override
+  {
+    rbt_destroy (&pRoot);
+    rbt_destroy (&pLoaded);
+  }
+
+  void fill (int count)
+  {
+    std::mt19937 generator (42);
+
+    for (auto i = 0; i < count; ++i)
+    {
+      char key[RBT_KEY_SIZE] = { 0 };
+      snprintf (key, sizeof (key), (i % 3) ? "%x" : "long-key-%08x-%0200d", generator (), i);
+      TestStruct item = { i, i + 1, i + 2 };
+
+      bool isNew = expected.emplace (key, item).second;
+      ASSERT_EQ (rbt_insert (&pRoot, &item, sizeof (item), key), isNew);
+    }
+  }
+
+  void checkLoaded ()
+  {
+    ASSERT_TRUE (expected.empty () ? pLoaded == NULL : pLoaded != NULL);
+
+    auto it = expected.begin ();
+    for (RBTNode* pNode = rbt_first (pLoaded); pNode != NULL; pNode = rbt_next (pNode), ++it)
+    {
+      ASSERT_TRUE (it != expected.end ());
+      EXPECT_EQ (it->first, pNode->key);
+      EXPECT_EQ (it->second, *static_cast<TestStruct*> (pNode->data));
+    }
+    EXPECT_TRUE (it == expected.end ());
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (RBTStreamTestClass, RBTStreamRegularTest)
+{
+  // rbt_dump, rbt_load : round trip with chunks smaller than a record and larger than all
+
+  fill (5000);
+
+  for (size_t bufferSize : { (size_t)1, (size_t)7, (size_t)4096, (size_t)1 << 22 })
+  {
+    std::vector<char> buffer (bufferSize);
+    MemoryStream stream;
+
+    ASSERT_TRUE (rbt_dump (pRoot, sizeof (TestStruct), buffer.data (), bufferSize,
+                           MemoryStream::write, &stream));
+    EXPECT_EQ (stream.chunksCount, (stream.bytes.size () + bufferSize - 1) / bufferSize);
+
+    // loading chunk size is independent of the dumping one
+    std::vector<char> loadBuffer (bufferSize * 3 + 1);
+    ASSERT_TRUE (rbt_load (&pLoaded, sizeof (TestStruct), loadBuffer.data (), loadBuffer.size (),
+                           MemoryStream::read, &stream));
+    checkLoaded ();
+    ASSERT_TRUE (rbt_destroy (&pLoaded));
+  }
+
+  // empty tree
+  RBTNode* pEmpty = NULL;
+  std::vector<char> buffer (64);
+  MemoryStream stream;
+
+  ASSERT_TRUE (rbt_dump (pEmpty, sizeof (TestStruct), buffer.data (), buffer.size (),
+                         MemoryStream::write, &stream));
+  ASSERT_TRUE (rbt_load (&pLoaded, sizeof (TestStruct), buffer.data (), buffer.size (),
+                         MemoryStream::read, &stream));
+  EXPECT_TRUE (pLoaded == NULL);
+}
+
+TEST_F (RBTStreamTestClass, RBTStreamCorruptionTest)
+{
+  // any damaged snapshot is rejected and the tree is left empty
+
+  fill (300);
+
+  std::vector<char> buffer (256);
+  MemoryStream stream;
+  ASSERT_TRUE (rbt_dump (pRoot, sizeof (TestStruct), buffer.data (), buffer.size (),
+                         MemoryStream::write, &stream));
+  const std::string original = stream.bytes;
+
+  std::mt19937 generator (42);
+  for (auto i = 0; i < 200; ++i)
+  {
+    stream.bytes = original;
+    stream.position = 0;
+    stream.bytes[generator () % original.size ()] ^= (char)(1 + generator () % 255);
+
+    EXPECT_FALSE (rbt_load (&pLoaded, sizeof (TestStruct), buffer.data (), buffer.size (),
+                            MemoryStream::read, &stream));
+    ASSERT_TRUE (pLoaded == NULL);
+  }
+
+  // truncated
+  for (size_t size : { (size_t)0, (size_t)10, original.size () / 2, original.size () - 1 })
+  {
+    stream.bytes = original.substr (0, size);
+    stream.position = 0;
+
+    EXPECT_FALSE (rbt_load (&pLoaded, sizeof (TestStruct), buffer.data (), buffer.size (),
+                            MemoryStream::read, &stream));
+    ASSERT_TRUE (pLoaded == NULL);
+  }
+
+  // another payload size, non-empty destination
+  stream.bytes = original;
+  stream.position = 0;
+  EXPECT_FALSE (rbt_load (&pLoaded, sizeof (int), buffer.data (), buffer.size (),
+                          MemoryStream::read, &stream));
+
+  stream.position = 0;
+  EXPECT_FALSE (rbt_load (&pRoot, sizeof (TestStruct), buffer.data (), buffer.size (),
+                          MemoryStream::read, &stream));
+
+  // a writer failure stops dumping
+  auto failingWrite = [] (const void*, size_t, void*) { return false; };
+  EXPECT_FALSE (rbt_dump (pRoot, sizeof (TestStruct), buffer.data (), buffer.size (),
+                          failingWrite, NULL));
+  EXPECT_FALSE (rbt_dump (pRoot, sizeof (TestStruct), NULL, 0, MemoryStream::write, &stream));
+}
+
+TEST_F (RBTStreamTestClass, RBTStreamFileTest)
+{
+  // rbt_dump_fd, rbt_load_fd
+
+  fill (20000);
+
+  char name[] = "/tmp/rbt_stream_XXXXXX";
+  int fd = mkstemp (name);
+  ASSERT_GE (fd, 0);
+
+  ASSERT_TRUE (rbt_dump_fd (pRoot, sizeof (TestStruct), fd));
+  ASSERT_EQ (lseek (fd, 0, SEEK_SET), 0);
+  ASSERT_TRUE (rbt_load_fd (&pLoaded, sizeof (TestStruct), fd));
+  checkLoaded ();
+
+  close (fd);
+  unlink (name);
+
+  EXPECT_FALSE (rbt_dump_fd (pRoot, sizeof (TestStruct), -1));
+}
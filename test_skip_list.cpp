@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/skip_list.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct TestStruct
+{
+  int mem0, mem1, mem2;
+
+  bool operator== (const TestStruct& other) const
+  {
+    return mem0 == other.mem0 && mem1 == other.mem1 && mem2 == other.mem2;
+  }
+};
+
+static bool collectKeys (const char* key, const void*, size_t, void* pContext)
+{
+  static_cast<std::vector<std::string>*> (pContext)->push_back (key);
+  return true;
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class SkipListTestClass : public ::testing::Test
+{
+public:
+  SkipList list;
+
+  void SetUp () override { ASSERT_TRUE (sl_init (&list)); }
+  void TearDown () override { sl_destroy (&list); }
+
+  std::vector<std::string> scan (const char* keyFrom, const char* keyTo)
+  {
+    std::vector<std::string> keys;
+    EXPECT_TRUE (sl_scan_range (&list, keyFrom, keyTo, collectKeys, &keys));
+    return keys;
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (SkipListTestClass, SLRegularTest)
+{
+  // sl_insert, sl_get, sl_delete, sl_scan_range against std::map
+
+  const int SL_NODES_COUNT = 20000;
+
+  std::mt19937 generator (42);
+  std::map<std::string, TestStruct> expected;
+
+  for (auto i = 0; i < SL_NODES_COUNT; ++i)
+  {
+    char key[64] = { 0 };
+    snprintf (key, sizeof (key), (i % 2) ? "%x" : "long-key-%08x-%08x", generator () % 30000, i);
+    TestStruct item = { i, i + 1, i + 2 };
+
+    bool isNew = expected.emplace (key, item).second;
+    EXPECT_EQ (sl_insert (&list, &item, sizeof (item), key), isNew);
+
+    if (i % 4 == 0)
+    {
+      snprintf (key, sizeof (key), "%x", generator () % 30000);
+      EXPECT_EQ (sl_delete (&list, key), expected.erase (key) == 1);
+    }
+  }
+
+  ASSERT_EQ (sl_count (&list), expected.size ());
+
+  for (const auto& it : expected)
+  {
+    TestStruct actual = { 0, 0, 0 };
+    ASSERT_TRUE (sl_get (&list, &actual, sizeof (actual), it.first.c_str ()));
+    EXPECT_EQ (actual, it.second);
+    EXPECT_FALSE (sl_get (&list, &actual, sizeof (actual) - 1, it.first.c_str ()));
+  }
+
+  TestStruct item = { 0, 0, 0 };
+  EXPECT_FALSE (sl_get (&list, &item, sizeof (item), "absent"));
+  EXPECT_FALSE (sl_delete (&list, "absent"));
+  EXPECT_FALSE (sl_insert (&list, NULL, 0, "null"));
+  EXPECT_FALSE (sl_insert (&list, &item, sizeof (item), NULL));
+  EXPECT_FALSE (sl_insert (&list, &item, sizeof (item), std::string (SL_KEY_SIZE, 'k').c_str ()));
+
+  // ordered iteration : whole and bounded
+  auto keys = scan (NULL, NULL);
+  ASSERT_EQ (keys.size (), expected.size ());
+  EXPECT_TRUE (std::equal (keys.begin (), keys.end (), expected.begin (),
+                           [] (const std::string& key, const auto& it) { return key == it.first; }));
+
+  keys = scan ("a", "long-key-");
+  auto from = expected.lower_bound ("a");
+  auto to = expected.lower_bound ("long-key-");
+  ASSERT_EQ (keys.size (), (size_t)std::distance (from, to));
+  EXPECT_TRUE (std::equal (keys.begin (), keys.end (), from,
+                           [] (const std::string& key, const auto& it) { return key == it.first; }));
+
+  EXPECT_TRUE (scan ("~", NULL).empty ());
+  EXPECT_FALSE (sl_scan_range (&list, NULL, NULL, NULL, NULL));
+}
+
+TEST_F (SkipListTestClass, SLConcurrentTest)
+{
+  // writers insert and delete own and shared keys, readers scan and look up meanwhile
+
+  const unsigned int THREADS_COUNT = 8;
+  const int KEYS_PER_THREAD = 5000;
+
+  std::atomic<int> sharedInserted (0);
+  std::atomic<bool> isDone (false);
+  std::vector<std::thread> threads;
+
+  for (unsigned int id = 0; id < THREADS_COUNT; ++id)
+  {
+    threads.push_back (std::thread ([&, id] {
+      TestStruct item = { (int)id, 0, 0 };
+
+      for (auto i = 0; i < KEYS_PER_THREAD; ++i)
+      {
+        std::string own = "own:" + std::to_string (id) + ":" + std::to_string (i);
+        std::string shared = "shared:" + std::to_string (i);
+
+        EXPECT_TRUE (sl_insert (&list, &item, sizeof (item), own.c_str ()));
+        sharedInserted += sl_insert (&list, &item, sizeof (item), shared.c_str ());
+
+        // every odd own key is deleted right away
+        if (i % 2)
+        {
+          EXPECT_TRUE (sl_delete (&list, own.c_str ()));
+        }
+      }
+    }));
+  }
+
+  std::thread reader ([&] {
+    while (!isDone)
+    {
+      std::vector<std::string> keys;
+      sl_scan_range (&list, NULL, NULL, collectKeys, &keys);
+      EXPECT_TRUE (std::is_sorted (keys.begin (), keys.end ()));
+      EXPECT_TRUE (std::adjacent_find (keys.begin (), keys.end ()) == keys.end ());
+    }
+  });
+
+  for (auto& thread : threads)
+  {
+    thread.join ();
+  }
+  isDone = true;
+  reader.join ();
+
+  EXPECT_EQ (sharedInserted, KEYS_PER_THREAD);
+  EXPECT_EQ (sl_count (&list), THREADS_COUNT * KEYS_PER_THREAD / 2 + KEYS_PER_THREAD);
+
+  TestStruct item;
+  for (unsigned int id = 0; id < THREADS_COUNT; ++id)
+  {
+    for (auto i = 0; i < KEYS_PER_THREAD; ++i)
+    {
+      std::string own = "own:" + std::to_string (id) + ":" + std::to_string (i);
+      ASSERT_EQ (sl_get (&list, &item, sizeof (item), own.c_str ()), i % 2 == 0);
+    }
+  }
+
+  EXPECT_EQ (scan (NULL, NULL).size (), sl_count (&list));
+}
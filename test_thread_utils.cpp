@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "include/c/thread_utils.h"
+}
+
+/************************************************************************
+ *                             HELPER    	                            *
+ ************************************************************************/
+
+struct StackNode
+{
+  int value;
+  StackNode* next;
+};
+
+static void releaseNode (void* pNode, void* pContext)
+{
+  ++*static_cast<std::atomic<size_t>*> (pContext);
+  delete static_cast<StackNode*> (pNode);
+}
+
+/************************************************************************
+ *                             CLASS    	                            *
+ ************************************************************************/
+
+class SmrTestClass : public ::testing::Test
+{
+public:
+  SmrDomain domain;
+  std::atomic<size_t> released{ 0 };
+
+  void TearDown () override { smr_destroy (&domain); }
+
+  // Treiber stack : the popped node is retired, readers protect the top before using it
+  void push (StackNode** pHead, int value)
+  {
+    StackNode* pNode = new StackNode{ value, __atomic_load_n (pHead, __ATOMIC_ACQUIRE) };
+
+    while (!__atomic_compare_exchange_n (pHead, &pNode->next, pNode, false, __ATOMIC_ACQ_REL,
+                                         __ATOMIC_ACQUIRE))
+    {
+    }
+  }
+
+  bool pop (StackNode** pHead, int* pValue)
+  {
+    SmrRecord* pRecord = smr_enter (&domain);
+    StackNode* pTop = NULL;
+
+    while ((pTop = (StackNode*)smr_protect (&domain, pRecord, 0, (void* const*)pHead)) != NULL)
+    {
+      if (__atomic_compare_exchange_n (pHead, &pTop, pTop->next, false, __ATOMIC_ACQ_REL,
+                                       __ATOMIC_ACQUIRE))
+      {
+        *pValue = pTop->value;
+        smr_retire (&domain, pRecord, pTop);
+        break;
+      }
+    }
+
+    smr_exit (&domain, pRecord);
+
+    return pTop != NULL;
+  }
+};
+
+/************************************************************************
+ *                             TESTS    	                            *
+ ************************************************************************/
+
+TEST_F (SmrTestClass, SmrEpochTest)
+{
+  // nodes retired while a reader is inside are kept until it leaves
+
+  const size_t NODES_COUNT = 1000;
+
+  EXPECT_FALSE (smr_init (&domain, SMR_EPOCH, NULL, NULL));
+  ASSERT_TRUE (smr_init (&domain, SMR_EPOCH, releaseNode, &released));
+
+  SmrRecord* pReader = smr_enter (&domain);
+
+  // nested critical section of the same thread gets own record
+  SmrRecord* pWriter = smr_enter (&domain);
+  ASSERT_NE (pReader, pWriter);
+
+  for (size_t i = 0; i < NODES_COUNT; ++i)
+  {
+    smr_retire (&domain, pWriter, new StackNode{ (int)i, NULL });
+  }
+  smr_exit (&domain, pWriter);
+
+  for (int i = 0; i < 3; ++i)
+  {
+    SmrRecord* pRecord = smr_enter (&domain);
+    smr_reclaim (&domain, pRecord);
+    smr_exit (&domain, pRecord);
+  }
+  EXPECT_EQ (released, 0u);
+
+  // the epoch moves on once per reclamation attempt : retired at E, released at E + 2
+  smr_exit (&domain, pReader);
+
+  for (int i = 0; i < 3; ++i)
+  {
+    SmrRecord* pRecord = smr_enter (&domain);
+    smr_reclaim (&domain, pRecord);
+    smr_exit (&domain, pRecord);
+  }
+  EXPECT_EQ (released, NODES_COUNT);
+}
+
+TEST_F (SmrTestClass, SmrHazardTest)
+{
+  // concurrent Treiber stack : every value is popped once, memory is released on the go
+
+  const unsigned int THREADS_COUNT = 8;
+  const int VALUES_PER_THREAD = 20000;
+
+  ASSERT_TRUE (smr_init (&domain, SMR_HAZARD, releaseNode, &released));
+
+  StackNode* pHead = NULL;
+  std::vector<std::vector<int>> popped (THREADS_COUNT);
+  std::vector<std::thread> threads;
+
+  for (unsigned int id = 0; id < THREADS_COUNT; ++id)
+  {
+    threads.push_back (std::thread ([&, id] {
+      for (auto i = 0; i < VALUES_PER_THREAD; ++i)
+      {
+        push (&pHead, (int)id * VALUES_PER_THREAD + i);
+
+        int value = 0;
+        if (pop (&pHead, &value))
+        {
+          popped[id].push_back (value);
+        }
+      }
+    }));
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join ();
+  }
+
+  int value = 0;
+  while (pop (&pHead, &value))
+  {
+    popped[0].push_back (value);
+  }
+
+  std::set<int> values;
+  for (const auto& threadValues : popped)
+  {
+    values.insert (threadValues.begin (), threadValues.end ());
+  }
+  EXPECT_EQ (values.size (), THREADS_COUNT * VALUES_PER_THREAD);
+
+  // the rest waits in records under the scan threshold
+  size_t pending = values.size () - released;
+  EXPECT_LT (pending, 2 * THREADS_COUNT * SMR_SCAN_THRESHOLD);
+}